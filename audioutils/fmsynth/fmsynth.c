@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include <audioutils/fmsynth.h>
 
 /****************************************************************************
@@ -93,6 +94,58 @@ static int sound_modulate(FAR fmsynth_sound_t *snd)
   return out * snd->volume / FMSYNTH_MAX_VOLUME;
 }
 
+/****************************************************************************
+ * name: sound_modulate_block
+ ****************************************************************************/
+
+static void sound_modulate_block(FAR fmsynth_sound_t *snd, FAR int *mix,
+                                 int num)
+{
+  int out[FMSYNTH_BLOCK_SIZE];
+  FAR fmsynth_op_t *op;
+  int volume;
+  int n;
+  int i;
+
+  if (snd->operators == NULL)
+    {
+      return;
+    }
+
+  volume = (snd->volume << 15) / FMSYNTH_MAX_VOLUME;
+
+  while (num > 0)
+    {
+      /* Split the block where the phase time wraps round */
+
+      n = max_phase_time - snd->phase_time;
+      if (n > num)
+        {
+          n = num;
+        }
+
+      fetch_feedback(snd->operators);
+
+      for (op = snd->operators; op != NULL; op = op->parallelop)
+        {
+          fmsynthop_operate_block(op, snd->phase_time, out, n);
+          for (i = 0; i < n; i++)
+            {
+              mix[i] += (out[i] * volume) >> 15;
+            }
+        }
+
+      snd->phase_time += n;
+      if (snd->phase_time >= max_phase_time)
+        {
+          snd->phase_time = 0;
+        }
+
+      mix += n;
+      num -= n;
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -266,3 +319,65 @@ int fmsynth_rendering(FAR fmsynth_sound_t *snd,
 
   return i * sizeof(int16_t);
 }
+
+/****************************************************************************
+ * name: fmsynth_rendering_block
+ *
+ * Same as fmsynth_rendering(), but each operator renders
+ * FMSYNTH_BLOCK_SIZE samples per call, and cb is called once per block
+ * instead of once per sample.  Feedback from another operator is sampled
+ * once per block, so for high feedback ratios the sound differs from
+ * fmsynth_rendering().  Self feedback is still applied per sample.
+ ****************************************************************************/
+
+int fmsynth_rendering_block(FAR fmsynth_sound_t *snd,
+                            FAR int16_t *sample, int sample_num, int chnum,
+                            fmsynth_tickcb_t cb, unsigned long cbarg)
+{
+  int mix[FMSYNTH_BLOCK_SIZE];
+  FAR fmsynth_sound_t *itr;
+  int frames;
+  int done;
+  int num;
+  int ch;
+  int i;
+
+  if (chnum <= 0)
+    {
+      return 0;
+    }
+
+  frames = sample_num / chnum;
+
+  for (done = 0; done < frames; done += num)
+    {
+      num = frames - done;
+      if (num > FMSYNTH_BLOCK_SIZE)
+        {
+          num = FMSYNTH_BLOCK_SIZE;
+        }
+
+      memset(mix, 0, num * sizeof(int));
+      for (itr = snd; itr != NULL; itr = itr->next_sound)
+        {
+          sound_modulate_block(itr, mix, num);
+        }
+
+      for (i = 0; i < num; i++)
+        {
+          for (ch = 0; ch < chnum; ch++)
+            {
+              *sample++ = (int16_t)mix[i];
+            }
+        }
+
+      if (cb != NULL)
+        {
+          cb(cbarg);
+        }
+    }
+
+  /* Return total bytes stored in the buffer */
+
+  return frames * chnum * sizeof(int16_t);
+}
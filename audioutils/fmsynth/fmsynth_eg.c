@@ -60,6 +60,25 @@ static int set_egparams(int fs,
   return 0;
 }
 
+/****************************************************************************
+ * name: next_state
+ ****************************************************************************/
+
+static int next_state(FAR fmsynth_eg_t *eg)
+{
+  int state = eg->state;
+
+  /* Search next available state */
+
+  do
+    {
+      state++;
+    }
+  while (state < EGSTATE_RELEASED && eg->state_params[state].period == 0);
+
+  return state;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -184,15 +203,7 @@ int fmsyntheg_operate(FAR fmsynth_eg_t *eg)
           /* Reset the counter */
 
           eg->state_counter = 0;
-
-          /* Search next available state */
-
-          do
-            {
-              eg->state++;
-            }
-          while (eg->state < EGSTATE_RELEASED
-               && eg->state_params[eg->state].period == 0);
+          eg->state = next_state(eg);
 
           val = eg->state_params[eg->state].initval;
         }
@@ -205,3 +216,62 @@ int fmsyntheg_operate(FAR fmsynth_eg_t *eg)
 
   return val;
 }
+
+/****************************************************************************
+ * name: fmsyntheg_get_level
+ *
+ * Return the level the next fmsyntheg_operate() call would return, without
+ * advancing the envelope.
+ ****************************************************************************/
+
+int fmsyntheg_get_level(FAR fmsynth_eg_t *eg)
+{
+  FAR fmsynth_egparam_t *param = &eg->state_params[eg->state];
+
+  if (eg->state == EGSTATE_RELEASED)
+    {
+      return param->initval;
+    }
+
+  if (eg->state_counter >= param->period)
+    {
+      return eg->state_params[next_state(eg)].initval;
+    }
+
+  return param->initval + param->diff2next * eg->state_counter
+                          / param->period;
+}
+
+/****************************************************************************
+ * name: fmsyntheg_skip
+ *
+ * Advance the envelope as if fmsyntheg_operate() was called num times.
+ ****************************************************************************/
+
+void fmsyntheg_skip(FAR fmsynth_eg_t *eg, int num)
+{
+  int period;
+
+  while (num > 0 && eg->state != EGSTATE_RELEASED)
+    {
+      period = eg->state_params[eg->state].period;
+      if (eg->state_counter >= period)
+        {
+          /* A state change takes one sample of its own */
+
+          eg->state_counter = 0;
+          eg->state = next_state(eg);
+          num--;
+        }
+      else if (period - eg->state_counter > num)
+        {
+          eg->state_counter += num;
+          num = 0;
+        }
+      else
+        {
+          num -= period - eg->state_counter;
+          eg->state_counter = period;
+        }
+    }
+}
@@ -22,6 +22,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <audioutils/fmsynth_op.h>
 
@@ -29,8 +30,25 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* The adjusted phase is never negative, so the modulo of the power of two
+ * period is a mask, and the quadrant a shift.
+ */
+
 #define PHASE_ADJUST(th) \
-        (((th) < 0 ? (FMSYNTH_PI) - (th) : (th)) % (FMSYNTH_PI * 2))
+        (((th) < 0 ? (FMSYNTH_PI) - (th) : (th)) & (FMSYNTH_PI * 2 - 1))
+
+#define QUARTER_SHIFT (15)
+#define QUARTER_MASK  ((FMSYNTH_PI / 2) - 1)
+
+/* Envelope level to Q15 gain */
+
+#define EG2GAIN(lv)   ((lv) * 32768 / FMSYNTH_MAX_EGLEVEL)
+
+/* The block renderer keeps the phase in a 32 bit accumulator, in which one
+ * period (2 * FMSYNTH_PI) is 1 << 32.
+ */
+
+#define PHASE_FRAC    (15)
 
 /****************************************************************************
  * Private Data
@@ -110,6 +128,16 @@ static const short s_sintbl[] =
   0x7fff, /* Extra data for linear completion */
 };
 
+/* Start value and slope of the triangle wave in each quadrant */
+
+static const int s_tritbl[4][2] =
+{
+  {         0,  SHRT_MAX },
+  {  SHRT_MAX, -SHRT_MAX },
+  {         0, -SHRT_MAX },
+  { -SHRT_MAX,  SHRT_MAX },
+};
+
 static int local_fs;
 
 /****************************************************************************
@@ -117,10 +145,10 @@ static int local_fs;
  ****************************************************************************/
 
 /****************************************************************************
- * name: pseudo_sin256
+ * name: sin256
  ****************************************************************************/
 
-static int pseudo_sin256(int theta)
+static inline int sin256(int theta)
 {
   int short_sin;
   int rest;
@@ -130,8 +158,8 @@ static int pseudo_sin256(int theta)
   theta = PHASE_ADJUST(theta);
 
   rest   = theta & 0x7f;
-  phase  = theta / (FMSYNTH_PI / 2);
-  tblidx = (theta % (FMSYNTH_PI / 2)) >> 7;
+  phase  = theta >> QUARTER_SHIFT;
+  tblidx = (theta & QUARTER_MASK) >> 7;
 
   if (phase & 0x01)
     {
@@ -151,45 +179,85 @@ static int pseudo_sin256(int theta)
 }
 
 /****************************************************************************
- * name: triangle_wave
+ * name: triangle
  ****************************************************************************/
 
-static int triangle_wave(int theta)
+static inline int triangle(int theta)
 {
-  int ret = 0;
   int phase;
   int offset;
-  int slope;
 
   theta = PHASE_ADJUST(theta);
-  phase  = theta / (FMSYNTH_PI / 2);
-  offset = theta % (FMSYNTH_PI / 2);
+  phase  = theta >> QUARTER_SHIFT;
+  offset = theta & QUARTER_MASK;
+
+  return s_tritbl[phase][0] + ((s_tritbl[phase][1] * offset) >> 15);
+}
+
+/****************************************************************************
+ * name: sawtooth
+ ****************************************************************************/
+
+static inline int sawtooth(int theta)
+{
+  theta = PHASE_ADJUST(theta);
+  return (theta >> 1) - SHRT_MAX;
+}
+
+/****************************************************************************
+ * name: square
+ ****************************************************************************/
+
+static inline int square(int theta)
+{
+  theta = PHASE_ADJUST(theta);
+  return theta < FMSYNTH_PI ? SHRT_MAX : -SHRT_MAX;
+}
 
-  switch (phase)
+/****************************************************************************
+ * name: pseudo_sin256
+ ****************************************************************************/
+
+static int pseudo_sin256(int theta)
+{
+  return sin256(theta);
+}
+
+/****************************************************************************
+ * name: pseudo_sin256_block
+ ****************************************************************************/
+
+static void pseudo_sin256_block(FAR const int *theta, FAR int *out, int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
     {
-      case 0:
-        ret = 0;
-        slope = SHRT_MAX;
-        break;
-      case 1:
-        ret = SHRT_MAX;
-        slope = -SHRT_MAX;
-        break;
-      case 2:
-        ret = 0;
-        slope = -SHRT_MAX;
-        break;
-      case 3:
-        ret = -SHRT_MAX;
-        slope = SHRT_MAX;
-        break;
-      default:
-        ret = 0;
-        slope = SHRT_MAX;
-        break;
+      out[i] = sin256(theta[i]);
     }
+}
 
-  return ret + ((slope * offset) >> 15);
+/****************************************************************************
+ * name: triangle_wave
+ ****************************************************************************/
+
+static int triangle_wave(int theta)
+{
+  return triangle(theta);
+}
+
+/****************************************************************************
+ * name: triangle_wave_block
+ ****************************************************************************/
+
+static void triangle_wave_block(FAR const int *theta, FAR int *out, int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
+    {
+      out[i] = triangle(theta[i]);
+    }
 }
 
 /****************************************************************************
@@ -198,8 +266,21 @@ static int triangle_wave(int theta)
 
 static int sawtooth_wave(int theta)
 {
-  theta = PHASE_ADJUST(theta);
-  return (theta >> 1) - SHRT_MAX;
+  return sawtooth(theta);
+}
+
+/****************************************************************************
+ * name: sawtooth_wave_block
+ ****************************************************************************/
+
+static void sawtooth_wave_block(FAR const int *theta, FAR int *out, int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
+    {
+      out[i] = sawtooth(theta[i]);
+    }
 }
 
 /****************************************************************************
@@ -208,8 +289,21 @@ static int sawtooth_wave(int theta)
 
 static int square_wave(int theta)
 {
-  theta = PHASE_ADJUST(theta);
-  return theta < FMSYNTH_PI ? SHRT_MAX : -SHRT_MAX;
+  return square(theta);
+}
+
+/****************************************************************************
+ * name: square_wave_block
+ ****************************************************************************/
+
+static void square_wave_block(FAR const int *theta, FAR int *out, int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
+    {
+      out[i] = square(theta[i]);
+    }
 }
 
 /****************************************************************************
@@ -261,6 +355,7 @@ FAR fmsynth_op_t *create_fmsynthop(FAR fmsynth_op_t *op,
 
       op->own_allocate  = 0;
       op->wavegen       = NULL;
+      op->wavegen_block = NULL;
       op->cascadeop     = NULL;
       op->parallelop    = NULL;
       op->feedback_ref  = NULL;
@@ -333,21 +428,25 @@ int fmsynthop_select_opfunc(FAR fmsynth_op_t *op, int type)
         {
           case FMSYNTH_OPFUNC_SIN:
             op->wavegen = pseudo_sin256;
+            op->wavegen_block = pseudo_sin256_block;
             ret = OK;
             break;
 
           case FMSYNTH_OPFUNC_TRIANGLE:
             op->wavegen = triangle_wave;
+            op->wavegen_block = triangle_wave_block;
             ret = OK;
             break;
 
           case FMSYNTH_OPFUNC_SAWTOOTH:
             op->wavegen = sawtooth_wave;
+            op->wavegen_block = sawtooth_wave_block;
             ret = OK;
             break;
 
           case FMSYNTH_OPFUNC_SQUARE:
             op->wavegen = square_wave;
+            op->wavegen_block = square_wave_block;
             ret = OK;
             break;
         }
@@ -544,3 +643,101 @@ int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time)
 
   return op->last_sigval;
 }
+
+/****************************************************************************
+ * name: fmsynthop_operate_block
+ *
+ * Render num (up to FMSYNTH_BLOCK_SIZE) samples of the operator into out.
+ * The envelope is evaluated once per block and ramped linearly across it.
+ ****************************************************************************/
+
+void fmsynthop_operate_block(FAR fmsynth_op_t *op, int phase_time,
+                             FAR int *out, int num)
+{
+  int phase[FMSYNTH_BLOCK_SIZE];
+  FAR fmsynth_op_t *subop;
+  uint32_t current;
+  uint32_t delta;
+  int fbrate;
+  int gain;
+  int step;
+  int last;
+  int val;
+  int i;
+
+  if (num <= 0)
+    {
+      return;
+    }
+
+  /* Phase of the operator itself */
+
+  i = 0;
+  current = (uint32_t)(op->current_phase * (1 << PHASE_FRAC));
+  delta = (uint32_t)(op->delta_phase * (1 << PHASE_FRAC));
+  if (phase_time == 0)
+    {
+      current = 0;
+      phase[i++] = 0;
+    }
+
+  for (; i < num; i++)
+    {
+      current += delta;
+      phase[i] = (int)(current >> PHASE_FRAC);
+    }
+
+  op->current_phase = (float)current / (1 << PHASE_FRAC);
+
+  /* Add the modulation of the cascaded operators, using out as scratch */
+
+  for (subop = op->cascadeop; subop != NULL; subop = subop->parallelop)
+    {
+      fmsynthop_operate_block(subop, phase_time, out, num);
+      for (i = 0; i < num; i++)
+        {
+          phase[i] += out[i];
+        }
+    }
+
+  /* Envelope gain in Q15, with 8 more bits for the ramp */
+
+  gain = EG2GAIN(fmsyntheg_get_level(op->eg));
+  fmsyntheg_skip(op->eg, num);
+  step = ((EG2GAIN(fmsyntheg_get_level(op->eg)) - gain) << 8) / num;
+  gain <<= 8;
+
+  if (op->feedback_ref == &op->last_sigval)
+    {
+      /* Self feedback needs the previous sample of this very operator */
+
+      fbrate = (op->feedbackrate << 12) / FMSYNTH_MAX_EGLEVEL;
+      last = op->last_sigval;
+      for (i = 0; i < num; i++)
+        {
+          val  = phase[i] + ((last * fbrate) >> 12);
+          last = ((gain >> 8) * op->wavegen(val)) >> 15;
+          out[i] = last;
+          gain += step;
+        }
+    }
+  else
+    {
+      if (op->feedback_ref != NULL)
+        {
+          for (i = 0; i < num; i++)
+            {
+              phase[i] += op->feedback_val;
+            }
+        }
+
+      op->wavegen_block(phase, out, num);
+      for (i = 0; i < num; i++)
+        {
+          out[i] = ((gain >> 8) * out[i]) >> 15;
+          gain += step;
+        }
+    }
+
+  op->last_sigval = out[num - 1];
+}
@@ -0,0 +1,569 @@
+/****************************************************************************
+ * apps/benchmarks/benchlib/bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "benchmarks/bench.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_WARMUP  0
+#define BENCH_DEFAULT_TRIALS  1
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_compare
+ ****************************************************************************/
+
+static int bench_compare(FAR const void *a, FAR const void *b)
+{
+  uint64_t x = *(FAR const uint64_t *)a;
+  uint64_t y = *(FAR const uint64_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+ * Name: bench_sqrt
+ *
+ *   Integer square root, so the library does not need libm.
+ *
+ ****************************************************************************/
+
+static uint64_t bench_sqrt(uint64_t x)
+{
+  uint64_t bit = (uint64_t)1 << 62;
+  uint64_t res = 0;
+
+  while (bit > x)
+    {
+      bit >>= 2;
+    }
+
+  while (bit != 0)
+    {
+      if (x >= res + bit)
+        {
+          x  -= res + bit;
+          res = (res >> 1) + bit;
+        }
+      else
+        {
+          res >>= 1;
+        }
+
+      bit >>= 2;
+    }
+
+  return res;
+}
+
+/****************************************************************************
+ * Name: bench_percentile
+ *
+ *   Nearest-rank percentile of the sorted samples.
+ *
+ ****************************************************************************/
+
+static uint64_t bench_percentile(FAR const uint64_t *sorted, uint32_t n,
+                                 uint32_t pct)
+{
+  uint32_t rank = (uint32_t)(((uint64_t)pct * n + 99) / 100);
+
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/****************************************************************************
+ * Name: bench_stats
+ ****************************************************************************/
+
+static void bench_stats(FAR const uint64_t *samples, uint32_t n,
+                        FAR uint64_t *sorted,
+                        FAR struct bench_result_s *result)
+{
+  uint64_t sum = 0;
+  uint64_t var = 0;
+  uint64_t limit;
+  uint64_t diff;
+  uint32_t shift = 0;
+  uint32_t i;
+
+  /* Keep the samples in the order they were taken for the report */
+
+  memcpy(sorted, samples, n * sizeof(uint64_t));
+  qsort(sorted, n, sizeof(uint64_t), bench_compare);
+
+  for (i = 0; i < n; i++)
+    {
+      sum += samples[i];
+    }
+
+  result->trials = n;
+  result->min    = sorted[0];
+  result->max    = sorted[n - 1];
+  result->mean   = sum / n;
+
+  /* The sum of the squared deviations must fit 64 bits.  Drop low bits of
+   * the deviations when they are too large for that, which only happens
+   * for trials of seconds.
+   */
+
+  diff  = result->max - result->mean > result->mean - result->min ?
+          result->max - result->mean : result->mean - result->min;
+  limit = bench_sqrt(UINT64_MAX / n);
+
+  while ((diff >> shift) > limit)
+    {
+      shift++;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      diff = samples[i] > result->mean ? samples[i] - result->mean :
+                                         result->mean - samples[i];
+      diff >>= shift;
+      var += diff * diff;
+    }
+
+  result->stddev = bench_sqrt(var / n) << shift;
+  result->p50    = bench_percentile(sorted, n, 50);
+  result->p90    = bench_percentile(sorted, n, 90);
+  result->p99    = bench_percentile(sorted, n, 99);
+}
+
+/****************************************************************************
+ * Name: bench_print_string
+ *
+ *   Print a JSON string.  Case names are plain ASCII, so escaping quotes
+ *   and backslashes is enough.
+ *
+ ****************************************************************************/
+
+static void bench_print_string(FAR const char *str)
+{
+  putchar('"');
+  for (; *str != '\0'; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        {
+          putchar('\\');
+        }
+
+      putchar(*str);
+    }
+
+  putchar('"');
+}
+
+/****************************************************************************
+ * Name: bench_report
+ ****************************************************************************/
+
+static void bench_report(FAR struct bench_s *bench,
+                         FAR const struct bench_case_s *bcase,
+                         FAR const struct bench_result_s *result,
+                         FAR const uint64_t *samples)
+{
+  uint32_t ops = bcase->ops > 0 ? bcase->ops : 1;
+  uint64_t kbps = 0;
+  uint32_t i;
+
+  if (bcase->bytes > 0 && result->mean > 0)
+    {
+      kbps = bcase->bytes * 1000000000ull / result->mean / 1024;
+    }
+
+  switch (bench->format)
+    {
+      case BENCH_FORMAT_JSON:
+        printf("%s\n    {\"case\": ", bench->nrecords > 0 ? "," : "");
+        bench_print_string(bcase->name);
+        printf(", \"cpu\": %d, \"trials\": %" PRIu32 ", "
+               "\"mean_ns\": %" PRIu64,
+               result->cpu, result->trials, result->mean);
+
+        if (result->trials > 1)
+          {
+            printf(", \"min_ns\": %" PRIu64 ", \"p50_ns\": %" PRIu64
+                   ", \"p90_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64
+                   ", \"max_ns\": %" PRIu64 ", \"stddev_ns\": %" PRIu64,
+                   result->min, result->p50, result->p90, result->p99,
+                   result->max, result->stddev);
+          }
+
+        printf(", \"bytes\": %" PRIu64 ", \"ops\": %" PRIu32
+               ", \"kbps\": %" PRIu64 ", \"ns_per_op\": %" PRIu64,
+               bcase->bytes, ops, kbps, result->mean / ops);
+
+        if (bench->detail)
+          {
+            printf(", \"samples\": [");
+            for (i = 0; i < result->trials; i++)
+              {
+                printf("%s%" PRIu64, i > 0 ? ", " : "", samples[i]);
+              }
+
+            putchar(']');
+          }
+
+        putchar('}');
+        break;
+
+      case BENCH_FORMAT_CSV:
+        printf("%s,%s,%d,%" PRIu32 ",", bench->name, bcase->name,
+               result->cpu, result->trials);
+
+        if (result->trials > 1)
+          {
+            printf("%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                   ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+                   result->min, result->mean, result->p50, result->p90,
+                   result->p99, result->max, result->stddev);
+          }
+        else
+          {
+            printf(",%" PRIu64 ",,,,,", result->mean);
+          }
+
+        printf(",%" PRIu64 ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 "\n",
+               bcase->bytes, ops, kbps, result->mean / ops);
+        break;
+
+      default:
+        if (bench->detail)
+          {
+            for (i = 0; i < result->trials; i++)
+              {
+                printf("\t%" PRIu32 ": %" PRIu64 "\n", i, samples[i]);
+              }
+          }
+
+        if (result->trials > 1)
+          {
+            printf("%-32s %3d %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+                   " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %8" PRIu64,
+                   bcase->name, result->cpu, result->min, result->mean,
+                   result->p50, result->p90, result->p99, result->max,
+                   result->stddev);
+          }
+        else
+          {
+            printf("%-32s %3d %10" PRIu64,
+                   bcase->name, result->cpu, result->mean);
+          }
+
+        if (bcase->bytes > 0)
+          {
+            printf(" %8" PRIu64 " KB/s", kbps);
+          }
+        else if (ops > 1)
+          {
+            printf(" %8" PRIu64 " ns/op", result->mean / ops);
+          }
+
+        putchar('\n');
+        break;
+    }
+
+  bench->nrecords++;
+}
+
+/****************************************************************************
+ * Name: bench_trials
+ ****************************************************************************/
+
+static void bench_trials(FAR struct bench_s *bench,
+                         FAR const struct bench_case_s *bcase, int cpu,
+                         FAR struct bench_result_s *result)
+{
+  FAR uint64_t *samples = bench->samples;
+  uint32_t i;
+
+  for (i = 0; i < bench->warmup; i++)
+    {
+      bcase->trial(bcase->arg);
+    }
+
+  for (i = 0; i < bench->trials; i++)
+    {
+      samples[i] = bcase->trial(bcase->arg);
+    }
+
+  result->cpu = cpu;
+  bench_stats(samples, bench->trials, samples + bench->trials, result);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_init
+ ****************************************************************************/
+
+void bench_init(FAR struct bench_s *bench, FAR const char *name)
+{
+  memset(bench, 0, sizeof(*bench));
+  bench->name   = name;
+  bench->warmup = BENCH_DEFAULT_WARMUP;
+  bench->trials = BENCH_DEFAULT_TRIALS;
+  bench->format = BENCH_FORMAT_TEXT;
+}
+
+/****************************************************************************
+ * Name: bench_option
+ ****************************************************************************/
+
+int bench_option(FAR struct bench_s *bench, int opt, FAR const char *arg)
+{
+  FAR char *end;
+
+  switch (opt)
+    {
+      case 'W':
+        bench->warmup = strtoul(arg, &end, 0);
+        return *end == '\0' ? OK : -EINVAL;
+
+      case 'T':
+        bench->trials = strtoul(arg, &end, 0);
+        return *end == '\0' && bench->trials > 0 ? OK : -EINVAL;
+
+      case 'F':
+        if (strcasecmp(arg, "text") == 0)
+          {
+            bench->format = BENCH_FORMAT_TEXT;
+          }
+        else if (strcasecmp(arg, "json") == 0)
+          {
+            bench->format = BENCH_FORMAT_JSON;
+          }
+        else if (strcasecmp(arg, "csv") == 0)
+          {
+            bench->format = BENCH_FORMAT_CSV;
+          }
+        else
+          {
+            return -EINVAL;
+          }
+
+        return OK;
+
+      case 'A':
+#ifdef CONFIG_SMP
+        bench->cpumask = strtoul(arg, &end, 16);
+        return *end == '\0' ? OK : -EINVAL;
+#else
+        return -ENOSYS;
+#endif
+
+      case 'D':
+        bench->detail = true;
+        return OK;
+
+      default:
+        return -ENOENT;
+    }
+}
+
+/****************************************************************************
+ * Name: bench_usage
+ ****************************************************************************/
+
+void bench_usage(void)
+{
+  printf("Common options:\n");
+  printf("  -W <n>     Warm-up runs before each case [%d]\n",
+         BENCH_DEFAULT_WARMUP);
+  printf("  -T <n>     Timed trials per case [%d]\n",
+         BENCH_DEFAULT_TRIALS);
+  printf("  -F <fmt>   Output format: text, json or csv [text]\n");
+#ifdef CONFIG_SMP
+  printf("  -A <mask>  Run each case on every CPU in the hex mask\n");
+#endif
+  printf("  -D         Print every sample (text and json)\n");
+}
+
+/****************************************************************************
+ * Name: bench_begin
+ ****************************************************************************/
+
+int bench_begin(FAR struct bench_s *bench, FAR const char *config)
+{
+  /* The samples in the order they were taken, followed by a sorted copy */
+
+  bench->samples = malloc(2 * bench->trials * sizeof(uint64_t));
+  if (bench->samples == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  bench->nsamples = bench->trials;
+  bench->nrecords = 0;
+
+  switch (bench->format)
+    {
+      case BENCH_FORMAT_JSON:
+        printf("{\n  \"bench\": ");
+        bench_print_string(bench->name);
+        printf(",\n  \"config\": ");
+        bench_print_string(config != NULL ? config : "");
+        printf(",\n  \"warmup\": %" PRIu32 ",\n  \"trials\": %" PRIu32
+               ",\n  \"results\": [", bench->warmup, bench->trials);
+        break;
+
+      case BENCH_FORMAT_CSV:
+        printf("bench,case,cpu,trials,min_ns,mean_ns,p50_ns,p90_ns,"
+               "p99_ns,max_ns,stddev_ns,bytes,ops,kbps,ns_per_op\n");
+        break;
+
+      default:
+        printf("%s: %s%swarmup %" PRIu32 ", trials %" PRIu32 "\n",
+               bench->name, config != NULL ? config : "",
+               config != NULL ? ", " : "", bench->warmup, bench->trials);
+        if (bench->trials > 1)
+          {
+            printf("%-32s %3s %10s %10s %10s %10s %10s %10s %8s\n",
+                   "Case", "CPU", "Min(ns)", "Avg(ns)", "P50(ns)",
+                   "P90(ns)", "P99(ns)", "Max(ns)", "Stddev");
+          }
+        else
+          {
+            printf("%-32s %3s %10s\n", "Case", "CPU", "Time(ns)");
+          }
+        break;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_end
+ ****************************************************************************/
+
+void bench_end(FAR struct bench_s *bench)
+{
+  if (bench->format == BENCH_FORMAT_JSON)
+    {
+      printf("\n  ]\n}\n");
+    }
+
+  free(bench->samples);
+  bench->samples  = NULL;
+  bench->nsamples = 0;
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+int bench_run(FAR struct bench_s *bench,
+              FAR const struct bench_case_s *bcase,
+              FAR struct bench_result_s *result)
+{
+  struct bench_result_s local;
+  int ret = OK;
+#ifdef CONFIG_SMP
+  cpu_set_t saved;
+  cpu_set_t cpuset;
+  int cpu;
+#endif
+
+  if (bench->samples == NULL || bench->nsamples < bench->trials)
+    {
+      return -EINVAL;
+    }
+
+  if (result == NULL)
+    {
+      result = &local;
+    }
+
+#ifdef CONFIG_SMP
+  if (bench->cpumask != 0)
+    {
+      sched_getaffinity(0, sizeof(saved), &saved);
+
+      for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+        {
+          if ((bench->cpumask & (1u << cpu)) == 0)
+            {
+              continue;
+            }
+
+          CPU_ZERO(&cpuset);
+          CPU_SET(cpu, &cpuset);
+          if (sched_setaffinity(0, sizeof(cpuset), &cpuset) < 0)
+            {
+              ret = -errno;
+              break;
+            }
+
+          bench_trials(bench, bcase, cpu, result);
+          bench_report(bench, bcase, result, bench->samples);
+        }
+
+      sched_setaffinity(0, sizeof(saved), &saved);
+      return ret;
+    }
+#endif
+
+  bench_trials(bench, bcase, -1, result);
+  bench_report(bench, bcase, result, bench->samples);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bench_timestamp
+ ****************************************************************************/
+
+clock_t bench_timestamp(void)
+{
+  return perf_gettime();
+}
+
+/****************************************************************************
+ * Name: bench_elapsed
+ ****************************************************************************/
+
+uint64_t bench_elapsed(clock_t start, clock_t end)
+{
+  struct timespec ts;
+
+  perf_convert(end - start, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
@@ -31,7 +31,11 @@
 #include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "benchmarks/bench.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -81,6 +85,13 @@ struct cachespeed_s
   size_t alloc;
 };
 
+struct cachespeed_trial_s
+{
+  FAR struct cachespeed_s *cs;
+  CODE void (*func)(uintptr_t, uintptr_t);
+  size_t bytes;
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -109,10 +120,6 @@ static void setup(FAR struct cachespeed_s *cs)
       printf(CACHESPEED_PREFIX "Unable to request memory.\n");
       exit(EXIT_FAILURE);
     }
-
-  /* Let's export the test message */
-
-  printf(CACHESPEED_PREFIX "address src: %" PRIxPTR "\n", cs->addr);
 }
 
 /****************************************************************************
@@ -122,86 +129,68 @@ static void setup(FAR struct cachespeed_s *cs)
 static void teardown(FAR struct cachespeed_s *cs)
 {
   free((void *)cs->addr);
-  printf(CACHESPEED_PREFIX "Done!\n");
 }
 
 /****************************************************************************
- * Name: report_line
+ * Name: cachespeed_trial
  ****************************************************************************/
 
-static void report_line(size_t bytes, TIME cost)
+static uint64_t cachespeed_trial(FAR void *arg)
 {
-  double rate;
-
-  /* There is a situation: if the time is 0, then the
-   * calculated speed is wrong.
+  FAR struct cachespeed_trial_s *t = arg;
+  irqstate_t irq;
+  TIME start;
+  TIME end;
+  TIME cost;
+
+  /* Make sure that test with all the contents of our address in the
+   * cache.
    */
 
-  CONVERT(cost);
+  irq = enter_critical_section();
+  memset((FAR void *)t->cs->addr, 1, t->cs->alloc);
+  TIMESTAMP(start);
+  t->func(t->cs->addr, (uintptr_t)(t->cs->addr + t->bytes));
+  TIMESTAMP(end);
+  leave_critical_section(irq);
 
-  if (cost == 0)
-    {
-      printf(CACHESPEED_PREFIX "%d bytes cost time too small!\n", bytes);
-      return;
-    }
-
-  /* rate = Test Data Size / Execution Time */
-
-  rate = 1.00 * bytes * REPEAT_NUM / cost;
-
-  printf("%d Bytes: %4lf, %4llu, %4llu\n\r",
-         bytes, rate, cost / REPEAT_NUM, cost);
+  cost = end - start;
+  CONVERT(cost);
+  return cost;
 }
 
 /****************************************************************************
  * Name: test_skeleton
  ****************************************************************************/
 
-static void test_skeleton(FAR struct cachespeed_s *cs,
+static void test_skeleton(FAR struct bench_s *bench,
+                          FAR struct cachespeed_s *cs,
                           const size_t cache_size,
                           const size_t cache_line_size, int align,
                           void (*func)(uintptr_t, uintptr_t),
                           const char *name)
 {
-  size_t update_size;
-  printf("** %s [rate, avg, cost] in nanoseconds(bytes/nesc) %s **\n",
-         name, align ? "align" : "unalign");
+  struct cachespeed_trial_s t;
+  struct bench_case_s bcase;
+  char casename[40];
 
-  if (!align)
-    {
-      update_size = cache_line_size - 1;
-    }
-  else
-    {
-      update_size = cache_line_size;
-    }
+  t.cs   = cs;
+  t.func = func;
 
-  for (size_t bytes = update_size;
-       bytes <= cache_size; bytes = 2 * bytes)
-    {
-      irqstate_t irq;
-      TIME start;
-      TIME end;
-      TIME cost = 0;
+  memset(&bcase, 0, sizeof(bcase));
+  bcase.name  = casename;
+  bcase.trial = cachespeed_trial;
+  bcase.arg   = &t;
 
-      /* Make sure that test with all the contents
-       * of our address in the cache.
-       */
+  for (t.bytes = align ? cache_line_size : cache_line_size - 1;
+       t.bytes <= cache_size; t.bytes = 2 * t.bytes)
+    {
+      snprintf(casename, sizeof(casename), "%s-%s/%zu", name,
+               align ? "align" : "unalign", t.bytes);
 
+      bcase.bytes = t.bytes;
       up_flush_dcache_all();
-
-      irq = enter_critical_section();
-      for (int i = 0; i < REPEAT_NUM; i++)
-        {
-          memset((void *)cs->addr, 1, cs->alloc);
-          TIMESTAMP(start);
-          func(cs->addr, (uintptr_t)(cs->addr + bytes));
-          TIMESTAMP(end);
-          cost += end - start;
-        }
-
-      leave_critical_section(irq);
-      report_line(bytes, cost);
+      bench_run(bench, &bcase, NULL);
     }
 }
 
@@ -209,24 +198,25 @@ static void test_skeleton(FAR struct cachespeed_s *cs,
  * Name: cachespeed_common
  ****************************************************************************/
 
-static void cachespeed_common(struct cachespeed_s *cs)
+static void cachespeed_common(FAR struct bench_s *bench,
+                              FAR struct cachespeed_s *cs)
 {
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
-                up_invalidate_dcache, "dcache invalidate");
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
-                up_invalidate_dcache, "dcache invalidate");
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
-                up_clean_dcache, "dcache clean");
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
-                up_clean_dcache, "dcache clean");
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
-                up_flush_dcache, "dcache flush");
-  test_skeleton(cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
-                up_flush_dcache, "dcache flush");
-  test_skeleton(cs, GET_ICACHE_SIZE, GET_ICACHE_LINE, 1,
-                up_invalidate_icache, "icache invalidate");
-  test_skeleton(cs, GET_ICACHE_SIZE, GET_ICACHE_LINE, 0,
-                up_invalidate_icache, "icache invalidate");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
+                up_invalidate_dcache, "dcache-invalidate");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
+                up_invalidate_dcache, "dcache-invalidate");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
+                up_clean_dcache, "dcache-clean");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
+                up_clean_dcache, "dcache-clean");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 1,
+                up_flush_dcache, "dcache-flush");
+  test_skeleton(bench, cs, GET_DCACHE_SIZE, GET_DCACHE_LINE, 0,
+                up_flush_dcache, "dcache-flush");
+  test_skeleton(bench, cs, GET_ICACHE_SIZE, GET_ICACHE_LINE, 1,
+                up_invalidate_icache, "icache-invalidate");
+  test_skeleton(bench, cs, GET_ICACHE_SIZE, GET_ICACHE_LINE, 0,
+                up_invalidate_icache, "icache-invalidate");
 }
 
 /****************************************************************************
@@ -245,8 +235,37 @@ int main(int argc, FAR char *argv[])
       .alloc = 0
     };
 
+  struct bench_s bench;
+  char config[48];
+  int opt;
+
+  bench_init(&bench, "cachespeed");
+  bench.trials = REPEAT_NUM;
+
+  while ((opt = getopt(argc, argv, "h" BENCH_OPTSTRING)) != ERROR)
+    {
+      if (opt == 'h' || bench_option(&bench, opt, optarg) < 0)
+        {
+          printf("Usage: %s [options]\n", argv[0]);
+          bench_usage();
+          return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
   setup(&cs);
-  cachespeed_common(&cs);
+
+  /* Let's export the test message */
+
+  snprintf(config, sizeof(config), "address src: %" PRIxPTR, cs.addr);
+  if (bench_begin(&bench, config) < 0)
+    {
+      printf(CACHESPEED_PREFIX "Unable to allocate samples.\n");
+      teardown(&cs);
+      return EXIT_FAILURE;
+    }
+
+  cachespeed_common(&bench, &cs);
+  bench_end(&bench);
   teardown(&cs);
   return 0;
 }
@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <assert.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
 #include <sched.h>
@@ -38,6 +39,8 @@
 
 #include <nuttx/sched.h>
 
+#include "benchmarks/bench.h"
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -333,49 +336,42 @@ static void performance_help(void)
 {
   printf("Usage: performance [OPTIONS] [name]\n\n");
   printf("OPTIONS:\n");
-  printf("\t-c, \tNumber of times to run each test\n");
-  printf("\t-d, \tShow detail of each test\n");
+  printf("\t-c, \tNumber of times to run each test (same as -T)\n");
+  printf("\t-d, \tShow detail of each test (same as -D)\n");
   printf("\t-h, \tShow this help message\n");
   printf("\t-l, \tList all tests\n");
+  bench_usage();
 }
 
 /****************************************************************************
- * performance_run
+ * performance_trial
  ****************************************************************************/
 
-static void performance_run(const FAR struct performance_entry_s *item,
-                            size_t count, bool detail)
+static uint64_t performance_trial(FAR void *arg)
 {
-  size_t total = 0;
-  size_t max = 0;
-  size_t min = 0;
-  size_t i;
+  FAR const struct performance_entry_s *item = arg;
+  irq_t flags = enter_critical_section();
+  size_t time = item->entry();
+  leave_critical_section(flags);
 
-  for (i = 0; i < count; i++)
-    {
-      irq_t flags = enter_critical_section();
-      size_t time = item->entry();
-      leave_critical_section(flags);
+  return time;
+}
 
-      total += time;
-      if (time > max)
-        {
-          max = time;
-        }
+/****************************************************************************
+ * performance_run
+ ****************************************************************************/
 
-      if (time < min || min == 0)
-        {
-          min = time;
-        }
+static void performance_run(FAR struct bench_s *bench,
+                            const FAR struct performance_entry_s *item)
+{
+  struct bench_case_s bcase;
 
-      if (detail)
-        {
-          printf("\t%zu: %zu\n", i, time);
-        }
-    }
+  memset(&bcase, 0, sizeof(bcase));
+  bcase.name  = item->name;
+  bcase.trial = performance_trial;
+  bcase.arg   = (FAR void *)item;
 
-  printf("%-*s %10zu %10zu %10zu\n", NAME_MAX, item->name, max, min,
-         total / count);
+  bench_run(bench, &bcase, NULL);
 }
 
 /****************************************************************************
@@ -415,20 +411,28 @@ void performance_list(void)
 int main(int argc, FAR char *argv[])
 {
   const FAR struct performance_entry_s *item = NULL;
-  bool detail = false;
-  size_t count = 100;
+  struct bench_s bench;
   size_t i;
   int opt;
 
-  while ((opt = getopt(argc, argv, "dc:hl")) != -1)
+  bench_init(&bench, "osperf");
+  bench.trials = 100;
+
+  while ((opt = getopt(argc, argv, "dc:hl" BENCH_OPTSTRING)) != -1)
     {
       switch (opt)
         {
           case 'd':
-            detail = true;
+            bench.detail = true;
             break;
           case 'c':
-            count = strtoul(optarg, NULL, 0);
+            bench.trials = strtoul(optarg, NULL, 0);
+            if (bench.trials == 0)
+              {
+                performance_help();
+                return EXIT_FAILURE;
+              }
+
             break;
           case 'h':
             performance_help();
@@ -437,8 +441,13 @@ int main(int argc, FAR char *argv[])
             performance_list();
             return EXIT_SUCCESS;
           default:
-            performance_help();
-            return EXIT_FAILURE;
+            if (bench_option(&bench, opt, optarg) < 0)
+              {
+                performance_help();
+                return EXIT_FAILURE;
+              }
+
+            break;
         }
     }
 
@@ -452,23 +461,24 @@ int main(int argc, FAR char *argv[])
         }
     }
 
-  printf("OS performance args: count:%zu, detail:%s\n", count,
-         detail ? "true" : "false");
-
-  printf("==============================================================\n");
-  printf("%-*s %10s %10s %10s\n", NAME_MAX, "Describe", "Max", "Min", "Avg");
+  if (bench_begin(&bench, NULL) < 0)
+    {
+      printf("Failed to allocate %" PRIu32 " samples\n", bench.trials);
+      return EXIT_FAILURE;
+    }
 
   if (item != NULL)
     {
-      performance_run(item, count, detail);
-      return EXIT_SUCCESS;
+      performance_run(&bench, item);
     }
-
-  for (i = 0; i < nitems(g_entry_list); i++)
+  else
     {
-      item = &g_entry_list[i];
-      performance_run(item, count, detail);
+      for (i = 0; i < nitems(g_entry_list); i++)
+        {
+          performance_run(&bench, &g_entry_list[i]);
+        }
     }
 
+  bench_end(&bench);
   return EXIT_SUCCESS;
 }
@@ -32,6 +32,8 @@
 #include <unistd.h>
 #include <inttypes.h>
 
+#include "benchmarks/bench.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -78,6 +80,17 @@ struct ramspeed_s
   bool irq_disable;
 };
 
+struct ramspeed_trial_s
+{
+  FAR void *dest;
+  FAR const void *src;
+  size_t step;
+  uint8_t value;
+  uint32_t repeat_num;
+  bool irq_disable;
+  bool internal;
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -106,6 +119,7 @@ static void show_usage(FAR const char *progname, int exitcode)
          " [default value: 100].\n");
   printf("  -i turn off interrupts while testing"
          " [default value: false].\n");
+  bench_usage();
   exit(exitcode);
 }
 
@@ -114,7 +128,8 @@ static void show_usage(FAR const char *progname, int exitcode)
  ****************************************************************************/
 
 static void parse_commandline(int argc, FAR char **argv,
-                              FAR struct ramspeed_s *info)
+                              FAR struct ramspeed_s *info,
+                              FAR struct bench_s *bench)
 {
   int ch;
   bool allocate_rw_address = false;
@@ -128,7 +143,7 @@ static void parse_commandline(int argc, FAR char **argv,
       show_usage(argv[0], EXIT_FAILURE);
     }
 
-  while ((ch = getopt(argc, argv, "r:w:s:v:n:ia")) != ERROR)
+  while ((ch = getopt(argc, argv, "r:w:s:v:n:ia" BENCH_OPTSTRING)) != ERROR)
     {
       switch (ch)
         {
@@ -169,6 +184,15 @@ static void parse_commandline(int argc, FAR char **argv,
             printf(RAMSPEED_PREFIX "Unknown option: %c\n", (char)optopt);
             show_usage(argv[0], EXIT_FAILURE);
             break;
+          default:
+            if (bench_option(bench, ch, optarg) < 0)
+              {
+                printf(RAMSPEED_PREFIX "Parameter error: -%c %s\n", ch,
+                       optarg != NULL ? optarg : "");
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+
+            break;
         }
     }
 
@@ -185,42 +209,6 @@ static void parse_commandline(int argc, FAR char **argv,
     }
 }
 
-/****************************************************************************
- * Name: get_timestamp
- ****************************************************************************/
-
-static uint32_t get_timestamp(void)
-{
-  struct timespec ts;
-  uint32_t ms;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-  return ms;
-}
-
-/****************************************************************************
- * Name: get_time_elaps
- ****************************************************************************/
-
-static uint32_t get_time_elaps(uint32_t prev_time)
-{
-  uint32_t act_time = get_timestamp();
-
-  /* If there is no overflow in sys_time simple subtract */
-
-  if (act_time >= prev_time)
-    {
-      prev_time = act_time - prev_time;
-    }
-  else
-    {
-      prev_time = UINT32_MAX - prev_time + 1;
-      prev_time += act_time;
-    }
-
-  return prev_time;
-}
-
 /****************************************************************************
  * Name: internal_memcpy
  ****************************************************************************/
@@ -345,154 +333,132 @@ static void internal_memset(FAR void *dst, uint8_t v, size_t len)
 }
 
 /****************************************************************************
- * Name: print_rate
- ****************************************************************************/
-
-static void print_rate(FAR const char *name, uint64_t bytes,
-                       uint32_t cost_time)
-{
-  uint32_t rate;
-  if (cost_time == 0)
-    {
-      printf(RAMSPEED_PREFIX
-             "Time-consuming is too short,"
-             " please increase the <repeat number>\n");
-      return;
-    }
-
-  rate = bytes * 1000 / cost_time / 1024;
-  printf(RAMSPEED_PREFIX
-         "%s Rate = %" PRIu32 " KB/s\t[cost: %" PRIu32 "ms]\n",
-         name, rate, cost_time);
-}
-
-/****************************************************************************
- * Name: memcpy_speed_test
+ * Name: memcpy_trial
  ****************************************************************************/
 
-static void memcpy_speed_test(FAR void *dest, FAR const void *src,
-                              size_t size, uint32_t repeat_cnt,
-                              bool irq_disable)
+static uint64_t memcpy_trial(FAR void *arg)
 {
-  uint32_t start_time;
-  uint32_t cost_time_system;
-  uint32_t cost_time_internal;
-  uint32_t cnt;
-  uint32_t step;
-  uint64_t total_size;
+  FAR struct ramspeed_trial_s *t = arg;
   irqstate_t flags = 0;
+  clock_t start;
+  uint64_t cost;
+  uint32_t cnt;
 
-  printf("______memcpy performance______\n");
-
-  for (step = 32; step <= size; step <<= 1)
+  if (t->irq_disable)
     {
-      total_size = (uint64_t)step * (uint64_t)repeat_cnt;
-
-      if (step < 1024)
-        {
-          printf("______Perform %" PRIu32 " Bytes access ______\n", step);
-        }
-      else
-        {
-          printf("______Perform %" PRIu32  " KBytes access ______\n",
-                 step / 1024);
-        }
-
-      if (irq_disable)
-        {
-          flags = enter_critical_section();
-        }
+      flags = enter_critical_section();
+    }
 
-      start_time = get_timestamp();
+  start = bench_timestamp();
 
-      for (cnt = 0; cnt < repeat_cnt; cnt++)
+  if (t->internal)
+    {
+      for (cnt = 0; cnt < t->repeat_num; cnt++)
         {
-          memcpy(dest, src, step);
+          internal_memcpy(t->dest, t->src, t->step);
         }
-
-      cost_time_system = get_time_elaps(start_time);
-
-      start_time = get_timestamp();
-
-      for (cnt = 0; cnt < repeat_cnt; cnt++)
+    }
+  else
+    {
+      for (cnt = 0; cnt < t->repeat_num; cnt++)
         {
-          internal_memcpy(dest, src, step);
+          memcpy(t->dest, t->src, t->step);
         }
+    }
 
-      cost_time_internal = get_time_elaps(start_time);
-
-      if (irq_disable)
-        {
-          leave_critical_section(flags);
-        }
+  cost = bench_elapsed(start, bench_timestamp());
 
-      print_rate("system memcpy():\t", total_size, cost_time_system);
-      print_rate("internal memcpy():\t", total_size, cost_time_internal);
+  if (t->irq_disable)
+    {
+      leave_critical_section(flags);
     }
+
+  return cost;
 }
 
 /****************************************************************************
- * Name: memset_speed_test
+ * Name: memset_trial
  ****************************************************************************/
 
-static void memset_speed_test(FAR void *dest, uint8_t value,
-                              size_t size, uint32_t repeat_num,
-                              bool irq_disable)
+static uint64_t memset_trial(FAR void *arg)
 {
-  uint32_t start_time;
-  uint32_t cost_time_system;
-  uint32_t cost_time_internal;
-  uint32_t cnt;
-  uint32_t step;
-  uint64_t total_size;
+  FAR struct ramspeed_trial_s *t = arg;
   irqstate_t flags = 0;
+  clock_t start;
+  uint64_t cost;
+  uint32_t cnt;
 
-  printf("______memset performance______\n");
-
-  for (step = 32; step <= size; step <<= 1)
+  if (t->irq_disable)
     {
-      total_size = (uint64_t)step * (uint64_t)repeat_num;
+      flags = enter_critical_section();
+    }
 
-      if (step < 1024)
-        {
-          printf("______Perform %" PRIu32 " Bytes access______\n", step);
-        }
-      else
-        {
-          printf("______Perform %" PRIu32  " KBytes access______\n",
-                 step / 1024);
-        }
+  start = bench_timestamp();
 
-      if (irq_disable)
+  if (t->internal)
+    {
+      for (cnt = 0; cnt < t->repeat_num; cnt++)
         {
-          flags = enter_critical_section();
+          internal_memset(t->dest, t->value, t->step);
         }
-
-      start_time = get_timestamp();
-
-      for (cnt = 0; cnt < repeat_num; cnt++)
+    }
+  else
+    {
+      for (cnt = 0; cnt < t->repeat_num; cnt++)
         {
-          memset(dest, value, step);
+          memset(t->dest, t->value, t->step);
         }
+    }
 
-      cost_time_system = get_time_elaps(start_time);
+  cost = bench_elapsed(start, bench_timestamp());
 
-      start_time = get_timestamp();
+  if (t->irq_disable)
+    {
+      leave_critical_section(flags);
+    }
 
-      for (cnt = 0; cnt < repeat_num; cnt++)
-        {
-          internal_memset(dest, value, step);
-        }
+  return cost;
+}
+
+/****************************************************************************
+ * Name: speed_test
+ *
+ *   Run the system and the internal version of a trial for every power of
+ *   two size from 32 bytes up to the buffer size.
+ *
+ ****************************************************************************/
 
-      cost_time_internal = get_time_elaps(start_time);
+static void speed_test(FAR struct bench_s *bench,
+                       FAR const struct ramspeed_s *info,
+                       FAR const char *name, bench_trial_t trial)
+{
+  struct ramspeed_trial_s t;
+  struct bench_case_s bcase;
+  char casename[32];
+  int internal;
+
+  t.dest        = info->dest;
+  t.src         = info->src;
+  t.value       = info->value;
+  t.repeat_num  = info->repeat_num;
+  t.irq_disable = info->irq_disable;
+
+  bcase.name  = casename;
+  bcase.trial = trial;
+  bcase.arg   = &t;
+  bcase.ops   = info->repeat_num;
+
+  for (t.step = 32; t.step <= info->size; t.step <<= 1)
+    {
+      bcase.bytes = (uint64_t)t.step * info->repeat_num;
 
-      if (irq_disable)
+      for (internal = 0; internal < 2; internal++)
         {
-          leave_critical_section(flags);
+          t.internal = internal;
+          snprintf(casename, sizeof(casename), "%s-%s/%zu", name,
+                   internal ? "internal" : "system", t.step);
+          bench_run(bench, &bcase, NULL);
         }
-
-      print_rate("system memset():\t", total_size, cost_time_system);
-      print_rate("internal memset():\t", total_size, cost_time_internal);
     }
 }
 
@@ -507,16 +473,25 @@ static void memset_speed_test(FAR void *dest, uint8_t value,
 int main(int argc, FAR char *argv[])
 {
   struct ramspeed_s ramspeed;
+  struct bench_s bench;
+  char config[64];
 
-  parse_commandline(argc, argv, &ramspeed);
+  bench_init(&bench, "ramspeed");
+  parse_commandline(argc, argv, &ramspeed, &bench);
 
-  memcpy_speed_test(ramspeed.dest, ramspeed.src,
-                    ramspeed.size, ramspeed.repeat_num,
-                    ramspeed.irq_disable);
+  snprintf(config, sizeof(config), "size %zu, repeat %" PRIu32 ", irq %s",
+           ramspeed.size, ramspeed.repeat_num,
+           ramspeed.irq_disable ? "off" : "on");
+
+  if (bench_begin(&bench, config) < 0)
+    {
+      printf(RAMSPEED_PREFIX "Failed to allocate samples\n");
+      return EXIT_FAILURE;
+    }
 
-  memset_speed_test(ramspeed.dest, ramspeed.value,
-                    ramspeed.size, ramspeed.repeat_num,
-                    ramspeed.irq_disable);
+  speed_test(&bench, &ramspeed, "memcpy", memcpy_trial);
+  speed_test(&bench, &ramspeed, "memset", memset_trial);
 
+  bench_end(&bench);
   return EXIT_SUCCESS;
 }
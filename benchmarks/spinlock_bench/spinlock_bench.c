@@ -22,18 +22,31 @@
  * Included Files
  ****************************************************************************/
 
-#include <stdio.h>
+#include <nuttx/config.h>
+
 #include <assert.h>
 #include <errno.h>
-#include <nuttx/spinlock.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
+
+#include <nuttx/spinlock.h>
+
+#include "benchmarks/bench.h"
 
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define TEST_NUM CONFIG_SPINLOCK_MULTITHREAD
-#define THREAD_NUM CONFIG_SPINLOCK_MULTITHREAD
+#ifndef CONFIG_SPINLOCK_MULTITHREAD
+#  define CONFIG_SPINLOCK_MULTITHREAD 40
+#endif
+
+#ifndef CONFIG_SPINLOCK_ITERATIONS
+#  define CONFIG_SPINLOCK_ITERATIONS 100
+#endif
 
 /****************************************************************************
  * Private Types
@@ -43,6 +56,14 @@ struct thread_parmeter_s
 {
   FAR int *result;
   FAR spinlock_t *lock;
+  int iterations;
+};
+
+struct spinlock_trial_s
+{
+  FAR pthread_t *thread;
+  int nthreads;
+  int iterations;
 };
 
 /****************************************************************************
@@ -51,44 +72,46 @@ struct thread_parmeter_s
 
 static FAR void *thread_spinlock(FAR void *parameter)
 {
-  FAR int *result = ((FAR struct thread_parmeter_s *)parameter)->result;
-  FAR spinlock_t *lock = ((FAR struct thread_parmeter_s *)parameter)->lock;
-
+  FAR struct thread_parmeter_s *para = parameter;
   int i;
 
-  for (i = 0; i < TEST_NUM; i++)
+  for (i = 0; i < para->iterations; i++)
     {
-      spin_lock(lock);
-      (*result)++;
-      spin_unlock(lock);
+      spin_lock(para->lock);
+      (*para->result)++;
+      spin_unlock(para->lock);
     }
 
   return NULL;
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: spinlock_trial
+ *
+ *   Start the threads, let each of them take the lock the given number of
+ *   times and wait for all of them.  The time includes thread creation.
+ *
  ****************************************************************************/
 
-void main(void)
+static uint64_t spinlock_trial(FAR void *arg)
 {
+  FAR struct spinlock_trial_s *t = arg;
   spinlock_t lock = SP_UNLOCKED;
-  int result = 0;
-  pthread_t thread[THREAD_NUM];
   struct thread_parmeter_s para;
+  int result = 0;
   clock_t start;
   clock_t end;
-
   int status;
   int i;
 
-  para.result = &result;
-  para.lock = &lock;
+  para.result     = &result;
+  para.lock       = &lock;
+  para.iterations = t->iterations;
 
-  start = perf_gettime();
-  for (i = 0; i < THREAD_NUM; ++i)
+  start = bench_timestamp();
+  for (i = 0; i < t->nthreads; ++i)
     {
-      status = pthread_create(&thread[i], NULL,
+      status = pthread_create(&t->thread[i], NULL,
                               thread_spinlock, &para);
       if (status != 0)
         {
@@ -98,13 +121,125 @@ void main(void)
         }
     }
 
-  for (i = 0; i < THREAD_NUM; ++i)
+  for (i = 0; i < t->nthreads; ++i)
     {
-      pthread_join(thread[i], NULL);
+      pthread_join(t->thread[i], NULL);
     }
 
-  end = perf_gettime();
-  assert(result == THREAD_NUM * TEST_NUM);
+  end = bench_timestamp();
+  assert(result == t->nthreads * t->iterations);
+
+  return bench_elapsed(start, end);
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-t <threads>] [-i <iterations>] [-s]\n", progname);
+  printf("  -t <threads>     Number of threads [%d]\n",
+         CONFIG_SPINLOCK_MULTITHREAD);
+  printf("  -i <iterations>  Lock/unlock per thread [%d]\n",
+         CONFIG_SPINLOCK_ITERATIONS);
+  printf("  -s               Sweep 1, 2, 4, ... threads up to -t\n");
+  bench_usage();
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct spinlock_trial_s t;
+  struct bench_case_s bcase;
+  struct bench_s bench;
+  char casename[24];
+  char config[48];
+  bool sweep = false;
+  int nthreads = CONFIG_SPINLOCK_MULTITHREAD;
+  int opt;
+
+  bench_init(&bench, "spinlock_bench");
+  t.iterations = CONFIG_SPINLOCK_ITERATIONS;
+
+  while ((opt = getopt(argc, argv, "t:i:sh" BENCH_OPTSTRING)) != ERROR)
+    {
+      switch (opt)
+        {
+          case 't':
+            nthreads = atoi(optarg);
+            break;
+
+          case 'i':
+            t.iterations = atoi(optarg);
+            break;
+
+          case 's':
+            sweep = true;
+            break;
+
+          case 'h':
+            show_usage(argv[0]);
+            return EXIT_SUCCESS;
+
+          default:
+            if (bench_option(&bench, opt, optarg) < 0)
+              {
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+              }
+
+            break;
+        }
+    }
+
+  if (nthreads < 1 || t.iterations < 1)
+    {
+      show_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  t.thread = malloc(nthreads * sizeof(pthread_t));
+  if (t.thread == NULL)
+    {
+      printf("spinlock_test: ERROR no memory for %d threads\n", nthreads);
+      return EXIT_FAILURE;
+    }
+
+  snprintf(config, sizeof(config), "threads %d, iterations %d",
+           nthreads, t.iterations);
+  if (bench_begin(&bench, config) < 0)
+    {
+      free(t.thread);
+      return EXIT_FAILURE;
+    }
+
+  bcase.name  = casename;
+  bcase.trial = spinlock_trial;
+  bcase.arg   = &t;
+  bcase.bytes = 0;
+
+  for (t.nthreads = sweep ? 1 : nthreads; ; t.nthreads <<= 1)
+    {
+      if (t.nthreads > nthreads)
+        {
+          t.nthreads = nthreads;
+        }
+
+      snprintf(casename, sizeof(casename), "spinlock/%d", t.nthreads);
+      bcase.ops = t.nthreads * t.iterations;
+      bench_run(&bench, &bcase, NULL);
+
+      if (t.nthreads == nthreads)
+        {
+          break;
+        }
+    }
 
-  printf("total_time: %lu\n", end - start);
+  bench_end(&bench);
+  free(t.thread);
+  return EXIT_SUCCESS;
 }
@@ -25,10 +25,33 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PPP_IFNAME "ppp0"
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+typedef enum
+{
+  PPP_EVENT_LINK_NEW = 0,   /* RTM_NEWLINK */
+  PPP_EVENT_LINK_DEL,       /* RTM_DELLINK */
+  PPP_EVENT_ADDR_NEW,       /* RTM_NEWADDR */
+  PPP_EVENT_ADDR_DEL,       /* RTM_DELADDR */
+} ppp_event;
+
+/* Called from the PPP monitor task, not from the subscriber's task: the
+ * callback must not use file descriptors owned by the subscriber.
+ */
+
+typedef void (*ppp_event_cb_t)(ppp_event event, const char *ifname,
+                               void *arg);
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -38,4 +61,12 @@ int launch_pppd(char *tty, char *account, char *password, bool use_pap,
 int get_pppd_pid(void);
 int terminate_pppd(void);
 
+#ifdef CONFIG_CENTURYSYS_LIB_PPP_EVENT
+int ppp_monitor_start(void);
+int ppp_subscribe(ppp_event_cb_t cb, void *arg);
+int ppp_unsubscribe(ppp_event_cb_t cb, void *arg);
+int ppp_wait_up(int timeout);
+bool ppp_is_up(void);
+#endif
+
 #endif /* __APPS_CENTURYSYS_LIB_PPP_H */
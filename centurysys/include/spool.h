@@ -0,0 +1,92 @@
+/****************************************************************************
+ * apps/centurysys/include/spool.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_CENTURYSYS_LIB_SPOOL_H
+#define __APPS_CENTURYSYS_LIB_SPOOL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Records are appended to the open segment "seg-<seq>.dat".  A closed
+ * segment is renamed to "seg-<seq>.lzf" (LZF stream compressed) or
+ * "seg-<seq>.raw" and is waiting for upload.
+ *
+ * Upload protocol (one TCP session, two round trips):
+ *
+ *   C: "SPOOL1 <count>\n"
+ *   C: "<name> <size>\n"                  x count
+ *   S: "<offset>\n"                       x count  (bytes already stored)
+ *   C: <size - offset bytes of each file, back to back, in order>
+ *   S: "OK <n>\n"                         (first n files are committed)
+ *
+ * Committed files are removed from the spool directory.
+ */
+
+#define SPOOL_PROTO_MAGIC   "SPOOL1"
+#define SPOOL_RECORD_MAX    UINT16_MAX
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct spool_s
+{
+  char dir[PATH_MAX];
+  int fd;              /* Open segment */
+  uint32_t seq;        /* Sequence number of the open segment */
+  off_t size;          /* Open segment size, including buffered bytes */
+  off_t recend;        /* End of the last complete record */
+  off_t synced;        /* End of the last complete record in the file */
+  size_t buflen;       /* Bytes pending in buf */
+  bool full;           /* Too many segments, no new one is started */
+  uint8_t buf[CONFIG_CENTURYSYS_LIB_SPOOL_BUFSIZE];
+};
+
+struct spool_stat_s
+{
+  int segments;        /* Closed segments waiting for upload */
+  off_t pending;       /* Total size of closed segments */
+  off_t current;       /* Size of the open segment */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+int spool_open(struct spool_s *spool, const char *dir);
+int spool_append(struct spool_s *spool, const void *data, size_t len);
+int spool_flush(struct spool_s *spool);
+int spool_rotate(struct spool_s *spool);
+int spool_close(struct spool_s *spool);
+
+int spool_stat(const char *dir, struct spool_stat_s *st);
+int spool_upload(const char *dir, const char *host, const char *port);
+
+#endif /* __APPS_CENTURYSYS_LIB_SPOOL_H */
@@ -0,0 +1,82 @@
+/****************************************************************************
+ * apps/centurysys/include/stage.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_CENTURYSYS_LIB_STAGE_H
+#define __APPS_CENTURYSYS_LIB_STAGE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Up to 32 stages, dependencies are expressed as a bitmask of indices */
+
+#define STAGE_MAX          32
+#define STAGE_DEP(n)       (1ul << (n))
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+typedef enum
+{
+  STAGE_PENDING = 0,
+  STAGE_RUNNING,
+  STAGE_DONE,
+  STAGE_FAILED,
+  STAGE_SKIPPED,   /* One of the dependencies failed */
+} stage_state;
+
+typedef int (*stage_func_t)(void *arg);
+
+struct stage_s
+{
+  /* Filled by the caller */
+
+  const char *name;
+  stage_func_t func;
+  void *arg;
+  uint32_t depends;
+
+  /* Filled by stage_run() */
+
+  stage_state state;
+  int result;
+  struct timespec start;
+  struct timespec end;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+int stage_run(struct stage_s *stages, int nstages);
+void stage_report(struct stage_s *stages, int nstages, FILE *stream);
+unsigned long stage_elapsed_ms(const struct timespec *from,
+                               const struct timespec *to);
+
+#endif /* __APPS_CENTURYSYS_LIB_STAGE_H */
@@ -0,0 +1,107 @@
+/****************************************************************************
+ * apps/centurysys/include/wakeprof.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_CENTURYSYS_LIB_WAKEPROF_H
+#define __APPS_CENTURYSYS_LIB_WAKEPROF_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WAKEPROF_MAGIC      0x57505246  /* "WPRF" */
+#define WAKEPROF_VERSION    2
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+typedef enum
+{
+  WAKEPROF_SCHEDULE = 0,   /* get_next_schedule() */
+  WAKEPROF_I2C_RESET,      /* i2c_bus_reset() retry */
+  WAKEPROF_LTE_POWER,      /* LTE module power on */
+  WAKEPROF_PPP,            /* launch_pppd() until ppp0 has an address */
+  WAKEPROF_MOUNT,          /* mount_fs() */
+  WAKEPROF_UPLOAD,         /* Data upload */
+  WAKEPROF_WATCHDOG,       /* "timeout" expired */
+  WAKEPROF_POWERDOWN,      /* About to cut the power */
+  WAKEPROF_NPHASES
+} wakeprof_phase;
+
+typedef enum
+{
+  WAKEPROF_BEGIN = 0,
+  WAKEPROF_END,
+  WAKEPROF_MARK,           /* Single point in time */
+} wakeprof_event;
+
+/* Journal file layout: header followed by a ring of records.  The header
+ * is only written when a cycle starts.  The records of the current cycle
+ * are the run of slots from 'head' on that carry its cycle number.
+ */
+
+struct wakeprof_hdr_s
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t cycle;          /* Current wake cycle number, never 0 */
+  uint32_t capacity;       /* Number of record slots */
+  uint32_t head;           /* First slot of the current cycle */
+  uint32_t count;          /* Valid records before 'head' (<= capacity) */
+};
+
+struct wakeprof_rec_s
+{
+  uint32_t time;           /* RTC time (seconds since the epoch) */
+  uint32_t uptime;         /* Milliseconds since boot */
+  uint16_t cycle;          /* 0: unused slot */
+  uint8_t phase;           /* wakeprof_phase */
+  uint8_t event;           /* wakeprof_event */
+  int32_t value;           /* Result of the phase */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_CENTURYSYS_LIB_WAKEPROF
+int wakeprof_start(void);
+int wakeprof_record(wakeprof_phase phase, wakeprof_event event,
+                    int32_t value);
+const char *wakeprof_phase_name(int phase);
+
+#  define wakeprof_begin(p)    wakeprof_record(p, WAKEPROF_BEGIN, 0)
+#  define wakeprof_end(p, v)   wakeprof_record(p, WAKEPROF_END, v)
+#  define wakeprof_mark(p, v)  wakeprof_record(p, WAKEPROF_MARK, v)
+#else
+#  define wakeprof_start()
+#  define wakeprof_begin(p)
+#  define wakeprof_end(p, v)
+#  define wakeprof_mark(p, v)
+#endif
+
+#endif /* __APPS_CENTURYSYS_LIB_WAKEPROF_H */
@@ -24,11 +24,13 @@
 
 #include <nuttx/config.h>
 #include <stdio.h>
+#include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/mount.h>
 #include <debug.h>
 
 #include "libmount.h"
+#include "wakeprof.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -49,7 +51,13 @@
 int mount_fs(const char *source, const char *target, const char *fstype,
              unsigned long flags)
 {
-  return mount(source, target, fstype, flags, NULL);
+  int ret;
+
+  wakeprof_begin(WAKEPROF_MOUNT);
+  ret = mount(source, target, fstype, flags, NULL);
+  wakeprof_end(WAKEPROF_MOUNT, ret < 0 ? -errno : ret);
+
+  return ret;
 }
 
 int umount_fs(const char *target)
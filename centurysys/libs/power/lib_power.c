@@ -34,6 +34,7 @@
 
 #include "boardctl.h"
 #include "power.h"
+#include "wakeprof.h"
 
 #ifndef ARRAY_SIZE
 #  define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
@@ -144,6 +145,7 @@ int get_wakeup(uint32_t *sources)
 
 void board_powerdown(void)
 {
+  wakeprof_mark(WAKEPROF_POWERDOWN, 0);
   boardctl(BIOC_SHUTDOWN, (uintptr_t)0);
 }
 
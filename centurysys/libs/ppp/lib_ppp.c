@@ -32,6 +32,8 @@
 #include <nuttx/board.h>
 
 #include "pppd.h"
+#include "libppp.h"
+#include "wakeprof.h"
 
 /****************************************************************************
  * Private Data
@@ -107,6 +109,14 @@ int launch_pppd(char *tty, char *account, char *password, bool use_pap,
 #endif
   settings.persist = persist;
 
+#ifdef CONFIG_CENTURYSYS_LIB_PPP_EVENT
+  /* Make sure the ppp0 address event can not be missed by ppp_wait_up() */
+
+  ppp_monitor_start();
+#endif
+
+  wakeprof_begin(WAKEPROF_PPP);
+
   pid = task_create("pppd", 100, 4096, (main_t)spawn_pppd, NULL);
 
   usleep(USEC_PER_TICK);
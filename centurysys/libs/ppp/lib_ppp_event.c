@@ -0,0 +1,430 @@
+/****************************************************************************
+ * apps/centurysys/libs/ppp/lib_ppp_event.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netpacket/netlink.h>
+#include <debug.h>
+
+#include "netlib.h"
+#include "libppp.h"
+#include "wakeprof.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef enum
+{
+  MONITOR_STOPPED = 0,
+  MONITOR_STARTING,
+  MONITOR_RUNNING,
+} monitor_state;
+
+struct subscriber
+{
+  ppp_event_cb_t cb;
+  void *arg;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static monitor_state g_state = MONITOR_STOPPED;
+static bool g_ppp_up = false;
+static struct subscriber g_subscribers[CONFIG_CENTURYSYS_LIB_PPP_SUBSCRIBERS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int open_netlink(void)
+{
+  struct sockaddr_nl local;
+  int sockfd;
+
+  sockfd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
+
+  if (sockfd < 0)
+    {
+      _err("?? NETLINK socket not supported.\n");
+      return ERROR;
+    }
+
+  memset(&local, 0, sizeof(struct sockaddr_nl));
+  local.nl_family = AF_NETLINK;
+  local.nl_groups = RTMGRP_LINK | RTMGRP_NOTIFY | RTMGRP_IPV4_IFADDR;
+
+  if (bind(sockfd, (struct sockaddr *)&local,
+           sizeof(struct sockaddr_nl)) < 0)
+    {
+      close(sockfd);
+      return ERROR;
+    }
+
+  return sockfd;
+}
+
+static bool ppp_has_addr(void)
+{
+  struct in_addr addr;
+
+  return netlib_get_ipv4addr(PPP_IFNAME, &addr) == OK &&
+         addr.s_addr != INADDR_ANY;
+}
+
+static void dispatch_event(ppp_event event, const char *ifname)
+{
+  struct subscriber subs[CONFIG_CENTURYSYS_LIB_PPP_SUBSCRIBERS];
+  int i;
+
+  pthread_mutex_lock(&g_lock);
+
+  if (strcmp(ifname, PPP_IFNAME) == 0)
+    {
+      if (event == PPP_EVENT_ADDR_NEW)
+        {
+          _info("PPP up detected.\n");
+          g_ppp_up = true;
+          pthread_cond_broadcast(&g_cond);
+        }
+      else if (event == PPP_EVENT_ADDR_DEL || event == PPP_EVENT_LINK_DEL)
+        {
+          if (g_ppp_up)
+            {
+              _info("PPP down detected.\n");
+            }
+
+          g_ppp_up = false;
+        }
+    }
+
+  /* Callbacks are called without the lock so that they may (un)subscribe */
+
+  memcpy(subs, g_subscribers, sizeof(subs));
+  pthread_mutex_unlock(&g_lock);
+
+  if (event == PPP_EVENT_ADDR_NEW && strcmp(ifname, PPP_IFNAME) == 0)
+    {
+      wakeprof_end(WAKEPROF_PPP, 0);
+    }
+
+  for (i = 0; i < CONFIG_CENTURYSYS_LIB_PPP_SUBSCRIBERS; i++)
+    {
+      if (subs[i].cb)
+        {
+          subs[i].cb(event, ifname, subs[i].arg);
+        }
+    }
+}
+
+static void handle_event(struct nlmsghdr *hdr)
+{
+  char ifname[IFNAMSIZ];
+  struct ifinfomsg *ifi;
+  struct ifaddrmsg *ifa;
+  unsigned int index;
+  ppp_event event;
+
+  switch (hdr->nlmsg_type)
+    {
+      case RTM_NEWLINK:
+      case RTM_DELLINK:
+        ifi = NLMSG_DATA(hdr);
+        index = ifi->ifi_index;
+        event = hdr->nlmsg_type == RTM_NEWLINK ?
+                PPP_EVENT_LINK_NEW : PPP_EVENT_LINK_DEL;
+        break;
+
+      case RTM_NEWADDR:
+      case RTM_DELADDR:
+        ifa = NLMSG_DATA(hdr);
+        index = ifa->ifa_index;
+        event = hdr->nlmsg_type == RTM_NEWADDR ?
+                PPP_EVENT_ADDR_NEW : PPP_EVENT_ADDR_DEL;
+        break;
+
+      default:
+        return;
+    }
+
+  if (if_indextoname(index, ifname) == NULL)
+    {
+      return;
+    }
+
+  dispatch_event(event, ifname);
+}
+
+static int ppp_monitor(int argc, char **argv)
+{
+  struct nlmsghdr *hdr;
+  char buf[1024];
+  int sockfd;
+  int len;
+
+  sockfd = open_netlink();
+
+  /* The socket is bound before anybody is released from
+   * ppp_monitor_start(), so no event after that point can be lost.
+   */
+
+  pthread_mutex_lock(&g_lock);
+  g_state = sockfd < 0 ? MONITOR_STOPPED : MONITOR_RUNNING;
+  g_ppp_up = sockfd < 0 ? false : ppp_has_addr();
+  pthread_cond_broadcast(&g_cond);
+  pthread_mutex_unlock(&g_lock);
+
+  if (sockfd < 0)
+    {
+      return ERROR;
+    }
+
+  _info("PPP monitor started.\n");
+
+  for (; ; )
+    {
+      len = recv(sockfd, buf, sizeof(buf), 0);
+
+      if (len < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          break;
+        }
+
+      for (hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, len);
+           hdr = NLMSG_NEXT(hdr, len))
+        {
+          handle_event(hdr);
+        }
+    }
+
+  _err("PPP monitor stopped (%d).\n", errno);
+
+  pthread_mutex_lock(&g_lock);
+  g_state = MONITOR_STOPPED;
+  pthread_cond_broadcast(&g_cond);
+  pthread_mutex_unlock(&g_lock);
+
+  close(sockfd);
+  return ERROR;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ppp_monitor_start
+ *
+ * Description:
+ *   Start the shared NETLINK monitor task if it is not running yet.  It is
+ *   started implicitly by launch_pppd(), ppp_subscribe() and ppp_wait_up().
+ *
+ ****************************************************************************/
+
+int ppp_monitor_start(void)
+{
+  int ret = OK;
+  int pid;
+
+  pthread_mutex_lock(&g_lock);
+
+  if (g_state == MONITOR_STOPPED)
+    {
+      g_state = MONITOR_STARTING;
+
+      pid = task_create("ppp_monitor",
+                        CONFIG_CENTURYSYS_LIB_PPP_MONITOR_PRIORITY,
+                        CONFIG_CENTURYSYS_LIB_PPP_MONITOR_STACKSIZE,
+                        (main_t)ppp_monitor, NULL);
+
+      if (pid < 0)
+        {
+          g_state = MONITOR_STOPPED;
+          pthread_mutex_unlock(&g_lock);
+          return -errno;
+        }
+    }
+
+  while (g_state == MONITOR_STARTING)
+    {
+      pthread_cond_wait(&g_cond, &g_lock);
+    }
+
+  if (g_state != MONITOR_RUNNING)
+    {
+      ret = -ENOTSUP;
+    }
+
+  pthread_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ppp_subscribe
+ *
+ * Description:
+ *   Register a callback for every link/address event (of all interfaces).
+ *
+ ****************************************************************************/
+
+int ppp_subscribe(ppp_event_cb_t cb, void *arg)
+{
+  int ret;
+  int i;
+
+  if (!cb)
+    {
+      return -EINVAL;
+    }
+
+  ret = ppp_monitor_start();
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = -ENOSPC;
+  pthread_mutex_lock(&g_lock);
+
+  for (i = 0; i < CONFIG_CENTURYSYS_LIB_PPP_SUBSCRIBERS; i++)
+    {
+      if (g_subscribers[i].cb == NULL)
+        {
+          g_subscribers[i].cb = cb;
+          g_subscribers[i].arg = arg;
+          ret = OK;
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+int ppp_unsubscribe(ppp_event_cb_t cb, void *arg)
+{
+  int ret = -ENOENT;
+  int i;
+
+  pthread_mutex_lock(&g_lock);
+
+  for (i = 0; i < CONFIG_CENTURYSYS_LIB_PPP_SUBSCRIBERS; i++)
+    {
+      if (g_subscribers[i].cb == cb && g_subscribers[i].arg == arg)
+        {
+          g_subscribers[i].cb = NULL;
+          g_subscribers[i].arg = NULL;
+          ret = OK;
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ppp_wait_up
+ *
+ * Description:
+ *   Block until ppp0 has an IPv4 address.
+ *
+ * Input Parameters:
+ *   timeout - Maximum time to wait in milliseconds, negative to wait
+ *             forever, zero to only check the current state.
+ *
+ * Returned Value:
+ *   OK if ppp0 is up, -ETIMEDOUT otherwise.
+ *
+ ****************************************************************************/
+
+int ppp_wait_up(int timeout)
+{
+  struct timespec abstime;
+  int ret;
+
+  ret = ppp_monitor_start();
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  clock_gettime(CLOCK_REALTIME, &abstime);
+  abstime.tv_sec += timeout / MSEC_PER_SEC;
+  abstime.tv_nsec += (timeout % MSEC_PER_SEC) * NSEC_PER_MSEC;
+
+  if (abstime.tv_nsec >= NSEC_PER_SEC)
+    {
+      abstime.tv_sec++;
+      abstime.tv_nsec -= NSEC_PER_SEC;
+    }
+
+  pthread_mutex_lock(&g_lock);
+
+  while (!g_ppp_up && g_state == MONITOR_RUNNING && timeout != 0)
+    {
+      if (timeout < 0)
+        {
+          pthread_cond_wait(&g_cond, &g_lock);
+        }
+      else if (pthread_cond_timedwait(&g_cond, &g_lock, &abstime) ==
+               ETIMEDOUT)
+        {
+          break;
+        }
+    }
+
+  ret = g_ppp_up ? OK : -ETIMEDOUT;
+  pthread_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+bool ppp_is_up(void)
+{
+  bool up;
+
+  pthread_mutex_lock(&g_lock);
+  up = g_ppp_up;
+  pthread_mutex_unlock(&g_lock);
+
+  return up;
+}
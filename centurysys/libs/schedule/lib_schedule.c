@@ -33,6 +33,7 @@
 #include <nuttx/board.h>
 
 #include "schedule.h"
+#include "wakeprof.h"
 
 #define MAX_TIME_STRING 80
 
@@ -74,6 +75,7 @@ static int i2c_bus_reset(int bus)
     }
 
   ret = ioctl(fd, I2CIOC_RESET, 0);
+  wakeprof_mark(WAKEPROF_I2C_RESET, ret);
 
   result_txt = ret >= 0 ? "succeed" : "fail";
   sprintf(msg, "reset I2C-bus %sed\n", result_txt);
@@ -102,11 +104,14 @@ int get_next_schedule(time_t interval, time_t minimum_diff,
       return -EFAULT;
     }
 
+  wakeprof_begin(WAKEPROF_SCHEDULE);
+
 retry:
   fd = open("/dev/rtc0", O_RDONLY);
   if (fd < 0)
     {
       printf("open RTC failed!, %s\n", strerror(errno));
+      wakeprof_end(WAKEPROF_SCHEDULE, -ENODEV);
       return -ENODEV;
     }
 
@@ -126,6 +131,7 @@ retry:
           goto retry;
         }
 
+      wakeprof_end(WAKEPROF_SCHEDULE, ret);
       return ret;
     }
 
@@ -146,5 +152,6 @@ retry:
 
   close(fd);
 
+  wakeprof_end(WAKEPROF_SCHEDULE, ret);
   return ret;
 }
@@ -0,0 +1,1079 @@
+/****************************************************************************
+ * apps/centurysys/libs/spool/lib_spool.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <debug.h>
+
+#include <nuttx/streams.h>
+
+#include "spool.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define SEG_PREFIX   "seg-"
+#define SEG_OPEN     "dat"
+#ifdef CONFIG_CENTURYSYS_LIB_SPOOL_COMPRESSION
+#  define SEG_CLOSED "lzf"
+#else
+#  define SEG_CLOSED "raw"
+#endif
+#define SEG_TMP      SEG_CLOSED ".tmp"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct seg_entry
+{
+  uint32_t seq;
+  bool closed;
+  off_t size;
+};
+
+struct seg_list
+{
+  int count;
+  int overflow;        /* Segments left out because the list was full */
+  uint32_t maxseq;
+  struct seg_entry entry[CONFIG_CENTURYSYS_LIB_SPOOL_MAXSEGS];
+};
+
+struct line_reader
+{
+  int sockfd;
+  size_t pos;
+  size_t len;
+  char buf[64];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void seg_path(char *path, const char *dir, uint32_t seq,
+                     const char *ext)
+{
+  snprintf(path, PATH_MAX, "%s/" SEG_PREFIX "%08" PRIu32 ".%s",
+           dir, seq, ext);
+}
+
+/****************************************************************************
+ * Name: seg_parse
+ *
+ * Description:
+ *   Parse a segment file name.  Returns the extension following
+ *   "seg-<seq>." or NULL if 'name' is not a segment file.
+ *
+ ****************************************************************************/
+
+static const char *seg_parse(const char *name, uint32_t *seq)
+{
+  int n = 0;
+
+  if (sscanf(name, SEG_PREFIX "%" SCNu32 ".%n", seq, &n) != 1 || n == 0)
+    {
+      return NULL;
+    }
+
+  return name + n;
+}
+
+static int seg_compare(const void *a, const void *b)
+{
+  const struct seg_entry *ea = a;
+  const struct seg_entry *eb = b;
+
+  return ea->seq < eb->seq ? -1 : ea->seq > eb->seq ? 1 : 0;
+}
+
+/****************************************************************************
+ * Name: seg_scan
+ *
+ * Description:
+ *   Collect the segments in 'dir', sorted by sequence number.  If there
+ *   are more than CONFIG_CENTURYSYS_LIB_SPOOL_MAXSEGS, the oldest ones are
+ *   kept so that they are uploaded first.
+ *
+ ****************************************************************************/
+
+static int seg_scan(const char *dir, struct seg_list *list)
+{
+  char path[PATH_MAX];
+  struct dirent *entry;
+  struct stat st;
+  const char *ext;
+  uint32_t seq;
+  bool closed;
+  DIR *dirp;
+  int i;
+
+  memset(list, 0, sizeof(struct seg_list));
+
+  dirp = opendir(dir);
+  if (dirp == NULL)
+    {
+      return -errno;
+    }
+
+  while ((entry = readdir(dirp)) != NULL)
+    {
+      struct seg_entry *seg;
+
+      ext = seg_parse(entry->d_name, &seq);
+      if (ext == NULL)
+        {
+          continue;
+        }
+
+      if (strcmp(ext, SEG_CLOSED) == 0)
+        {
+          closed = true;
+        }
+      else if (strcmp(ext, SEG_OPEN) == 0)
+        {
+          closed = false;
+        }
+      else
+        {
+          continue;
+        }
+
+      if (seq > list->maxseq)
+        {
+          list->maxseq = seq;
+        }
+
+      if (list->count < CONFIG_CENTURYSYS_LIB_SPOOL_MAXSEGS)
+        {
+          seg = &list->entry[list->count++];
+        }
+      else
+        {
+          /* Full: replace the newest segment if this one is older */
+
+          seg = &list->entry[0];
+          for (i = 1; i < list->count; i++)
+            {
+              if (list->entry[i].seq > seg->seq)
+                {
+                  seg = &list->entry[i];
+                }
+            }
+
+          list->overflow++;
+          if (seg->seq < seq)
+            {
+              continue;
+            }
+        }
+
+      seg->seq    = seq;
+      seg->closed = closed;
+
+      seg_path(path, dir, seq, ext);
+      seg->size = stat(path, &st) < 0 ? 0 : st.st_size;
+    }
+
+  closedir(dirp);
+
+  qsort(list->entry, list->count, sizeof(struct seg_entry), seg_compare);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: seg_cleanup
+ *
+ * Description:
+ *   Remove the temporary files that a power loss in seg_seal() leaves
+ *   behind.  The directory is read again after every removal, entries
+ *   removed while a directory is read may make readdir() skip others.
+ *
+ ****************************************************************************/
+
+static void seg_cleanup(const char *dir)
+{
+  char path[PATH_MAX];
+  struct dirent *entry;
+  const char *ext;
+  uint32_t seq;
+  bool found;
+  DIR *dirp;
+
+  do
+    {
+      found = false;
+
+      dirp = opendir(dir);
+      if (dirp == NULL)
+        {
+          return;
+        }
+
+      while ((entry = readdir(dirp)) != NULL)
+        {
+          ext = seg_parse(entry->d_name, &seq);
+          if (ext != NULL && strcmp(ext, SEG_TMP) == 0)
+            {
+              found = true;
+              break;
+            }
+        }
+
+      closedir(dirp);
+
+      if (found)
+        {
+          seg_path(path, dir, seq, SEG_TMP);
+          if (unlink(path) < 0)
+            {
+              _err("removing %s failed: %d\n", path, errno);
+              return;
+            }
+        }
+    }
+  while (found);
+}
+
+/****************************************************************************
+ * Name: seg_recover
+ *
+ * Description:
+ *   Return the end of the last complete record in the open segment 'fd'
+ *   of 'size' bytes.  A power loss may have cut the last record short.
+ *
+ ****************************************************************************/
+
+static off_t seg_recover(int fd, off_t size)
+{
+  uint8_t hdr[2];
+  off_t pos = 0;
+  off_t next;
+
+  while (pos + (off_t)sizeof(hdr) <= size)
+    {
+      if (pread(fd, hdr, sizeof(hdr), pos) != sizeof(hdr))
+        {
+          break;
+        }
+
+      next = pos + sizeof(hdr) + (hdr[0] | (hdr[1] << 8));
+      if (next > size)
+        {
+          break;
+        }
+
+      pos = next;
+    }
+
+  return pos;
+}
+
+/****************************************************************************
+ * Name: seg_seal
+ *
+ * Description:
+ *   Turn the open segment 'seq' into a closed one, compressing it with the
+ *   LZF stream if enabled.  On failure the open segment is kept as it is.
+ *
+ ****************************************************************************/
+
+static int seg_seal(const char *dir, uint32_t seq)
+{
+  char src[PATH_MAX];
+  char dst[PATH_MAX];
+  struct stat st;
+#ifdef CONFIG_CENTURYSYS_LIB_SPOOL_COMPRESSION
+  struct lib_lzfoutstream_s *lstream;
+  struct lib_rawoutstream_s *rstream;
+  char tmp[PATH_MAX];
+  ssize_t nread;
+  uint8_t *buf;
+  int infd;
+  int outfd;
+#endif
+  int ret = OK;
+
+  seg_path(src, dir, seq, SEG_OPEN);
+  seg_path(dst, dir, seq, SEG_CLOSED);
+
+  if (stat(src, &st) < 0)
+    {
+      return -errno;
+    }
+
+  if (st.st_size == 0)
+    {
+      unlink(src);
+      return OK;
+    }
+
+#ifdef CONFIG_CENTURYSYS_LIB_SPOOL_COMPRESSION
+  seg_path(tmp, dir, seq, SEG_TMP);
+
+  lstream = malloc(sizeof(*lstream) + sizeof(*rstream) +
+                   CONFIG_CENTURYSYS_LIB_SPOOL_BUFSIZE);
+  if (lstream == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  rstream = (struct lib_rawoutstream_s *)(lstream + 1);
+  buf = (uint8_t *)(rstream + 1);
+
+  infd = open(src, O_RDONLY);
+  if (infd < 0)
+    {
+      ret = -errno;
+      goto errout_with_mem;
+    }
+
+  outfd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (outfd < 0)
+    {
+      ret = -errno;
+      goto errout_with_infd;
+    }
+
+  lib_rawoutstream(rstream, outfd);
+  lib_lzfoutstream(lstream, (struct lib_outstream_s *)rstream);
+
+  while ((nread = read(infd, buf,
+                       CONFIG_CENTURYSYS_LIB_SPOOL_BUFSIZE)) > 0)
+    {
+      lib_stream_puts(lstream, buf, nread);
+    }
+
+  if (nread < 0)
+    {
+      ret = -errno;
+    }
+
+  lib_stream_flush(lstream);
+
+  if (fsync(outfd) < 0 && ret == OK)
+    {
+      ret = -errno;
+    }
+
+  close(outfd);
+
+  if (ret == OK && rename(tmp, dst) < 0)
+    {
+      ret = -errno;
+    }
+
+  if (ret < 0)
+    {
+      unlink(tmp);
+    }
+
+errout_with_infd:
+  close(infd);
+errout_with_mem:
+  free(lstream);
+
+  if (ret == OK)
+    {
+      unlink(src);
+    }
+#else
+  if (rename(src, dst) < 0)
+    {
+      ret = -errno;
+    }
+#endif
+
+  if (ret < 0)
+    {
+      _err("sealing segment %" PRIu32 " failed: %d\n", seq, ret);
+    }
+
+  return ret;
+}
+
+static int spool_write(struct spool_s *spool, const void *data, size_t len)
+{
+  const uint8_t *ptr = data;
+  size_t chunk;
+  int ret;
+
+  while (len > 0)
+    {
+      chunk = sizeof(spool->buf) - spool->buflen;
+      if (chunk > len)
+        {
+          chunk = len;
+        }
+
+      memcpy(&spool->buf[spool->buflen], ptr, chunk);
+      spool->buflen += chunk;
+      spool->size += chunk;
+      ptr += chunk;
+      len -= chunk;
+
+      /* Write only whole buffers to flash */
+
+      if (spool->buflen == sizeof(spool->buf))
+        {
+          ret = spool_flush(spool);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
+static int spool_new_segment(struct spool_s *spool)
+{
+  char path[PATH_MAX];
+  off_t size;
+
+  if (spool->full)
+    {
+      return -ENOSPC;
+    }
+
+  seg_path(path, spool->dir, spool->seq, SEG_OPEN);
+
+  spool->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0666);
+  if (spool->fd < 0)
+    {
+      return -errno;
+    }
+
+  size = lseek(spool->fd, 0, SEEK_END);
+  if (size < 0)
+    {
+      size = 0;
+    }
+
+  /* Drop a record that a power loss cut short */
+
+  spool->size = seg_recover(spool->fd, size);
+  if (spool->size < size && ftruncate(spool->fd, spool->size) < 0)
+    {
+      _err("truncating segment %" PRIu32 " failed: %d\n",
+           spool->seq, errno);
+    }
+
+  spool->recend = spool->size;
+  spool->synced = spool->size;
+  return OK;
+}
+
+static int line_read(struct line_reader *rd, char *line, size_t size)
+{
+  size_t n = 0;
+  ssize_t nrecv;
+
+  for (; ; )
+    {
+      if (rd->pos == rd->len)
+        {
+          nrecv = recv(rd->sockfd, rd->buf, sizeof(rd->buf), 0);
+          if (nrecv <= 0)
+            {
+              return nrecv < 0 ? -errno : -ECONNRESET;
+            }
+
+          rd->pos = 0;
+          rd->len = nrecv;
+        }
+
+      if (rd->buf[rd->pos] == '\n')
+        {
+          rd->pos++;
+          line[n] = '\0';
+          return OK;
+        }
+
+      if (n + 1 < size)
+        {
+          line[n++] = rd->buf[rd->pos];
+        }
+
+      rd->pos++;
+    }
+}
+
+static int send_all(int sockfd, const void *data, size_t len)
+{
+  const uint8_t *ptr = data;
+  ssize_t nsent;
+
+  while (len > 0)
+    {
+      nsent = send(sockfd, ptr, len, 0);
+      if (nsent < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      ptr += nsent;
+      len -= nsent;
+    }
+
+  return OK;
+}
+
+static int send_file(int sockfd, const char *path, off_t offset, off_t size)
+{
+  uint8_t buf[CONFIG_CENTURYSYS_LIB_SPOOL_BUFSIZE];
+  ssize_t nread;
+  int ret = OK;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (lseek(fd, offset, SEEK_SET) < 0)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  while (offset < size)
+    {
+      nread = read(fd, buf, sizeof(buf));
+      if (nread <= 0)
+        {
+          ret = nread < 0 ? -errno : -EIO;
+          break;
+        }
+
+      if (nread > size - offset)
+        {
+          nread = size - offset;
+        }
+
+      ret = send_all(sockfd, buf, nread);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      offset += nread;
+    }
+
+out:
+  close(fd);
+  return ret;
+}
+
+static int tcp_connect(const char *host, const char *port)
+{
+  struct addrinfo hints;
+  struct addrinfo *res;
+  struct addrinfo *ai;
+  int sockfd = -ENOTCONN;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+      return -EHOSTUNREACH;
+    }
+
+  for (ai = res; ai != NULL; ai = ai->ai_next)
+    {
+      sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (sockfd < 0)
+        {
+          sockfd = -errno;
+          continue;
+        }
+
+      if (connect(sockfd, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+          break;
+        }
+
+      close(sockfd);
+      sockfd = -errno;
+    }
+
+  freeaddrinfo(res);
+
+  return sockfd;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spool_open
+ *
+ * Description:
+ *   Open the spool in 'dir' (created if needed).  Records are appended to
+ *   the newest open segment left by the previous wake-up; older open
+ *   segments (interrupted by power loss) are sealed.
+ *
+ ****************************************************************************/
+
+int spool_open(struct spool_s *spool, const char *dir)
+{
+  struct seg_list *list;
+  int ret;
+  int i;
+
+  if (!spool || !dir)
+    {
+      return -EINVAL;
+    }
+
+  memset(spool, 0, sizeof(struct spool_s));
+  strlcpy(spool->dir, dir, sizeof(spool->dir));
+  spool->fd = -1;
+
+  if (mkdir(dir, 0777) < 0 && errno != EEXIST)
+    {
+      return -errno;
+    }
+
+  list = malloc(sizeof(struct seg_list));
+  if (list == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  seg_cleanup(dir);
+
+  ret = seg_scan(dir, list);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  spool->seq  = list->maxseq + 1;
+  spool->full = list->overflow > 0;
+
+  for (i = 0; i < list->count; i++)
+    {
+      if (list->entry[i].closed)
+        {
+          continue;
+        }
+
+      if (!spool->full && list->entry[i].seq == list->maxseq &&
+          list->entry[i].size < CONFIG_CENTURYSYS_LIB_SPOOL_SEGSIZE)
+        {
+          spool->seq = list->maxseq;
+        }
+      else
+        {
+          seg_seal(dir, list->entry[i].seq);
+        }
+    }
+
+  /* While the spool holds more segments than can be handled at once, every
+   * open segment is sealed and no new one is started, so appending fails
+   * with -ENOSPC.  Rotating and uploading still work and drain the spool;
+   * the segments left out are picked up once the older ones are gone.
+   */
+
+  if (spool->full)
+    {
+      _err("spool full: %d segments left out\n", list->overflow);
+      ret = OK;
+      goto out;
+    }
+
+  ret = spool_new_segment(spool);
+
+out:
+  free(list);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: spool_append
+ *
+ * Description:
+ *   Append one record (16-bit little endian length followed by the data).
+ *   The segment is rotated when it would exceed the segment size.
+ *
+ ****************************************************************************/
+
+int spool_append(struct spool_s *spool, const void *data, size_t len)
+{
+  uint8_t hdr[2];
+  int ret;
+
+  if (!spool || (!data && len > 0) || len > SPOOL_RECORD_MAX)
+    {
+      return -EINVAL;
+    }
+
+  if (spool->size > 0 &&
+      spool->size + sizeof(hdr) + len > CONFIG_CENTURYSYS_LIB_SPOOL_SEGSIZE)
+    {
+      ret = spool_rotate(spool);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (spool->fd < 0)
+    {
+      ret = spool_new_segment(spool);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  hdr[0] = len & 0xff;
+  hdr[1] = (len >> 8) & 0xff;
+
+  ret = spool_write(spool, hdr, sizeof(hdr));
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = spool_write(spool, data, len);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  spool->recend = spool->size;
+  return OK;
+}
+
+int spool_flush(struct spool_s *spool)
+{
+  ssize_t nwritten;
+  size_t offset = 0;
+  int ret;
+
+  if (!spool || spool->fd < 0)
+    {
+      return OK;
+    }
+
+  while (offset < spool->buflen)
+    {
+      nwritten = write(spool->fd, &spool->buf[offset],
+                       spool->buflen - offset);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          /* Drop what could not be written and cut the file back to the
+           * last record that was written completely.
+           */
+
+          ret = -errno;
+          if (ftruncate(spool->fd, spool->synced) < 0)
+            {
+              _err("truncating segment %" PRIu32 " failed: %d\n",
+                   spool->seq, errno);
+            }
+
+          spool->size   = spool->synced;
+          spool->recend = spool->synced;
+          spool->buflen = 0;
+          return ret;
+        }
+
+      offset += nwritten;
+    }
+
+  /* Everything up to the end of the last complete record is in the file */
+
+  spool->synced = spool->recend;
+  spool->buflen = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: spool_rotate
+ *
+ * Description:
+ *   Close the open segment and make it ready for upload.  The next record
+ *   starts a new segment.
+ *
+ ****************************************************************************/
+
+int spool_rotate(struct spool_s *spool)
+{
+  int ret;
+
+  if (!spool)
+    {
+      return -EINVAL;
+    }
+
+  if (spool->fd < 0)
+    {
+      return OK;
+    }
+
+  ret = spool_flush(spool);
+  close(spool->fd);
+  spool->fd = -1;
+
+  if (ret == OK)
+    {
+      ret = seg_seal(spool->dir, spool->seq);
+    }
+
+  spool->seq++;
+  spool->size = 0;
+
+  return ret;
+}
+
+int spool_close(struct spool_s *spool)
+{
+  int ret;
+
+  if (!spool || spool->fd < 0)
+    {
+      return OK;
+    }
+
+  ret = spool_flush(spool);
+  fsync(spool->fd);
+  close(spool->fd);
+  spool->fd = -1;
+
+  return ret;
+}
+
+int spool_stat(const char *dir, struct spool_stat_s *st)
+{
+  struct seg_list *list;
+  int ret;
+  int i;
+
+  if (!dir || !st)
+    {
+      return -EINVAL;
+    }
+
+  list = malloc(sizeof(struct seg_list));
+  if (list == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memset(st, 0, sizeof(struct spool_stat_s));
+
+  ret = seg_scan(dir, list);
+
+  for (i = 0; ret == OK && i < list->count; i++)
+    {
+      if (list->entry[i].closed)
+        {
+          st->segments++;
+          st->pending += list->entry[i].size;
+        }
+      else
+        {
+          st->current += list->entry[i].size;
+        }
+    }
+
+  free(list);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: spool_upload
+ *
+ * Description:
+ *   Upload all closed segments in one TCP session.  All headers are sent
+ *   first and the server answers with the resume offset of every file, so
+ *   the data of all segments is streamed without any further round trip.
+ *
+ * Returned Value:
+ *   Number of segments committed by the server, or a negated errno.
+ *
+ ****************************************************************************/
+
+int spool_upload(const char *dir, const char *host, const char *port)
+{
+  off_t offset[CONFIG_CENTURYSYS_LIB_SPOOL_MAXSEGS];
+  struct line_reader *rd;
+  struct seg_list *list;
+  char path[PATH_MAX];
+  char line[64];
+  int nfiles = 0;
+  int sockfd;
+  int ret;
+  int len;
+  int i;
+
+  if (!dir || !host || !port)
+    {
+      return -EINVAL;
+    }
+
+  list = malloc(sizeof(struct seg_list) + sizeof(struct line_reader));
+  if (list == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  rd = (struct line_reader *)(list + 1);
+
+  ret = seg_scan(dir, list);
+  if (ret < 0)
+    {
+      goto errout_with_mem;
+    }
+
+  /* Keep only the closed segments */
+
+  for (i = 0; i < list->count; i++)
+    {
+      if (list->entry[i].closed)
+        {
+          list->entry[nfiles++] = list->entry[i];
+        }
+    }
+
+  if (nfiles == 0)
+    {
+      ret = 0;
+      goto errout_with_mem;
+    }
+
+  sockfd = tcp_connect(host, port);
+  if (sockfd < 0)
+    {
+      ret = sockfd;
+      goto errout_with_mem;
+    }
+
+  memset(rd, 0, sizeof(struct line_reader));
+  rd->sockfd = sockfd;
+
+  len = snprintf(line, sizeof(line), SPOOL_PROTO_MAGIC " %d\n", nfiles);
+  ret = send_all(sockfd, line, len);
+
+  for (i = 0; ret == OK && i < nfiles; i++)
+    {
+      len = snprintf(line, sizeof(line),
+                     SEG_PREFIX "%08" PRIu32 "." SEG_CLOSED " %lld\n",
+                     list->entry[i].seq, (long long)list->entry[i].size);
+      ret = send_all(sockfd, line, len);
+    }
+
+  /* Resume offsets */
+
+  for (i = 0; ret == OK && i < nfiles; i++)
+    {
+      ret = line_read(rd, line, sizeof(line));
+      if (ret < 0)
+        {
+          break;
+        }
+
+      offset[i] = strtoll(line, NULL, 10);
+      if (offset[i] < 0 || offset[i] > list->entry[i].size)
+        {
+          offset[i] = 0;
+        }
+    }
+
+  /* Stream all remaining data back to back */
+
+  for (i = 0; ret == OK && i < nfiles; i++)
+    {
+      seg_path(path, dir, list->entry[i].seq, SEG_CLOSED);
+      ret = send_file(sockfd, path, offset[i], list->entry[i].size);
+    }
+
+  if (ret == OK)
+    {
+      ret = line_read(rd, line, sizeof(line));
+    }
+
+  if (ret == OK)
+    {
+      int committed = 0;
+
+      if (sscanf(line, "OK %d", &committed) != 1 || committed < 0)
+        {
+          ret = -EPROTO;
+        }
+      else
+        {
+          if (committed > nfiles)
+            {
+              committed = nfiles;
+            }
+
+          for (i = 0; i < committed; i++)
+            {
+              seg_path(path, dir, list->entry[i].seq, SEG_CLOSED);
+              unlink(path);
+            }
+
+          ret = committed;
+        }
+    }
+
+  close(sockfd);
+
+errout_with_mem:
+  free(list);
+  return ret;
+}
@@ -0,0 +1,343 @@
+/****************************************************************************
+ * apps/centurysys/libs/stage/lib_stage.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <debug.h>
+
+#include "stage.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct stage_ctx
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  struct stage_s *stages;
+  int nstages;
+  int running;
+};
+
+struct stage_arg
+{
+  struct stage_ctx *ctx;
+  int index;
+  bool joinable;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char *state_str[] =
+{
+  "pending", "running", "ok", "failed", "skipped"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void *stage_thread(void *arg)
+{
+  struct stage_arg *sarg = (struct stage_arg *)arg;
+  struct stage_ctx *ctx = sarg->ctx;
+  struct stage_s *stage = &ctx->stages[sarg->index];
+  int ret;
+
+  ret = stage->func(stage->arg);
+
+  pthread_mutex_lock(&ctx->lock);
+  clock_gettime(CLOCK_MONOTONIC, &stage->end);
+  stage->result = ret;
+  stage->state = ret < 0 ? STAGE_FAILED : STAGE_DONE;
+  ctx->running--;
+  pthread_cond_signal(&ctx->cond);
+  pthread_mutex_unlock(&ctx->lock);
+
+  return NULL;
+}
+
+/* Called with ctx->lock held.  Returns true if something changed. */
+
+static bool stage_schedule(struct stage_ctx *ctx, pthread_t *threads,
+                           struct stage_arg *args)
+{
+  pthread_attr_t attr;
+  struct sched_param param;
+  bool changed = false;
+  uint32_t done = 0;
+  uint32_t failed = 0;
+  int i;
+
+  for (i = 0; i < ctx->nstages; i++)
+    {
+      if (ctx->stages[i].state == STAGE_DONE)
+        {
+          done |= STAGE_DEP(i);
+        }
+      else if (ctx->stages[i].state == STAGE_FAILED ||
+               ctx->stages[i].state == STAGE_SKIPPED)
+        {
+          failed |= STAGE_DEP(i);
+        }
+    }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_CENTURYSYS_LIB_STAGE_STACKSIZE);
+  param.sched_priority = CONFIG_CENTURYSYS_LIB_STAGE_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+
+  for (i = 0; i < ctx->nstages; i++)
+    {
+      struct stage_s *stage = &ctx->stages[i];
+
+      if (stage->state != STAGE_PENDING)
+        {
+          continue;
+        }
+
+      if ((stage->depends & failed) != 0)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &stage->start);
+          stage->end = stage->start;
+          stage->state = STAGE_SKIPPED;
+          stage->result = -ECANCELED;
+          changed = true;
+          continue;
+        }
+
+      if ((stage->depends & done) != stage->depends)
+        {
+          continue;
+        }
+
+      args[i].ctx = ctx;
+      args[i].index = i;
+
+      clock_gettime(CLOCK_MONOTONIC, &stage->start);
+      stage->state = STAGE_RUNNING;
+
+      if (pthread_create(&threads[i], &attr, stage_thread, &args[i]) != 0)
+        {
+          _err("stage \"%s\": pthread_create failed.\n", stage->name);
+          stage->end = stage->start;
+          stage->state = STAGE_FAILED;
+          stage->result = -EAGAIN;
+        }
+      else
+        {
+          args[i].joinable = true;
+          ctx->running++;
+        }
+
+      changed = true;
+    }
+
+  pthread_attr_destroy(&attr);
+
+  return changed;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: stage_run
+ *
+ * Description:
+ *   Run all stages, each in its own thread, as soon as the stages listed
+ *   in its 'depends' mask have completed successfully.  A stage whose
+ *   dependency failed is skipped.  Returns when no stage is running and
+ *   nothing more can be started.
+ *
+ * Returned Value:
+ *   OK if every stage succeeded, otherwise the result of the first failed
+ *   stage (in table order).
+ *
+ ****************************************************************************/
+
+int stage_run(struct stage_s *stages, int nstages)
+{
+  pthread_t threads[STAGE_MAX];
+  struct stage_arg args[STAGE_MAX];
+  struct stage_ctx ctx;
+  bool changed;
+  int ret = OK;
+  int i;
+
+  if (!stages || nstages <= 0 || nstages > STAGE_MAX)
+    {
+      return -EINVAL;
+    }
+
+  for (i = 0; i < nstages; i++)
+    {
+      /* Dependencies must refer to existing stages other than itself */
+
+      if ((stages[i].depends & STAGE_DEP(i)) != 0 ||
+          (nstages < STAGE_MAX && stages[i].depends >= STAGE_DEP(nstages)))
+        {
+          return -EINVAL;
+        }
+
+      stages[i].state = STAGE_PENDING;
+      stages[i].result = 0;
+    }
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(args, 0, sizeof(args));
+  pthread_mutex_init(&ctx.lock, NULL);
+  pthread_cond_init(&ctx.cond, NULL);
+  ctx.stages = stages;
+  ctx.nstages = nstages;
+
+  pthread_mutex_lock(&ctx.lock);
+
+  for (; ; )
+    {
+      /* Start everything that became runnable, then wait for a stage to
+       * finish.  Skipping a stage may unblock (skip) others, so loop until
+       * nothing changes.
+       */
+
+      do
+        {
+          changed = stage_schedule(&ctx, threads, args);
+        }
+      while (changed);
+
+      if (ctx.running == 0)
+        {
+          break;
+        }
+
+      pthread_cond_wait(&ctx.cond, &ctx.lock);
+    }
+
+  pthread_mutex_unlock(&ctx.lock);
+
+  for (i = 0; i < nstages; i++)
+    {
+      if (args[i].joinable)
+        {
+          pthread_join(threads[i], NULL);
+        }
+
+      if (ret == OK && stages[i].state != STAGE_DONE)
+        {
+          ret = stages[i].result < 0 ? stages[i].result : -ECANCELED;
+        }
+    }
+
+  pthread_cond_destroy(&ctx.cond);
+  pthread_mutex_destroy(&ctx.lock);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: stage_elapsed_ms
+ ****************************************************************************/
+
+unsigned long stage_elapsed_ms(const struct timespec *from,
+                               const struct timespec *to)
+{
+  long long ms;
+
+  ms = (long long)(to->tv_sec - from->tv_sec) * MSEC_PER_SEC +
+       (to->tv_nsec - from->tv_nsec) / NSEC_PER_MSEC;
+
+  return ms < 0 ? 0 : (unsigned long)ms;
+}
+
+/****************************************************************************
+ * Name: stage_report
+ *
+ * Description:
+ *   Print the start/end offset (relative to the first stage started) and
+ *   the duration of every stage.
+ *
+ ****************************************************************************/
+
+void stage_report(struct stage_s *stages, int nstages, FILE *stream)
+{
+  struct timespec base;
+  struct timespec last;
+  int i;
+
+  if (!stages || nstages <= 0)
+    {
+      return;
+    }
+
+  base = stages[0].start;
+  last = stages[0].end;
+
+  for (i = 1; i < nstages; i++)
+    {
+      if (stage_elapsed_ms(&stages[i].start, &base) > 0)
+        {
+          base = stages[i].start;
+        }
+
+      if (stage_elapsed_ms(&last, &stages[i].end) > 0)
+        {
+          last = stages[i].end;
+        }
+    }
+
+  fprintf(stream, "%-12s %8s %8s %8s  %s\n",
+          "STAGE", "START", "END", "TIME", "RESULT");
+
+  for (i = 0; i < nstages; i++)
+    {
+      struct stage_s *stage = &stages[i];
+
+      if (stage->state == STAGE_PENDING)
+        {
+          fprintf(stream, "%-12s %8s %8s %8s  %s\n", stage->name,
+                  "-", "-", "-", state_str[stage->state]);
+          continue;
+        }
+
+      fprintf(stream, "%-12s %8lu %8lu %8lu  %s (%d)\n", stage->name,
+              stage_elapsed_ms(&base, &stage->start),
+              stage_elapsed_ms(&base, &stage->end),
+              stage_elapsed_ms(&stage->start, &stage->end),
+              state_str[stage->state], stage->result);
+    }
+
+  fprintf(stream, "total: %lu [msec]\n", stage_elapsed_ms(&base, &last));
+}
@@ -0,0 +1,324 @@
+/****************************************************************************
+ * apps/centurysys/libs/wakeprof/lib_wakeprof.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <debug.h>
+
+#include "wakeprof.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Records read or cleared with one call */
+
+#define WAKEPROF_CHUNK 16
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *phase_names[WAKEPROF_NPHASES] =
+{
+  "schedule", "i2c_reset", "lte_power", "ppp", "mount", "upload",
+  "watchdog", "powerdown"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int write_header(int fd, const struct wakeprof_hdr_s *hdr)
+{
+  if (pwrite(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr))
+    {
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: read_header
+ *
+ * Description:
+ *   Read the header.  A new or foreign journal is started over with all
+ *   slots unused, so stale records can not pass for the current cycle.
+ *
+ ****************************************************************************/
+
+static int read_header(int fd, struct wakeprof_hdr_s *hdr)
+{
+  struct wakeprof_rec_s zero[WAKEPROF_CHUNK];
+  uint32_t slot;
+  uint32_t n;
+
+  if (pread(fd, hdr, sizeof(*hdr), 0) == sizeof(*hdr) &&
+      hdr->magic == WAKEPROF_MAGIC && hdr->version == WAKEPROF_VERSION &&
+      hdr->capacity == CONFIG_CENTURYSYS_LIB_WAKEPROF_RECORDS &&
+      hdr->head < hdr->capacity && hdr->count <= hdr->capacity &&
+      hdr->cycle != 0)
+    {
+      return OK;
+    }
+
+  memset(zero, 0, sizeof(zero));
+
+  for (slot = 0; slot < CONFIG_CENTURYSYS_LIB_WAKEPROF_RECORDS; slot += n)
+    {
+      n = CONFIG_CENTURYSYS_LIB_WAKEPROF_RECORDS - slot;
+      if (n > WAKEPROF_CHUNK)
+        {
+          n = WAKEPROF_CHUNK;
+        }
+
+      if (pwrite(fd, zero, n * sizeof(zero[0]),
+                 sizeof(*hdr) + slot * sizeof(zero[0])) !=
+          n * sizeof(zero[0]))
+        {
+          return -EIO;
+        }
+    }
+
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->magic = WAKEPROF_MAGIC;
+  hdr->version = WAKEPROF_VERSION;
+  hdr->cycle = 1;
+  hdr->capacity = CONFIG_CENTURYSYS_LIB_WAKEPROF_RECORDS;
+
+  return write_header(fd, hdr);
+}
+
+/****************************************************************************
+ * Name: count_current
+ *
+ * Description:
+ *   Return the number of records of the current cycle, found in the slots
+ *   from the head on.
+ *
+ ****************************************************************************/
+
+static uint32_t count_current(int fd, const struct wakeprof_hdr_s *hdr)
+{
+  struct wakeprof_rec_s recs[WAKEPROF_CHUNK];
+  uint32_t count = 0;
+  uint32_t slot;
+  uint32_t n;
+  ssize_t nread;
+  int i;
+
+  while (count < hdr->capacity)
+    {
+      /* Read up to the end of the ring, then continue at its start */
+
+      slot = (hdr->head + count) % hdr->capacity;
+      n = hdr->capacity - (slot > count ? slot : count);
+      if (n > WAKEPROF_CHUNK)
+        {
+          n = WAKEPROF_CHUNK;
+        }
+
+      nread = pread(fd, recs, n * sizeof(recs[0]),
+                    sizeof(*hdr) + slot * sizeof(recs[0]));
+      if (nread <= 0)
+        {
+          break;
+        }
+
+      for (i = 0; i < nread / sizeof(recs[0]); i++)
+        {
+          if (recs[i].cycle != hdr->cycle)
+            {
+              return count;
+            }
+
+          count++;
+        }
+
+      if (nread < n * sizeof(recs[0]))
+        {
+          break;
+        }
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wakeprof_start
+ *
+ * Description:
+ *   Start a new wake cycle.  Called once per boot before the first phase
+ *   is recorded; this is the only regular write of the journal header.
+ *
+ ****************************************************************************/
+
+int wakeprof_start(void)
+{
+  struct wakeprof_hdr_s hdr;
+  uint32_t current;
+  int ret;
+  int fd;
+
+  pthread_mutex_lock(&g_lock);
+
+  fd = open(CONFIG_CENTURYSYS_LIB_WAKEPROF_PATH, O_RDWR | O_CREAT, 0666);
+  if (fd < 0)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  ret = read_header(fd, &hdr);
+  if (ret < 0)
+    {
+      goto out_with_fd;
+    }
+
+  current = count_current(fd, &hdr);
+
+  hdr.head = (hdr.head + current) % hdr.capacity;
+  hdr.count = hdr.count + current < hdr.capacity ?
+              hdr.count + current : hdr.capacity;
+
+  if (++hdr.cycle == 0)
+    {
+      hdr.cycle = 1;
+    }
+
+  ret = write_header(fd, &hdr);
+
+out_with_fd:
+  close(fd);
+out:
+  pthread_mutex_unlock(&g_lock);
+
+  if (ret < 0)
+    {
+      _warn("wakeprof: start failed (%d)\n", ret);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: wakeprof_record
+ *
+ * Description:
+ *   Append one phase boundary of the current cycle to the journal.  Only
+ *   the record slot is written.
+ *
+ ****************************************************************************/
+
+int wakeprof_record(wakeprof_phase phase, wakeprof_event event,
+                    int32_t value)
+{
+  struct wakeprof_hdr_s hdr;
+  struct wakeprof_rec_s rec;
+  struct timespec ts;
+  uint32_t current;
+  off_t offset;
+  int ret;
+  int fd;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  rec.uptime = ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+  rec.time = time(NULL);
+  rec.phase = phase;
+  rec.event = event;
+  rec.value = value;
+
+  pthread_mutex_lock(&g_lock);
+
+  fd = open(CONFIG_CENTURYSYS_LIB_WAKEPROF_PATH, O_RDWR | O_CREAT, 0666);
+  if (fd < 0)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  ret = read_header(fd, &hdr);
+  if (ret < 0)
+    {
+      goto out_with_fd;
+    }
+
+  rec.cycle = hdr.cycle;
+
+  current = count_current(fd, &hdr);
+  offset = sizeof(hdr) +
+           ((hdr.head + current) % hdr.capacity) * sizeof(rec);
+
+  if (pwrite(fd, &rec, sizeof(rec), offset) != sizeof(rec))
+    {
+      ret = -EIO;
+      goto out_with_fd;
+    }
+
+  if (current == hdr.capacity)
+    {
+      /* The cycle filled the whole ring and overwrote its own first
+       * record, move the head past it.
+       */
+
+      hdr.head = (hdr.head + 1) % hdr.capacity;
+      ret = write_header(fd, &hdr);
+    }
+
+out_with_fd:
+  close(fd);
+out:
+  pthread_mutex_unlock(&g_lock);
+
+  if (ret < 0)
+    {
+      _warn("wakeprof: record failed (%d)\n", ret);
+    }
+
+  return ret;
+}
+
+const char *wakeprof_phase_name(int phase)
+{
+  if (phase < 0 || phase >= WAKEPROF_NPHASES)
+    {
+      return "?";
+    }
+
+  return phase_names[phase];
+}
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 #include <stdio.h>
+#include <errno.h>
 #include <string.h>
 #include <fcntl.h>
 #include <getopt.h>
@@ -33,6 +34,7 @@
 #include <nuttx/board.h>
 
 #include "mas1xx_lte.h"
+#include "wakeprof.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -73,7 +75,9 @@ int main(int argc, char *argv[])
 
   if (strncmp(cmd, "on", 2) == 0)
     {
+      wakeprof_begin(WAKEPROF_LTE_POWER);
       res = lte_power_ctrl(true);
+      wakeprof_end(WAKEPROF_LTE_POWER, res ? OK : -EIO);
     }
   else if (strncmp(cmd, "off", 3) == 0)
     {
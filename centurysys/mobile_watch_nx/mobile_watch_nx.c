@@ -28,11 +28,8 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <unistd.h>
+#include <semaphore.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
-#include <sys/time.h>
-#include <net/if.h>
-#include <netpacket/netlink.h>
 
 #include <debug.h>
 
@@ -40,6 +37,8 @@
 #include <arch/board/board.h>
 #include <nuttx/leds/userled.h>
 
+#include "libppp.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -47,7 +46,8 @@
 struct task_data
 {
   int led_fd;
-  int sockfd;
+  sem_t sem;
+  volatile bool ppp_event;
   bool ppp_stat;
 };
 
@@ -56,87 +56,62 @@ struct task_data
  ****************************************************************************/
 
 /****************************************************************************
- *
+ * Runs in the PPP monitor task: only record the state and wake main loop,
+ * the LED device is owned by this task.
  ****************************************************************************/
 
-static void handle_event_link(struct task_data *self, char *ifname,
-                              bool new_del)
+static void handle_event(ppp_event event, const char *ifname, void *arg)
 {
-  if (strncmp(ifname, "ppp0", 4) != 0)
+  struct task_data *self = arg;
+
+  if (strcmp(ifname, PPP_IFNAME) != 0)
     {
       return;
     }
 
-  if ((self->ppp_stat == true) && (new_del == false))
+  switch (event)
     {
-      userled_set_t set = 0;
-      _info("PPP down detected.\n");
+      case PPP_EVENT_LINK_DEL:
+        self->ppp_event = false;
+        break;
+
+      case PPP_EVENT_ADDR_NEW:
+        self->ppp_event = true;
+        break;
 
-      ioctl(self->led_fd, ULEDIOC_SETALL, set);
-      self->ppp_stat = false;
+      default:
+        return;
     }
+
+  sem_post(&self->sem);
 }
 
 /****************************************************************************
  *
  ****************************************************************************/
 
-static void handle_event_addr(struct task_data *self, char *ifname,
-                              bool new_del)
+static void update_led(struct task_data *self, bool up)
 {
-  if (strncmp(ifname, "ppp0", 4) != 0)
+  userled_set_t set;
+
+  if (self->ppp_stat == up)
     {
       return;
     }
 
-  if ((self->ppp_stat == false) && (new_del == true))
+  if (up)
     {
-      userled_set_t set = BOARD_MOBILE0_G_BIT;
       _info("PPP up detected.\n");
-
-      ioctl(self->led_fd, ULEDIOC_SETALL, set);
-      self->ppp_stat = true;
+      set = BOARD_MOBILE0_G_BIT;
     }
-}
-
-/****************************************************************************
- *
- ****************************************************************************/
-
-static void handle_event(struct task_data *self, struct nlmsghdr *hdr)
-{
-  char ifname[IFNAMSIZ];
-  struct ifinfomsg *ifi = NULL;
-  struct ifaddrmsg *ifa = NULL;
-  bool new_del;
-
-  switch (hdr->nlmsg_type)
+  else
     {
-      case RTM_NEWLINK:
-      case RTM_DELLINK:
-        /* New/Delete LINK Status */
-
-        ifi = NLMSG_DATA(hdr);
-        if_indextoname(ifi->ifi_index, ifname);
-        new_del = hdr->nlmsg_type == RTM_NEWLINK ? true : false;
-
-        handle_event_link(self, ifname, new_del);
-        break;
-
-      case RTM_NEWADDR:
-      case RTM_DELADDR:
-        /* New/Delete IP Address */
-
-        ifa = NLMSG_DATA(hdr);
-        if_indextoname(ifa->ifa_index, ifname);
-        new_del = hdr->nlmsg_type == RTM_NEWADDR ? true : false;
-
-        handle_event_addr(self, ifname, new_del);
-        break;
-
-      default:
-        break;
+      _info("PPP down detected.\n");
+      set = 0;
     }
+
+  ioctl(self->led_fd, ULEDIOC_SETALL, set);
+  self->ppp_stat = up;
 }
 
 /****************************************************************************
@@ -145,37 +120,19 @@ static void handle_event(struct task_data *self, struct nlmsghdr *hdr)
 
 static void watch_event(struct task_data *self)
 {
-  struct pollfd pfd;
-  char buf[1024];
-  struct nlmsghdr *hdr;
-  int len;
-  int n;
-
   _info("Monitoring started.\n");
 
-  memset(buf, 0, sizeof(buf));
-
-  pfd.fd = self->sockfd;
-  pfd.events = POLLIN;
-  pfd.revents = 0;
-
-  while (1) {
-    n = poll(&pfd, 1, -1);
-    len = recv(self->sockfd, buf, sizeof(buf), 0);
+  update_led(self, ppp_is_up());
 
-    if (len < 0)
-      {
-        break;
-      }
-
-    for (hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, len);
-         hdr = NLMSG_NEXT(hdr, len))
-      {
-        handle_event(self, hdr);
-      }
-  }
+  while (1)
+    {
+      if (sem_wait(&self->sem) < 0 && errno != EINTR)
+        {
+          break;
+        }
 
-  return;
+      update_led(self, self->ppp_event);
+    }
 }
 
 /****************************************************************************
@@ -189,9 +146,10 @@ static void watch_event(struct task_data *self)
 int main(int argc, char *argv[])
 {
   struct task_data self;
-  int ret = ERROR;
-  socklen_t alen;
-  struct sockaddr_nl local;
+  int ret;
+
+  memset(&self, 0, sizeof(struct task_data));
+  sem_init(&self.sem, 0, 0);
 
   self.led_fd = open("/dev/userleds", O_RDWR);
   if (self.led_fd < 0)
@@ -199,36 +157,20 @@ int main(int argc, char *argv[])
       _warn("open userleds failed.\n");
     }
 
-  self.sockfd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
-
-  if (self.sockfd < 0)
-    {
-      _err("?? NETLINK socket not supported.\n");
-      goto exit;
-    }
-
-  memset(&local, 0, sizeof(struct sockaddr_nl));
-  local.nl_family = AF_NETLINK;
-  local.nl_groups = RTMGRP_LINK | RTMGRP_NOTIFY | RTMGRP_IPV4_IFADDR;
-
-  alen = sizeof(struct sockaddr_nl);
-  ret = bind(self.sockfd, (struct sockaddr *)&local, alen);
+  ret = ppp_subscribe(handle_event, &self);
 
   if (ret < 0)
     {
-      goto exit;
-    }
-
-  if (getsockname(self.sockfd, (struct sockaddr *)&local, &alen) < 0 ||
-      alen != sizeof(local) || local.nl_family != AF_NETLINK)
-    {
+      _err("?? PPP event monitor not available.\n");
       goto exit;
     }
 
   watch_event(&self);
+  ppp_unsubscribe(handle_event, &self);
   ret = OK;
 
 exit:
-  close(self.sockfd);
+  close(self.led_fd);
+  sem_destroy(&self.sem);
   return ret;
 }
@@ -0,0 +1,199 @@
+/****************************************************************************
+ * apps/centurysys/spoolctl/spoolctl.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "spool.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct spool_s g_spool;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void usage(char *name)
+{
+  fprintf(stderr, "Usage: %s [-d <dir>] [COMMAND]\n", name);
+  fprintf(stderr, "  COMMAND: append <record> / rotate / stat /"
+                  " upload <host> <port>\n");
+  fprintf(stderr, "\t-d|--dir <path>: spool directory (%s)\n",
+          CONFIG_CENTURYSYS_SPOOLCTL_DIR);
+
+  exit(EXIT_FAILURE);
+}
+
+static int do_append(const char *dir, const char *record)
+{
+  int ret;
+
+  ret = spool_open(&g_spool, dir);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = spool_append(&g_spool, record, strlen(record));
+  spool_close(&g_spool);
+
+  return ret;
+}
+
+static int do_rotate(const char *dir)
+{
+  int ret;
+
+  ret = spool_open(&g_spool, dir);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = spool_rotate(&g_spool);
+  spool_close(&g_spool);
+
+  return ret;
+}
+
+static int do_stat(const char *dir)
+{
+  struct spool_stat_s st;
+  int ret;
+
+  ret = spool_stat(dir, &st);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  printf("Segments: %d\n", st.segments);
+  printf("Pending:  %lld [bytes]\n", (long long)st.pending);
+  printf("Current:  %lld [bytes]\n", (long long)st.current);
+
+  return OK;
+}
+
+static int do_upload(const char *dir, const char *host, const char *port)
+{
+  int ret;
+
+  /* Include the records of this wake-up */
+
+  ret = do_rotate(dir);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = spool_upload(dir, host, port);
+  if (ret >= 0)
+    {
+      printf("%d segment(s) uploaded.\n", ret);
+      ret = OK;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * spoolctl main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  const char *dir = CONFIG_CENTURYSYS_SPOOLCTL_DIR;
+  char *cmd;
+  int ret;
+  struct option options[] =
+    {
+      {"dir", 1, NULL, 'd' },
+      {"help", 0, NULL, 'h' },
+      {NULL, 0, NULL, 0 },
+    };
+
+  while ((ret = getopt_long(argc, argv, "d:h", options, NULL)) != ERROR)
+    {
+      switch (ret)
+        {
+          case 'd':
+            dir = optarg;
+            break;
+
+          case 'h':
+          case '?':
+          default:
+            usage(argv[0]);
+            break;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      usage(argv[0]);
+    }
+
+  cmd = argv[optind++];
+
+  if (strcmp(cmd, "append") == 0 && optind + 1 == argc)
+    {
+      ret = do_append(dir, argv[optind]);
+    }
+  else if (strcmp(cmd, "rotate") == 0)
+    {
+      ret = do_rotate(dir);
+    }
+  else if (strcmp(cmd, "stat") == 0)
+    {
+      ret = do_stat(dir);
+    }
+  else if (strcmp(cmd, "upload") == 0 && optind + 2 == argc)
+    {
+      ret = do_upload(dir, argv[optind], argv[optind + 1]);
+    }
+  else
+    {
+      usage(argv[0]);
+      ret = ERROR;
+    }
+
+  if (ret < 0)
+    {
+      fprintf(stderr, "%s %s failed: %s\n", argv[0], cmd, strerror(-ret));
+      return ERROR;
+    }
+
+  return OK;
+}
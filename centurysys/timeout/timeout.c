@@ -34,6 +34,7 @@
 
 #include "libmount.h"
 #include "power.h"
+#include "wakeprof.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -168,6 +169,8 @@ int main(int argc, FAR char *argv[])
       fprintf(stderr, "timeouted, reboot!\n");
     }
 
+  wakeprof_mark(WAKEPROF_WATCHDOG, param.timeout);
+
   if (!param.fake)
     {
       umount_fs("/home");
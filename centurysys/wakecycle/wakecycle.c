@@ -0,0 +1,461 @@
+/****************************************************************************
+ * apps/centurysys/wakecycle/wakecycle.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <debug.h>
+
+#include <nuttx/board.h>
+
+#include "mas1xx_lte.h"
+#include "libmount.h"
+#include "libppp.h"
+#include "power.h"
+#include "schedule.h"
+#include "stage.h"
+#include "wakeprof.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MAX_TIME_STRING 80
+
+enum
+{
+  ST_SCHEDULE = 0,
+  ST_LTE,
+  ST_MOUNT,
+  ST_PREPARE,
+  ST_PPP,
+  ST_NETUP,
+  ST_UPLOAD,
+  ST_NUM
+};
+
+struct parameter
+{
+  time_t interval;
+  time_t minimum;
+  int netwait;
+  char *tty;
+  char *account;
+  char *password;
+  char *device;
+  char *mountpoint;
+  char *fstype;
+  char *prepare;
+  char *upload;
+  bool verbose;
+  bool fake;
+};
+
+struct task_data
+{
+  struct parameter *param;
+  struct schedule_s schedule;
+  bool mounted;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int run_command(const char *cmd)
+{
+  int ret;
+
+  if (!cmd)
+    {
+      return OK;
+    }
+
+  ret = system(cmd);
+
+  return ret == 0 ? OK : -EIO;
+}
+
+static int cycle_schedule(void *arg)
+{
+  struct task_data *self = arg;
+
+  return get_next_schedule(self->param->interval, self->param->minimum,
+                           &self->schedule);
+}
+
+static int cycle_lte(void *arg)
+{
+  int ret;
+
+  wakeprof_begin(WAKEPROF_LTE_POWER);
+  ret = lte_power_ctrl(true) ? OK : -EIO;
+  wakeprof_end(WAKEPROF_LTE_POWER, ret);
+
+  return ret;
+}
+
+static int cycle_mount(void *arg)
+{
+  struct task_data *self = arg;
+  int ret;
+
+  if (!self->param->device)
+    {
+      return OK;
+    }
+
+  ret = mount_fs(self->param->device, self->param->mountpoint,
+                 self->param->fstype, 0);
+
+  if (ret < 0)
+    {
+      return -errno;
+    }
+
+  self->mounted = true;
+  return OK;
+}
+
+static int cycle_prepare(void *arg)
+{
+  struct task_data *self = arg;
+
+  return run_command(self->param->prepare);
+}
+
+static int cycle_ppp(void *arg)
+{
+  struct task_data *self = arg;
+  struct parameter *param = self->param;
+  bool use_pap = param->account != NULL && param->password != NULL;
+  int pid;
+
+  pid = launch_pppd(param->tty, param->account, param->password, use_pap,
+                    false);
+
+  return pid < 0 ? -EIO : OK;
+}
+
+static int cycle_netup(void *arg)
+{
+  struct task_data *self = arg;
+
+  return ppp_wait_up(self->param->netwait * MSEC_PER_SEC);
+}
+
+static int cycle_upload(void *arg)
+{
+  struct task_data *self = arg;
+  int ret;
+
+  wakeprof_begin(WAKEPROF_UPLOAD);
+  ret = run_command(self->param->upload);
+  wakeprof_end(WAKEPROF_UPLOAD, ret);
+
+  return ret;
+}
+
+static int powerdown(struct task_data *self)
+{
+  int ret;
+
+  if (self->schedule.skipped)
+    {
+      fprintf(stderr, "Wait %d [sec] -> Schedule Skipped.\n",
+              self->schedule.wait_sec);
+      return OK;
+    }
+
+  ret = enable_wakeup(WKUP_RTC | WKUP_OPTSW);
+
+  if (ret < 0)
+    {
+      fprintf(stderr, "enable_wakeup(RTC|OPTSW) failed.\n");
+      return ret;
+    }
+
+  ret = set_rtc_alarm((struct rtc_time *)&self->schedule.sched_time);
+
+  if (ret < 0)
+    {
+      fprintf(stderr, "set_rtc_alarm failed.\n");
+    }
+  else
+    {
+      board_powerdown();
+      /* not reached here */
+    }
+
+  return ret;
+}
+
+static void usage(char *name)
+{
+  fprintf(stderr, "Usage: %s [OPTIONS]\n", name);
+  fprintf(stderr, "\t-i|--interval <seconds>: schedule interval\n");
+  fprintf(stderr, "\t-m|--minimum  <seconds>: minimum wait\n");
+  fprintf(stderr, "\t-t|--tty <device>: LTE modem tty\n");
+  fprintf(stderr, "\t-a|--account <user>: PAP account\n");
+  fprintf(stderr, "\t-p|--password <pass>: PAP password\n");
+  fprintf(stderr, "\t-d|--device <blockdev>: storage to mount\n");
+  fprintf(stderr, "\t-D|--dir <path>: mount point (/home)\n");
+  fprintf(stderr, "\t-T|--type <fstype>: filesystem type (vfat)\n");
+  fprintf(stderr, "\t-P|--prepare <command>: data preparation command\n");
+  fprintf(stderr, "\t-u|--upload <command>: upload command\n");
+  fprintf(stderr, "\t-w|--wait <seconds>: PPP wait timeout (%d)\n",
+          CONFIG_CENTURYSYS_WAKECYCLE_NETWAIT);
+  fprintf(stderr, "\t-v|--verbose: verbose\n");
+  fprintf(stderr, "\t-f|--fake: do not shutdown (fake)\n");
+  fprintf(stderr, "\t-h|--help: show this message\n");
+
+  exit(EXIT_FAILURE);
+}
+
+static int parse_args(int argc, char **argv, struct parameter *param)
+{
+  int ret;
+  struct option options[] =
+    {
+      {"interval", 1, NULL, 'i' },
+      {"minimum", 1, NULL, 'm' },
+      {"tty", 1, NULL, 't' },
+      {"account", 1, NULL, 'a' },
+      {"password", 1, NULL, 'p' },
+      {"device", 1, NULL, 'd' },
+      {"dir", 1, NULL, 'D' },
+      {"type", 1, NULL, 'T' },
+      {"prepare", 1, NULL, 'P' },
+      {"upload", 1, NULL, 'u' },
+      {"wait", 1, NULL, 'w' },
+      {"verbose", 0, NULL, 'v' },
+      {"fake", 0, NULL, 'f' },
+      {"help", 0, NULL, 'h' },
+      {NULL, 0, NULL, 0 },
+    };
+
+  memset(param, 0, sizeof(struct parameter));
+  param->netwait = CONFIG_CENTURYSYS_WAKECYCLE_NETWAIT;
+  param->tty = "/dev/ttyACM0";
+  param->mountpoint = "/home";
+  param->fstype = "vfat";
+
+  while ((ret = getopt_long(argc, argv, "i:m:t:a:p:d:D:T:P:u:w:fvh",
+                            options, NULL)) != ERROR)
+    {
+      switch (ret)
+        {
+          case 'i':
+            param->interval = atoi(optarg);
+            break;
+
+          case 'm':
+            param->minimum = atoi(optarg);
+            break;
+
+          case 't':
+            param->tty = optarg;
+            break;
+
+          case 'a':
+            param->account = optarg;
+            break;
+
+          case 'p':
+            param->password = optarg;
+            break;
+
+          case 'd':
+            param->device = optarg;
+            break;
+
+          case 'D':
+            param->mountpoint = optarg;
+            break;
+
+          case 'T':
+            param->fstype = optarg;
+            break;
+
+          case 'P':
+            param->prepare = optarg;
+            break;
+
+          case 'u':
+            param->upload = optarg;
+            break;
+
+          case 'w':
+            param->netwait = atoi(optarg);
+            break;
+
+          case 'v':
+            param->verbose = true;
+            break;
+
+          case 'f':
+            param->fake = true;
+            break;
+
+          case 'h':
+          case '?':
+          default:
+            usage(argv[0]);
+            break;
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * wakecycle main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct task_data self;
+  struct parameter param;
+  int ret;
+
+  /* Stage graph:
+   *
+   *   SCHEDULE
+   *   LTE ---> PPP ---> NETUP ---+
+   *   MOUNT -> PREPARE ----------+--> UPLOAD
+   */
+
+  struct stage_s stages[ST_NUM] =
+    {
+      [ST_SCHEDULE] =
+        {
+          .name = "schedule", .func = cycle_schedule,
+        },
+      [ST_LTE] =
+        {
+          .name = "lte", .func = cycle_lte,
+        },
+      [ST_MOUNT] =
+        {
+          .name = "mount", .func = cycle_mount,
+        },
+      [ST_PREPARE] =
+        {
+          .name = "prepare", .func = cycle_prepare,
+          .depends = STAGE_DEP(ST_MOUNT),
+        },
+      [ST_PPP] =
+        {
+          .name = "ppp", .func = cycle_ppp,
+          .depends = STAGE_DEP(ST_LTE),
+        },
+      [ST_NETUP] =
+        {
+          .name = "netup", .func = cycle_netup,
+          .depends = STAGE_DEP(ST_PPP),
+        },
+      [ST_UPLOAD] =
+        {
+          .name = "upload", .func = cycle_upload,
+          .depends = STAGE_DEP(ST_NETUP) | STAGE_DEP(ST_PREPARE),
+        },
+    };
+
+  int i;
+
+  ret = parse_args(argc, argv, &param);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (param.interval <= 0)
+    {
+      usage(argv[0]);
+    }
+
+  /* Everything recorded from now on belongs to this wake cycle */
+
+  wakeprof_start();
+
+  memset(&self, 0, sizeof(struct task_data));
+  self.param = &param;
+
+  for (i = 0; i < ST_NUM; i++)
+    {
+      stages[i].arg = &self;
+    }
+
+  ret = stage_run(stages, ST_NUM);
+
+  if (param.verbose || ret < 0)
+    {
+      stage_report(stages, ST_NUM, stdout);
+      fflush(stdout);
+    }
+
+  terminate_pppd();
+
+  if (self.mounted)
+    {
+      umount_fs(param.mountpoint);
+    }
+
+  if (stages[ST_SCHEDULE].state != STAGE_DONE)
+    {
+      /* Without a schedule the RTC alarm can not be set, stay powered */
+
+      fprintf(stderr, "no schedule, keep running.\n");
+      return ERROR;
+    }
+
+  if (param.verbose || param.fake)
+    {
+      char timbuf[MAX_TIME_STRING];
+
+      strftime(timbuf, MAX_TIME_STRING, "%a, %b %d %H:%M:%S %Y",
+               &self.schedule.tm_local);
+      printf("  Next Schedule: %s\n", timbuf);
+
+      if (param.fake)
+        {
+          return ret;
+        }
+    }
+
+  return powerdown(&self);
+}
@@ -0,0 +1,466 @@
+/****************************************************************************
+ * apps/centurysys/wakeprof/wakeprof.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "wakeprof.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Pseudo phase: uptime of the last record of a cycle (total awake time) */
+
+#define PHASE_AWAKE WAKEPROF_NPHASES
+
+struct sample
+{
+  uint8_t phase;
+  uint8_t mark;          /* 0: duration of begin/end, 1: time since boot */
+  uint32_t value;
+};
+
+struct parameter
+{
+  int cycles;
+  bool list;
+  bool clear;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int sample_compare(const void *a, const void *b)
+{
+  const struct sample *sa = a;
+  const struct sample *sb = b;
+
+  if (sa->phase != sb->phase)
+    {
+      return sa->phase - sb->phase;
+    }
+
+  if (sa->mark != sb->mark)
+    {
+      return sa->mark - sb->mark;
+    }
+
+  return sa->value < sb->value ? -1 : sa->value > sb->value ? 1 : 0;
+}
+
+static const char *phase_name(int phase)
+{
+  return phase == PHASE_AWAKE ? "awake" : wakeprof_phase_name(phase);
+}
+
+static uint32_t percentile(const struct sample *s, int n, int pct)
+{
+  return s[(n - 1) * pct / 100].value;
+}
+
+/****************************************************************************
+ * Name: load_journal
+ *
+ * Description:
+ *   Read the records, oldest first, and return their number.  The records
+ *   of the current cycle follow the head of the ring; the header counts
+ *   only the ones before it.
+ *
+ ****************************************************************************/
+
+static int load_journal(struct wakeprof_rec_s **recs)
+{
+  struct wakeprof_hdr_s hdr;
+  struct wakeprof_rec_s *ring;
+  struct wakeprof_rec_s *buf;
+  uint32_t current;
+  uint32_t first;
+  uint32_t total;
+  uint32_t i;
+  ssize_t nread;
+  int fd;
+
+  fd = open(CONFIG_CENTURYSYS_LIB_WAKEPROF_PATH, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+      hdr.magic != WAKEPROF_MAGIC || hdr.version != WAKEPROF_VERSION ||
+      hdr.capacity == 0 || hdr.head >= hdr.capacity ||
+      hdr.count > hdr.capacity || hdr.cycle == 0)
+    {
+      close(fd);
+      return -ENODATA;
+    }
+
+  ring = calloc(hdr.capacity, sizeof(struct wakeprof_rec_s));
+  if (ring == NULL)
+    {
+      close(fd);
+      return -ENOMEM;
+    }
+
+  /* Slots past the end of the file are unused */
+
+  nread = read(fd, ring, hdr.capacity * sizeof(struct wakeprof_rec_s));
+  close(fd);
+
+  if (nread < 0)
+    {
+      free(ring);
+      return -EIO;
+    }
+
+  for (current = 0; current < hdr.capacity; current++)
+    {
+      if (ring[(hdr.head + current) % hdr.capacity].cycle != hdr.cycle)
+        {
+          break;
+        }
+    }
+
+  total = hdr.count + current < hdr.capacity ?
+          hdr.count + current : hdr.capacity;
+  first = (hdr.head + current + hdr.capacity - total) % hdr.capacity;
+
+  buf = malloc(total * sizeof(struct wakeprof_rec_s) + 1);
+  if (buf == NULL)
+    {
+      free(ring);
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < total; i++)
+    {
+      buf[i] = ring[(first + i) % hdr.capacity];
+    }
+
+  free(ring);
+  *recs = buf;
+
+  return total;
+}
+
+static void list_journal(struct wakeprof_rec_s *recs, int n)
+{
+  static const char *events[] =
+    {
+      "begin", "end", "mark"
+    };
+
+  char timbuf[32];
+  time_t t;
+  int i;
+
+  printf("%5s %-19s %9s %-10s %-5s %s\n",
+         "CYCLE", "TIME", "UPTIME", "PHASE", "EVENT", "VALUE");
+
+  for (i = 0; i < n; i++)
+    {
+      t = recs[i].time;
+      strftime(timbuf, sizeof(timbuf), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+
+      printf("%5u %-19s %9" PRIu32 " %-10s %-5s %" PRId32 "\n",
+             recs[i].cycle, timbuf, recs[i].uptime,
+             wakeprof_phase_name(recs[i].phase),
+             recs[i].event <= WAKEPROF_MARK ? events[recs[i].event] : "?",
+             recs[i].value);
+    }
+}
+
+/****************************************************************************
+ * Name: summarize
+ *
+ * Description:
+ *   Turn the records into samples (durations of begin/end pairs, time
+ *   since boot of marks and total awake time per cycle) and print their
+ *   percentiles per phase.
+ *
+ ****************************************************************************/
+
+static int summarize(struct wakeprof_rec_s *recs, int n, int cycles)
+{
+  uint32_t begin[WAKEPROF_NPHASES];
+  struct sample *samples;
+  uint16_t first_cycle = 0;
+  int nsamples = 0;
+  int ncycles = 0;
+  int start = 0;
+  int i;
+  int j;
+
+  /* Start at the first record of the last 'cycles' cycles */
+
+  if (cycles > 0)
+    {
+      for (i = n - 1, j = 0; i >= 0; i--)
+        {
+          if (i == n - 1 || recs[i].cycle != recs[i + 1].cycle)
+            {
+              if (++j > cycles)
+                {
+                  break;
+                }
+
+              start = i;
+              first_cycle = recs[i].cycle;
+            }
+        }
+
+      while (start > 0 && recs[start - 1].cycle == first_cycle)
+        {
+          start--;
+        }
+    }
+
+  samples = malloc((2 * n + 1) * sizeof(struct sample));
+  if (samples == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = start; i < n; i++)
+    {
+      struct wakeprof_rec_s *rec = &recs[i];
+
+      if (i == start || rec->cycle != recs[i - 1].cycle)
+        {
+          memset(begin, 0xff, sizeof(begin));
+          ncycles++;
+        }
+
+      if (rec->phase >= WAKEPROF_NPHASES)
+        {
+          continue;
+        }
+
+      switch (rec->event)
+        {
+          case WAKEPROF_BEGIN:
+            begin[rec->phase] = rec->uptime;
+            break;
+
+          case WAKEPROF_END:
+            if (begin[rec->phase] != UINT32_MAX &&
+                rec->uptime >= begin[rec->phase])
+              {
+                samples[nsamples].phase = rec->phase;
+                samples[nsamples].mark = 0;
+                samples[nsamples].value = rec->uptime - begin[rec->phase];
+                nsamples++;
+                begin[rec->phase] = UINT32_MAX;
+              }
+            break;
+
+          case WAKEPROF_MARK:
+            samples[nsamples].phase = rec->phase;
+            samples[nsamples].mark = 1;
+            samples[nsamples].value = rec->uptime;
+            nsamples++;
+            break;
+
+          default:
+            break;
+        }
+
+      /* Last record of the cycle gives the awake time */
+
+      if (i == n - 1 || recs[i + 1].cycle != rec->cycle)
+        {
+          samples[nsamples].phase = PHASE_AWAKE;
+          samples[nsamples].mark = 1;
+          samples[nsamples].value = rec->uptime;
+          nsamples++;
+        }
+    }
+
+  qsort(samples, nsamples, sizeof(struct sample), sample_compare);
+
+  printf("%d cycle(s), %d record(s) [msec]\n", ncycles, n - start);
+  printf("%-10s %-4s %5s %8s %8s %8s %8s %8s\n",
+         "PHASE", "KIND", "N", "MIN", "P50", "P90", "P99", "MAX");
+
+  for (i = 0; i < nsamples; i = j)
+    {
+      j = i;
+      while (j < nsamples && samples[j].phase == samples[i].phase &&
+             samples[j].mark == samples[i].mark)
+        {
+          j++;
+        }
+
+      printf("%-10s %-4s %5d %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+             " %8" PRIu32 " %8" PRIu32 "\n",
+             phase_name(samples[i].phase), samples[i].mark ? "at" : "dur",
+             j - i, samples[i].value,
+             percentile(&samples[i], j - i, 50),
+             percentile(&samples[i], j - i, 90),
+             percentile(&samples[i], j - i, 99),
+             samples[j - 1].value);
+    }
+
+  free(samples);
+  return OK;
+}
+
+static int clear_journal(void)
+{
+  struct wakeprof_hdr_s hdr;
+  int fd;
+  int ret = OK;
+
+  /* Invalidate the header, the journal may be a raw device */
+
+  fd = open(CONFIG_CENTURYSYS_LIB_WAKEPROF_PATH, O_WRONLY);
+  if (fd < 0)
+    {
+      return errno == ENOENT ? OK : -errno;
+    }
+
+  memset(&hdr, 0, sizeof(hdr));
+  if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+      ret = -EIO;
+    }
+
+  close(fd);
+  return ret;
+}
+
+static void usage(char *name)
+{
+  fprintf(stderr, "Usage: %s [OPTIONS]\n", name);
+  fprintf(stderr, "\t-n|--cycles <num>: summarize the last <num> cycles\n");
+  fprintf(stderr, "\t-l|--list: list all records\n");
+  fprintf(stderr, "\t-c|--clear: clear the journal\n");
+  fprintf(stderr, "\t-h|--help: show this message\n");
+
+  exit(EXIT_FAILURE);
+}
+
+static int parse_args(int argc, char **argv, struct parameter *param)
+{
+  int ret;
+  struct option options[] =
+    {
+      {"cycles", 1, NULL, 'n' },
+      {"list", 0, NULL, 'l' },
+      {"clear", 0, NULL, 'c' },
+      {"help", 0, NULL, 'h' },
+      {NULL, 0, NULL, 0 },
+    };
+
+  memset(param, 0, sizeof(struct parameter));
+
+  while ((ret = getopt_long(argc, argv, "n:lch", options, NULL))
+         != ERROR)
+    {
+      switch (ret)
+        {
+          case 'n':
+            param->cycles = atoi(optarg);
+            break;
+
+          case 'l':
+            param->list = true;
+            break;
+
+          case 'c':
+            param->clear = true;
+            break;
+
+          case 'h':
+          case '?':
+          default:
+            usage(argv[0]);
+            break;
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * wakeprof main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct wakeprof_rec_s *recs = NULL;
+  struct parameter param;
+  int ret;
+  int n;
+
+  parse_args(argc, argv, &param);
+
+  if (param.clear)
+    {
+      ret = clear_journal();
+      goto out;
+    }
+
+  ret = n = load_journal(&recs);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  if (param.list)
+    {
+      list_journal(recs, n);
+    }
+  else
+    {
+      ret = summarize(recs, n, param.cycles);
+    }
+
+  free(recs);
+
+out:
+  if (ret < 0)
+    {
+      fprintf(stderr, "%s: %s\n", CONFIG_CENTURYSYS_LIB_WAKEPROF_PATH,
+              strerror(-ret));
+      return ERROR;
+    }
+
+  return OK;
+}
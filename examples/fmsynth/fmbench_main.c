@@ -0,0 +1,307 @@
+/****************************************************************************
+ * apps/examples/fmsynth/fmbench_main.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <audioutils/fmsynth.h>
+
+#include "operator_algorithm.h"
+#include "music_scale.h"
+
+/****************************************************************************
+ * Pre-processor
+ ****************************************************************************/
+
+#define APP_FS          (48000)
+#define APP_FRAMES      (256)
+#define APP_MAX_VOICES  (64)
+
+#define APP_DEFAULT_VOICES  (16)
+#define APP_DEFAULT_SECONDS (2)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef CODE int (*render_t)(FAR fmsynth_sound_t *snd,
+                             FAR int16_t *sample, int sample_num,
+                             int chnum, fmsynth_tickcb_t cb,
+                             unsigned long cbarg);
+
+struct voices_s
+{
+  int num;
+  FAR fmsynth_sound_t *sound[APP_MAX_VOICES];
+  FAR fmsynth_op_t *carrier[APP_MAX_VOICES];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int16_t g_scalar_buf[APP_FRAMES];
+static int16_t g_block_buf[APP_FRAMES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * name: delete_voices
+ ****************************************************************************/
+
+static void delete_voices(FAR struct voices_s *v)
+{
+  int i;
+
+  for (i = 0; i < v->num; i++)
+    {
+      fmsynthutil_delete_ops(v->carrier[i]);
+      fmsynthsnd_delete(v->sound[i]);
+    }
+
+  v->num = 0;
+}
+
+/****************************************************************************
+ * name: create_voices
+ ****************************************************************************/
+
+static int create_voices(FAR struct voices_s *v, int num, int mode)
+{
+  int i;
+
+  v->num = 0;
+  for (i = 0; i < num; i++)
+    {
+      switch (mode)
+        {
+          case 0:
+            v->carrier[i] = fmsynthutil_algorithm0();
+            break;
+
+          case 1:
+            v->carrier[i] = fmsynthutil_algorithm1();
+            break;
+
+          default:
+            v->carrier[i] = fmsynthutil_algorithm2();
+            break;
+        }
+
+      v->sound[i] = fmsynthsnd_create();
+      if (v->carrier[i] == NULL || v->sound[i] == NULL)
+        {
+          fmsynthutil_delete_ops(v->carrier[i]);
+          fmsynthsnd_delete(v->sound[i]);
+          delete_voices(v);
+          return ERROR;
+        }
+
+      v->num++;
+      fmsynthsnd_set_operator(v->sound[i], v->carrier[i]);
+      fmsynthsnd_set_volume(v->sound[i], 1.f / num);
+      fmsynthsnd_set_soundfreq(v->sound[i],
+                               musical_scale[OCTAVE(3, 0) + i % 36]);
+      if (i > 0)
+        {
+          fmsynthsnd_add_subsound(v->sound[0], v->sound[i]);
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * name: elapsed_us
+ ****************************************************************************/
+
+static unsigned long elapsed_us(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000ul +
+         (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/****************************************************************************
+ * name: run_bench
+ ****************************************************************************/
+
+static unsigned long run_bench(FAR struct voices_s *v, render_t render,
+                               FAR int16_t *buf, int seconds)
+{
+  struct timespec start;
+  int frames;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (frames = 0; frames < APP_FS * seconds; frames += APP_FRAMES)
+    {
+      render(v->sound[0], buf, APP_FRAMES, 1, NULL, 0);
+    }
+
+  return elapsed_us(&start);
+}
+
+/****************************************************************************
+ * name: compare_output
+ ****************************************************************************/
+
+static int compare_output(FAR struct voices_s *scalar,
+                          FAR struct voices_s *block, int seconds)
+{
+  int frames;
+  int diff;
+  int max = 0;
+  int i;
+
+  for (frames = 0; frames < APP_FS * seconds; frames += APP_FRAMES)
+    {
+      fmsynth_rendering(scalar->sound[0], g_scalar_buf, APP_FRAMES, 1,
+                        NULL, 0);
+      fmsynth_rendering_block(block->sound[0], g_block_buf, APP_FRAMES, 1,
+                              NULL, 0);
+
+      for (i = 0; i < APP_FRAMES; i++)
+        {
+          diff = abs(g_scalar_buf[i] - g_block_buf[i]);
+          if (diff > max)
+            {
+              max = diff;
+            }
+        }
+    }
+
+  return max;
+}
+
+/****************************************************************************
+ * name: print_result
+ ****************************************************************************/
+
+static void print_result(FAR const char *name, int voices, int seconds,
+                         unsigned long us)
+{
+  unsigned long load = us / (seconds * 10000ul);
+
+  printf("%-8s %3d voices: %8lu us for %ds of audio, load %3lu%%, "
+         "about %lu voices in real time\n",
+         name, voices, us, seconds, load,
+         us ? (unsigned long)((uint64_t)voices * seconds * 1000000 / us)
+            : 0);
+}
+
+/****************************************************************************
+ * name: print_help
+ ****************************************************************************/
+
+static void print_help(FAR char *name)
+{
+  printf("nsh> %s ([-n (voices up to %d)]) ([-s (seconds)]) "
+         "([-m (mode 0, 1 or 2)])\n", name, APP_MAX_VOICES);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct voices_s scalar;
+  struct voices_s block;
+  unsigned long us;
+  int seconds = APP_DEFAULT_SECONDS;
+  int voices = APP_DEFAULT_VOICES;
+  int mode = 2;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "hn:s:m:")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            voices = atoi(optarg);
+            break;
+
+          case 's':
+            seconds = atoi(optarg);
+            break;
+
+          case 'm':
+            mode = atoi(optarg);
+            break;
+
+          default:
+            print_help(argv[0]);
+            return -1;
+        }
+    }
+
+  if (voices < 1 || voices > APP_MAX_VOICES || seconds < 1 ||
+      mode < 0 || mode > 2)
+    {
+      print_help(argv[0]);
+      return -1;
+    }
+
+  fmsynth_initialize(APP_FS);
+
+  if (create_voices(&scalar, voices, mode) != OK)
+    {
+      printf("create_voices() error!!\n");
+      return -1;
+    }
+
+  if (create_voices(&block, voices, mode) != OK)
+    {
+      printf("create_voices() error!!\n");
+      delete_voices(&scalar);
+      return -1;
+    }
+
+  printf("mode %d, %d Hz, block size %d\n", mode, APP_FS,
+         FMSYNTH_BLOCK_SIZE);
+  printf("max difference to per-sample rendering over 1s: %d\n",
+         compare_output(&scalar, &block, 1));
+
+  us = run_bench(&scalar, fmsynth_rendering, g_scalar_buf, seconds);
+  print_result("sample", voices, seconds, us);
+
+  us = run_bench(&block, fmsynth_rendering_block, g_block_buf, seconds);
+  print_result("block", voices, seconds, us);
+
+  delete_voices(&block);
+  delete_voices(&scalar);
+  return 0;
+}
@@ -176,19 +176,20 @@ static void app_dequeue_cb(unsigned long arg,
 
   if (kbd->request_scale != -1)
     {
-      apb->nbytes = fmsynth_rendering(kbd->sound,
-                                      (FAR int16_t *)apb->samp,
-                                      apb->nmaxbytes / sizeof(int16_t),
-                                      kbd->nxaudio.chnum,
-                                      tick_callback, (unsigned long)kbd);
+      apb->nbytes = fmsynth_rendering_block(kbd->sound,
+                                            (FAR int16_t *)apb->samp,
+                                            apb->nmaxbytes / sizeof(int16_t),
+                                            kbd->nxaudio.chnum,
+                                            tick_callback,
+                                            (unsigned long)kbd);
     }
   else
     {
-      apb->nbytes = fmsynth_rendering(kbd->sound,
-                                      (FAR int16_t *)apb->samp,
-                                      apb->nmaxbytes / sizeof(int16_t),
-                                      kbd->nxaudio.chnum,
-                                      NULL, 0);
+      apb->nbytes = fmsynth_rendering_block(kbd->sound,
+                                            (FAR int16_t *)apb->samp,
+                                            apb->nmaxbytes / sizeof(int16_t),
+                                            kbd->nxaudio.chnum,
+                                            NULL, 0);
     }
 
   if (g_running)
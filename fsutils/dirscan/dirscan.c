@@ -0,0 +1,383 @@
+/****************************************************************************
+ * apps/fsutils/dirscan/dirscan.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fsutils/dirscan.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_FSUTILS_DIRSCAN_NCACHE
+#  define CONFIG_FSUTILS_DIRSCAN_NCACHE 0
+#endif
+
+/* A directory modified less than this many seconds before it was scanned
+ * may change again without a visible change of its modification time
+ * (FAT keeps it in units of two seconds).  Such listings are not cached.
+ */
+
+#define DIRSCAN_MTIME_SLACK 2
+
+#define DIRSCAN_ALIGN(n) \
+  (((n) + sizeof(uintmax_t) - 1) & ~(sizeof(uintmax_t) - 1))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+static pthread_mutex_t g_dirscan_lock = PTHREAD_MUTEX_INITIALIZER;
+static FAR struct dirscan_s *g_dirscan_cache;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: dirscan_compare
+ ****************************************************************************/
+
+static int dirscan_compare(FAR const void *a, FAR const void *b)
+{
+  return strcmp(((FAR const struct dirscan_entry_s *)a)->name,
+                ((FAR const struct dirscan_entry_s *)b)->name);
+}
+
+/****************************************************************************
+ * Name: dirscan_read
+ *
+ * Description:
+ *   Make a new listing of 'path'.  A first pass over the directory sizes
+ *   the allocation, the second one fills it in.  Entries that show up
+ *   between the two passes are not listed.
+ *
+ ****************************************************************************/
+
+static FAR struct dirscan_s *dirscan_read(FAR const char *path,
+                                          unsigned int flags)
+{
+  FAR struct dirscan_entry_s *entry;
+  FAR struct dirscan_s *scan;
+  FAR struct dirent *de;
+  FAR char *namebuf;
+  FAR char *nameend;
+  FAR char *pathbuf;
+  FAR char *linkbuf;
+  FAR char *leaf;
+  size_t nentries = 0;
+  size_t namelen = 0;
+  size_t maxname = 0;
+  size_t nlinks = 0;
+  size_t pathlen;
+  size_t len;
+  size_t size;
+  ssize_t ret;
+  DIR *dirp;
+
+  dirp = opendir(path);
+  if (dirp == NULL)
+    {
+      return NULL;
+    }
+
+  while ((de = readdir(dirp)) != NULL)
+    {
+      len = strlen(de->d_name) + 1;
+      if (len > maxname)
+        {
+          maxname = len;
+        }
+
+      if ((flags & DIRSCAN_READLINK) != 0 && DIRENT_ISLINK(de->d_type))
+        {
+          nlinks++;
+        }
+
+      namelen += len;
+      nentries++;
+    }
+
+  /* Layout: the listing, the entries, the directory path, a buffer to
+   * build the path of each entry, the entry names and the link targets.
+   */
+
+  pathlen = strlen(path);
+  size    = DIRSCAN_ALIGN(sizeof(struct dirscan_s)) +
+            nentries * sizeof(struct dirscan_entry_s) +
+            2 * (pathlen + 1) + maxname + namelen + nlinks * PATH_MAX;
+
+  scan = malloc(size);
+  if (scan == NULL)
+    {
+      closedir(dirp);
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  memset(scan, 0, sizeof(*scan));
+  scan->entries = (FAR struct dirscan_entry_s *)
+                  ((FAR char *)scan + DIRSCAN_ALIGN(sizeof(*scan)));
+  scan->flags   = flags;
+  scan->refs    = 1;
+
+  pathbuf = (FAR char *)&scan->entries[nentries];
+  memcpy(pathbuf, path, pathlen + 1);
+  scan->path = pathbuf;
+
+  /* Build "<path>/<name>" by only replacing the leaf for every entry */
+
+  pathbuf += pathlen + 1;
+  memcpy(pathbuf, path, pathlen);
+  leaf = pathbuf + pathlen;
+  if (pathlen == 0 || path[pathlen - 1] != '/')
+    {
+      *leaf++ = '/';
+    }
+
+  namebuf = pathbuf + pathlen + 1 + maxname;
+  nameend = namebuf + namelen;
+  linkbuf = nameend;
+
+  rewinddir(dirp);
+  while (scan->nentries < nentries && (de = readdir(dirp)) != NULL)
+    {
+      len = strlen(de->d_name) + 1;
+      if (len > maxname || namebuf + len > nameend)
+        {
+          continue;
+        }
+
+      entry       = &scan->entries[scan->nentries++];
+      memset(entry, 0, sizeof(*entry));
+      entry->name = namebuf;
+      entry->type = de->d_type;
+      memcpy(namebuf, de->d_name, len);
+      namebuf += len;
+
+      if ((flags & (DIRSCAN_STAT | DIRSCAN_READLINK)) == 0)
+        {
+          continue;
+        }
+
+      memcpy(leaf, entry->name, len);
+
+      if ((flags & DIRSCAN_STAT) != 0 && stat(pathbuf, &entry->st) < 0)
+        {
+          entry->staterr = errno;
+        }
+
+      if ((flags & DIRSCAN_READLINK) != 0 && DIRENT_ISLINK(entry->type) &&
+          nlinks > 0)
+        {
+          ret = readlink(pathbuf, linkbuf, PATH_MAX - 1);
+          if (ret < 0)
+            {
+              entry->linkerr = errno;
+            }
+          else
+            {
+              linkbuf[ret] = '\0';
+              entry->link  = linkbuf;
+              linkbuf     += PATH_MAX;
+              nlinks--;
+            }
+        }
+    }
+
+  closedir(dirp);
+
+  qsort(scan->entries, scan->nentries, sizeof(struct dirscan_entry_s),
+        dirscan_compare);
+  return scan;
+}
+
+/****************************************************************************
+ * Name: dirscan_release
+ *
+ * Description:
+ *   Drop one reference to a listing.  Called with the cache locked.
+ *
+ ****************************************************************************/
+
+static void dirscan_release(FAR struct dirscan_s *scan)
+{
+  if (--scan->refs == 0)
+    {
+      free(scan);
+    }
+}
+
+/****************************************************************************
+ * Name: dirscan_lookup
+ *
+ * Description:
+ *   Find a usable cached listing of 'path' and take a reference to it.
+ *   Cached listings of 'path' that are out of date are dropped.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+static FAR struct dirscan_s *dirscan_lookup(FAR const char *path,
+                                            unsigned int flags,
+                                            time_t mtime)
+{
+  FAR struct dirscan_s **prev = &g_dirscan_cache;
+  FAR struct dirscan_s *scan;
+
+  while ((scan = *prev) != NULL)
+    {
+      if (strcmp(scan->path, path) != 0)
+        {
+          prev = &scan->flink;
+          continue;
+        }
+
+      *prev = scan->flink;
+      if (scan->mtime == mtime && (flags & ~scan->flags) == 0)
+        {
+          /* Move it to the front, the cache is kept in the order of use */
+
+          scan->flink     = g_dirscan_cache;
+          g_dirscan_cache = scan;
+          scan->refs++;
+          return scan;
+        }
+
+      dirscan_release(scan);
+    }
+
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: dirscan_insert
+ *
+ * Description:
+ *   Keep a new listing in the cache, pushing out the least recently used
+ *   one if the cache is full.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+static void dirscan_insert(FAR struct dirscan_s *scan)
+{
+  FAR struct dirscan_s **prev;
+  int n = 1;
+
+  scan->refs++;
+  scan->flink     = g_dirscan_cache;
+  g_dirscan_cache = scan;
+
+  for (prev = &scan->flink; *prev != NULL; n++)
+    {
+      if (n >= CONFIG_FSUTILS_DIRSCAN_NCACHE)
+        {
+          scan  = *prev;
+          *prev = scan->flink;
+          dirscan_release(scan);
+        }
+      else
+        {
+          prev = &(*prev)->flink;
+        }
+    }
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: dirscan_open
+ ****************************************************************************/
+
+FAR struct dirscan_s *dirscan_open(FAR const char *path, unsigned int flags)
+{
+  FAR struct dirscan_s *scan;
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+  struct stat st;
+
+  if (stat(path, &st) < 0)
+    {
+      return NULL;
+    }
+
+  pthread_mutex_lock(&g_dirscan_lock);
+  scan = dirscan_lookup(path, flags, st.st_mtime);
+  pthread_mutex_unlock(&g_dirscan_lock);
+
+  if (scan != NULL)
+    {
+      return scan;
+    }
+#endif
+
+  scan = dirscan_read(path, flags);
+
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+  /* File systems without directory times report 0, do not cache those */
+
+  if (scan != NULL && st.st_mtime != 0 &&
+      time(NULL) - st.st_mtime >= DIRSCAN_MTIME_SLACK)
+    {
+      scan->mtime = st.st_mtime;
+
+      pthread_mutex_lock(&g_dirscan_lock);
+      dirscan_insert(scan);
+      pthread_mutex_unlock(&g_dirscan_lock);
+    }
+#endif
+
+  return scan;
+}
+
+/****************************************************************************
+ * Name: dirscan_close
+ ****************************************************************************/
+
+void dirscan_close(FAR struct dirscan_s *scan)
+{
+#if CONFIG_FSUTILS_DIRSCAN_NCACHE > 0
+  pthread_mutex_lock(&g_dirscan_lock);
+  dirscan_release(scan);
+  pthread_mutex_unlock(&g_dirscan_lock);
+#else
+  dirscan_release(scan);
+#endif
+}
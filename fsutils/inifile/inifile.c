@@ -24,9 +24,16 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <debug.h>
 
 #include "fsutils/inifile.h"
@@ -63,6 +70,12 @@
 #  define iniinfo printf
 #endif
 
+/* Size of the arena chunks holding the sections and variables of the
+ * in-memory index.  Larger allocations get a chunk of their own.
+ */
+
+#define INIFILE_ARENA_CHUNK 1024
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -75,6 +88,49 @@ struct inifile_var_s
   FAR char *value;
 };
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/* One chunk of the arena holding the whole in-memory index */
+
+struct inifile_arena_s
+{
+  FAR struct inifile_arena_s *next;
+  size_t size;
+  size_t used;
+};
+
+/* A section header of the INI file */
+
+struct inifile_section_s
+{
+  FAR struct inifile_section_s *next;
+  FAR const char *name;
+};
+
+/* One variable of the index.  The strings point into the copy of the INI
+ * file held by the arena.
+ */
+
+struct inifile_entry_s
+{
+  FAR struct inifile_entry_s *next;   /* Next variable in file order */
+  FAR struct inifile_entry_s *chain;  /* Next variable of the hash bucket */
+  FAR const char *section;
+  FAR char *variable;
+  FAR char *value;
+  uint32_t hash;
+};
+
+/* A structure describes the parsed INI file */
+
+struct inifile_state_s
+{
+  FAR struct inifile_arena_s *arena;
+  FAR struct inifile_section_s *sections;
+  FAR struct inifile_entry_s *entries;
+  FAR struct inifile_entry_s **buckets;
+  uint32_t nbuckets;                  /* Power of two */
+};
+#else
 /* A structure describes the state of one instance of the INI file parser */
 
 struct inifile_state_s
@@ -83,6 +139,7 @@ struct inifile_state_s
   int   nextch;
   char  line[CONFIG_FSUTILS_INIFILE_MAXLINE + 1];
 };
+#endif
 
 /****************************************************************************
  * Private Data
@@ -92,6 +149,17 @@ struct inifile_state_s
  * Private Function Prototypes
  ****************************************************************************/
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+static FAR void *inifile_alloc(FAR struct inifile_state_s *priv,
+              size_t size);
+static uint32_t inifile_hash(FAR const char *section,
+              FAR const char *variable);
+static int  inifile_parse(FAR struct inifile_state_s *priv, FAR char *text,
+              size_t len);
+static int  inifile_build_index(FAR struct inifile_state_s *priv);
+static int  inifile_load(FAR struct inifile_state_s *priv,
+              FAR const char *inifile_name);
+#else
 static bool inifile_next_line(FAR struct inifile_state_s *priv);
 static int  inifile_read_line(FAR struct inifile_state_s *priv);
 static int  inifile_read_noncomment_line(FAR struct inifile_state_s *priv);
@@ -102,6 +170,7 @@ static bool inifile_read_variable(FAR struct inifile_state_s *priv,
 static FAR char *
             inifile_find_section_variable(FAR struct inifile_state_s *priv,
               FAR const char *variable);
+#endif
 static FAR char *
             inifile_find_variable(FAR struct inifile_state_s *priv,
               FAR const char *section, FAR const char *variable);
@@ -110,6 +179,385 @@ static FAR char *
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/****************************************************************************
+ * Name:  inifile_alloc
+ *
+ * Description:
+ *   Allocate memory from the arena of the index.  Everything allocated is
+ *   released at once by inifile_uninitialize().
+ *
+ ****************************************************************************/
+
+static FAR void *inifile_alloc(FAR struct inifile_state_s *priv,
+                               size_t size)
+{
+  FAR struct inifile_arena_s *chunk = priv->arena;
+  FAR void *ptr;
+
+  size = (size + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+
+  if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+      size_t chunksize = size > INIFILE_ARENA_CHUNK ?
+                         size : INIFILE_ARENA_CHUNK;
+
+      chunk = malloc(sizeof(struct inifile_arena_s) + chunksize);
+      if (chunk == NULL)
+        {
+          return NULL;
+        }
+
+      chunk->next = priv->arena;
+      chunk->size = chunksize;
+      chunk->used = 0;
+      priv->arena = chunk;
+    }
+
+  ptr = (FAR uint8_t *)(chunk + 1) + chunk->used;
+  chunk->used += size;
+  return ptr;
+}
+
+/****************************************************************************
+ * Name:  inifile_hash
+ *
+ * Description:
+ *   FNV-1a hash of the section and variable names.  Names are compared
+ *   without regard to case, so they are hashed in lower case.
+ *
+ ****************************************************************************/
+
+static uint32_t inifile_hash(FAR const char *section,
+                             FAR const char *variable)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*section)
+    {
+      hash = (hash ^ tolower((unsigned char)*section++)) * 16777619u;
+    }
+
+  hash *= 16777619u;
+
+  while (*variable)
+    {
+      hash = (hash ^ tolower((unsigned char)*variable++)) * 16777619u;
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name:  inifile_parse
+ *
+ * Description:
+ *   Split the INI file text into sections and variables in place.  Lines
+ *   are handled as by inifile_read_line() and the variables recorded are
+ *   the ones the stream parser would find: those before the first empty
+ *   line of the first section with a given name.
+ *
+ ****************************************************************************/
+
+static int inifile_parse(FAR struct inifile_state_s *priv, FAR char *text,
+                         size_t len)
+{
+  FAR struct inifile_entry_s **tail = &priv->entries;
+  FAR struct inifile_section_s *sect;
+  FAR struct inifile_entry_s *entry;
+  FAR const char *section = NULL;
+  FAR char *end = text + len;
+  FAR char *ptr = text;
+  FAR char *line;
+  FAR char *delim;
+  int nbytes;
+  int nentries = 0;
+
+  while (ptr < end)
+    {
+      /* Compact the line: drop carriage returns and leading whitespace and
+       * truncate it to CONFIG_FSUTILS_INIFILE_MAXLINE characters.
+       */
+
+      line = ptr;
+      nbytes = 0;
+
+      for (; ptr < end && *ptr != '\n'; ptr++)
+        {
+          if (*ptr != '\r' && nbytes < CONFIG_FSUTILS_INIFILE_MAXLINE &&
+              (nbytes || (*ptr != ' ' && *ptr != '\t')))
+            {
+              line[nbytes++] = *ptr;
+            }
+        }
+
+      line[nbytes] = '\0';
+      ptr++;
+
+      /* An empty line ends the variables of the section */
+
+      if (nbytes == 0)
+        {
+          section = NULL;
+          continue;
+        }
+
+      if (line[0] == ';')
+        {
+          continue;
+        }
+
+      if (line[0] == '[')
+        {
+          section = NULL;
+
+          if (nbytes < 3)
+            {
+              continue;
+            }
+
+          delim = strchr(&line[1], ']');
+          if (delim)
+            {
+              *delim = '\0';
+            }
+
+          /* Only the first section of a given name is ever searched */
+
+          for (sect = priv->sections; sect; sect = sect->next)
+            {
+              if (strcasecmp(sect->name, &line[1]) == 0)
+                {
+                  break;
+                }
+            }
+
+          if (sect == NULL)
+            {
+              sect = inifile_alloc(priv, sizeof(struct inifile_section_s));
+              if (sect == NULL)
+                {
+                  return -ENOMEM;
+                }
+
+              sect->name = &line[1];
+              sect->next = priv->sections;
+              priv->sections = sect;
+              section = sect->name;
+            }
+
+          continue;
+        }
+
+      delim = strchr(&line[1], '=');
+      if (section == NULL || delim == NULL)
+        {
+          continue;
+        }
+
+      *delim = '\0';
+
+      entry = inifile_alloc(priv, sizeof(struct inifile_entry_s));
+      if (entry == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      entry->next = NULL;
+      entry->section = section;
+      entry->variable = line;
+      entry->value = delim + 1;
+      entry->hash = inifile_hash(section, line);
+
+      *tail = entry;
+      tail = &entry->next;
+      nentries++;
+    }
+
+  return nentries;
+}
+
+/****************************************************************************
+ * Name:  inifile_build_index
+ *
+ * Description:
+ *   Hash the variables found by inifile_parse().  The first occurrence of a
+ *   variable in a section wins, later ones are dropped from the index.
+ *
+ ****************************************************************************/
+
+static int inifile_build_index(FAR struct inifile_state_s *priv)
+{
+  FAR struct inifile_entry_s **prev;
+  FAR struct inifile_entry_s *entry;
+  FAR struct inifile_entry_s *other;
+  FAR struct inifile_entry_s **bucket;
+  int nentries = 0;
+
+  for (entry = priv->entries; entry; entry = entry->next)
+    {
+      nentries++;
+    }
+
+  /* Keep the load factor at or below one half */
+
+  priv->nbuckets = 1;
+  while (priv->nbuckets < 2 * nentries)
+    {
+      priv->nbuckets <<= 1;
+    }
+
+  priv->buckets = inifile_alloc(priv, priv->nbuckets *
+                                sizeof(FAR struct inifile_entry_s *));
+  if (priv->buckets == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memset(priv->buckets, 0, priv->nbuckets *
+         sizeof(FAR struct inifile_entry_s *));
+
+  prev = &priv->entries;
+  while ((entry = *prev) != NULL)
+    {
+      bucket = &priv->buckets[entry->hash & (priv->nbuckets - 1)];
+
+      for (other = *bucket; other; other = other->chain)
+        {
+          if (other->hash == entry->hash &&
+              other->section == entry->section &&
+              strcasecmp(other->variable, entry->variable) == 0)
+            {
+              break;
+            }
+        }
+
+      if (other)
+        {
+          *prev = entry->next;
+          continue;
+        }
+
+      entry->chain = *bucket;
+      *bucket = entry;
+      prev = &entry->next;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name:  inifile_load
+ *
+ * Description:
+ *   Read the whole INI file into the arena and build the index.
+ *
+ ****************************************************************************/
+
+static int inifile_load(FAR struct inifile_state_s *priv,
+                        FAR const char *inifile_name)
+{
+  struct stat buf;
+  FAR char *text;
+  ssize_t nread;
+  size_t len = 0;
+  int ret;
+  int fd;
+
+  fd = open(inifile_name, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (fstat(fd, &buf) < 0)
+    {
+      ret = -errno;
+      goto errout;
+    }
+
+  text = inifile_alloc(priv, buf.st_size + 1);
+  if (text == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  while (len < buf.st_size)
+    {
+      nread = read(fd, text + len, buf.st_size - len);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          ret = -errno;
+          goto errout;
+        }
+      else if (nread == 0)
+        {
+          break;
+        }
+
+      len += nread;
+    }
+
+  close(fd);
+
+  ret = inifile_parse(priv, text, len);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  iniinfo("%d variables\n", ret);
+  return inifile_build_index(priv);
+
+errout:
+  close(fd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name:  inifile_find_variable
+ *
+ * Description:
+ *   Obtains the specified string value for the specified variable name
+ *   within the specified section of the INI file.
+ *
+ ****************************************************************************/
+
+static FAR char *inifile_find_variable(FAR struct inifile_state_s *priv,
+                                       FAR const char *section,
+                                       FAR const char *variable)
+{
+  FAR struct inifile_entry_s *entry;
+  uint32_t hash;
+
+  iniinfo("section=\"%s\" variable=\"%s\"\n", section, variable);
+
+  hash = inifile_hash(section, variable);
+
+  for (entry = priv->buckets[hash & (priv->nbuckets - 1)]; entry;
+       entry = entry->chain)
+    {
+      if (entry->hash == hash &&
+          strcasecmp(entry->section, section) == 0 &&
+          strcasecmp(entry->variable, variable) == 0)
+        {
+          /* A variable without a value is not found */
+
+          iniinfo("Returning \"%s\"\n", entry->value);
+          return *entry->value ? entry->value : NULL;
+        }
+    }
+
+  iniinfo("Returning NULL\n");
+  return NULL;
+}
+#else
 /****************************************************************************
  * Name:  inifile_next_line
  *
@@ -463,6 +911,7 @@ static FAR char *inifile_find_variable(FAR struct inifile_state_s *priv,
   iniinfo("Returning 0x%p\n", ret);
   return ret;
 }
+#endif /* CONFIG_FSUTILS_INIFILE_INDEX */
 
 /****************************************************************************
  * Public Functions
@@ -489,6 +938,20 @@ INIHANDLE inifile_initialize(FAR const char *inifile_name)
       return NULL;
     }
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+  /* Parse the whole INI file once */
+
+  memset(priv, 0, sizeof(struct inifile_state_s));
+
+  if (inifile_load(priv, inifile_name) < 0)
+    {
+      inidbg("ERROR: Could not load \"%s\"\n", inifile_name);
+      inifile_uninitialize((INIHANDLE)priv);
+      return NULL;
+    }
+
+  return (INIHANDLE)priv;
+#else
   /* Open the specified INI file for reading */
 
   priv->instream = fopen(inifile_name, "r");
@@ -506,6 +969,7 @@ INIHANDLE inifile_initialize(FAR const char *inifile_name)
       free(priv);
       return NULL;
     }
+#endif
 }
 
 /****************************************************************************
@@ -519,15 +983,28 @@ INIHANDLE inifile_initialize(FAR const char *inifile_name)
 void inifile_uninitialize(INIHANDLE handle)
 {
   FAR struct inifile_state_s *priv = (FAR struct inifile_state_s *)handle;
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+  FAR struct inifile_arena_s *chunk;
+#endif
 
   if (priv)
     {
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+      /* Release the arena holding the index */
+
+      while ((chunk = priv->arena) != NULL)
+        {
+          priv->arena = chunk->next;
+          free(chunk);
+        }
+#else
       /* Close the INI file stream */
 
       if (priv->instream)
         {
           fclose(priv->instream);
         }
+#endif
 
       /* Release the state structure */
 
@@ -645,3 +1122,79 @@ void inifile_free_string(FAR char *value)
       free(value);
     }
 }
+
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/****************************************************************************
+ * Name:  inifile_iter_init
+ *
+ * Description:
+ *   Prepare iter for visiting the variables of one section (or of all
+ *   sections if section is NULL) in file order.
+ *
+ ****************************************************************************/
+
+void inifile_iter_init(INIHANDLE handle, FAR const char *section,
+                       FAR struct inifile_iter_s *iter)
+{
+  FAR struct inifile_state_s *priv = (FAR struct inifile_state_s *)handle;
+
+  iter->next = priv ? priv->entries : NULL;
+  iter->section = section;
+}
+
+/****************************************************************************
+ * Name:  inifile_iter_next
+ *
+ * Description:
+ *   Return the next variable of the iteration.  The strings belong to the
+ *   handle and stay valid until inifile_uninitialize().  Variables without
+ *   a value are skipped, like inifile_read_string() does not find them.
+ *
+ * Returned Value:
+ *   true if a variable was returned, false at the end of the iteration.
+ *
+ ****************************************************************************/
+
+bool inifile_iter_next(FAR struct inifile_iter_s *iter,
+                       FAR const char **section,
+                       FAR const char **variable,
+                       FAR const char **value)
+{
+  FAR const struct inifile_entry_s *entry = iter->next;
+
+  for (; entry; entry = entry->next)
+    {
+      if (*entry->value &&
+          (iter->section == NULL ||
+           strcasecmp(entry->section, iter->section) == 0))
+        {
+          break;
+        }
+    }
+
+  if (entry == NULL)
+    {
+      iter->next = NULL;
+      return false;
+    }
+
+  iter->next = entry->next;
+
+  if (section)
+    {
+      *section = entry->section;
+    }
+
+  if (variable)
+    {
+      *variable = entry->variable;
+    }
+
+  if (value)
+    {
+      *value = entry->value;
+    }
+
+  return true;
+}
+#endif /* CONFIG_FSUTILS_INIFILE_INDEX */
@@ -25,10 +25,13 @@
 #include <nuttx/config.h>
 
 #include <sys/ioctl.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <string.h>
+#include <syslog.h>
+#include <time.h>
 #include <debug.h>
 #include <errno.h>
 #include <unistd.h>
@@ -50,6 +53,10 @@
 #  define fat_buffer_alloc(s) malloc((s))
 #endif
 
+#ifndef CONFIG_MKFATFS_WRITE_SECTORS
+#  define CONFIG_MKFATFS_WRITE_SECTORS 1
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -209,6 +216,36 @@ static inline int mkfatfs_getgeometry(FAR struct fat_format_s *fmt,
   return 0;
 }
 
+/****************************************************************************
+ * Name: mkfatfs_report
+ *
+ * Description:
+ *   Log the number of sectors formatted and the write throughput.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MKFATFS_REPORT
+static void mkfatfs_report(FAR const char *pathname,
+                           FAR const struct fat_var_s *var,
+                           FAR const struct timespec *start)
+{
+  struct timespec now;
+  uint64_t nbytes;
+  uint32_t msec;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  msec = (now.tv_sec - start->tv_sec) * 1000 +
+         (now.tv_nsec - start->tv_nsec) / 1000000;
+
+  nbytes = (uint64_t)var->fv_nwritten << var->fv_sectshift;
+
+  syslog(LOG_INFO, "mkfatfs: %s: %" PRIu32 " sectors written, %" PRIu32
+         " skipped in %" PRIu32 " ms (%" PRIu64 " KiB/s)\n",
+         pathname, var->fv_nwritten, var->fv_nskipped, msec,
+         nbytes * 1000 / 1024 / (msec > 0 ? msec : 1));
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -244,6 +281,9 @@ static inline int mkfatfs_getgeometry(FAR struct fat_format_s *fmt,
 int mkfatfs(FAR const char *pathname, FAR struct fat_format_s *fmt)
 {
   struct fat_var_s var;
+#ifdef CONFIG_MKFATFS_REPORT
+  struct timespec start;
+#endif
   int ret;
 
   /* Initialize */
@@ -349,21 +389,46 @@ int mkfatfs(FAR const char *pathname, FAR struct fat_format_s *fmt)
       goto errout_with_driver;
     }
 
-  /* Allocate a buffer that will be working sector memory
-   * Lets align it as needed
+  /* Allocate a buffer that will be working sector memory, holding up to
+   * CONFIG_MKFATFS_WRITE_SECTORS sectors per transfer (but a single sector
+   * will do).  Lets align it as needed
    */
 
-  var.fv_sect = (FAR uint8_t *)fat_buffer_alloc(var.fv_sectorsize);
+  for (var.fv_nbufsects = CONFIG_MKFATFS_WRITE_SECTORS;
+       var.fv_nbufsects > 0; var.fv_nbufsects >>= 1)
+    {
+      var.fv_sect = (FAR uint8_t *)
+        fat_buffer_alloc(var.fv_nbufsects << var.fv_sectshift);
+      if (var.fv_sect)
+        {
+          break;
+        }
+    }
+
   if (!var.fv_sect)
     {
       ferr("ERROR: Failed to allocate working buffers\n");
+      ret = -ENOMEM;
       goto errout_with_driver;
     }
 
   /* Write the filesystem to media */
 
+  var.fv_fpos = -1;
+
+#ifdef CONFIG_MKFATFS_REPORT
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
   ret = mkfatfs_writefatfs(fmt, &var);
 
+#ifdef CONFIG_MKFATFS_REPORT
+  if (ret >= 0)
+    {
+      mkfatfs_report(pathname, &var, &start);
+    }
+#endif
+
 errout_with_driver:
 
   /* Close the driver */
@@ -26,6 +26,7 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <sys/types.h>
 #include <stdint.h>
 
 /****************************************************************************
@@ -72,6 +73,10 @@ struct fat_var_s
   uint32_t       fv_nfatsects;      /* Number of sectors in each FAT */
   uint32_t       fv_nclusters;      /* Number of clusters */
   uint8_t       *fv_sect;           /* Allocated working sector buffer */
+  uint32_t       fv_nbufsects;      /* Number of sectors in fv_sect */
+  off_t          fv_fpos;           /* Driver position, -1 if unknown */
+  uint32_t       fv_nwritten;       /* Number of sectors written */
+  uint32_t       fv_nskipped;       /* Zero sectors left as they were */
   uint8_t        fv_bootcodepatch;  /* FAT16/FAT32 Bootcode offset patch */
   const uint8_t *fv_bootcodeblob;   /* Points to boot code to put into MBR */
 };
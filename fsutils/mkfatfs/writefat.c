@@ -43,41 +43,49 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mkfatfs_devwrite
+ * Name: mkfatfs_devseek
  *
  * Description:
- *   Write the content of the dedicate sector buffer beginning to the
- *   specified sector
+ *   Position the block driver at the specified sector.  The lseek() is
+ *   skipped when the previous transfer ended at that sector.
  *
  * Input:
  *    fmt  - User specified format parameters
  *    var  - Other format parameters that are not user specifiable
+ *    sector - First sector of the transfer
+ *    nsectors - Number of sectors of the transfer
  *
  * Return:
- *    None; caller is responsible for providing valid parameters.
+ *    Zero on success; negated errno on failure
  *
  ****************************************************************************/
 
-static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
-                            FAR const struct fat_var_s *var, off_t sector)
+static int mkfatfs_devseek(FAR const struct fat_format_s *fmt,
+                           FAR struct fat_var_s *var, off_t sector,
+                           uint32_t nsectors)
 {
-  ssize_t nwritten;
   off_t seekpos;
   off_t fpos;
   int ret;
 
   /* Convert the sector number to a byte offset */
 
-  if (sector < 0 || sector >= (off_t)fmt->ff_nsectors)
+  if (sector < 0 || nsectors > fmt->ff_nsectors ||
+      sector > (off_t)(fmt->ff_nsectors - nsectors))
     {
       ferr("sector out of range: %ju\n", (intmax_t)sector);
       return -ESPIPE;
     }
 
   fpos = sector << var->fv_sectshift;
+  if (fpos == var->fv_fpos)
+    {
+      return OK;
+    }
 
   /* Seek to that offset */
 
+  var->fv_fpos = -1;
   seekpos = lseek(var->fv_fd, fpos, SEEK_SET);
   if (seekpos == (off_t)-1)
     {
@@ -92,23 +100,180 @@ static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
       return -EINVAL;
     }
 
-  /* Write the sector to that offset.  Partial writes are not expected. */
+  var->fv_fpos = fpos;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mkfatfs_devwrite
+ *
+ * Description:
+ *   Write the content of the dedicate sector buffer beginning to the
+ *   specified sector.  Up to fv_nbufsects sectors are written with one
+ *   write().
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *    sector - First sector to write
+ *    nsectors - Number of sectors to write from the sector buffer
+ *
+ * Return:
+ *    Zero on success; negated errno on failure
+ *
+ ****************************************************************************/
+
+static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
+                            FAR struct fat_var_s *var, off_t sector,
+                            uint32_t nsectors)
+{
+  size_t nbytes = nsectors << var->fv_sectshift;
+  ssize_t nwritten;
+  int ret;
+
+  DEBUGASSERT(nsectors > 0 && nsectors <= var->fv_nbufsects);
+
+  ret = mkfatfs_devseek(fmt, var, sector, nsectors);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Write the sectors to that offset.  Partial writes are not expected. */
 
-  nwritten = write(var->fv_fd, var->fv_sect, var->fv_sectorsize);
+  nwritten = write(var->fv_fd, var->fv_sect, nbytes);
   if (nwritten < 0)
     {
       ret = -errno;
-      ferr("ERROR:  write failed: size=%" PRIu32 " pos=%jd error=%d\n",
-           var->fv_sectorsize, (intmax_t)fpos, ret);
+      var->fv_fpos = -1;
+      ferr("ERROR:  write failed: size=%zu sector=%jd error=%d\n",
+           nbytes, (intmax_t)sector, ret);
       return ret;
     }
-  else if (nwritten != (ssize_t)var->fv_sectorsize)
+  else if (nwritten != (ssize_t)nbytes)
     {
-      ferr("ERROR:  Partial write: size=%" PRIu32 " written=%zd\n",
-           var->fv_sectorsize, nwritten);
+      var->fv_fpos = -1;
+      ferr("ERROR:  Partial write: size=%zu written=%zd\n",
+           nbytes, nwritten);
       return -ENODATA;
     }
 
+  var->fv_fpos += nbytes;
+  var->fv_nwritten += nsectors;
+  return OK;
+}
+
+#ifdef CONFIG_MKFATFS_FASTZERO
+/****************************************************************************
+ * Name: mkfatfs_deviszero
+ *
+ * Description:
+ *   Read sectors into the sector buffer and check if they are all zero.
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *    sector - First sector to read
+ *    nsectors - Number of sectors to read into the sector buffer
+ *
+ * Return:
+ *    true if the sectors could be read and contain only zeroes
+ *
+ ****************************************************************************/
+
+static bool mkfatfs_deviszero(FAR const struct fat_format_s *fmt,
+                              FAR struct fat_var_s *var, off_t sector,
+                              uint32_t nsectors)
+{
+  size_t nbytes = nsectors << var->fv_sectshift;
+  FAR const uintptr_t *ptr = (FAR const uintptr_t *)var->fv_sect;
+  size_t i;
+
+  if (mkfatfs_devseek(fmt, var, sector, nsectors) < 0)
+    {
+      return false;
+    }
+
+  if (read(var->fv_fd, var->fv_sect, nbytes) != (ssize_t)nbytes)
+    {
+      var->fv_fpos = -1;
+      return false;
+    }
+
+  var->fv_fpos += nbytes;
+
+  for (i = 0; i < nbytes / sizeof(uintptr_t); i++)
+    {
+      if (ptr[i] != 0)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: mkfatfs_devzero
+ *
+ * Description:
+ *   Fill a range of sectors with zeroes using transfers of fv_nbufsects
+ *   sectors.  With CONFIG_MKFATFS_FASTZERO, sectors that already read as
+ *   zero are not written again.
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *    sector - First sector to clear
+ *    nsectors - Number of sectors to clear
+ *
+ * Return:
+ *    Zero on success; negated errno on failure
+ *
+ ****************************************************************************/
+
+static int mkfatfs_devzero(FAR const struct fat_format_s *fmt,
+                           FAR struct fat_var_s *var, off_t sector,
+                           uint32_t nsectors)
+{
+  uint32_t nbatch;
+  bool clean = false;
+  int ret;
+
+  while (nsectors > 0)
+    {
+      nbatch = nsectors < var->fv_nbufsects ? nsectors : var->fv_nbufsects;
+
+#ifdef CONFIG_MKFATFS_FASTZERO
+      if (mkfatfs_deviszero(fmt, var, sector, nbatch))
+        {
+          /* The buffer holds zeroes now, but the next read may change it */
+
+          var->fv_nskipped += nbatch;
+          sector += nbatch;
+          nsectors -= nbatch;
+          clean = false;
+          continue;
+        }
+#endif
+
+      if (!clean)
+        {
+          memset(var->fv_sect, 0, var->fv_nbufsects << var->fv_sectshift);
+          clean = true;
+        }
+
+      ret = mkfatfs_devwrite(fmt, var, sector, nbatch);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      sector += nbatch;
+      nsectors -= nbatch;
+    }
+
   return OK;
 }
 
@@ -410,7 +575,6 @@ static inline void mkfatfs_initrootdir(FAR struct fat_format_s *fmt,
 static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
                                    FAR struct fat_var_s *var)
 {
-  int sectno;
   int ret;
 
   /* Create an image of the configured master boot record */
@@ -419,14 +583,13 @@ static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
 
   /* Write the master boot record as sector zero */
 
-  ret = mkfatfs_devwrite(fmt, var, 0);
+  ret = mkfatfs_devwrite(fmt, var, 0, 1);
 
   /* Write all of the reserved sectors */
 
-  memset(var->fv_sect, 0, var->fv_sectorsize);
-  for (sectno = 1; sectno < fmt->ff_rsvdseccount && ret >= 0; sectno++)
+  if (ret >= 0 && fmt->ff_rsvdseccount > 1)
     {
-      ret = mkfatfs_devwrite(fmt, var, sectno);
+      ret = mkfatfs_devzero(fmt, var, 1, fmt->ff_rsvdseccount - 1);
     }
 
   /* Write FAT32-specific sectors */
@@ -443,7 +606,7 @@ static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
 
           /* Write it to the backup location */
 
-          ret = mkfatfs_devwrite(fmt, var, fmt->ff_backupboot);
+          ret = mkfatfs_devwrite(fmt, var, fmt->ff_backupboot, 1);
         }
 
       if (ret >= 0)
@@ -454,7 +617,7 @@ static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
 
           /* Write the fsinfo sector */
 
-          ret = mkfatfs_devwrite(fmt, var, FAT_DEFAULT_FSINFO_SECTOR);
+          ret = mkfatfs_devwrite(fmt, var, FAT_DEFAULT_FSINFO_SECTOR, 1);
         }
     }
 
@@ -484,76 +647,80 @@ static inline int mkfatfs_writefat(FAR struct fat_format_s *fmt,
                                    FAR struct fat_var_s *var)
 {
   off_t offset = fmt->ff_rsvdseccount;
+  uint32_t nsectors;
   uint8_t fatno;
-  uint32_t sectno;
   int ret;
 
+  /* The first transfer of each FAT holds the first sector and as many of
+   * the following (zero) sectors as the sector buffer can hold.
+   */
+
+  nsectors = var->fv_nfatsects < var->fv_nbufsects ?
+             var->fv_nfatsects : var->fv_nbufsects;
+
   /* Loop for each FAT copy */
 
   for (fatno = 0; fatno < fmt->ff_nfats; fatno++)
     {
-      /* Loop for each sector in the FAT */
-
-      for (sectno = 0; sectno < var->fv_nfatsects; sectno++)
-        {
-          memset(var->fv_sect, 0, var->fv_sectorsize);
+      memset(var->fv_sect, 0, nsectors << var->fv_sectshift);
 
-          /* Mark cluster allocations in sector one of each FAT */
+      /* Mark cluster allocations in sector one of each FAT */
 
-          if (sectno == 0)
-            {
-              memset(var->fv_sect, 0, var->fv_sectorsize);
-              switch (fmt->ff_fattype)
-                {
-                  case 12:
-                    /* Mark the first two full FAT entries -- 24 bits,
-                     * 3 bytes total
-                     */
+      switch (fmt->ff_fattype)
+        {
+          case 12:
+            /* Mark the first two full FAT entries -- 24 bits,
+             * 3 bytes total
+             */
 
-                    memset(var->fv_sect, 0xff, 3);
-                    break;
+            memset(var->fv_sect, 0xff, 3);
+            break;
 
-                  case 16:
-                    /* Mark the first two full FAT entries -- 32 bits,
-                     * 4 bytes total
-                     */
+          case 16:
+            /* Mark the first two full FAT entries -- 32 bits,
+             * 4 bytes total
+             */
 
-                    memset(var->fv_sect, 0xff, 4);
-                    break;
+            memset(var->fv_sect, 0xff, 4);
+            break;
 
-                  case 32:
-                  default: /* Shouldn't happen */
+          case 32:
+          default: /* Shouldn't happen */
 
-                    /* Mark the first two full FAT entries -- 64 bits,
-                     * 8 bytes total
-                     */
+            /* Mark the first two full FAT entries -- 64 bits,
+             * 8 bytes total
+             */
 
-                    memset(var->fv_sect, 0xff, 8);
+            memset(var->fv_sect, 0xff, 8);
 
-                    /* Cluster 2 is used as the root directory.
-                     * Mark as EOF
-                     */
+            /* Cluster 2 is used as the root directory.
+             * Mark as EOF
+             */
 
-                    var->fv_sect[8] =  0xf8;
-                    memset(&var->fv_sect[9], 0xff, 3);
-                    break;
-                }
+            var->fv_sect[8] =  0xf8;
+            memset(&var->fv_sect[9], 0xff, 3);
+            break;
+        }
 
-              /* Save the media type in the first byte of the FAT */
+      /* Save the media type in the first byte of the FAT */
 
-              var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
-            }
+      var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
 
-          /* Write the FAT sector */
+      /* Write the first FAT sectors, then clear the rest of the FAT */
 
-          ret = mkfatfs_devwrite(fmt, var, offset);
-          if (ret < 0)
-            {
-              return ret;
-            }
+      ret = mkfatfs_devwrite(fmt, var, offset, nsectors);
+      if (ret >= 0)
+        {
+          ret = mkfatfs_devzero(fmt, var, offset + nsectors,
+                                var->fv_nfatsects - nsectors);
+        }
 
-          offset++;
+      if (ret < 0)
+        {
+          return ret;
         }
+
+      offset += var->fv_nfatsects;
     }
 
   return OK;
@@ -578,31 +745,32 @@ static inline int mkfatfs_writerootdir(FAR struct fat_format_s *fmt,
                                        FAR struct fat_var_s *var)
 {
   off_t offset = fmt->ff_rsvdseccount + fmt->ff_nfats * var->fv_nfatsects;
+  uint32_t nsectors;
   int ret;
-  int i;
 
   /* Write the root directory after the last FAT. This is the root directory
-   * area for FAT12/16, and the first cluster on FAT32.
+   * area for FAT12/16, and the first cluster on FAT32.  Only its first
+   * sector has content.
    */
 
-  for (i = 0; i < var->fv_nrootdirsects; i++)
+  nsectors = var->fv_nrootdirsects < var->fv_nbufsects ?
+             var->fv_nrootdirsects : var->fv_nbufsects;
+  if (nsectors == 0)
     {
-      /* Format the next sector of the root directory */
-
-      mkfatfs_initrootdir(fmt, var, i);
-
-      /* Write the next sector of the root directory */
+      return OK;
+    }
 
-      ret = mkfatfs_devwrite(fmt, var, offset);
-      if (ret < 0)
-        {
-          return ret;
-        }
+  memset(var->fv_sect, 0, nsectors << var->fv_sectshift);
+  mkfatfs_initrootdir(fmt, var, 0);
 
-      offset++;
+  ret = mkfatfs_devwrite(fmt, var, offset, nsectors);
+  if (ret < 0)
+    {
+      return ret;
     }
 
-  return 0;
+  return mkfatfs_devzero(fmt, var, offset + nsectors,
+                         var->fv_nrootdirsects - nsectors);
 }
 
 /****************************************************************************
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////
+// apps/graphics/nxwidgets/UnitTests/CNxString/cnxstring_main.cxx
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Included Files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <nuttx/config.h>
+
+#include <cstdio>
+
+#include "cnxstringtest.hxx"
+
+/////////////////////////////////////////////////////////////////////////////
+// Definitions
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Classes
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Data
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Function Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+// Suppress name-mangling
+
+extern "C" int main(int argc, char *argv[]);
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Functions
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// cnxstring_main
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+  // Create an instance of the string test
+
+  printf("cnxstring_main: Create CNxStringTest instance\n");
+  CNxStringTest *test = new CNxStringTest();
+
+  // Create the font used for the string width queries
+
+  if (!test->createFont())
+    {
+      printf("cnxstring_main: Failed to create the font\n");
+    }
+
+  int inuse = getHeapInUse();
+
+  // Run the tests
+
+  test->testInline();
+  test->testMove();
+  test->testViews();
+  test->testIterator();
+  test->testStringWidth();
+
+  printf("cnxstring_main: %d bytes of heap held after the tests\n",
+         getHeapInUse() - inuse);
+
+  if (getHeapInUse() != inuse)
+    {
+      printf("cnxstring_main: Memory was leaked\n");
+      delete test;
+      return 1;
+    }
+
+  // Clean up and exit
+
+  int failures = test->getFailures();
+  printf("cnxstring_main: %d failure(s)\n", failures);
+
+  delete test;
+  return failures > 0 ? 1 : 0;
+}
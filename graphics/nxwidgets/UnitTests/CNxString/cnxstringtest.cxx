@@ -0,0 +1,318 @@
+/////////////////////////////////////////////////////////////////////////////
+// apps/graphics/nxwidgets/UnitTests/CNxString/cnxstringtest.cxx
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Included Files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <nuttx/config.h>
+
+#include <cstdio>
+#include <utility>
+#include <malloc.h>
+
+#include <nuttx/nx/nxfonts.h>
+
+#include "graphics/nxwidgets/nxconfig.hxx"
+#include "graphics/nxwidgets/cstringiterator.hxx"
+#include "cnxstringtest.hxx"
+
+/////////////////////////////////////////////////////////////////////////////
+// Definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// Length of the longest string used by the tests that is expected to fit
+// the inline storage of a CNxString ("Hello, World")
+
+#define SHORT_STRING_LENGTH 12
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Classes
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Data
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Data
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Function Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Functions
+/////////////////////////////////////////////////////////////////////////////
+
+// Get the number of heap bytes in use.  This only sees memory that is
+// still held when it is called, so each check reads it while the objects
+// created by the step under test are alive.
+
+int getHeapInUse(void)
+{
+  struct mallinfo mmcurrent = mallinfo();
+  return mmcurrent.uordblks;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CNxStringTest Method Implementations
+/////////////////////////////////////////////////////////////////////////////
+
+// CNxStringTest Constructor
+
+CNxStringTest::CNxStringTest()
+{
+  m_nxFont   = NULL;
+  m_failures = 0;
+}
+
+// CNxStringTest Descriptor
+
+CNxStringTest::~CNxStringTest()
+{
+  delete m_nxFont;
+}
+
+// Record the result of one check
+
+void CNxStringTest::check(bool ok, FAR const char *what)
+{
+  printf("CNxStringTest: %s: %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+    {
+      m_failures++;
+    }
+}
+
+// Compare the characters of a view to a C string
+
+bool CNxStringTest::equals(const CNxStringView &view, FAR const char *text)
+{
+  int i;
+
+  for (i = 0; i < view.getLength(); i++)
+    {
+      if (text[i] == '\0' || view.getCharAt(i) != (nxwidget_char_t)text[i])
+        {
+          return false;
+        }
+    }
+
+  return text[i] == '\0';
+}
+
+// Create the font used by testStringWidth()
+
+bool CNxStringTest::createFont(void)
+{
+  m_nxFont = new CNxFont(NXFONT_DEFAULT,
+                         CONFIG_NXWIDGETS_DEFAULT_FONTCOLOR,
+                         CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  return m_nxFont != NULL;
+}
+
+// Strings that fit the inline storage must not allocate
+
+void CNxStringTest::testInline(void)
+{
+  if (CONFIG_NXWIDGETS_STRING_INLINESIZE < SHORT_STRING_LENGTH)
+    {
+      printf("CNxStringTest: SKIP: CONFIG_NXWIDGETS_STRING_INLINESIZE < %d\n",
+             SHORT_STRING_LENGTH);
+      return;
+    }
+
+  int inuse = getHeapInUse();
+
+  CNxString string("Hello");
+  string.append(CNxString("World"));
+  string.insert(CNxString(", "), 5);
+  bool ok = equals(string, "Hello, World");
+
+  CNxString copy(string);
+  ok = ok && equals(copy, "Hello, World");
+
+  copy.setText("Bye");
+  copy.remove(1, 1);
+  ok = ok && equals(copy, "Be");
+
+  copy = 'x';
+  ok = ok && equals(copy, "x");
+
+  check(getHeapInUse() == inuse, "short strings do not allocate");
+  check(ok, "short string contents");
+}
+
+// Moving a string must hand over its memory instead of copying it
+
+void CNxStringTest::testMove(void)
+{
+  // Build a string that does not fit the inline storage
+
+  CNxString longString;
+  while (longString.getLength() <= CONFIG_NXWIDGETS_STRING_INLINESIZE)
+    {
+      longString.append(CNxString("0123456789"));
+    }
+
+  unsigned int length = longString.getLength();
+  FAR const nxwidget_char_t *text =
+    CNxStringView(longString).getCharArray();
+
+  int inuse = getHeapInUse();
+
+  CNxString moved(std::move(longString));
+
+  check(getHeapInUse() == inuse,
+        "move construction does not allocate");
+  check(moved.getLength() == length && longString.getLength() == 0 &&
+        CNxStringView(moved).getCharArray() == text,
+        "move construction hands over the text");
+
+  CNxString assigned("x");
+
+  inuse = getHeapInUse();
+
+  assigned = std::move(moved);
+
+  check(getHeapInUse() == inuse,
+        "move assignment does not allocate");
+  check(assigned.getLength() == length && moved.getLength() == 0 &&
+        CNxStringView(assigned).getCharArray() == text,
+        "move assignment hands over the text");
+
+  // The moved-from strings must still be usable
+
+  moved.setText("abc");
+  longString.setText("def");
+  check(equals(moved, "abc") && equals(longString, "def"),
+        "moved-from strings can be reused");
+}
+
+// Substring views must not allocate.  subString() must allocate only the
+// new string object for a short string.
+
+void CNxStringTest::testViews(void)
+{
+  CNxString string("Hello, World");
+
+  int inuse = getHeapInUse();
+
+  CNxStringView hello   = string.subStringView(0, 5);
+  CNxStringView world   = string.subStringView(7);
+  CNxStringView clipped = string.subStringView(7, 100);
+  CNxStringView empty   = string.subStringView(100, 1);
+
+  check(getHeapInUse() == inuse, "substring views do not allocate");
+  check(equals(hello, "Hello") && equals(world, "World") &&
+        equals(clipped, "World") && empty.getLength() == 0,
+        "substring view contents");
+
+  if (CONFIG_NXWIDGETS_STRING_INLINESIZE >= 5)
+    {
+      CNxString copy;
+
+      inuse = getHeapInUse();
+      copy.setText(world);
+
+      check(getHeapInUse() == inuse && equals(copy, "World"),
+            "setting a short string from a view does not allocate");
+    }
+
+  // Heap used by the object of an empty string
+
+  inuse = getHeapInUse();
+  FAR CNxString *blank = new CNxString();
+  int objectSize = getHeapInUse() - inuse;
+  delete blank;
+
+  inuse = getHeapInUse();
+  FAR CNxString *sub = string.subString(7, 5);
+  int subSize = getHeapInUse() - inuse;
+
+  check(sub != NULL && equals(*sub, "World"), "subString contents");
+  if (CONFIG_NXWIDGETS_STRING_INLINESIZE >= 5)
+    {
+      check(subSize == objectSize,
+            "subString does not allocate the text of a short string");
+    }
+
+  delete sub;
+}
+
+// A CStringIterator on the stack must not allocate
+
+void CNxStringTest::testIterator(void)
+{
+  CNxString string("Hello, World");
+
+  int inuse = getHeapInUse();
+
+  CStringIterator iterator(&string);
+  unsigned int count = 0;
+
+  if (iterator.moveToFirst())
+    {
+      do
+        {
+          count++;
+        }
+      while (iterator.moveToNext());
+    }
+
+  int first = string.indexOf('o');
+  int last  = string.lastIndexOf('o');
+
+  check(getHeapInUse() == inuse, "iterating a string does not allocate");
+  check(count == string.getLength() && first == 4 && last == 8,
+        "iterator and index results");
+}
+
+// String width queries must not allocate
+
+void CNxStringTest::testStringWidth(void)
+{
+  if (m_nxFont == NULL)
+    {
+      check(false, "font available for width queries");
+      return;
+    }
+
+  CNxString string("Hello, World");
+
+  int inuse = getHeapInUse();
+
+  nxgl_coord_t whole = m_nxFont->getStringWidth(string);
+  nxgl_coord_t hello = m_nxFont->getStringWidth(string.subStringView(0, 5));
+  nxgl_coord_t range = m_nxFont->getStringWidth(string, 0, 5);
+
+  check(getHeapInUse() == inuse, "string width queries do not allocate");
+
+  nxgl_coord_t expected = 0;
+  for (int i = 0; i < 5; i++)
+    {
+      expected += m_nxFont->getCharWidth(string.getCharAt(i));
+    }
+
+  check(hello == expected && range == expected && whole >= hello,
+        "string width results");
+}
@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////
+// apps/graphics/nxwidgets/UnitTests/CNxString/cnxstringtest.hxx
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __APPS_GRAPHICS_NXWIDGETS_UNITTESTS_CNXSTRING_CNXSTRINGTEST_HXX
+#define __APPS_GRAPHICS_NXWIDGETS_UNITTESTS_CNXSTRING_CNXSTRINGTEST_HXX
+
+/////////////////////////////////////////////////////////////////////////////
+// Included Files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <nuttx/config.h>
+
+#include <cstdio>
+
+#include "graphics/nxwidgets/nxconfig.hxx"
+#include "graphics/nxwidgets/cnxfont.hxx"
+#include "graphics/nxwidgets/cnxstring.hxx"
+
+/////////////////////////////////////////////////////////////////////////////
+// Definitions
+/////////////////////////////////////////////////////////////////////////////
+// Configuration ////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_HAVE_CXX
+#  error "CONFIG_HAVE_CXX must be defined"
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Classes
+/////////////////////////////////////////////////////////////////////////////
+
+using namespace NXWidgets;
+
+class CNxStringTest
+{
+private:
+  CNxFont           *m_nxFont;         // Font used for the width queries
+  int                m_failures;       // Number of failed checks
+
+  // Record the result of one check
+
+  void check(bool ok, FAR const char *what);
+
+  // Compare the characters of a view to a C string
+
+  static bool equals(const CNxStringView &view, FAR const char *text);
+
+public:
+  // Constructor/destructors
+
+  CNxStringTest();
+  ~CNxStringTest();
+
+  // Create the font used by testStringWidth()
+
+  bool createFont(void);
+
+  // Strings that fit the inline storage must not allocate
+
+  void testInline(void);
+
+  // Moving a string must hand over its memory instead of copying it
+
+  void testMove(void);
+
+  // Substring views must not allocate.  subString() must allocate only
+  // the new string object for a short string.
+
+  void testViews(void);
+
+  // A CStringIterator on the stack must not allocate
+
+  void testIterator(void);
+
+  // String width queries must not allocate
+
+  void testStringWidth(void);
+
+  // Get the number of failed checks
+
+  inline int getFailures(void) const
+  {
+    return m_failures;
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Function Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+// Get the number of heap bytes in use (mallinfo() uordblks)
+
+int getHeapInUse(void);
+
+#endif // __APPS_GRAPHICS_NXWIDGETS_UNITTESTS_CNXSTRING_CNXSTRINGTEST_HXX
@@ -488,18 +488,16 @@ void CMultiLineTextBox::getCursorCoordinates(nxgl_coord_t &x, nxgl_coord_t &y) c
 
       uint8_t cursorLineOffset = m_cursorPos - m_text->getLineStartIndex(cursorRow);
 
-      CStringIterator *iterator = m_text->newStringIterator();
-      iterator->moveTo(m_text->getLineStartIndex(cursorRow));
+      CStringIterator iterator(m_text);
+      iterator.moveTo(m_text->getLineStartIndex(cursorRow));
 
       // Sum the width of each char in the row to find the x coordinate
 
       for (int i = 0; i < cursorLineOffset; ++i)
         {
-          x += getFont()->getCharWidth(iterator->getChar());
-          iterator->moveToNext();
+          x += getFont()->getCharWidth(iterator.getChar());
+          iterator.moveToNext();
         }
-
-      delete iterator;
     }
 
   // Add offset of row to calculated value
@@ -529,10 +527,10 @@ int CMultiLineTextBox::getCharIndexAtCoordinate(nxgl_coord_t x, int rowIndex) co
   int width      = getRowX(rowIndex);
   int index      = -1;
 
-  CStringIterator *iterator = m_text->newStringIterator();
-  iterator->moveTo(startIndex);
+  CStringIterator iterator(m_text);
+  iterator.moveTo(startIndex);
 
-  width += m_text->getFont()->getCharWidth(iterator->getChar());
+  width += m_text->getFont()->getCharWidth(iterator.getChar());
 
   for (int i = 0; i < stopIndex; ++i)
     {
@@ -555,12 +553,10 @@ int CMultiLineTextBox::getCharIndexAtCoordinate(nxgl_coord_t x, int rowIndex) co
           break;
         }
 
-      iterator->moveToNext();
-      width += m_text->getFont()->getCharWidth(iterator->getChar());
+      iterator.moveToNext();
+      width += m_text->getFont()->getCharWidth(iterator.getChar());
     }
 
-  delete iterator;
-
   // If the coordinate is past the last character, index will still be -1.
   // We need to set it to the last character
 
@@ -34,7 +34,6 @@
 
 #include "graphics/nxwidgets/nxconfig.hxx"
 #include "graphics/nxwidgets/cnxstring.hxx"
-#include "graphics/nxwidgets/cstringiterator.hxx"
 #include "graphics/nxwidgets/cnxfont.hxx"
 #include "graphics/nxwidgets/cbitmap.hxx"
 
@@ -126,32 +125,7 @@ void CNxFont::drawChar(FAR SBitmap *bitmap, nxwidget_char_t letter)
 
 nxgl_coord_t CNxFont::getStringWidth(const CNxString &text) const
 {
-  CStringIterator *iter = text.newStringIterator();
-
-  // Get the width of the string of characters
-  // Move to the first character
-
-  unsigned int width = 0;
-  if (iter->moveToFirst())
-    {
-      // moveToFirst returns true if there is at least one character
-
-      do
-        {
-          // Add the width of the font bitmap for this character and
-          // move the the next character
-
-          nxwidget_char_t ch = iter->getChar();
-
-          width += getCharWidth(ch);
-        }
-      while (iter->moveToNext());
-    }
-
-  // Return the total width
-
-  delete iter;
-  return width;
+  return getStringWidth(CNxStringView(text));
 }
 
 /**
@@ -167,31 +141,29 @@ nxgl_coord_t CNxFont::getStringWidth(const CNxString &text) const
 nxgl_coord_t CNxFont::getStringWidth(const CNxString &text,
                                      int startIndex, int length) const
 {
-  CStringIterator *iter = text.newStringIterator();
+  return getStringWidth(text.subStringView(startIndex, length));
+}
 
-  // Get the width of the string of characters
+/**
+ * Get the width of a view of a string in pixels when drawn with this
+ * font.  No memory is allocated.
+ *
+ * @param text The view of the string to check.
+ * @return The width of the characters in pixels.
+ */
 
-  iter->moveTo(startIndex);
-  unsigned int width = 0;
+nxgl_coord_t CNxFont::getStringWidth(const CNxStringView &text) const
+{
+  // Add the width of the font bitmap for each character
 
-  while (length-- > 0)
+  unsigned int width = 0;
+  for (int i = 0; i < text.getLength(); i++)
     {
-      // Add the width of the font bitmap for this character
-
-      nxwidget_char_t ch = iter->getChar();
-      width += getCharWidth(ch);
-
-      // Position to the next character in the string
-
-      if (!iter->moveToNext())
-        {
-          break;
-        }
+      width += getCharWidth(text.getCharAt(i));
     }
 
   // Return the total width
 
-  delete iter;
   return width;
 }
 
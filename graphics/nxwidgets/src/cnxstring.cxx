@@ -80,9 +80,9 @@ using namespace NXWidgets;
 
 CNxString::CNxString()
 {
-  m_text          = NULL;
+  m_text          = m_inline;
   m_stringLength  = 0;
-  m_allocatedSize = 0;
+  m_allocatedSize = sizeof(m_inline);
   m_growAmount    = 16;
 }
 
@@ -95,9 +95,9 @@ CNxString::CNxString()
 
 CNxString::CNxString(FAR const char *text)
 {
-  m_text          = NULL;
+  m_text          = m_inline;
   m_stringLength  = 0;
-  m_allocatedSize = 0;
+  m_allocatedSize = sizeof(m_inline);
   m_growAmount    = 16;
 
   setText(text);
@@ -110,9 +110,9 @@ CNxString::CNxString(FAR const char *text)
 
 CNxString::CNxString(const nxwidget_char_t text)
 {
-  m_text          = NULL;
+  m_text          = m_inline;
   m_stringLength  = 0;
-  m_allocatedSize = 0;
+  m_allocatedSize = sizeof(m_inline);
   m_growAmount    = 16;
 
   setText(text);
@@ -120,18 +120,36 @@ CNxString::CNxString(const nxwidget_char_t text)
 
 CNxString::CNxString(const CNxString &string)
 {
-  m_text          = NULL;
+  m_text          = m_inline;
   m_stringLength  = 0;
-  m_allocatedSize = 0;
+  m_allocatedSize = sizeof(m_inline);
   m_growAmount    = 16;
 
   setText(string);
 }
 
+/**
+ * Move constructor.  Takes over the memory of the argument string,
+ * which is left empty.
+ *
+ * @param string CNxString object to move from.
+ */
+
+CNxString::CNxString(CNxString &&string)
+{
+  m_text          = m_inline;
+  m_stringLength  = 0;
+  m_allocatedSize = sizeof(m_inline);
+  m_growAmount    = 16;
+
+  takeText(string);
+}
+
 /**
  * Creates and returns a new CCStringIterator object that will iterate
  * over this string.  The object must be manually deleted once it is
- * no longer needed.
+ * no longer needed.  A CStringIterator constructed on the stack does
+ * the same job without allocating memory.
  *
  * @return A new CCStringIterator object.
  */
@@ -241,6 +259,26 @@ void CNxString::setText(const nxwidget_char_t letter)
    m_stringLength = 1;
 }
 
+/**
+ * Set the text in the string.
+ *
+ * @param text View of the new data for this string.
+ */
+
+void CNxString::setText(const CNxStringView &text)
+{
+  // Ensure we've got enough memory available
+
+  allocateMemory(text.getLength(), false);
+
+  // Copy characters into m_text and cache the length.  The view may be
+  // a part of this string; no memory was allocated for it then.
+
+  m_stringLength = text.getLength();
+  memmove(m_text, text.getCharArray(),
+          sizeof(nxwidget_char_t) * text.getLength());
+}
+
 /**
  * Append text to the end of the string.
  *
@@ -340,7 +378,7 @@ void CNxString::insert(const CNxString &text, int index)
 
       // Delete existing string
 
-      delete[] m_text;
+      freeMemory();
 
       // Swap pointers
 
@@ -505,26 +543,24 @@ const int CNxString::indexOf(nxwidget_char_t letter, int startIndex, int count)
   int index = -1;
   int charsExamined = 0;
 
-  CStringIterator *iterator = new CStringIterator(this);
-  if (!iterator->moveTo(startIndex))
+  CStringIterator iterator(this);
+  if (!iterator.moveTo(startIndex))
     {
-      delete iterator;
       return -1;
     }
 
   do
     {
-      if (iterator->getChar() == letter)
+      if (iterator.getChar() == letter)
         {
-          index = iterator->getIndex();
+          index = iterator.getIndex();
           break;
         }
 
       charsExamined++;
     }
-  while (iterator->moveToNext() && (charsExamined < count));
+  while (iterator.moveToNext() && (charsExamined < count));
 
-  delete iterator;
   return index;
 }
 
@@ -580,26 +616,24 @@ const int CNxString::lastIndexOf(nxwidget_char_t letter, int startIndex, int cou
   int index = -1;
   int charsExamined = 0;
 
-  CStringIterator *iterator = new CStringIterator(this);
-  if (!iterator->moveTo(startIndex))
+  CStringIterator iterator(this);
+  if (!iterator.moveTo(startIndex))
     {
-      delete iterator;
       return -1;
     }
 
   do
     {
-      if (iterator->getChar() == letter)
+      if (iterator.getChar() == letter)
         {
-          index = iterator->getIndex();
+          index = iterator.getIndex();
           break;
         }
 
       charsExamined++;
     }
-  while (iterator->moveToPrevious() && (charsExamined <= count));
+  while (iterator.moveToPrevious() && (charsExamined <= count));
 
-  delete iterator;
   return index;
 }
 
@@ -629,28 +663,38 @@ CNxString* CNxString::subString(int startIndex) const
 
 CNxString *CNxString::subString(int startIndex, int length) const
 {
-  CNxString *newString = new CNxString();
-  CStringIterator *iterator = new CStringIterator(this);
-
-  if (!iterator->moveTo(startIndex))
+  if (startIndex < 0 || startIndex >= m_stringLength)
     {
-      delete iterator;
       return (CNxString *)0;
     }
 
-  // Build up the string character by character.  We could do a memcpy
-  // here and improve performance.
+  CNxString *newString = new CNxString();
+  newString->setText(subStringView(startIndex, length));
+  return newString;
+}
+
+/**
+ * Get a view of a part of this string.  Unlike subString(), no memory
+ * is allocated.  The range is clipped to the string.
+ *
+ * @param startIndex The starting point of the substring.
+ * @param length The length of the substring.
+ * @return A view of the substring.
+ */
 
-  int count = 0;
-  while (count < length)
+CNxStringView CNxString::subStringView(int startIndex, int length) const
+{
+  if (startIndex < 0 || startIndex >= m_stringLength || length <= 0)
     {
-      newString->append(iterator->getChar());
-      iterator->moveToNext();
-      count++;
+      return CNxStringView();
     }
 
-  delete iterator;
-  return newString;
+  if (length > m_stringLength - startIndex)
+    {
+      length = m_stringLength - startIndex;
+    }
+
+  return CNxStringView(&m_text[startIndex], length);
 }
 
 /**
@@ -671,6 +715,24 @@ CNxString& CNxString::operator=(const CNxString &string)
   return *this;
 }
 
+/**
+ * Overloaded move assignment operator.  Takes over the memory of the
+ * argument string, which is left empty.
+ *
+ * @param string The string to move from.
+ * @return This string.
+ */
+
+CNxString& CNxString::operator=(CNxString &&string)
+{
+  if (&string != this)
+    {
+      takeText(string);
+    }
+
+  return *this;
+}
+
 /**
  * Overloaded assignment operator.  Copies the data within the argument
  * char array to this string.
@@ -747,19 +809,16 @@ void CNxString::allocateMemory(int nChars, bool preserve)
       int allocChars = nChars + m_growAmount;
       nxwidget_char_t *newText = new nxwidget_char_t[allocChars];
 
-      // Free old memory if necessary
+      // Preserve existing data if required
 
-      if (m_text != NULL)
+      if (preserve)
         {
-          // Preserve existing data if required
+          memcpy(newText, m_text, sizeof(nxwidget_char_t) * m_stringLength);
+        }
 
-          if (preserve)
-            {
-              memcpy(newText, m_text, sizeof(nxwidget_char_t) * m_stringLength);
-            }
+      // Free old memory if necessary
 
-          delete[] m_text;
-        }
+      freeMemory();
 
       // Set pointer to new memory
 
@@ -771,6 +830,36 @@ void CNxString::allocateMemory(int nChars, bool preserve)
     }
 }
 
+/**
+ * Take over the text of another string, leaving that string empty.
+ * Allocated memory is handed over instead of being copied.
+ *
+ * @param string The string to take the text from.
+ */
+
+void CNxString::takeText(CNxString &string)
+{
+  if (string.m_text == string.m_inline)
+    {
+      // Inline text cannot be handed over, but it is short
+
+      setText(CNxStringView(string));
+    }
+  else
+    {
+      freeMemory();
+
+      m_text          = string.m_text;
+      m_allocatedSize = string.m_allocatedSize;
+      m_stringLength  = string.m_stringLength;
+
+      string.m_text          = string.m_inline;
+      string.m_allocatedSize = sizeof(string.m_inline);
+    }
+
+  string.m_stringLength = 0;
+}
+
 /**
  * Return a pointer to the specified characters.
  *
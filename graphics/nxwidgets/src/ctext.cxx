@@ -246,29 +246,27 @@ const int CText::getLineTrimmedLength(const int lineNumber) const
 
   // Loop through string until the end
 
-  CStringIterator *iterator = newStringIterator();
+  CStringIterator iterator(this);
 
   // Get char at the end of the line
 
-  if (iterator->moveTo(m_linePositions[lineNumber] + length - 1))
+  if (iterator.moveTo(m_linePositions[lineNumber] + length - 1))
     {
       do
         {
-          if (!m_font->isCharBlank(iterator->getChar()))
+          if (!m_font->isCharBlank(iterator.getChar()))
             {
               break;
             }
           length--;
         }
-      while (iterator->moveToPrevious() && (length > 0));
+      while (iterator.moveToPrevious() && (length > 0));
 
-      delete iterator;
       return length;
     }
 
   // May occur if data has been horribly corrupted somewhere
 
-  delete iterator;
   return 0;
 }
 
@@ -437,53 +435,53 @@ void CText::wrap(int charIndex)
 
   // Loop through string until the end
 
-  CStringIterator *iterator = newStringIterator();
+  CStringIterator iterator(this);
 
   while (!endReached)
     {
       breakIndex = 0;
       lineWidth = 0;
 
-      if (iterator->moveTo(pos))
+      if (iterator.moveTo(pos))
         {
           // Search for line breaks and valid breakpoints until we
           // exceed the width of the text field or we run out of
           // string to process
 
-          while (lineWidth + m_font->getCharWidth(iterator->getChar()) <= m_width)
+          while (lineWidth + m_font->getCharWidth(iterator.getChar()) <= m_width)
             {
-              lineWidth += m_font->getCharWidth(iterator->getChar());
+              lineWidth += m_font->getCharWidth(iterator.getChar());
 
               // Check for line return
 
-              if (iterator->getChar() == '\n')
+              if (iterator.getChar() == '\n')
                 {
                   // Remember this breakpoint
 
-                  breakIndex = iterator->getIndex();
+                  breakIndex = iterator.getIndex();
                   break;
                 }
-              else if ((iterator->getChar() == ' ') ||
-                       (iterator->getChar() == ',') ||
-                       (iterator->getChar() == '.') ||
-                       (iterator->getChar() == '-') ||
-                       (iterator->getChar() == ':') ||
-                       (iterator->getChar() == ';') ||
-                       (iterator->getChar() == '?') ||
-                       (iterator->getChar() == '!') ||
-                       (iterator->getChar() == '+') ||
-                       (iterator->getChar() == '=') ||
-                       (iterator->getChar() == '/') ||
-                       (iterator->getChar() == '\0'))
+              else if ((iterator.getChar() == ' ') ||
+                       (iterator.getChar() == ',') ||
+                       (iterator.getChar() == '.') ||
+                       (iterator.getChar() == '-') ||
+                       (iterator.getChar() == ':') ||
+                       (iterator.getChar() == ';') ||
+                       (iterator.getChar() == '?') ||
+                       (iterator.getChar() == '!') ||
+                       (iterator.getChar() == '+') ||
+                       (iterator.getChar() == '=') ||
+                       (iterator.getChar() == '/') ||
+                       (iterator.getChar() == '\0'))
                 {
                   // Remember the most recent breakpoint
 
-                  breakIndex = iterator->getIndex();
+                  breakIndex = iterator.getIndex();
                 }
 
               // Move to the next character
 
-              if (!iterator->moveToNext())
+              if (!iterator.moveToNext())
                 {
                   // No more text; abort loop
 
@@ -497,7 +495,7 @@ void CText::wrap(int charIndex)
           endReached = true;
         }
 
-      if ((!endReached) && (iterator->getIndex() > pos))
+      if ((!endReached) && (iterator.getIndex() > pos))
         {
           // Process any found data
 
@@ -505,18 +503,18 @@ void CText::wrap(int charIndex)
 
           if (breakIndex == 0)
             {
-              breakIndex = iterator->getIndex() - 1;
+              breakIndex = iterator.getIndex() - 1;
             }
 
           // Trim blank space from the start of the next line
 
-          CStringIterator *breakIterator = newStringIterator();
+          CStringIterator breakIterator(this);
 
-          if (breakIterator->moveTo(breakIndex + 1))
+          if (breakIterator.moveTo(breakIndex + 1))
             {
-              while (breakIterator->getChar() == ' ')
+              while (breakIterator.getChar() == ' ')
                 {
-                  if (breakIterator->moveToNext())
+                  if (breakIterator.moveToNext())
                     {
                       breakIndex++;
                     }
@@ -527,8 +525,6 @@ void CText::wrap(int charIndex)
                 }
             }
 
-          delete breakIterator;
-
           // Add the start of the next line to the vector
 
           pos = breakIndex + 1;
@@ -568,8 +564,6 @@ void CText::wrap(int charIndex)
       m_linePositions.push_back(getLength());
     }
 
-  delete iterator;
-
   // Calculate the total height of the text
 
   m_textPixelHeight = getLineCount() * (m_font->getHeight() + m_lineSpacing);
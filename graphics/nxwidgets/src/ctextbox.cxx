@@ -434,26 +434,26 @@ void CTextBox::moveCursorToClickLocation(nxgl_coord_t x, nxgl_coord_t y)
 
       // Locate the first character that comes after the clicked character
 
-      CStringIterator *iterator = m_text.newStringIterator();
+      CStringIterator iterator(&m_text);
 
       while (charX < clickX)
         {
-          charX += getFont()->getCharWidth(iterator->getChar());
+          charX += getFont()->getCharWidth(iterator.getChar());
 
-          if (!iterator->moveToNext())
+          if (!iterator.moveToNext())
             {
               break;
             }
         }
 
-      int index = iterator->getIndex();
+      int index = iterator.getIndex();
 
       // Move back to the clicked character if we've moved past it
 
       if (charX > clickX)
         {
-          iterator->moveToPrevious();
-          index = iterator->getIndex();
+          iterator.moveToPrevious();
+          index = iterator.getIndex();
         }
       else if (charX < clickX)
         {
@@ -463,7 +463,6 @@ void CTextBox::moveCursorToClickLocation(nxgl_coord_t x, nxgl_coord_t y)
         }
 
       moveCursorToPosition(index);
-      delete iterator;
     }
 }
 
@@ -537,15 +536,14 @@ const nxgl_coord_t CTextBox::getCursorXPos(void) const
 
   nxgl_coord_t cursorX = 0;
 
-  CStringIterator *iterator = m_text.newStringIterator();
+  CStringIterator iterator(&m_text);
 
   for (nxgl_coord_t i = 0; i < m_cursorPos; i++)
     {
-      cursorX += getFont()->getCharWidth(iterator->getChar());
-      iterator->moveToNext();
+      cursorX += getFont()->getCharWidth(iterator.getChar());
+      iterator.moveToNext();
     }
 
-  delete iterator;
   return cursorX;
 }
 
@@ -25,6 +25,8 @@
 #include <sys/ioctl.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #ifdef CONFIG_SYSTEM_TERMCURSES
@@ -34,6 +36,16 @@
 #include <graphics/curses.h>
 #include "pdcnuttx.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Up to this many unchanged cells between two changed ones are sent again
+ * rather than skipped, as that is about the length of a cursor move.
+ */
+
+#define PDC_TERM_MAXGAP 6
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -644,13 +656,13 @@ static void PDC_putc(FAR struct pdc_fbstate_s *fbstate, int row, int col,
 }
 
 /****************************************************************************
- * Name: PDC_gotoyx
+ * Name: PDC_gotoyx_term
  *
  * Description:
- *   Move the physical cursor (as opposed to the logical cursor affected by
- *   wmove()) to the given location. T his is called mainly from doupdate().
- *   In general, this function need not compare the old location with the
- *   new one, and should just move the cursor unconditionally.
+ *   Move the terminal cursor to the given location.  The cursor position
+ *   sequence is only queued in the termcurses output buffer, and nothing
+ *   is queued if the terminal cursor is already there.  The buffer is sent
+ *   by PDC_doupdate() at the end of the refresh.
  *
  ****************************************************************************/
 
@@ -661,7 +673,15 @@ static void PDC_gotoyx_term(FAR SCREEN *s, int row, int col)
   FAR struct pdc_termstate_s *termstate;
 
   termstate = &termscreen->termstate;
-  termcurses_moveyx(termstate->tcurs, row, col);
+
+  /* Nothing to send if the terminal cursor is already there */
+
+  if (row != termstate->currow || col != termstate->curcol)
+    {
+      termcurses_moveyx(termstate->tcurs, row, col);
+      termstate->currow = row;
+      termstate->curcol = col;
+    }
 }
 #endif
 
@@ -800,23 +820,20 @@ static void PDC_set_char_attrib_term(FAR struct pdc_termscreen_s *termscreen,
 #endif   /* CONFIG_SYSTEM_TERMCURSES */
 
 /****************************************************************************
- * Name: PDC_transform_line_term
+ * Name: PDC_output_term
  *
  * Description:
- *   The core output routine.  It takes len chtype entities from srcp (a
- *   pointer into curscr) and renders them to the physical screen at line
- *   lineno, column x. It must also translate characters 0-127 via acs_map[],
- *   if they're flagged with A_ALTCHARSET in the attribute portion of the
- *   chtype.
+ *   Send len cells from srcp to the terminal at line lineno, column x.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_SYSTEM_TERMCURSES
-static void PDC_transform_line_term(FAR SCREEN *s, int lineno, int x,
-                                    int len, FAR const chtype *srcp)
+static void PDC_output_term(FAR SCREEN *s, int lineno, int x, int len,
+                            FAR const chtype *srcp)
 {
   FAR struct pdc_termscreen_s *termscreen = (FAR struct pdc_termscreen_s *)s;
   FAR struct pdc_termstate_s *termstate = &termscreen->termstate;
+  bool  altcharset;
   int   c;
   int   i;
   char  ch;
@@ -852,21 +869,164 @@ static void PDC_transform_line_term(FAR SCREEN *s, int lineno, int x,
           buffer[i] = ch;
         }
 
+      /* Switch the character set only when it changes */
+
+      altcharset = (*srcp & A_ALTCHARSET) != 0;
+      if (altcharset != termstate->altcharset)
+        {
+          termcurses_write(termstate->tcurs,
+                           altcharset ? "\x1b(0" : "\x1b(B", 3);
+          termstate->altcharset = altcharset;
+        }
+
       /* Update source pointer and write data */
 
-      if (*srcp & A_ALTCHARSET)
+      termcurses_write(termstate->tcurs, buffer, i);
+
+      srcp += i;
+      c += i;
+    }
+
+  /* The cursor follows the text, unless it reached the right margin where
+   * terminals differ.
+   */
+
+  termstate->curcol = x + len;
+  if (termstate->curcol >= s->cols)
+    {
+      termstate->currow = -1;
+      termstate->curcol = -1;
+    }
+}
+#endif   /* CONFIG_SYSTEM_TERMCURSES */
+
+/****************************************************************************
+ * Name: PDC_shadow_term
+ *
+ * Description:
+ *   Return the shadow of line lineno, allocating the shadow screen if the
+ *   screen has no shadow yet or has been resized.  A new shadow is filled
+ *   with ~0 which no real cell uses, so all of it is sent.  Returns NULL
+ *   if there is no memory for the shadow.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TERMCURSES
+static FAR chtype *PDC_shadow_term(FAR SCREEN *s, int lineno)
+{
+  FAR struct pdc_termscreen_s *termscreen = (FAR struct pdc_termscreen_s *)s;
+  FAR struct pdc_termstate_s *termstate = &termscreen->termstate;
+  size_t size;
+
+  if (termstate->shadow == NULL || termstate->shadow_lines != s->lines ||
+      termstate->shadow_cols != s->cols)
+    {
+      free(termstate->shadow);
+
+      size = (size_t)s->lines * s->cols * sizeof(chtype);
+      termstate->shadow = malloc(size);
+      if (termstate->shadow == NULL)
         {
-          write(termstate->out_fd, "\x1b(0", 3);
-          write(termstate->out_fd, buffer, i);
-          write(termstate->out_fd, "\x1b(B", 3);
+          return NULL;
         }
-      else
+
+      memset(termstate->shadow, 0xff, size);
+      termstate->shadow_lines = s->lines;
+      termstate->shadow_cols  = s->cols;
+    }
+
+  if (lineno >= termstate->shadow_lines)
+    {
+      return NULL;
+    }
+
+  return termstate->shadow + lineno * termstate->shadow_cols;
+}
+#endif   /* CONFIG_SYSTEM_TERMCURSES */
+
+/****************************************************************************
+ * Name: PDC_transform_line_term
+ *
+ * Description:
+ *   The core output routine.  It takes len chtype entities from srcp (a
+ *   pointer into curscr) and renders them to the physical screen at line
+ *   lineno, column x. It must also translate characters 0-127 via acs_map[],
+ *   if they're flagged with A_ALTCHARSET in the attribute portion of the
+ *   chtype.
+ *
+ *   Cells the terminal already shows are skipped, so a full redraw only
+ *   sends what differs from the shadow screen.  If redraw is true, every
+ *   cell is sent.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TERMCURSES
+static void PDC_transform_line_term(FAR SCREEN *s, int lineno, int x,
+                                    int len, FAR const chtype *srcp,
+                                    bool redraw)
+{
+  FAR chtype *shadow;
+  int   end = x + len;
+  int   col;
+  int   run;
+  int   gap;
+
+  shadow = PDC_shadow_term(s, lineno);
+  if (shadow == NULL || end > s->cols)
+    {
+      PDC_output_term(s, lineno, x, len, srcp);
+      return;
+    }
+
+  /* Index the source the same way as the shadow */
+
+  srcp -= x;
+
+  for (col = x; col < end; col = run)
+    {
+      /* Skip the cells that are already on the terminal */
+
+      while (!redraw && col < end && shadow[col] == srcp[col])
         {
-          write(termstate->out_fd, buffer, i);
+          col++;
         }
 
-      srcp += i;
-      c += i;
+      if (col >= end)
+        {
+          break;
+        }
+
+      /* Find the end of the changed run, bridging short stretches of
+       * unchanged cells with the same attributes as the run.
+       */
+
+      run = col + 1;
+      for (; ; )
+        {
+          while (run < end && (redraw || shadow[run] != srcp[run]))
+            {
+              run++;
+            }
+
+          for (gap = run;
+               gap < end && gap - run < PDC_TERM_MAXGAP &&
+               shadow[gap] == srcp[gap] &&
+               (srcp[gap] & A_ATTRIBUTES) == (srcp[run - 1] & A_ATTRIBUTES);
+               gap++)
+            {
+            }
+
+          if (gap >= end || gap - run >= PDC_TERM_MAXGAP ||
+              shadow[gap] == srcp[gap])
+            {
+              break;
+            }
+
+          run = gap;
+        }
+
+      PDC_output_term(s, lineno, col, run - col, srcp + col);
+      memcpy(&shadow[col], &srcp[col], (run - col) * sizeof(chtype));
     }
 }
 #endif   /* CONFIG_SYSTEM_TERMCURSES */
@@ -880,9 +1040,10 @@ static void PDC_transform_line_term(FAR SCREEN *s, int lineno, int x,
  *
  * Description:
  *   Move the physical cursor (as opposed to the logical cursor affected by
- *   wmove()) to the given location. T his is called mainly from doupdate().
- *   In general, this function need not compare the old location with the
- *   new one, and should just move the cursor unconditionally.
+ *   wmove()) to the given location.  This is called mainly from
+ *   doupdate().  On a terminal the move is queued in the termcurses output
+ *   buffer and sent with the rest of the refresh by PDC_doupdate(); on a
+ *   framebuffer the cursor is redrawn directly.
  *
  ****************************************************************************/
 
@@ -960,7 +1121,7 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     {
       /* User terminal transformation routine */
 
-      PDC_transform_line_term(SP, lineno, x, len, srcp);
+      PDC_transform_line_term(SP, lineno, x, len, srcp, curscr->_clear);
       return;
     }
 #endif
@@ -988,6 +1149,32 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
   PDC_update(fbstate, lineno, x, nextx - x);
 }
 
+/****************************************************************************
+ * Name: PDC_doupdate
+ *
+ * Description:
+ *   Called at the end of doupdate().  The terminal output is buffered by
+ *   termcurses and sent here; the framebuffer has nothing to do.
+ *
+ ****************************************************************************/
+
+void PDC_doupdate(void)
+{
+#ifdef CONFIG_SYSTEM_TERMCURSES
+#ifdef CONFIG_PDCURSES_MULTITHREAD
+  FAR struct pdc_context_s *ctx = PDC_ctx();
+#endif
+
+  if (!graphic_screen)
+    {
+      FAR struct pdc_termscreen_s *termscreen =
+        (FAR struct pdc_termscreen_s *)SP;
+
+      termcurses_flush(termscreen->termstate.tcurs);
+    }
+#endif
+}
+
 /****************************************************************************
  * Name: PDC_clear_screen
  *
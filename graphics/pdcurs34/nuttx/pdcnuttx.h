@@ -310,6 +310,24 @@ struct pdc_termstate_s
   struct pdc_rgbcolor_s rgbcolor[16];
 #endif
 
+  /* What the terminal shows, so that only changed cells are sent.  The
+   * shadow is allocated on the first update and freed to force a full
+   * repaint.
+   */
+
+  FAR chtype *shadow;
+  int    shadow_lines;
+  int    shadow_cols;
+
+  /* Terminal cursor position, -1 if unknown */
+
+  int    currow;
+  int    curcol;
+
+  /* The VT100 line drawing character set is selected */
+
+  bool   altcharset;
+
   FAR struct termcurses_s *tcurs;
 };
 
@@ -66,12 +66,20 @@ static void PDC_scr_free_term(FAR SCREEN *sp)
     (FAR struct pdc_termscreen_s *)sp;
   FAR struct pdc_termstate_s  *termstate = &termscreen->termstate;
 
+  /* Leave the terminal in its normal character set */
+
+  if (termstate->altcharset)
+    {
+      termcurses_write(termstate->tcurs, "\x1b(B", 3);
+    }
+
   /* Deinitialize termcurses */
 
   termcurses_deinitterm(termstate->tcurs);
 
   /* Free the memory */
 
+  free(termstate->shadow);
   free(termscreen);
 #ifdef CONFIG_PDCURSES_MULTITHREAD
   PDC_ctx_free();
@@ -161,6 +169,8 @@ static int PDC_scr_open_term(int argc, char **argv)
   termscreen->termstate.in_fd  = 0;
   termscreen->termstate.fg_red = 0xfffe;
   termscreen->termstate.bg_red = 0xfffe;
+  termscreen->termstate.currow = -1;
+  termscreen->termstate.curcol = -1;
   termstate                    = &termscreen->termstate;
 
   /* Setup initial RGB colors */
@@ -722,7 +732,31 @@ int PDC_resize_screen(int nlines, int ncols)
 
 void PDC_reset_prog_mode(void)
 {
+#ifdef CONFIG_SYSTEM_TERMCURSES
+#ifdef CONFIG_PDCURSES_MULTITHREAD
+  FAR struct pdc_context_s *ctx = PDC_ctx();
+#endif
+#endif
+
   PDC_LOG(("PDC_reset_prog_mode() - called.\n"));
+
+#ifdef CONFIG_SYSTEM_TERMCURSES
+  if (!graphic_screen && SP != NULL)
+    {
+      FAR struct pdc_termscreen_s *termscreen =
+        (FAR struct pdc_termscreen_s *)SP;
+      FAR struct pdc_termstate_s *termstate = &termscreen->termstate;
+
+      /* The terminal may have been used by others since endwin(), forget
+       * what it shows so that the next update repaints all of it.
+       */
+
+      free(termstate->shadow);
+      termstate->shadow = NULL;
+      termstate->currow = -1;
+      termstate->curcol = -1;
+    }
+#endif
 }
 
 /****************************************************************************
@@ -64,6 +64,7 @@ static void PDC_curs_set_term(int visibility)
     }
 
   termcurses_setattribute(termstate->tcurs, attrib);
+  termcurses_flush(termstate->tcurs);
 }
 #endif   /* CONFIG_SYSTEM_TERMCURSES */
 
@@ -273,6 +273,9 @@ int doupdate(void)
   SP->cursrow = curscr->_cury;
   SP->curscol = curscr->_curx;
 
+  /* Let the port send anything it has buffered */
+
+  PDC_doupdate();
   return OK;
 }
 
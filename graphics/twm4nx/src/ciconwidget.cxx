@@ -183,7 +183,7 @@ bool CIconWidget::initialize(FAR CWindow *parent,
       nxgl_coord_t halfWidth = titleSize.w / 2;
 
       nxgl_coord_t sWidth =
-        iconFont->getStringWidth(title.subString(0, sIndex));
+        iconFont->getStringWidth(title.subStringView(0, sIndex));
 
       nxgl_coord_t error = halfWidth - sWidth;
       if (error < 0)
@@ -197,7 +197,7 @@ bool CIconWidget::initialize(FAR CWindow *parent,
           // Which is the better division point?  index or SIndex?
 
           nxgl_coord_t width =
-            iconFont->getStringWidth(title.subString(0, index));
+            iconFont->getStringWidth(title.subStringView(0, index));
 
           nxgl_coord_t tmperr = halfWidth - width;
           if (tmperr < 0)
@@ -216,11 +216,11 @@ bool CIconWidget::initialize(FAR CWindow *parent,
           sIndex = index;
         }
 
-      topString.setText(title.subString(0, sIndex));
+      topString.setText(title.subStringView(0, sIndex));
       iconTopLabelSize.w    = iconFont->getStringWidth(topString);
       iconTopLabelSize.h    = iconFont->getHeight();
 
-      bottomString.setText(title.subString(sIndex + 1));
+      bottomString.setText(title.subStringView(sIndex + 1));
       iconBottomLabelSize.w = iconFont->getStringWidth(bottomString);
       iconBottomLabelSize.h = iconFont->getHeight();
     }
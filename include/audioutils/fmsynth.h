@@ -76,6 +76,9 @@ int fmsynthsnd_add_subsound(FAR fmsynth_sound_t *top,
 int fmsynth_rendering(FAR fmsynth_sound_t *snd,
                       FAR int16_t *sample, int sample_num, int chnum,
                       fmsynth_tickcb_t cb, unsigned long cbarg);
+int fmsynth_rendering_block(FAR fmsynth_sound_t *snd,
+                            FAR int16_t *sample, int sample_num, int chnum,
+                            fmsynth_tickcb_t cb, unsigned long cbarg);
 
 #ifdef __cplusplus
 }
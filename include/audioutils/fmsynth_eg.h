@@ -93,6 +93,8 @@ int fmsyntheg_set_param(FAR fmsynth_eg_t *eg,
 void fmsyntheg_start(FAR fmsynth_eg_t *eg);
 void fmsyntheg_stop(FAR fmsynth_eg_t *eg);
 int fmsyntheg_operate(FAR fmsynth_eg_t *eg);
+int fmsyntheg_get_level(FAR fmsynth_eg_t *eg);
+void fmsyntheg_skip(FAR fmsynth_eg_t *eg, int num);
 
 #ifdef __cplusplus
 }
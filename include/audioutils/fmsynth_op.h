@@ -39,16 +39,27 @@
 #define FMSYNTH_OPFUNC_SQUARE   (3)
 #define FMSYNTH_OPFUNC_NUM      (4)
 
+/* Number of samples rendered per operator call by the block renderer */
+
+#ifdef CONFIG_AUDIOUTILS_FMSYNTH_BLOCKSIZE
+#  define FMSYNTH_BLOCK_SIZE CONFIG_AUDIOUTILS_FMSYNTH_BLOCKSIZE
+#else
+#  define FMSYNTH_BLOCK_SIZE (32)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
 typedef CODE int (*opfunc_t)(int theta);
+typedef CODE void (*opblkfunc_t)(FAR const int *theta, FAR int *out,
+                                 int num);
 
 typedef struct fmsynth_op_s
 {
   FAR fmsynth_eg_t *eg;
   opfunc_t wavegen;
+  opblkfunc_t wavegen_block;
   struct fmsynth_op_s *cascadeop;
   struct fmsynth_op_s *parallelop;
 
@@ -94,6 +105,8 @@ void fmsynthop_set_soundfreqrate(FAR fmsynth_op_t *op, float rate);
 void fmsynthop_start(FAR fmsynth_op_t *op);
 void fmsynthop_stop(FAR fmsynth_op_t *op);
 int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time);
+void fmsynthop_operate_block(FAR fmsynth_op_t *op, int phase_time,
+                             FAR int *out, int num);
 
 #ifdef __cplusplus
 }
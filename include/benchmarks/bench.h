@@ -0,0 +1,203 @@
+/****************************************************************************
+ * apps/include/benchmarks/bench.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_BENCHMARKS_BENCH_H
+#define __APPS_INCLUDE_BENCHMARKS_BENCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Options understood by bench_option().  They are upper case so they do
+ * not collide with the options of the individual benchmarks.
+ *
+ *   -W <n>     Untimed warm-up runs before each case
+ *   -T <n>     Timed trials per case
+ *   -F <fmt>   Output format: text, json or csv
+ *   -A <mask>  Hex CPU mask; each case is run pinned to every CPU in it
+ *   -D         Also print every sample
+ */
+
+#define BENCH_OPTSTRING     "W:T:F:A:D"
+
+#define BENCH_FORMAT_TEXT   0
+#define BENCH_FORMAT_JSON   1
+#define BENCH_FORMAT_CSV    2
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One trial of a benchmark case.  Returns the time it took in
+ * nanoseconds.  The function may measure only part of its work (e.g. to
+ * exclude per-trial setup), bench_elapsed() helps with that.
+ */
+
+typedef CODE uint64_t (*bench_trial_t)(FAR void *arg);
+
+struct bench_case_s
+{
+  FAR const char *name;     /* Name of the case in the report */
+  bench_trial_t   trial;    /* Runs one trial */
+  FAR void       *arg;      /* Argument of trial() */
+  uint64_t        bytes;    /* Bytes moved per trial, 0 if not a rate */
+  uint32_t        ops;      /* Operations per trial, 0 is treated as 1 */
+};
+
+/* Statistics of one case on one CPU, all times in nanoseconds per trial.
+ * The spread (min, max, stddev and percentiles) is only reported when
+ * there was more than one trial; use -T to get it.
+ */
+
+struct bench_result_s
+{
+  uint32_t        trials;
+  int             cpu;      /* CPU the case was pinned to, -1 if not */
+  uint64_t        min;
+  uint64_t        max;
+  uint64_t        mean;
+  uint64_t        stddev;
+  uint64_t        p50;
+  uint64_t        p90;
+  uint64_t        p99;
+};
+
+struct bench_s
+{
+  FAR const char *name;     /* Benchmark name */
+  uint32_t        warmup;   /* Untimed runs before each case */
+  uint32_t        trials;   /* Timed runs per case */
+  uint32_t        cpumask;  /* CPUs to sweep, 0 to leave affinity alone */
+  uint8_t         format;   /* BENCH_FORMAT_* */
+  bool            detail;   /* Print every sample */
+
+  /* Private */
+
+  FAR uint64_t   *samples;
+  uint32_t        nsamples;
+  uint32_t        nrecords;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: bench_init
+ *
+ * Description:
+ *   Initialize a benchmark context with the default settings: no warm-up
+ *   run, a single trial, text output, no affinity sweep.  The caller may
+ *   change the defaults before parsing its command line.
+ *
+ ****************************************************************************/
+
+void bench_init(FAR struct bench_s *bench, FAR const char *name);
+
+/****************************************************************************
+ * Name: bench_option
+ *
+ * Description:
+ *   Handle one of the common BENCH_OPTSTRING options returned by getopt().
+ *
+ * Returned Value:
+ *   OK if the option was handled, -EINVAL for a bad argument and -ENOENT
+ *   if opt is not a common option.
+ *
+ ****************************************************************************/
+
+int bench_option(FAR struct bench_s *bench, int opt, FAR const char *arg);
+
+/****************************************************************************
+ * Name: bench_usage
+ *
+ * Description:
+ *   Print the help text of the common options.
+ *
+ ****************************************************************************/
+
+void bench_usage(void);
+
+/****************************************************************************
+ * Name: bench_begin / bench_end
+ *
+ * Description:
+ *   Print the header and footer of the report.  Every bench_run() call
+ *   must be between the two.  A short config string (e.g. the command line
+ *   settings of the benchmark) is included in the header.
+ *
+ ****************************************************************************/
+
+int bench_begin(FAR struct bench_s *bench, FAR const char *config);
+void bench_end(FAR struct bench_s *bench);
+
+/****************************************************************************
+ * Name: bench_run
+ *
+ * Description:
+ *   Run a case: the warm-up runs, then the trials on every CPU of the
+ *   sweep mask, and report one record per CPU.  The statistics of the last
+ *   CPU are returned in result if it is not NULL.
+ *
+ * Returned Value:
+ *   OK on success, a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int bench_run(FAR struct bench_s *bench,
+              FAR const struct bench_case_s *bcase,
+              FAR struct bench_result_s *result);
+
+/****************************************************************************
+ * Name: bench_timestamp / bench_elapsed
+ *
+ * Description:
+ *   Take a high resolution timestamp, and convert the difference of two
+ *   of them to nanoseconds.
+ *
+ ****************************************************************************/
+
+clock_t bench_timestamp(void);
+uint64_t bench_elapsed(clock_t start, clock_t end);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_BENCHMARKS_BENCH_H */
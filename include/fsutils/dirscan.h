@@ -0,0 +1,129 @@
+/****************************************************************************
+ * apps/include/fsutils/dirscan.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_FSUTILS_DIRSCAN_H
+#define __APPS_INCLUDE_FSUTILS_DIRSCAN_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Flags of dirscan_open() */
+
+#define DIRSCAN_STAT      (1 << 0)  /* stat() every entry */
+#define DIRSCAN_READLINK  (1 << 1)  /* Read the target of symbolic links */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One entry of a directory listing */
+
+struct dirscan_entry_s
+{
+  FAR const char *name;           /* Name of the entry */
+  FAR const char *link;           /* Target of a symbolic link or NULL */
+  struct stat st;                 /* With DIRSCAN_STAT, if staterr is 0 */
+  int staterr;                    /* errno of a failed stat() */
+  int linkerr;                    /* errno of a failed readlink() */
+  uint8_t type;                   /* d_type reported by readdir() */
+};
+
+/* A directory listing.  The listing, its entries and all strings live in
+ * one allocation.  Entries are sorted by name.
+ */
+
+struct dirscan_s
+{
+  FAR struct dirscan_entry_s *entries;
+  size_t nentries;
+
+  /* Private: used by the listing cache */
+
+  FAR struct dirscan_s *flink;    /* Next cached listing */
+  FAR const char *path;           /* Directory that was scanned */
+  time_t mtime;                   /* Modification time of the directory */
+  unsigned int flags;             /* Flags the listing was made with */
+  int refs;                       /* Users of the listing */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: dirscan_open
+ *
+ * Description:
+ *   Read the directory 'path' into a sorted listing.  With DIRSCAN_STAT,
+ *   each entry is also stat()ed.  With DIRSCAN_READLINK, the targets of
+ *   symbolic links are read as well.
+ *
+ *   If CONFIG_FSUTILS_DIRSCAN_NCACHE is non-zero, recent listings are
+ *   kept.  A kept listing is returned again as long as the modification
+ *   time of the directory is unchanged.
+ *
+ * Input Parameters:
+ *   path  - The directory to list
+ *   flags - DIRSCAN_* flags
+ *
+ * Returned Value:
+ *   The listing, to be released with dirscan_close().  NULL is returned
+ *   with errno set on failure.
+ *
+ ****************************************************************************/
+
+FAR struct dirscan_s *dirscan_open(FAR const char *path, unsigned int flags);
+
+/****************************************************************************
+ * Name: dirscan_close
+ *
+ * Description:
+ *   Release a listing returned by dirscan_open().
+ *
+ ****************************************************************************/
+
+void dirscan_close(FAR struct dirscan_s *scan);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_FSUTILS_DIRSCAN_H */
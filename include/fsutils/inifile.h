@@ -27,6 +27,8 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -37,6 +39,16 @@
 
 typedef FAR void *INIHANDLE;
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/* State of an iteration over the variables, see inifile_iter_init() */
+
+struct inifile_iter_s
+{
+  FAR const void *next;           /* Private: next variable */
+  FAR const char *section;        /* Section visited, NULL for all */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -115,6 +127,38 @@ long inifile_read_integer(INIHANDLE handle,
 
 void inifile_free_string(FAR char *value);
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/****************************************************************************
+ * Name:  inifile_iter_init
+ *
+ * Description:
+ *   Prepare iter for visiting the variables of one section (or of all
+ *   sections if section is NULL) in file order.
+ *
+ ****************************************************************************/
+
+void inifile_iter_init(INIHANDLE handle, FAR const char *section,
+                       FAR struct inifile_iter_s *iter);
+
+/****************************************************************************
+ * Name:  inifile_iter_next
+ *
+ * Description:
+ *   Return the next variable of the iteration.  The strings belong to the
+ *   handle and stay valid until inifile_uninitialize().  Variables without
+ *   a value are skipped, like inifile_read_string() does not find them.
+ *
+ * Returned Value:
+ *   true if a variable was returned, false at the end of the iteration.
+ *
+ ****************************************************************************/
+
+bool inifile_iter_next(FAR struct inifile_iter_s *iter,
+                       FAR const char **section,
+                       FAR const char **variable,
+                       FAR const char **value);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -48,6 +48,7 @@
 namespace NXWidgets
 {
   class CNxString;
+  class CNxStringView;
   struct SBitmap;
 
   /**
@@ -178,6 +179,16 @@ namespace NXWidgets
       return getStringWidth(*text, startIndex, length);
     }
 
+    /**
+     * Get the width of a view of a string in pixels when drawn with this
+     * font.  No memory is allocated.
+     *
+     * @param text The view of the string to check.
+     * @return The width of the characters in pixels.
+     */
+
+    nxgl_coord_t getStringWidth(const CNxStringView &text) const;
+
     /**
      * Gets font metrics for a particular character
      *
@@ -81,8 +81,93 @@
 
 namespace NXWidgets
 {
+  class CNxString;
   class CStringIterator;
 
+  /**
+   * A read-only view of a run of characters, usually a part of a CNxString.
+   * A view neither owns nor copies the characters.  It remains valid only
+   * as long as the string it was taken from is not modified or destroyed.
+   * Views are cheap to pass by value and allow substring and width queries
+   * without creating a new CNxString.
+   */
+
+  class CNxStringView
+  {
+  private:
+    FAR const nxwidget_char_t *m_text; /**< First character of the view */
+    int m_length;                      /**< Number of characters */
+
+  public:
+
+    /**
+     * Constructor to create an empty view.
+     */
+
+    inline CNxStringView(void)
+    {
+      m_text   = (FAR const nxwidget_char_t *)0;
+      m_length = 0;
+    }
+
+    /**
+     * Constructor to create a view of a character array.
+     *
+     * @param text The first character of the view.
+     * @param length The number of characters in the view.
+     */
+
+    inline CNxStringView(FAR const nxwidget_char_t *text, int length)
+    {
+      m_text   = text;
+      m_length = length;
+    }
+
+    /**
+     * Constructor to create a view of a complete string.
+     *
+     * @param string The string to view.
+     */
+
+    inline CNxStringView(const CNxString &string);
+
+    /**
+     * Returns a pointer to the first character of the view.  The
+     * characters are not null-terminated.
+     *
+     * @return Pointer to the char array.
+     */
+
+    inline FAR const nxwidget_char_t *getCharArray(void) const
+    {
+      return m_text;
+    }
+
+    /**
+     * Get the number of characters in the view.
+     *
+     * @return The length of the view.
+     */
+
+    inline int getLength(void) const
+    {
+      return m_length;
+    }
+
+    /**
+     * Get the character at the specified index.  The index is not
+     * checked.
+     *
+     * @param index The index of the character to retrieve.
+     * @return The character at the specified index.
+     */
+
+    inline nxwidget_char_t getCharAt(int index) const
+    {
+      return m_text[index];
+    }
+  };
+
   /**
    * Unicode string class.  Uses 16-bt wide-character encoding.  For optimal
    * performance, use the CStringIterator class to iterate over a CNxString
@@ -99,6 +184,9 @@ namespace NXWidgets
    * time it needs to allocate extra memory, potentially reducing the number
    * of reallocs needed.
    *
+   * Strings of up to CONFIG_NXWIDGETS_STRING_INLINESIZE characters are kept
+   * in storage inside the object itself and do not allocate memory at all.
+   *
    * The string is not null-terminated.  Instead, it uses a m_stringLength
    * member that stores the number of characters in the string.  This saves a
    * byte and makes calls to getLength() run in O(1) time instead of O(n).
@@ -107,13 +195,36 @@ namespace NXWidgets
   class CNxString
   {
   private:
+    friend class CNxStringView;
     friend class CStringIterator;
 
     int m_stringLength;  /**< Number of characters in the string */
     int m_allocatedSize; /**< Number of bytes allocated for this string */
     int m_growAmount;    /**< Number of chars that the string grows by
                               whenever it needs to get larger */
+    nxwidget_char_t m_inline[CONFIG_NXWIDGETS_STRING_INLINESIZE];
+                         /**< Storage used while the string is short */
 
+    /**
+     * Free the memory holding the text if it was allocated.
+     */
+
+    inline void freeMemory(void)
+    {
+      if (m_text != m_inline)
+        {
+          delete[] m_text;
+        }
+    }
+
+    /**
+     * Take over the text of another string, leaving that string empty.
+     * Allocated memory is handed over instead of being copied.
+     *
+     * @param string The string to take the text from.
+     */
+
+    void takeText(CNxString &string);
 
   protected:
     FAR nxwidget_char_t *m_text;  /**< Raw char array data */
@@ -202,20 +313,30 @@ namespace NXWidgets
 
     CNxString(const CNxString &string);
 
+    /**
+     * Move constructor.  Takes over the memory of the argument string,
+     * which is left empty.
+     *
+     * @param string CNxString object to move from.
+     */
+
+    CNxString(CNxString &&string);
+
     /**
      * Destructor.
      */
 
     virtual inline ~CNxString()
     {
-      delete[] m_text;
+      freeMemory();
       m_text = NULL;
     };
 
     /**
      * Creates and returns a new CStringIterator object that will iterate
      * over this string.  The object must be manually deleted once it is
-     * no longer needed.
+     * no longer needed.  A CStringIterator constructed on the stack does
+     * the same job without allocating memory.
      *
      * @return A new CStringIterator object.
      */
@@ -272,6 +393,14 @@ namespace NXWidgets
 
     void setText(const nxwidget_char_t text);
 
+    /**
+     * Set the text in the string.
+     *
+     * @param text View of the new data for this string.
+     */
+
+    void setText(const CNxStringView &text);
+
     /**
      * Append text to the end of the string.
      *
@@ -343,6 +472,29 @@ namespace NXWidgets
 
     const nxwidget_char_t getCharAt(int index) const;
 
+    /**
+     * Get a view of a part of this string.  Unlike subString(), no memory
+     * is allocated.  The range is clipped to the string.
+     *
+     * @param startIndex The starting point of the substring.
+     * @param length The length of the substring.
+     * @return A view of the substring.
+     */
+
+    CNxStringView subStringView(int startIndex, int length) const;
+
+    /**
+     * Get a view of the end of this string, starting at startIndex.
+     *
+     * @param startIndex The starting point of the substring.
+     * @return A view of the substring.
+     */
+
+    inline CNxStringView subStringView(int startIndex) const
+    {
+      return subStringView(startIndex, m_stringLength - startIndex);
+    }
+
     /**
      * Returns the first index of the specified letter within the string.
      * Will return -1 if the letter is not found.
@@ -417,7 +569,8 @@ namespace NXWidgets
 
     /**
      * Get a substring from this string.  It is the responsibility of the
-     * caller to delete the substring when it is no longer required.
+     * caller to delete the substring when it is no longer required.  Use
+     * subStringView() where a copy of the substring is not needed.
      *
      * @param startIndex The starting point of the substring.
      * @return A pointer to a new CNxString object containing the
@@ -428,7 +581,8 @@ namespace NXWidgets
 
     /**
      * Get a substring from this string.  It is the responsibility of the
-     * caller to delete the substring when it is no longer required.
+     * caller to delete the substring when it is no longer required.  Use
+     * subStringView() where a copy of the substring is not needed.
      *
      * @param startIndex The starting point of the substring.
      * @param length The length of the substring.
@@ -448,6 +602,16 @@ namespace NXWidgets
 
     CNxString &operator=(const CNxString &string);
 
+    /**
+     * Overloaded move assignment operator.  Takes over the memory of the
+     * argument string, which is left empty.
+     *
+     * @param string The string to move from.
+     * @return This string.
+     */
+
+    CNxString &operator=(CNxString &&string);
+
     /**
      * Overloaded assignment operator.  Copies the data within the argument
      * char array to this string.
@@ -512,6 +676,12 @@ namespace NXWidgets
 
     static CNxString format(const char *fmt, ...) printf_like(1, 2);
   };
+
+  inline CNxStringView::CNxStringView(const CNxString &string)
+  {
+    m_text   = string.m_text;
+    m_length = string.m_stringLength;
+  }
 }
 
 #endif // __cplusplus
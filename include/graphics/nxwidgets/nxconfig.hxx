@@ -77,6 +77,8 @@
  * CONFIG_NXWIDGETS_DEFAULT_FONTID - Default font ID.  Default: NXFONT_DEFAULT
  * CONFIG_NXWIDGETS_TNXARRAY_INITIALSIZE, CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT -
  *   Default dynamic array parameters.  Default: 16, 8
+ * CONFIG_NXWIDGETS_STRING_INLINESIZE - Number of characters that a CNxString
+ *   holds without allocating memory.  Default: 16
  *
  * CONFIG_NXWIDGETS_DEFAULT_BACKGROUNDCOLOR - Normal background color.  Default:
  *   MKRGB(148,189,215)
@@ -304,6 +306,14 @@
 #  define CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT 8
 #endif
 
+/**
+ * Size of the storage inside each CNxString (in characters)
+ */
+
+#ifndef CONFIG_NXWIDGETS_STRING_INLINESIZE
+#  define CONFIG_NXWIDGETS_STRING_INLINESIZE 16
+#endif
+
 /**
  * Normal background color
  */
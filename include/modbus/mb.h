@@ -240,6 +240,60 @@ eMBErrorCode eMBDisable(void);
 
 eMBErrorCode eMBPoll(void);
 
+/* Instance based interface.
+ *
+ * Every instance is a complete slave protocol stack with its own
+ * transport (serial line or TCP port), framing state and event queue, so
+ * that one thread can serve several buses.  The function handlers, the
+ * register callbacks and the slave ID are shared by all instances.  At
+ * most CONFIG_MB_INSTANCES instances exist at the same time, the legacy
+ * interface above uses one of them.
+ *
+ * eMBInstanceInit(), eMBInstanceTCPInit(), eMBInstanceClose(),
+ * eMBInstanceEnable() and eMBInstanceDisable() behave like eMBInit(),
+ * eMBTCPInit(), eMBClose(), eMBEnable() and eMBDisable().  Init returns
+ * eMBErrorCode::MB_ENORES if all instances are in use.
+ */
+
+eMBErrorCode eMBInstanceInit(xMBHandle *pxHandle, eMBMode eMode,
+                             uint8_t ucSlaveAddress, uint8_t ucPort,
+                             speed_t ulBaudRate, eMBParity eParity);
+eMBErrorCode eMBInstanceTCPInit(xMBHandle *pxHandle, uint16_t usTCPPort);
+eMBErrorCode eMBInstanceClose(xMBHandle xHandle);
+eMBErrorCode eMBInstanceEnable(xMBHandle xHandle);
+eMBErrorCode eMBInstanceDisable(xMBHandle xHandle);
+
+/* Serve all enabled instances from the calling thread.
+ *
+ * The function waits with a single poll() until a character is received,
+ * a transmitter is ready or a frame timer (t3.5 in RTU mode) expires and
+ * handles the resulting events.  Call it in a loop.
+ *
+ * Input Parameters:
+ *   iTimeoutMs Maximum time to wait in milliseconds, -1 to wait until
+ *     something happens.
+ *
+ * Returned Value:
+ *   eMBErrorCode::MB_EILLSTATE if no instance is enabled,
+ *   eMBErrorCode::MB_EIO if the port reported an error and
+ *   eMBErrorCode::MB_ENOERR otherwise.
+ */
+
+eMBErrorCode eMBPollAll(int iTimeoutMs);
+
+/* Integrate an instance into an event loop of the application.
+ *
+ * iMBPollSetup() fills at most iNFds poll descriptors and lowers
+ * *piTimeoutMs to the expiry of the instance timer. It returns the number
+ * of descriptors used. After poll() returned, pass the same descriptors to
+ * eMBPollDispatch() which handles them and the timer.
+ */
+
+int iMBPollSetup(xMBHandle xHandle, struct pollfd *pxFds, int iNFds,
+                 int *piTimeoutMs);
+eMBErrorCode eMBPollDispatch(xMBHandle xHandle, struct pollfd *pxFds,
+                             int iNFds);
+
 /* Configure the slave id of the device.
  *
  * This function should be called when the Modbus function Report Slave ID
@@ -65,6 +65,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <termios.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -107,6 +108,42 @@ typedef enum
     MB_TMODE_CONVERT_DELAY          /* Master sent broadcast ,then delay sometime.*/
 }eMBMasterTimerMode;
 
+/* Tables of a scan list point, read with function code 1, 2, 3 and 4. */
+
+typedef enum
+{
+    MB_SCAN_COILS,
+    MB_SCAN_DISCRETE_INPUTS,
+    MB_SCAN_HOLDING_REGISTERS,
+    MB_SCAN_INPUT_REGISTERS
+} eMBMasterScanTable;
+
+/* One point of a scan list.  usAddress is the protocol address (the
+ * usRegAddr of eMBMasterReqReadHoldingRegister()), ulPeriodMs the maximum
+ * age of its value.
+ */
+
+typedef struct
+{
+    uint8_t            ucSlave;
+    eMBMasterScanTable eTable;
+    uint16_t           usAddress;
+    uint32_t           ulPeriodMs;
+} xMBMasterScanPoint;
+
+/* Cached value of a point.  Coils and discrete inputs are 0 or 1.
+ * xTimestamp (CLOCK_MONOTONIC) is the time of the response the value was
+ * taken from, zero if it was never read.  eStatus is the result of the
+ * last read, the value is kept when it failed.
+ */
+
+typedef struct
+{
+    uint16_t            usValue;
+    eMBMasterReqErrCode eStatus;
+    struct timespec     xTimestamp;
+} xMBMasterScanValue;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -427,6 +464,46 @@ eMBMasterReqErrCode eMBMasterReqWriteMultipleCoils(uint8_t ucSndAddr,
 eMBMasterReqErrCode eMBMasterReqReadDiscreteInputs(uint8_t ucSndAddr,
   uint16_t usDiscreteAddr, uint16_t usNDiscreteIn, uint32_t lTimeOut);
 
+/****************************************************************************
+ * Description:
+ *   Scan list engine.
+ *
+ *   eMBMasterScanInit() takes a list of points (it must stay valid until
+ *   eMBMasterScanClose()) and merges the adjacent points of the same slave
+ *   and table into the longest reads a request can carry.  Each merged
+ *   read is repeated with the shortest period of its points.
+ *
+ *   eMBMasterScanPoll() waits for the read with the earliest deadline,
+ *   across all slaves, and performs it like eMBMasterReqRead...().  A
+ *   dedicated thread calls it in a loop while another one runs
+ *   eMBMasterPoll().  The values of the points are stored in a cache read
+ *   with eMBMasterScanGet() by index in the point list, the application
+ *   register callbacks are not called for them.  One-shot requests of the
+ *   application can still be made in between.
+ *
+ *   eMBMasterScanClose() may be called from another thread; it waits
+ *   until a running eMBMasterScanPoll() has returned, which includes its
+ *   wait for the next deadline.
+ *
+ *   vMBMasterScanGetStats() returns the number of merged reads, the
+ *   requests sent and how many of them failed.
+ *
+ * Returned Value:
+ *   eMBMasterScanInit() returns eMBErrorCode::MB_EINVAL for an invalid
+ *   point (broadcast or unknown slave, unknown table, zero period) and
+ *   eMBErrorCode::MB_ENORES if memory or function handler slots are
+ *   missing.  eMBMasterScanPoll() returns the result of the read.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBMasterScanInit(const xMBMasterScanPoint *pxPoints,
+                               uint16_t usNPoints);
+eMBErrorCode eMBMasterScanClose(void);
+eMBMasterReqErrCode eMBMasterScanPoll(void);
+eMBErrorCode eMBMasterScanGet(uint16_t usPoint, xMBMasterScanValue *pxValue);
+void vMBMasterScanGetStats(uint16_t *pusBlocks, uint32_t *pulRequests,
+                           uint32_t *pulErrors);
+
 eMBException eMBMasterFuncReportSlaveID(uint8_t *pucFrame, uint16_t *usLen);
 eMBException eMBMasterFuncReadInputRegister(uint8_t *pucFrame,
   uint16_t *usLen);
@@ -39,6 +39,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <termios.h>
+#include <poll.h>
 
 /****************************************************************************
  * Public Types
@@ -49,6 +50,13 @@ extern "C"
 {
 #endif
 
+/* One slave protocol stack: transport, framing state and event queue.
+ * The layout is private to the stack (see apps/modbus/mbinstance.h).
+ */
+
+typedef struct xMBInstance xMBInstance;
+typedef xMBInstance *xMBHandle;
+
 typedef enum
 {
   EV_READY,                   /* Startup finished. */
@@ -104,12 +112,11 @@ typedef enum
  * Return true if a event was posted to the queue because a new byte was
  * received. The port implementation should wake up the tasks which are
  * currently blocked on the eventqueue.
+ *
+ * The slave callbacks are members of the instance (pxMBFrameCBByteReceived,
+ * pxMBFrameCBTransmitterEmpty and pxMBPortCBTimerExpired).
  */
 
-extern bool(*pxMBFrameCBByteReceived)(void);
-extern bool(*pxMBFrameCBTransmitterEmpty)(void);
-extern bool(*pxMBPortCBTimerExpired)(void);
-
 extern bool(*pxMBMasterFrameCBByteReceived)(void);
 extern bool(*pxMBMasterFrameCBTransmitterEmpty)(void);
 extern bool(*pxMBMasterPortCBTimerExpired)(void);
@@ -120,9 +127,9 @@ extern bool(*pxMBMasterPortCBTimerExpired)(void);
 
 /* Supporting functions */
 
-bool xMBPortEventInit(void);
-bool xMBPortEventPost(eMBEventType eEvent);
-bool xMBPortEventGet(eMBEventType *eEvent);
+bool xMBPortEventInit(xMBInstance *pxInst);
+bool xMBPortEventPost(xMBInstance *pxInst, eMBEventType eEvent);
+bool xMBPortEventGet(xMBInstance *pxInst, eMBEventType *eEvent);
 
 bool xMBMasterPortEventInit(void);
 bool xMBMasterPortEventPost(eMBMasterEventType eEvent);
@@ -133,13 +140,14 @@ void vMBMasterRunResRelease(void);
 
 /* Serial port functions */
 
-bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
-                       uint8_t ucDataBits, eMBParity eParity);
-void vMBPortClose(void);
-void xMBPortSerialClose(void);
-void vMBPortSerialEnable(bool xRxEnable, bool xTxEnable);
-bool xMBPortSerialGetByte(int8_t *pucByte);
-bool xMBPortSerialPutByte(int8_t ucByte);
+bool xMBPortSerialInit(xMBInstance *pxInst, uint8_t ucPort,
+                       speed_t ulBaudRate, uint8_t ucDataBits,
+                       eMBParity eParity);
+void vMBPortClose(xMBInstance *pxInst);
+void vMBPortSerialEnable(xMBInstance *pxInst, bool xRxEnable,
+                         bool xTxEnable);
+bool xMBPortSerialGetByte(xMBInstance *pxInst, int8_t *pucByte);
+bool xMBPortSerialPutByte(xMBInstance *pxInst, int8_t ucByte);
 
 bool xMBMasterPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
                              uint8_t ucDataBits, eMBParity eParity);
@@ -151,12 +159,27 @@ bool xMBMasterPortSerialPutByte(int8_t ucByte);
 
 /* Timers functions */
 
-bool xMBPortTimersInit(uint16_t usTimeOut50us);
-void xMBPortTimersClose(void);
-void vMBPortTimersEnable(void);
-void vMBPortTimersDisable(void);
+bool xMBPortTimersInit(xMBInstance *pxInst, uint32_t ulTimeOut50us);
+void xMBPortTimersClose(xMBInstance *pxInst);
+void vMBPortTimersEnable(xMBInstance *pxInst);
+void vMBPortTimersDisable(xMBInstance *pxInst);
 void vMBPortTimersDelay(uint16_t usTimeOutMS);
 
+/* Event loop functions
+ *
+ * iMBPortPollSetup() fills the descriptor of the serial line (if iNFds is
+ * not zero) and lowers *piTimeoutMs (-1 is infinite) to the expiry of the
+ * instance timer.  It returns the number of descriptors used.
+ * xMBPortPollDispatch() handles the poll() result: it feeds the received
+ * characters to the receiver, pumps the transmitter and runs the timer.
+ * Both may post events to the instance.
+ */
+
+int  iMBPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds,
+                      int iNFds, int *piTimeoutMs);
+bool xMBPortPollDispatch(xMBInstance *pxInst, struct pollfd *pxFds,
+                         int iNFds);
+
 bool xMBMasterPortTimersInit(uint16_t usTimeOut50us);
 void xMBMasterPortTimersClose(void);
 void vMBMasterPortTimersT35Enable(void);
@@ -175,15 +198,24 @@ void vMBMasterErrorCBExecuteFunction(uint8_t ucDestAddress, const uint8_t *pucPD
 void vMBMasterCBRequestSuccess(void);
 
 #ifdef CONFIG_MB_TCP_ENABLED
-/* TCP port function */
+/* TCP port function
+ *
+ * xMBTCPPortInit() opens the listening socket of the instance,
+ * vMBTCPPortDisable() drops all client connections and vMBTCPPortClose()
+ * also closes the listening socket.  iMBTCPPortPollSetup() and
+ * xMBTCPPortPollDispatch() work like iMBPortPollSetup() and
+ * xMBPortPollDispatch() but use one descriptor for the listening socket
+ * and one per client connection (at most MB_PORT_POLL_FDS).  The requests
+ * are executed with eMBTCPExecute() while the connections are dispatched.
+ */
 
-bool xMBTCPPortInit(uint16_t usTCPPort);
-#ifdef CONFIG_MB_HAVE_CLOSE
-void vMBTCPPortClose(void);
-#endif
-void vMBTCPPortDisable(void);
-bool xMBTCPPortGetRequest(uint8_t **ppucMBTCPFrame, uint16_t * usTCPLength);
-bool xMBTCPPortSendResponse(const uint8_t *pucMBTCPFrame, uint16_t usTCPLength);
+bool xMBTCPPortInit(xMBInstance *pxInst, uint16_t usTCPPort);
+void vMBTCPPortClose(xMBInstance *pxInst);
+void vMBTCPPortDisable(xMBInstance *pxInst);
+int  iMBTCPPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds,
+                         int iNFds, int *piTimeoutMs);
+bool xMBTCPPortPollDispatch(xMBInstance *pxInst, struct pollfd *pxFds,
+                            int iNFds);
 #endif
 
 #ifdef __cplusplus
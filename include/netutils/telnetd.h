@@ -90,6 +90,31 @@ extern "C"
 
 int telnetd_daemon(FAR const struct telnetd_config_s *config);
 
+/****************************************************************************
+ * Name: telnetd_mux
+ *
+ * Description:
+ *   Run the multiplexed Telnet daemon loop.  A single task polls all
+ *   client sockets, handles the Telnet protocol for them, and passes the
+ *   data to and from a bounded number of sessions over pty pairs.  The
+ *   session tasks are started as described by 'config', with the pty
+ *   slave as their stdin, stdout and stderr.
+ *
+ * Parameters:
+ *   config    A pointer to a configuration structure that characterizes the
+ *             Telnet daemon.  This configuration structure may be defined
+ *             on the caller's stack because it is not retained by the
+ *             daemon.
+ *
+ * Return:
+ *   A negated errno is returned if the daemon was not successfully started.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_MUX
+int telnetd_mux(FAR const struct telnetd_config_s *config);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -46,6 +46,21 @@ struct nxplayer_dec_ops_s
   CODE int (*fill_data)(int fd, FAR struct ap_buffer_s *apb);
 };
 
+/* Playback pipeline statistics returned by nxplayer_getstatus() */
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+struct nxplayer_status_s
+{
+  uint32_t        underruns;                   /* Device queue ran empty while streaming */
+  uint32_t        late;                        /* Buffers returned with nothing decoded */
+  uint16_t        nbuffers;                    /* Device plus prefetch buffers */
+  uint16_t        prefetch;                    /* Decoded buffers waiting right now */
+  uint16_t        minprefetch;                 /* Lowest prefetch level seen */
+};
+
+struct nxplayer_prefetch_s;
+#endif
+
 /* This structure describes the internal state of the NxPlayer */
 
 struct nxplayer_s
@@ -79,6 +94,10 @@ struct nxplayer_s
   uint16_t        treble;                      /* Treble as a whole % */
   uint16_t        bass;                        /* Bass as a whole % */
 #endif
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  FAR struct nxplayer_prefetch_s *prefetch;    /* Reader thread and buffer rings */
+  struct nxplayer_status_s status;             /* Statistics of the last playback */
+#endif
 
   FAR const struct nxplayer_dec_ops_s *ops;
 };
@@ -489,6 +508,26 @@ int nxplayer_settreble(FAR struct nxplayer_s *pplayer, uint8_t treble);
 int nxplayer_systemreset(FAR struct nxplayer_s *pplayer);
 #endif
 
+/****************************************************************************
+ * Name: nxplayer_getstatus
+ *
+ *   Returns the underrun counters and prefetch level of the current (or
+ *   last) playback.
+ *
+ * Input Parameters:
+ *   pplayer   - Pointer to the context
+ *   status    - Location to return the statistics
+ *
+ * Returned Value:
+ *   OK
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+int nxplayer_getstatus(FAR struct nxplayer_s *pplayer,
+                       FAR struct nxplayer_status_s *status);
+#endif
+
 /****************************************************************************
  * Name: nxplayer_parse_mp3
  *
@@ -25,6 +25,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <sys/types.h>
 #include <stdint.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/fs/fs.h>
@@ -111,6 +112,15 @@ struct termcurses_ops_s
 
   CODE bool (*checkkey)(FAR struct termcurses_s *dev);
 
+  /* Write text at the current cursor position */
+
+  CODE ssize_t (*write)(FAR struct termcurses_s *dev, FAR const char *buf,
+                        size_t len);
+
+  /* Send any buffered output to the terminal */
+
+  CODE int (*flush)(FAR struct termcurses_s *dev);
+
   /* Terminate  */
 
   CODE int (*terminate)(FAR struct termcurses_s *dev);
@@ -218,6 +228,29 @@ int termcurses_setcolors(FAR struct termcurses_s *term,
 int termcurses_getwinsize(FAR struct termcurses_s *term,
                           FAR struct winsize *winsz);
 
+/****************************************************************************
+ * Name: termcurses_write
+ *
+ * Description:
+ *   Write text at the current cursor position.  Like the cursor, attribute
+ *   and color operations, the text may be buffered until the next call to
+ *   termcurses_flush() or until the terminal input is read.
+ *
+ ****************************************************************************/
+
+ssize_t termcurses_write(FAR struct termcurses_s *term, FAR const char *buf,
+                         size_t len);
+
+/****************************************************************************
+ * Name: termcurses_flush
+ *
+ * Description:
+ *   Send any buffered output to the terminal.
+ *
+ ****************************************************************************/
+
+int termcurses_flush(FAR struct termcurses_s *term);
+
 /****************************************************************************
  * Name: termcurses_getkeycode
  *
@@ -94,14 +94,18 @@
  * to the remote receiver. Support for such asynchronous incoming data
  * notification is needed to support interruption of the file transfer by
  * the remote receiver.
- *
- * This capapability is not yet supported.  There are only incomplete hooks
- * in the code now!
  */
 
-#ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
-#  warning CONFIG_SYSTEM_ZMODEM_RCVSAMPLE not yet supported
-#  undef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
+/* Maximum number of unacknowledged bytes while streaming */
+
+#ifndef CONFIG_SYSTEM_ZMODEM_SNDWINDOW
+#  define CONFIG_SYSTEM_ZMODEM_SNDWINDOW 16384
+#endif
+
+/* Size of each of the two buffers of the sender's reader thread */
+
+#ifndef CONFIG_SYSTEM_ZMODEM_SNDREADSIZE
+#  define CONFIG_SYSTEM_ZMODEM_SNDREADSIZE 4096
 #endif
 
 /* CONFIG_SYSTEM_ZMODEM_SENDATTN indicates that the local sender retains
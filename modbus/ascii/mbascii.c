@@ -44,6 +44,7 @@
 #include "modbus/mbframe.h"
 #include "modbus/mbport.h"
 
+#include "mbinstance.h"
 #include "mbascii.h"
 #include "mbcrc.h"
 
@@ -95,28 +96,6 @@ static uint8_t prvucMBint8_t2BIN(uint8_t ucCharacter);
 static uint8_t prvucMBBIN2int8_t(uint8_t ucByte);
 static uint8_t prvucMBLRC(uint8_t *pucFrame, uint16_t usLen);
 
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static volatile eMBSndState eSndState;
-static volatile eMBRcvState eRcvState;
-
-/* We reuse the Modbus RTU buffer because only one buffer is needed and the
- * RTU buffer is bigger.
- */
-
-extern volatile uint8_t ucRTUBuf[];
-static volatile uint8_t *ucASCIIBuf = ucRTUBuf;
-
-static volatile uint16_t usRcvBufferPos;
-static volatile eMBBytePos eBytePos;
-
-static volatile uint8_t *pucSndBufferCur;
-static volatile uint16_t usSndBufferCount;
-
-static volatile uint8_t ucMBLFCharacter;
-
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -176,19 +155,21 @@ static uint8_t prvucMBLRC(uint8_t * pucFrame, uint16_t usLen)
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBASCIIInit(uint8_t ucSlaveAddress, uint8_t ucPort,
-                          speed_t ulBaudRate, eMBParity eParity)
+eMBErrorCode eMBASCIIInit(xMBInstance *pxInst, uint8_t ucSlaveAddress,
+                          uint8_t ucPort, speed_t ulBaudRate,
+                          eMBParity eParity)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
   ENTER_CRITICAL_SECTION();
-  ucMBLFCharacter = MB_ASCII_DEFAULT_LF;
+  pxInst->ucMBLFCharacter = MB_ASCII_DEFAULT_LF;
 
-  if (xMBPortSerialInit(ucPort, ulBaudRate, 7, eParity) != true)
+  if (xMBPortSerialInit(pxInst, ucPort, ulBaudRate, 7, eParity) != true)
     {
       eStatus = MB_EPORTERR;
     }
-  else if (xMBPortTimersInit(CONFIG_MB_ASCII_TIMEOUT_SEC * 20000UL) != true)
+  else if (xMBPortTimersInit(pxInst,
+                             CONFIG_MB_ASCII_TIMEOUT_SEC * 20000UL) != true)
     {
       eStatus = MB_EPORTERR;
     }
@@ -197,54 +178,55 @@ eMBErrorCode eMBASCIIInit(uint8_t ucSlaveAddress, uint8_t ucPort,
   return eStatus;
 }
 
-void eMBASCIIStart(void)
+void eMBASCIIStart(xMBInstance *pxInst)
 {
   ENTER_CRITICAL_SECTION();
-  vMBPortSerialEnable(true, false);
-  eRcvState = STATE_RX_IDLE;
+  vMBPortSerialEnable(pxInst, true, false);
+  pxInst->eRcvState = STATE_RX_IDLE;
   EXIT_CRITICAL_SECTION();
 
   /* No special startup required for ASCII. */
 
-  xMBPortEventPost(EV_READY);
+  xMBPortEventPost(pxInst, EV_READY);
 }
 
-void eMBASCIIStop(void)
+void eMBASCIIStop(xMBInstance *pxInst)
 {
   ENTER_CRITICAL_SECTION();
-  vMBPortSerialEnable(false, false);
-  vMBPortTimersDisable();
+  vMBPortSerialEnable(pxInst, false, false);
+  vMBPortTimersDisable(pxInst);
   EXIT_CRITICAL_SECTION();
 }
 
-eMBErrorCode eMBASCIIReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
-                             uint16_t *pusLength)
+eMBErrorCode eMBASCIIReceive(xMBInstance *pxInst, uint8_t *pucRcvAddress,
+                             uint8_t **pucFrame, uint16_t *pusLength)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
   ENTER_CRITICAL_SECTION();
-  DEBUGASSERT(usRcvBufferPos < MB_SER_PDU_SIZE_MAX);
+  DEBUGASSERT(pxInst->usRcvBufferPos < MB_SER_PDU_SIZE_MAX);
 
   /* Length and CRC check */
 
-  if ((usRcvBufferPos >= MB_SER_PDU_SIZE_MIN) &&
-      (prvucMBLRC((uint8_t *) ucASCIIBuf, usRcvBufferPos) == 0))
+  if ((pxInst->usRcvBufferPos >= MB_SER_PDU_SIZE_MIN) &&
+      (prvucMBLRC((uint8_t *) pxInst->ucSerBuf, pxInst->usRcvBufferPos) == 0))
     {
       /* Save the address field. All frames are passed to the upper laid
        * and the decision if a frame is used is done there.
        */
 
-      *pucRcvAddress = ucASCIIBuf[MB_SER_PDU_ADDR_OFF];
+      *pucRcvAddress = pxInst->ucSerBuf[MB_SER_PDU_ADDR_OFF];
 
       /* Total length of Modbus-PDU is Modbus-Serial-Line-PDU minus
        * size of address field and CRC checksum.
        */
 
-      *pusLength = usRcvBufferPos - MB_SER_PDU_PDU_OFF - MB_SER_PDU_SIZE_LRC;
+      *pusLength = pxInst->usRcvBufferPos - MB_SER_PDU_PDU_OFF -
+                   MB_SER_PDU_SIZE_LRC;
 
       /* Return the start of the Modbus PDU to the caller. */
 
-      *pucFrame = (uint8_t *) & ucASCIIBuf[MB_SER_PDU_PDU_OFF];
+      *pucFrame = (uint8_t *) & pxInst->ucSerBuf[MB_SER_PDU_PDU_OFF];
     }
   else
     {
@@ -255,8 +237,8 @@ eMBErrorCode eMBASCIIReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
   return eStatus;
 }
 
-eMBErrorCode eMBASCIISend(uint8_t ucSlaveAddress, const uint8_t *pucFrame,
-                          uint16_t usLength)
+eMBErrorCode eMBASCIISend(xMBInstance *pxInst, uint8_t ucSlaveAddress,
+                          const uint8_t *pucFrame, uint16_t usLength)
 {
   eMBErrorCode eStatus = MB_ENOERR;
   uint8_t usLRC;
@@ -268,27 +250,28 @@ eMBErrorCode eMBASCIISend(uint8_t ucSlaveAddress, const uint8_t *pucFrame,
    * frame on the network. We have to abort sending the frame.
    */
 
-  if (eRcvState == STATE_RX_IDLE)
+  if (pxInst->eRcvState == STATE_RX_IDLE)
     {
       /* First byte before the Modbus-PDU is the slave address. */
 
-      pucSndBufferCur = (uint8_t *) pucFrame - 1;
-      usSndBufferCount = 1;
+      pxInst->pucSndBufferCur = (uint8_t *) pucFrame - 1;
+      pxInst->usSndBufferCount = 1;
 
       /* Now copy the Modbus-PDU into the Modbus-Serial-Line-PDU. */
 
-      pucSndBufferCur[MB_SER_PDU_ADDR_OFF] = ucSlaveAddress;
-      usSndBufferCount += usLength;
+      pxInst->pucSndBufferCur[MB_SER_PDU_ADDR_OFF] = ucSlaveAddress;
+      pxInst->usSndBufferCount += usLength;
 
       /* Calculate LRC checksum for Modbus-Serial-Line-PDU. */
 
-      usLRC = prvucMBLRC((uint8_t *) pucSndBufferCur, usSndBufferCount);
-      ucASCIIBuf[usSndBufferCount++] = usLRC;
+      usLRC = prvucMBLRC((uint8_t *)pxInst->pucSndBufferCur,
+                         pxInst->usSndBufferCount);
+      pxInst->ucSerBuf[pxInst->usSndBufferCount++] = usLRC;
 
       /* Activate the transmitter. */
 
-      eSndState = STATE_TX_START;
-      vMBPortSerialEnable(false, true);
+      pxInst->eSndState = STATE_TX_START;
+      vMBPortSerialEnable(pxInst, false, true);
     }
   else
     {
@@ -299,16 +282,16 @@ eMBErrorCode eMBASCIISend(uint8_t ucSlaveAddress, const uint8_t *pucFrame,
   return eStatus;
 }
 
-bool xMBASCIIReceiveFSM(void)
+bool xMBASCIIReceiveFSM(xMBInstance *pxInst)
 {
   bool xNeedPoll = false;
   uint8_t ucByte;
   uint8_t ucResult;
 
-  DEBUGASSERT(eSndState == STATE_TX_IDLE);
+  DEBUGASSERT(pxInst->eSndState == STATE_TX_IDLE);
 
-  xMBPortSerialGetByte((int8_t *) & ucByte);
-  switch (eRcvState)
+  xMBPortSerialGetByte(pxInst, (int8_t *) & ucByte);
+  switch (pxInst->eRcvState)
     {
     /* A new character is received. If the character is a ':' the input
      * buffer is cleared. A CR-character signals the end of the data
@@ -320,32 +303,33 @@ bool xMBASCIIReceiveFSM(void)
 
       /* Enable timer for character timeout. */
 
-      vMBPortTimersEnable();
+      vMBPortTimersEnable(pxInst);
       if (ucByte == ':')
         {
           /* Empty receive buffer. */
 
-          eBytePos = BYTE_HIGH_NIBBLE;
-          usRcvBufferPos = 0;
+          pxInst->eBytePos = BYTE_HIGH_NIBBLE;
+          pxInst->usRcvBufferPos = 0;
         }
       else if (ucByte == MB_ASCII_DEFAULT_CR)
         {
-          eRcvState = STATE_RX_WAIT_EOF;
+          pxInst->eRcvState = STATE_RX_WAIT_EOF;
         }
       else
         {
           ucResult = prvucMBint8_t2BIN(ucByte);
-          switch (eBytePos)
+          switch (pxInst->eBytePos)
           {
           /* High nibble of the byte comes first. We check for
            * a buffer overflow here.
            */
 
           case BYTE_HIGH_NIBBLE:
-            if (usRcvBufferPos < MB_SER_PDU_SIZE_MAX)
+            if (pxInst->usRcvBufferPos < MB_SER_PDU_SIZE_MAX)
               {
-                ucASCIIBuf[usRcvBufferPos] = (uint8_t)(ucResult << 4);
-                eBytePos = BYTE_LOW_NIBBLE;
+                pxInst->ucSerBuf[pxInst->usRcvBufferPos] =
+                  (uint8_t)(ucResult << 4);
+                pxInst->eBytePos = BYTE_LOW_NIBBLE;
                 break;
               }
             else
@@ -354,59 +338,59 @@ bool xMBASCIIReceiveFSM(void)
                  * a reasonable implementation.
                  */
 
-                eRcvState = STATE_RX_IDLE;
+                pxInst->eRcvState = STATE_RX_IDLE;
 
                 /* Disable previously activated timer due to error state. */
 
-                vMBPortTimersDisable();
+                vMBPortTimersDisable(pxInst);
               }
             break;
 
           case BYTE_LOW_NIBBLE:
-            ucASCIIBuf[usRcvBufferPos] |= ucResult;
-            usRcvBufferPos++;
-            eBytePos = BYTE_HIGH_NIBBLE;
+            pxInst->ucSerBuf[pxInst->usRcvBufferPos] |= ucResult;
+            pxInst->usRcvBufferPos++;
+            pxInst->eBytePos = BYTE_HIGH_NIBBLE;
             break;
           }
         }
         break;
 
     case STATE_RX_WAIT_EOF:
-      if (ucByte == ucMBLFCharacter)
+      if (ucByte == pxInst->ucMBLFCharacter)
         {
           /* Disable character timeout timer because all characters are
            * received.
            */
 
-          vMBPortTimersDisable();
+          vMBPortTimersDisable(pxInst);
 
            /* Receiver is again in idle state. */
 
-           eRcvState = STATE_RX_IDLE;
+           pxInst->eRcvState = STATE_RX_IDLE;
 
           /* Notify the caller of eMBASCIIReceive that a new frame
            * was received.
            */
 
-          xNeedPoll = xMBPortEventPost(EV_FRAME_RECEIVED);
+          xNeedPoll = xMBPortEventPost(pxInst, EV_FRAME_RECEIVED);
         }
       else if (ucByte == ':')
         {
           /* Empty receive buffer and back to receive state. */
 
-          eBytePos = BYTE_HIGH_NIBBLE;
-          usRcvBufferPos = 0;
-          eRcvState = STATE_RX_RCV;
+          pxInst->eBytePos = BYTE_HIGH_NIBBLE;
+          pxInst->usRcvBufferPos = 0;
+          pxInst->eRcvState = STATE_RX_RCV;
 
           /* Enable timer for character timeout. */
 
-          vMBPortTimersEnable();
+          vMBPortTimersEnable(pxInst);
         }
       else
         {
           /* Frame is not okay. Delete entire frame. */
 
-          eRcvState = STATE_RX_IDLE;
+          pxInst->eRcvState = STATE_RX_IDLE;
         }
         break;
 
@@ -415,13 +399,13 @@ bool xMBASCIIReceiveFSM(void)
         {
           /* Enable timer for character timeout. */
 
-          vMBPortTimersEnable();
+          vMBPortTimersEnable(pxInst);
 
           /* Reset the input buffers to store the frame. */
 
-          usRcvBufferPos = 0;
-          eBytePos = BYTE_HIGH_NIBBLE;
-          eRcvState = STATE_RX_RCV;
+          pxInst->usRcvBufferPos = 0;
+          pxInst->eBytePos = BYTE_HIGH_NIBBLE;
+          pxInst->eRcvState = STATE_RX_RCV;
         }
         break;
     }
@@ -429,13 +413,13 @@ bool xMBASCIIReceiveFSM(void)
   return xNeedPoll;
 }
 
-bool xMBASCIITransmitFSM(void)
+bool xMBASCIITransmitFSM(xMBInstance *pxInst)
 {
   bool xNeedPoll = false;
   uint8_t ucByte;
 
-  DEBUGASSERT(eRcvState == STATE_RX_IDLE);
-  switch (eSndState)
+  DEBUGASSERT(pxInst->eRcvState == STATE_RX_IDLE);
+  switch (pxInst->eSndState)
   {
   /* Start of transmission. The start of a frame is defined by sending
    * the character ':'.
@@ -443,9 +427,9 @@ bool xMBASCIITransmitFSM(void)
 
   case STATE_TX_START:
     ucByte = ':';
-    xMBPortSerialPutByte((int8_t)ucByte);
-    eSndState = STATE_TX_DATA;
-    eBytePos = BYTE_HIGH_NIBBLE;
+    xMBPortSerialPutByte(pxInst, (int8_t)ucByte);
+    pxInst->eSndState = STATE_TX_DATA;
+    pxInst->eBytePos = BYTE_HIGH_NIBBLE;
     break;
 
   /* Send the data block. Each data byte is encoded as a character hex
@@ -455,42 +439,44 @@ bool xMBASCIITransmitFSM(void)
    */
 
   case STATE_TX_DATA:
-    if (usSndBufferCount > 0)
+    if (pxInst->usSndBufferCount > 0)
       {
-        switch (eBytePos)
+        switch (pxInst->eBytePos)
         {
         case BYTE_HIGH_NIBBLE:
-          ucByte = prvucMBBIN2int8_t((uint8_t)(*pucSndBufferCur >> 4));
-          xMBPortSerialPutByte((int8_t) ucByte);
-          eBytePos = BYTE_LOW_NIBBLE;
+          ucByte =
+            prvucMBBIN2int8_t((uint8_t)(*pxInst->pucSndBufferCur >> 4));
+          xMBPortSerialPutByte(pxInst, (int8_t) ucByte);
+          pxInst->eBytePos = BYTE_LOW_NIBBLE;
           break;
 
         case BYTE_LOW_NIBBLE:
-          ucByte = prvucMBBIN2int8_t((uint8_t)(*pucSndBufferCur & 0x0f));
-          xMBPortSerialPutByte((int8_t)ucByte);
-          pucSndBufferCur++;
-          eBytePos = BYTE_HIGH_NIBBLE;
-          usSndBufferCount--;
+          ucByte =
+            prvucMBBIN2int8_t((uint8_t)(*pxInst->pucSndBufferCur & 0x0f));
+          xMBPortSerialPutByte(pxInst, (int8_t)ucByte);
+          pxInst->pucSndBufferCur++;
+          pxInst->eBytePos = BYTE_HIGH_NIBBLE;
+          pxInst->usSndBufferCount--;
           break;
         }
       }
     else
       {
-        xMBPortSerialPutByte(MB_ASCII_DEFAULT_CR);
-        eSndState = STATE_TX_END;
+        xMBPortSerialPutByte(pxInst, MB_ASCII_DEFAULT_CR);
+        pxInst->eSndState = STATE_TX_END;
       }
     break;
 
     /* Finish the frame by sending a LF character. */
 
     case STATE_TX_END:
-      xMBPortSerialPutByte((int8_t)ucMBLFCharacter);
+      xMBPortSerialPutByte(pxInst, (int8_t)pxInst->ucMBLFCharacter);
 
       /* We need another state to make sure that the CR character has
        * been sent.
        */
 
-      eSndState = STATE_TX_NOTIFY;
+      pxInst->eSndState = STATE_TX_NOTIFY;
       break;
 
     /* Notify the task which called eMBASCIISend that the frame has
@@ -498,15 +484,15 @@ bool xMBASCIITransmitFSM(void)
      */
 
     case STATE_TX_NOTIFY:
-      eSndState = STATE_TX_IDLE;
-      xNeedPoll = xMBPortEventPost(EV_FRAME_SENT);
+      pxInst->eSndState = STATE_TX_IDLE;
+      xNeedPoll = xMBPortEventPost(pxInst, EV_FRAME_SENT);
 
       /* Disable transmitter. This prevents another transmit buffer
        * empty interrupt.
        */
 
-      vMBPortSerialEnable(true, false);
-      eSndState = STATE_TX_IDLE;
+      vMBPortSerialEnable(pxInst, true, false);
+      pxInst->eSndState = STATE_TX_IDLE;
       break;
 
     /* We should not get a transmitter event if the transmitter is in
@@ -517,16 +503,16 @@ bool xMBASCIITransmitFSM(void)
 
       /* enable receiver/disable transmitter. */
 
-      vMBPortSerialEnable(true, false);
+      vMBPortSerialEnable(pxInst, true, false);
       break;
     }
 
   return xNeedPoll;
 }
 
-bool xMBASCIITimerT1SExpired(void)
+bool xMBASCIITimerT1SExpired(xMBInstance *pxInst)
 {
-  switch (eRcvState)
+  switch (pxInst->eRcvState)
   {
   /* If we have a timeout we go back to the idle state and wait for
    * the next frame.
@@ -534,15 +520,16 @@ bool xMBASCIITimerT1SExpired(void)
 
   case STATE_RX_RCV:
   case STATE_RX_WAIT_EOF:
-    eRcvState = STATE_RX_IDLE;
+    pxInst->eRcvState = STATE_RX_IDLE;
     break;
 
   default:
-    DEBUGASSERT(eRcvState == STATE_RX_RCV || eRcvState == STATE_RX_WAIT_EOF);
+    DEBUGASSERT(pxInst->eRcvState == STATE_RX_RCV ||
+                pxInst->eRcvState == STATE_RX_WAIT_EOF);
     break;
   }
 
-  vMBPortTimersDisable();
+  vMBPortTimersDisable(pxInst);
 
   /* no context switch required. */
 
@@ -42,17 +42,18 @@ extern "C"
  ****************************************************************************/
 
 #ifdef CONFIG_MB_ASCII_ENABLED
-eMBErrorCode eMBASCIIInit(uint8_t slaveAddress, uint8_t ucPort,
-                          speed_t ulBaudRate, eMBParity eParity);
-void eMBASCIIStart(void);
-void eMBASCIIStop(void);
-eMBErrorCode eMBASCIIReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
-                             uint16_t * pusLength);
-eMBErrorCode eMBASCIISend(uint8_t slaveAddress, const uint8_t *pucFrame,
-                          uint16_t usLength);
-bool xMBASCIIReceiveFSM(void);
-bool xMBASCIITransmitFSM(void);
-bool xMBASCIITimerT1SExpired(void);
+eMBErrorCode eMBASCIIInit(xMBInstance *pxInst, uint8_t slaveAddress,
+                          uint8_t ucPort, speed_t ulBaudRate,
+                          eMBParity eParity);
+void eMBASCIIStart(xMBInstance *pxInst);
+void eMBASCIIStop(xMBInstance *pxInst);
+eMBErrorCode eMBASCIIReceive(xMBInstance *pxInst, uint8_t *pucRcvAddress,
+                             uint8_t **pucFrame, uint16_t *pusLength);
+eMBErrorCode eMBASCIISend(xMBInstance *pxInst, uint8_t slaveAddress,
+                          const uint8_t *pucFrame, uint16_t usLength);
+bool xMBASCIIReceiveFSM(xMBInstance *pxInst);
+bool xMBASCIITransmitFSM(xMBInstance *pxInst);
+bool xMBASCIITimerT1SExpired(xMBInstance *pxInst);
 #endif
 
 #ifdef __cplusplus
@@ -36,6 +36,8 @@
 #include <nuttx/config.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
 
 #include "port.h"
 
@@ -46,6 +48,8 @@
 
 #include "modbus/mbport.h"
 
+#include "mbinstance.h"
+
 #ifdef CONFIG_MB_RTU_ENABLED
 #  include "mbrtu.h"
 #endif
@@ -59,40 +63,27 @@
 #endif
 
 /****************************************************************************
- * Private Data
+ * Pre-processor Definitions
  ****************************************************************************/
 
-static uint8_t  ucMBAddress;
-static eMBMode  eMBCurrentMode;
-
-static enum
-{
-  STATE_ENABLED,
-  STATE_DISABLED,
-  STATE_NOT_INITIALIZED
-} eMBState = STATE_NOT_INITIALIZED;
+#ifndef CONFIG_MB_INSTANCES
+#  define CONFIG_MB_INSTANCES 1
+#endif
 
-/* Functions pointer which are initialized in eMBInit(). Depending on the
- * mode (RTU or ASCII) the are set to the correct implementations.
- */
+#ifndef CONFIG_MB_POLL_TIMEOUT_MS
+#  define CONFIG_MB_POLL_TIMEOUT_MS 50
+#endif
 
-static peMBFrameSend peMBFrameSendCur;
-static pvMBFrameStart pvMBFrameStartCur;
-static pvMBFrameStop pvMBFrameStopCur;
-static peMBFrameReceive peMBFrameReceiveCur;
-static pvMBFrameClose pvMBFrameCloseCur;
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
 
-/* Callback functions required by the porting layer. They are called when
- * an external event has happened which includes a timeout or the reception
- * or transmission of a character.
+/* Instance pool, unused slots are STATE_NOT_INITIALIZED.  The legacy
+ * interface (eMBInit(), eMBPoll(), ...) works on pxMBDefault.
  */
 
-bool(*pxMBFrameCBByteReceived)(void);
-bool(*pxMBFrameCBTransmitterEmpty)(void);
-bool(*pxMBPortCBTimerExpired)(void);
-
-bool(*pxMBFrameCBReceiveFSMCur)(void);
-bool(*pxMBFrameCBTransmitFSMCur)(void);
+static xMBInstance  xMBInstances[CONFIG_MB_INSTANCES];
+static xMBInstance *pxMBDefault;
 
 /* An array of Modbus functions handlers which associates Modbus function
  * codes with implementing functions.
@@ -133,11 +124,45 @@ static xMBFunctionHandler xFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX] =
 };
 
 /****************************************************************************
- * Public Functions
+ * Private Functions
  ****************************************************************************/
 
-eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
-                     speed_t ulBaudRate, eMBParity eParity)
+static xMBInstance *prvpxMBAlloc(void)
+{
+  xMBInstance *pxInst = NULL;
+  int          i;
+
+  ENTER_CRITICAL_SECTION();
+
+  for (i = 0; i < CONFIG_MB_INSTANCES; i++)
+    {
+      if (xMBInstances[i].eMBState == STATE_NOT_INITIALIZED)
+        {
+          pxInst = &xMBInstances[i];
+          memset(pxInst, 0, sizeof(xMBInstance));
+          vMBPortInstanceInit(pxInst);
+
+          /* Reserve the slot, it is not polled until enabled. */
+
+          pxInst->eMBState = STATE_DISABLED;
+          break;
+        }
+    }
+
+  EXIT_CRITICAL_SECTION();
+  return pxInst;
+}
+
+static void prvvMBFree(xMBInstance *pxInst)
+{
+  ENTER_CRITICAL_SECTION();
+  pxInst->eMBState = STATE_NOT_INITIALIZED;
+  EXIT_CRITICAL_SECTION();
+}
+
+static eMBErrorCode prveMBSerialInit(xMBInstance *pxInst, eMBMode eMode,
+                                     uint8_t ucSlaveAddress, uint8_t ucPort,
+                                     speed_t ulBaudRate, eMBParity eParity)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
@@ -150,36 +175,38 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
     }
   else
     {
-      ucMBAddress = ucSlaveAddress;
+      pxInst->ucMBAddress = ucSlaveAddress;
 
       switch (eMode)
         {
 #ifdef CONFIG_MB_RTU_ENABLED
         case MB_RTU:
-          pvMBFrameStartCur = eMBRTUStart;
-          pvMBFrameStopCur = eMBRTUStop;
-          peMBFrameSendCur = eMBRTUSend;
-          peMBFrameReceiveCur = eMBRTUReceive;
-          pvMBFrameCloseCur = vMBPortClose;
-          pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
-          pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
-          pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
-
-          eStatus = eMBRTUInit(ucMBAddress, ucPort, ulBaudRate, eParity);
+          pxInst->pvMBFrameStartCur = eMBRTUStart;
+          pxInst->pvMBFrameStopCur = eMBRTUStop;
+          pxInst->peMBFrameSendCur = eMBRTUSend;
+          pxInst->peMBFrameReceiveCur = eMBRTUReceive;
+          pxInst->pvMBFrameCloseCur = vMBPortClose;
+          pxInst->pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
+          pxInst->pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
+          pxInst->pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
+
+          eStatus = eMBRTUInit(pxInst, ucSlaveAddress, ucPort, ulBaudRate,
+                               eParity);
           break;
 #endif
 #ifdef CONFIG_MB_ASCII_ENABLED
         case MB_ASCII:
-          pvMBFrameStartCur = eMBASCIIStart;
-          pvMBFrameStopCur = eMBASCIIStop;
-          peMBFrameSendCur = eMBASCIISend;
-          peMBFrameReceiveCur = eMBASCIIReceive;
-          pvMBFrameCloseCur = vMBPortClose;
-          pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
-          pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
-          pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
-
-          eStatus = eMBASCIIInit(ucMBAddress, ucPort, ulBaudRate, eParity);
+          pxInst->pvMBFrameStartCur = eMBASCIIStart;
+          pxInst->pvMBFrameStopCur = eMBASCIIStop;
+          pxInst->peMBFrameSendCur = eMBASCIISend;
+          pxInst->peMBFrameReceiveCur = eMBASCIIReceive;
+          pxInst->pvMBFrameCloseCur = vMBPortClose;
+          pxInst->pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
+          pxInst->pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
+          pxInst->pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
+
+          eStatus = eMBASCIIInit(pxInst, ucSlaveAddress, ucPort, ulBaudRate,
+                                 eParity);
           break;
 #endif
         default:
@@ -188,7 +215,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
 
       if (eStatus == MB_ENOERR)
         {
-          if (!xMBPortEventInit())
+          if (!xMBPortEventInit(pxInst))
             {
               /* port dependent event module initialization failed. */
 
@@ -196,249 +223,505 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
             }
           else
             {
-              eMBCurrentMode = eMode;
-              eMBState = STATE_DISABLED;
+              pxInst->eMBCurrentMode = eMode;
             }
         }
     }
 
+  if (eStatus != MB_ENOERR)
+    {
+      vMBPortClose(pxInst);
+    }
+
   return eStatus;
 }
 
 #ifdef CONFIG_MB_TCP_ENABLED
-eMBErrorCode eMBTCPInit(uint16_t ucTCPPort)
+static eMBErrorCode prveMBTCPInit(xMBInstance *pxInst, uint16_t ucTCPPort)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
-  if ((eStatus = eMBTCPDoInit(ucTCPPort)) != MB_ENOERR)
+  /* Requests are executed by the porting layer as they arrive on the
+   * client connections (see eMBTCPExecute()), the event queue and the
+   * frame receive and send functions are not used.
+   */
+
+  if ((eStatus = eMBTCPDoInit(pxInst, ucTCPPort)) != MB_ENOERR)
     {
-      eMBState = STATE_DISABLED;
+      /* Nothing to release */
     }
-  else if (!xMBPortEventInit())
+  else if (!xMBPortEventInit(pxInst))
     {
       /* Port dependent event module initialization failed. */
 
+      vMBTCPPortClose(pxInst);
       eStatus = MB_EPORTERR;
     }
   else
     {
-      pvMBFrameStartCur = eMBTCPStart;
-      pvMBFrameStopCur = eMBTCPStop;
-      peMBFrameReceiveCur = eMBTCPReceive;
-      peMBFrameSendCur = eMBTCPSend;
-#ifdef CONFIG_MB_HAVE_CLOSE
-      pvMBFrameCloseCur = vMBTCPPortClose;
-#else
-      pvMBFrameCloseCur = NULL;
-#endif
-      ucMBAddress = MB_TCP_PSEUDO_ADDRESS;
-      eMBCurrentMode = MB_TCP;
-      eMBState = STATE_DISABLED;
+      pxInst->pvMBFrameStartCur = eMBTCPStart;
+      pxInst->pvMBFrameStopCur = eMBTCPStop;
+      pxInst->peMBFrameReceiveCur = NULL;
+      pxInst->peMBFrameSendCur = NULL;
+      pxInst->pvMBFrameCloseCur = vMBTCPPortClose;
+      pxInst->ucMBAddress = MB_TCP_PSEUDO_ADDRESS;
+      pxInst->eMBCurrentMode = MB_TCP;
     }
 
   return eStatus;
 }
 #endif
 
-eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler)
+static void prvvMBHandleEvent(xMBInstance *pxInst, eMBEventType eEvent)
 {
-  eMBErrorCode  eStatus;
-  int           i;
+  eMBErrorCode eStatus;
 
-  if ((0 < ucFunctionCode) && (ucFunctionCode <= 127))
+  switch (eEvent)
     {
-      ENTER_CRITICAL_SECTION();
-      if (pxHandler != NULL)
+    case EV_READY:
+      break;
+
+    case EV_FRAME_RECEIVED:
+      eStatus = pxInst->peMBFrameReceiveCur(pxInst, &pxInst->ucRcvAddress,
+                                            &pxInst->pucMBFrame,
+                                            &pxInst->usLength);
+      if (eStatus == MB_ENOERR)
         {
-          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+          /* Check if the frame is for us. If not ignore the frame. */
+
+          if ((pxInst->ucRcvAddress == pxInst->ucMBAddress) ||
+              (pxInst->ucRcvAddress == MB_ADDRESS_BROADCAST))
             {
-              if ((xFuncHandlers[i].pxHandler == NULL) ||
-                  (xFuncHandlers[i].pxHandler == pxHandler))
-                {
-                  xFuncHandlers[i].ucFunctionCode = ucFunctionCode;
-                  xFuncHandlers[i].pxHandler = pxHandler;
-                  break;
-                }
+              xMBPortEventPost(pxInst, EV_EXECUTE);
             }
-          eStatus = (i != CONFIG_MB_FUNC_HANDLERS_MAX) ? MB_ENOERR : MB_ENORES;
         }
-      else
+        break;
+
+    case EV_EXECUTE:
+      eMBFrameExecute(pxInst->pucMBFrame, &pxInst->usLength);
+
+      /* If the request was not sent to the broadcast address we
+       * return a reply.
+       */
+
+      if (pxInst->ucRcvAddress != MB_ADDRESS_BROADCAST)
         {
-          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+#ifdef CONFIG_MB_ASCII_ENABLED
+          if ((pxInst->eMBCurrentMode == MB_ASCII) &&
+              CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS)
             {
-              if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
-                {
-                  xFuncHandlers[i].ucFunctionCode = 0;
-                  xFuncHandlers[i].pxHandler = NULL;
-                  break;
-                }
+              vMBPortTimersDelay(CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS);
             }
+#endif
+          pxInst->peMBFrameSendCur(pxInst, pxInst->ucMBAddress,
+                                   pxInst->pucMBFrame, pxInst->usLength);
+        }
+        break;
 
-          /* Remove can't fail. */
+    case EV_FRAME_SENT:
+        break;
+    }
+}
 
-          eStatus = MB_ENOERR;
+static void prvvMBHandleEvents(xMBInstance *pxInst)
+{
+  eMBEventType eEvent;
+
+  while (pxInst->eMBState == STATE_ENABLED &&
+         xMBPortEventGet(pxInst, &eEvent))
+    {
+      prvvMBHandleEvent(pxInst, eEvent);
+    }
+}
+
+/* Wait for and handle the events of a set of instances with one poll() */
+
+static eMBErrorCode prveMBPollInstances(xMBInstance **ppxInst, int iNInst,
+                                        int iTimeoutMs)
+{
+  struct pollfd axFds[CONFIG_MB_INSTANCES * MB_PORT_POLL_FDS];
+  int           aiNFds[CONFIG_MB_INSTANCES];
+  eMBErrorCode  eStatus = MB_ENOERR;
+  int           iNFds = 0;
+  int           i;
+
+  for (i = 0; i < iNInst; i++)
+    {
+      aiNFds[i] = iMBPollSetup(ppxInst[i], &axFds[iNFds],
+                               CONFIG_MB_INSTANCES * MB_PORT_POLL_FDS -
+                               iNFds, &iTimeoutMs);
+      iNFds += aiNFds[i];
+    }
+
+  if (poll(axFds, iNFds, iTimeoutMs) < 0)
+    {
+      if (errno != EINTR)
+        {
+          vMBPortLog(MB_LOG_ERROR, "POLL", "poll failed: %d\n", errno);
+          return MB_EIO;
         }
 
-      EXIT_CRITICAL_SECTION();
+      /* Interrupted, only the timers are checked */
+
+      for (i = 0; i < iNFds; i++)
+        {
+          axFds[i].revents = 0;
+        }
     }
-  else
+
+  for (i = 0, iNFds = 0; i < iNInst; i++)
     {
-      eStatus = MB_EINVAL;
+      if (eMBPollDispatch(ppxInst[i], &axFds[iNFds], aiNFds[i]) ==
+          MB_EIO)
+        {
+          eStatus = MB_EIO;
+        }
+
+      iNFds += aiNFds[i];
     }
 
   return eStatus;
 }
 
-eMBErrorCode eMBClose(void)
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+eMBException eMBFrameExecute(uint8_t *pucFrame, uint16_t *pusLength)
 {
-  eMBErrorCode eStatus = MB_ENOERR;
+  uint8_t      ucFunctionCode;
+  eMBException eException;
+  int          i;
 
-  if (eMBState == STATE_DISABLED)
+  ucFunctionCode = pucFrame[MB_PDU_FUNC_OFF];
+  eException = MB_EX_ILLEGAL_FUNCTION;
+  for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
     {
-      if (pvMBFrameCloseCur != NULL)
+      /* No more function handlers registered. Abort. */
+
+      if (xFuncHandlers[i].ucFunctionCode == 0)
         {
-          pvMBFrameCloseCur();
+          break;
+        }
+      else if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
+        {
+          eException = xFuncHandlers[i].pxHandler(pucFrame, pusLength);
+          break;
         }
     }
-  else
+
+  if (eException != MB_EX_NONE)
     {
-      eStatus = MB_EILLSTATE;
+      /* An exception occurred. Build an error frame. */
+
+      *pusLength = 0;
+      pucFrame[(*pusLength)++] = (uint8_t)(ucFunctionCode | MB_FUNC_ERROR);
+      pucFrame[(*pusLength)++] = eException;
     }
 
-  return eStatus;
+  return eException;
 }
 
-eMBErrorCode eMBEnable(void)
+eMBErrorCode eMBInstanceInit(xMBHandle *pxHandle, eMBMode eMode,
+                             uint8_t ucSlaveAddress, uint8_t ucPort,
+                             speed_t ulBaudRate, eMBParity eParity)
 {
-  eMBErrorCode eStatus = MB_ENOERR;
+  xMBInstance *pxInst;
+  eMBErrorCode eStatus;
 
-  if (eMBState == STATE_DISABLED)
+  pxInst = prvpxMBAlloc();
+  if (pxInst == NULL)
     {
-      /* Activate the protocol stack. */
+      return MB_ENORES;
+    }
 
-      pvMBFrameStartCur();
-      eMBState = STATE_ENABLED;
+  eStatus = prveMBSerialInit(pxInst, eMode, ucSlaveAddress, ucPort,
+                             ulBaudRate, eParity);
+  if (eStatus != MB_ENOERR)
+    {
+      prvvMBFree(pxInst);
+      return eStatus;
     }
-  else
+
+  *pxHandle = pxInst;
+  return MB_ENOERR;
+}
+
+#ifdef CONFIG_MB_TCP_ENABLED
+eMBErrorCode eMBInstanceTCPInit(xMBHandle *pxHandle, uint16_t usTCPPort)
+{
+  xMBInstance *pxInst;
+  eMBErrorCode eStatus;
+
+  pxInst = prvpxMBAlloc();
+  if (pxInst == NULL)
     {
-      eStatus = MB_EILLSTATE;
+      return MB_ENORES;
     }
 
-  return eStatus;
+  eStatus = prveMBTCPInit(pxInst, usTCPPort);
+  if (eStatus != MB_ENOERR)
+    {
+      prvvMBFree(pxInst);
+      return eStatus;
+    }
+
+  *pxHandle = pxInst;
+  return MB_ENOERR;
 }
+#endif
 
-eMBErrorCode eMBDisable(void)
+eMBErrorCode eMBInstanceClose(xMBHandle xHandle)
 {
-  eMBErrorCode  eStatus;
+  if (xHandle == NULL || xHandle->eMBState != STATE_DISABLED)
+    {
+      return MB_EILLSTATE;
+    }
 
-  if (eMBState == STATE_ENABLED)
+  if (xHandle->pvMBFrameCloseCur != NULL)
     {
-      pvMBFrameStopCur();
-      eMBState = STATE_DISABLED;
-      eStatus = MB_ENOERR;
+      xHandle->pvMBFrameCloseCur(xHandle);
     }
-  else if (eMBState == STATE_DISABLED)
+
+  prvvMBFree(xHandle);
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBInstanceEnable(xMBHandle xHandle)
+{
+  if (xHandle == NULL || xHandle->eMBState != STATE_DISABLED)
     {
-      eStatus = MB_ENOERR;
+      return MB_EILLSTATE;
     }
-  else
+
+  /* Activate the protocol stack. */
+
+  xHandle->pvMBFrameStartCur(xHandle);
+  xHandle->eMBState = STATE_ENABLED;
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBInstanceDisable(xMBHandle xHandle)
+{
+  if (xHandle == NULL || xHandle->eMBState == STATE_NOT_INITIALIZED)
     {
-      eStatus = MB_EILLSTATE;
+      return MB_EILLSTATE;
     }
 
-  return eStatus;
+  if (xHandle->eMBState == STATE_ENABLED)
+    {
+      xHandle->pvMBFrameStopCur(xHandle);
+      xHandle->eMBState = STATE_DISABLED;
+    }
+
+  return MB_ENOERR;
 }
 
-eMBErrorCode eMBPoll(void)
+int iMBPollSetup(xMBHandle xHandle, struct pollfd *pxFds, int iNFds,
+                 int *piTimeoutMs)
 {
-  static uint8_t     *ucMBFrame;
-  static uint8_t      ucRcvAddress;
-  static uint8_t      ucFunctionCode;
-  static uint16_t     usLength;
-  static eMBException eException;
+  if (xHandle == NULL || xHandle->eMBState != STATE_ENABLED)
+    {
+      return 0;
+    }
 
-  int             i;
-  eMBErrorCode    eStatus = MB_ENOERR;
-  eMBEventType    eEvent;
+#ifdef CONFIG_MB_TCP_ENABLED
+  if (xHandle->eMBCurrentMode == MB_TCP)
+    {
+      return iMBTCPPortPollSetup(xHandle, pxFds, iNFds, piTimeoutMs);
+    }
+#endif
 
-  /* Check if the protocol stack is ready. */
+  return iMBPortPollSetup(xHandle, pxFds, iNFds, piTimeoutMs);
+}
 
-  if (eMBState != STATE_ENABLED)
+eMBErrorCode eMBPollDispatch(xMBHandle xHandle, struct pollfd *pxFds,
+                             int iNFds)
+{
+  eMBErrorCode eStatus = MB_ENOERR;
+
+  if (xHandle == NULL || xHandle->eMBState != STATE_ENABLED)
     {
       return MB_EILLSTATE;
     }
 
-  /* Check if there is a event available. If not return control to caller.
-   * Otherwise we will handle the event.
+  /* Events left over by eMBInstanceEnable() come first, then the ones
+   * raised by the received characters, the transmitter and the timer.
    */
 
-  if (xMBPortEventGet(&eEvent) == true)
+  prvvMBHandleEvents(xHandle);
+
+#ifdef CONFIG_MB_TCP_ENABLED
+  if (xHandle->eMBCurrentMode == MB_TCP)
+    {
+      /* Requests are executed while the connections are served */
+
+      return xMBTCPPortPollDispatch(xHandle, pxFds, iNFds) ? MB_ENOERR :
+                                                             MB_EIO;
+    }
+#endif
+
+  if (!xMBPortPollDispatch(xHandle, pxFds, iNFds))
     {
-      switch (eEvent)
+      eStatus = MB_EIO;
+    }
+
+  prvvMBHandleEvents(xHandle);
+  return eStatus;
+}
+
+eMBErrorCode eMBPollAll(int iTimeoutMs)
+{
+  xMBInstance *apxInst[CONFIG_MB_INSTANCES];
+  int          iNInst = 0;
+  int          i;
+
+  for (i = 0; i < CONFIG_MB_INSTANCES; i++)
+    {
+      if (xMBInstances[i].eMBState == STATE_ENABLED)
         {
-        case EV_READY:
-          break;
+          apxInst[iNInst++] = &xMBInstances[i];
+        }
+    }
 
-        case EV_FRAME_RECEIVED:
-          eStatus = peMBFrameReceiveCur(&ucRcvAddress, &ucMBFrame, &usLength);
-          if (eStatus == MB_ENOERR)
-            {
-              /* Check if the frame is for us. If not ignore the frame. */
+  if (iNInst == 0)
+    {
+      return MB_EILLSTATE;
+    }
 
-              if ((ucRcvAddress == ucMBAddress) || (ucRcvAddress == MB_ADDRESS_BROADCAST))
-                {
-                  xMBPortEventPost(EV_EXECUTE);
-                }
-            }
-            break;
+  return prveMBPollInstances(apxInst, iNInst, iTimeoutMs);
+}
 
-        case EV_EXECUTE:
-          ucFunctionCode = ucMBFrame[MB_PDU_FUNC_OFF];
-          eException = MB_EX_ILLEGAL_FUNCTION;
-          for( i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
-            {
-              /* No more function handlers registered. Abort. */
+eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
+                     speed_t ulBaudRate, eMBParity eParity)
+{
+  eMBErrorCode eStatus;
+
+  if (pxMBDefault != NULL)
+    {
+      eMBInstanceDisable(pxMBDefault);
+      eMBInstanceClose(pxMBDefault);
+      pxMBDefault = NULL;
+    }
+
+  eStatus = eMBInstanceInit(&pxMBDefault, eMode, ucSlaveAddress, ucPort,
+                            ulBaudRate, eParity);
+  if (eStatus != MB_ENOERR)
+    {
+      pxMBDefault = NULL;
+    }
+
+  return eStatus;
+}
+
+#ifdef CONFIG_MB_TCP_ENABLED
+eMBErrorCode eMBTCPInit(uint16_t ucTCPPort)
+{
+  eMBErrorCode eStatus;
 
-              if (xFuncHandlers[i].ucFunctionCode == 0)
+  if (pxMBDefault != NULL)
+    {
+      eMBInstanceDisable(pxMBDefault);
+      eMBInstanceClose(pxMBDefault);
+      pxMBDefault = NULL;
+    }
+
+  eStatus = eMBInstanceTCPInit(&pxMBDefault, ucTCPPort);
+  if (eStatus != MB_ENOERR)
+    {
+      pxMBDefault = NULL;
+    }
+
+  return eStatus;
+}
+#endif
+
+eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler)
+{
+  eMBErrorCode  eStatus;
+  int           i;
+
+  if ((0 < ucFunctionCode) && (ucFunctionCode <= 127))
+    {
+      ENTER_CRITICAL_SECTION();
+      if (pxHandler != NULL)
+        {
+          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+            {
+              if ((xFuncHandlers[i].pxHandler == NULL) ||
+                  (xFuncHandlers[i].pxHandler == pxHandler))
                 {
+                  xFuncHandlers[i].ucFunctionCode = ucFunctionCode;
+                  xFuncHandlers[i].pxHandler = pxHandler;
                   break;
                 }
-              else if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
+            }
+          eStatus = (i != CONFIG_MB_FUNC_HANDLERS_MAX) ? MB_ENOERR : MB_ENORES;
+        }
+      else
+        {
+          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+            {
+              if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
                 {
-                  eException = xFuncHandlers[i].pxHandler(ucMBFrame, &usLength);
+                  xFuncHandlers[i].ucFunctionCode = 0;
+                  xFuncHandlers[i].pxHandler = NULL;
                   break;
                 }
             }
 
-          /* If the request was not sent to the broadcast address we
-           * return a reply.
-           */
+          /* Remove can't fail. */
 
-          if (ucRcvAddress != MB_ADDRESS_BROADCAST)
-            {
-              if (eException != MB_EX_NONE)
-                {
-                  /* An exception occurred. Build an error frame. */
+          eStatus = MB_ENOERR;
+        }
 
-                  usLength = 0;
-                  ucMBFrame[usLength++] = (uint8_t)(ucFunctionCode | MB_FUNC_ERROR);
-                  ucMBFrame[usLength++] = eException;
-                }
+      EXIT_CRITICAL_SECTION();
+    }
+  else
+    {
+      eStatus = MB_EINVAL;
+    }
 
-#ifdef CONFIG_MB_ASCII_ENABLED
-              if ((eMBCurrentMode == MB_ASCII) && CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS)
-                {
-                  vMBPortTimersDelay(CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS);
-                }
-#endif
-              peMBFrameSendCur(ucMBAddress, ucMBFrame, usLength);
-            }
-            break;
+  return eStatus;
+}
 
-        case EV_FRAME_SENT:
-            break;
-        }
+eMBErrorCode eMBClose(void)
+{
+  eMBErrorCode eStatus;
+
+  eStatus = eMBInstanceClose(pxMBDefault);
+  if (eStatus == MB_ENOERR)
+    {
+      pxMBDefault = NULL;
+    }
+
+  return eStatus;
+}
+
+eMBErrorCode eMBEnable(void)
+{
+  return eMBInstanceEnable(pxMBDefault);
+}
+
+eMBErrorCode eMBDisable(void)
+{
+  return eMBInstanceDisable(pxMBDefault);
+}
+
+eMBErrorCode eMBPoll(void)
+{
+  /* Check if the protocol stack is ready. */
+
+  if (pxMBDefault == NULL || pxMBDefault->eMBState != STATE_ENABLED)
+    {
+      return MB_EILLSTATE;
     }
 
+  /* Wait until a character is received, the transmitter is ready or the
+   * frame timer expires (at most CONFIG_MB_POLL_TIMEOUT_MS) and handle the
+   * resulting events.  Port errors are logged and retried.
+   */
+
+  prveMBPollInstances(&pxMBDefault, 1, CONFIG_MB_POLL_TIMEOUT_MS);
   return MB_ENOERR;
 }
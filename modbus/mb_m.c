@@ -86,11 +86,11 @@ static enum
  * Using for Modbus Master,Add by Armink 20130813
  */
 
-static peMBFrameSend peMBMasterFrameSendCur;
-static pvMBFrameStart pvMBMasterFrameStartCur;
-static pvMBFrameStop pvMBMasterFrameStopCur;
-static peMBFrameReceive peMBMasterFrameReceiveCur;
-static pvMBFrameClose pvMBMasterFrameCloseCur;
+static peMBMasterFrameSend peMBMasterFrameSendCur;
+static pvMBMasterFrameStart pvMBMasterFrameStartCur;
+static pvMBMasterFrameStop pvMBMasterFrameStopCur;
+static peMBMasterFrameReceive peMBMasterFrameReceiveCur;
+static pvMBMasterFrameClose pvMBMasterFrameCloseCur;
 
 /* Callback functions required by the porting layer. They are called when
  * an external event has happened which includes a timeout or the reception
@@ -388,7 +388,6 @@ eMBErrorCode eMBMasterPoll(void)
           else
             {
               vMBMasterCBRequestSuccess();
-              vMBMasterRunResRelease();
             }
           break;
 
@@ -426,8 +425,6 @@ eMBErrorCode eMBMasterPoll(void)
                                               usMBMasterGetPDUSndLength());
               break;
             }
-
-          vMBMasterRunResRelease();
           break;
 
           case EV_MASTER_PROCESS_SUCCESS:
@@ -442,6 +439,58 @@ eMBErrorCode eMBMasterPoll(void)
   return MB_ENOERR;
 }
 
+eMBErrorCode eMBMasterRegisterCB(uint8_t ucFunctionCode,
+                                 pxMBFunctionHandler pxHandler)
+{
+  eMBErrorCode eStatus;
+  int          i;
+
+  if ((0 < ucFunctionCode) && (ucFunctionCode <= 127))
+    {
+      ENTER_CRITICAL_SECTION();
+      if (pxHandler != NULL)
+        {
+          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+            {
+              if ((xMasterFuncHandlers[i].pxHandler == NULL) ||
+                  (xMasterFuncHandlers[i].pxHandler == pxHandler))
+                {
+                  xMasterFuncHandlers[i].ucFunctionCode = ucFunctionCode;
+                  xMasterFuncHandlers[i].pxHandler = pxHandler;
+                  break;
+                }
+            }
+
+          eStatus = (i != CONFIG_MB_FUNC_HANDLERS_MAX) ? MB_ENOERR :
+                                                         MB_ENORES;
+        }
+      else
+        {
+          for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+            {
+              if (xMasterFuncHandlers[i].ucFunctionCode == ucFunctionCode)
+                {
+                  xMasterFuncHandlers[i].ucFunctionCode = 0;
+                  xMasterFuncHandlers[i].pxHandler = NULL;
+                  break;
+                }
+            }
+
+          /* Remove can't fail. */
+
+          eStatus = MB_ENOERR;
+        }
+
+      EXIT_CRITICAL_SECTION();
+    }
+  else
+    {
+      eStatus = MB_EINVAL;
+    }
+
+  return eStatus;
+}
+
 /* Get whether the Modbus Master is run in master mode.*/
 
 bool xMBMasterGetCBRunInMasterMode(void)
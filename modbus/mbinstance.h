@@ -0,0 +1,130 @@
+/****************************************************************************
+ * apps/modbus/mbinstance.h
+ *
+ * FreeModbus Library: A portable Modbus implementation for Modbus ASCII/RTU.
+ * Copyright (c) 2006 Christian Walter <wolti@sil.at>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_MODBUS_MBINSTANCE_H
+#define __APPS_MODBUS_MBINSTANCE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mbframe.h"
+#include "modbus/mbproto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_INSTANCE_BUF_SIZE    256  /* RTU frame or decoded ASCII frame */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+typedef enum
+{
+  STATE_NOT_INITIALIZED,      /* Free slot of the instance pool. */
+  STATE_DISABLED,
+  STATE_ENABLED
+} eMBInstanceState;
+
+/* Everything a slave protocol stack used to keep in static variables.  The
+ * register callbacks and the function handlers are shared by all
+ * instances.
+ */
+
+struct xMBInstance
+{
+  eMBInstanceState  eMBState;
+  uint8_t           ucMBAddress;
+  eMBMode           eMBCurrentMode;
+
+  /* Transmission layer selected by the mode (RTU, ASCII or TCP) */
+
+  peMBFrameSend     peMBFrameSendCur;
+  pvMBFrameStart    pvMBFrameStartCur;
+  pvMBFrameStop     pvMBFrameStopCur;
+  peMBFrameReceive  peMBFrameReceiveCur;
+  pvMBFrameClose    pvMBFrameCloseCur;
+
+  /* Callbacks required by the porting layer */
+
+  pxMBFrameCB       pxMBFrameCBByteReceived;
+  pxMBFrameCB       pxMBFrameCBTransmitterEmpty;
+  pxMBFrameCB       pxMBPortCBTimerExpired;
+
+  /* Frame being processed by eMBPoll() */
+
+  uint8_t          *pucMBFrame;
+  uint8_t           ucRcvAddress;
+  uint16_t          usLength;
+
+  /* RTU or ASCII framing, the states are private to the layer */
+
+  volatile uint8_t  eSndState;
+  volatile uint8_t  eRcvState;
+  volatile uint8_t  eBytePos;
+  volatile uint8_t  ucMBLFCharacter;
+  volatile uint8_t *pucSndBufferCur;
+  volatile uint16_t usSndBufferCount;
+  volatile uint16_t usRcvBufferPos;
+  volatile uint8_t  ucSerBuf[MB_INSTANCE_BUF_SIZE];
+
+  xMBPortInstance   xPort;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* Run the function handler of the request PDU in pucFrame and replace it by
+ * the response or an exception response.  Used by the transports which
+ * process requests outside the instance event queue (Modbus TCP).
+ */
+
+eMBException eMBFrameExecute(uint8_t *pucFrame, uint16_t *pusLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_MODBUS_MBINSTANCE_H */
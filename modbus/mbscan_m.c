@@ -0,0 +1,650 @@
+/****************************************************************************
+ * apps/modbus/mbscan_m.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mb_m.h"
+#include "modbus/mbframe.h"
+#include "modbus/mbproto.h"
+#include "modbus/mbport.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_PDU_REQ_READ_ADDR_OFF        (MB_PDU_DATA_OFF + 0)
+#define MB_PDU_REQ_READ_CNT_OFF         (MB_PDU_DATA_OFF + 2)
+#define MB_PDU_REQ_READ_SIZE            (4)
+#define MB_PDU_FUNC_READ_BYTECNT_OFF    (MB_PDU_DATA_OFF + 0)
+#define MB_PDU_FUNC_READ_VALUES_OFF     (MB_PDU_DATA_OFF + 1)
+
+/* Largest read of one request, limited by the PDU size */
+
+#define MB_SCAN_REGCNT_MAX              (0x007D)
+#define MB_SCAN_BITCNT_MAX              (0x07D0)
+
+#ifndef CONFIG_MB_MASTER_SCAN_MAX_GAP
+#  define CONFIG_MB_MASTER_SCAN_MAX_GAP 0
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One coalesced read: the points pusMBScanOrder[usFirst] ..
+ * pusMBScanOrder[usFirst + usNPoints - 1] of one slave and table, read
+ * with a single request every ulPeriodMs (the shortest period of them).
+ */
+
+typedef struct
+{
+  uint8_t         ucSlave;
+  uint8_t         ucFunctionCode;
+  uint16_t        usAddress;
+  uint16_t        usCount;
+  uint16_t        usFirst;
+  uint16_t        usNPoints;
+  uint32_t        ulPeriodMs;
+  struct timespec xDeadline;
+} xMBMasterScanBlock;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const xMBMasterScanPoint *pxMBScanPoints;
+static uint16_t                  usMBScanNPoints;
+static uint16_t                 *pusMBScanOrder;
+static xMBMasterScanValue       *pxMBScanValues;
+static xMBMasterScanBlock       *pxMBScanBlocks;
+static uint16_t                  usMBScanNBlocks;
+static uint32_t                  ulMBScanRequests;
+static uint32_t                  ulMBScanErrors;
+
+/* Block whose request is on the bus, the responses of other requests are
+ * passed on to the standard function handlers.
+ */
+
+static xMBMasterScanBlock       *pxMBScanActive;
+static pthread_mutex_t           xMBScanLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Held by eMBMasterScanPoll() for a whole read, so that the scan list can
+ * not be set up or freed under it.  xMBScanLock can not be used: it is
+ * taken by the response handler while the read is waited for.
+ */
+
+static pthread_mutex_t           xMBScanPollLock =
+                                   PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint8_t prvucMBScanFunctionCode(eMBMasterScanTable eTable)
+{
+  switch (eTable)
+    {
+    case MB_SCAN_COILS:
+      return MB_FUNC_READ_COILS;
+    case MB_SCAN_DISCRETE_INPUTS:
+      return MB_FUNC_READ_DISCRETE_INPUTS;
+    case MB_SCAN_HOLDING_REGISTERS:
+      return MB_FUNC_READ_HOLDING_REGISTER;
+    case MB_SCAN_INPUT_REGISTERS:
+      return MB_FUNC_READ_INPUT_REGISTER;
+    default:
+      return 0;
+    }
+}
+
+static int prviMBScanCompare(const void *pvA, const void *pvB)
+{
+  const xMBMasterScanPoint *pxA = &pxMBScanPoints[*(const uint16_t *)pvA];
+  const xMBMasterScanPoint *pxB = &pxMBScanPoints[*(const uint16_t *)pvB];
+
+  if (pxA->ucSlave != pxB->ucSlave)
+    {
+      return pxA->ucSlave - pxB->ucSlave;
+    }
+
+  if (pxA->eTable != pxB->eTable)
+    {
+      return pxA->eTable - pxB->eTable;
+    }
+
+  return pxA->usAddress - pxB->usAddress;
+}
+
+static void prvvMBScanAddMs(struct timespec *pxTime, uint32_t ulMs)
+{
+  pxTime->tv_sec += ulMs / 1000;
+  pxTime->tv_nsec += (ulMs % 1000) * 1000000;
+  if (pxTime->tv_nsec >= 1000000000)
+    {
+      pxTime->tv_sec++;
+      pxTime->tv_nsec -= 1000000000;
+    }
+}
+
+static bool prvxMBScanBefore(const struct timespec *pxA,
+                             const struct timespec *pxB)
+{
+  return pxA->tv_sec < pxB->tv_sec ||
+         (pxA->tv_sec == pxB->tv_sec && pxA->tv_nsec < pxB->tv_nsec);
+}
+
+/* Sort the points by slave, table and address and merge neighbours into
+ * the longest reads a request can carry.  Points up to
+ * CONFIG_MB_MASTER_SCAN_MAX_GAP addresses apart are merged too: reading a
+ * few unused registers costs less than another transaction.
+ */
+
+static uint16_t prvusMBScanBuildBlocks(void)
+{
+  const xMBMasterScanPoint *pxPoint;
+  xMBMasterScanBlock       *pxBlock = NULL;
+  uint16_t                  usNBlocks = 0;
+  uint16_t                  usMax;
+  uint32_t                  ulEnd;
+  int                       i;
+
+  for (i = 0; i < usMBScanNPoints; i++)
+    {
+      pusMBScanOrder[i] = i;
+    }
+
+  qsort(pusMBScanOrder, usMBScanNPoints, sizeof(uint16_t),
+        prviMBScanCompare);
+
+  for (i = 0; i < usMBScanNPoints; i++)
+    {
+      pxPoint = &pxMBScanPoints[pusMBScanOrder[i]];
+      usMax = pxPoint->eTable == MB_SCAN_COILS ||
+              pxPoint->eTable == MB_SCAN_DISCRETE_INPUTS ?
+              MB_SCAN_BITCNT_MAX : MB_SCAN_REGCNT_MAX;
+
+      if (pxBlock != NULL &&
+          pxBlock->ucSlave == pxPoint->ucSlave &&
+          pxBlock->ucFunctionCode ==
+            prvucMBScanFunctionCode(pxPoint->eTable) &&
+          (uint32_t)pxPoint->usAddress <= (uint32_t)pxBlock->usAddress +
+            pxBlock->usCount + CONFIG_MB_MASTER_SCAN_MAX_GAP &&
+          pxPoint->usAddress - pxBlock->usAddress < usMax)
+        {
+          ulEnd = pxPoint->usAddress + 1;
+          if (ulEnd > (uint32_t)pxBlock->usAddress + pxBlock->usCount)
+            {
+              pxBlock->usCount = ulEnd - pxBlock->usAddress;
+            }
+
+          if (pxPoint->ulPeriodMs < pxBlock->ulPeriodMs)
+            {
+              pxBlock->ulPeriodMs = pxPoint->ulPeriodMs;
+            }
+
+          pxBlock->usNPoints++;
+          continue;
+        }
+
+      pxBlock = &pxMBScanBlocks[usNBlocks++];
+      pxBlock->ucSlave = pxPoint->ucSlave;
+      pxBlock->ucFunctionCode = prvucMBScanFunctionCode(pxPoint->eTable);
+      pxBlock->usAddress = pxPoint->usAddress;
+      pxBlock->usCount = 1;
+      pxBlock->usFirst = i;
+      pxBlock->usNPoints = 1;
+      pxBlock->ulPeriodMs = pxPoint->ulPeriodMs;
+    }
+
+  return usNBlocks;
+}
+
+/* Store the values of a response to the active block.  Called by the
+ * thread running eMBMasterPoll() with xMBScanLock held.
+ */
+
+static eMBException prveMBScanStore(xMBMasterScanBlock *pxBlock,
+                                    const uint8_t *pucFrame,
+                                    uint16_t usLen)
+{
+  const xMBMasterScanPoint *pxPoint;
+  xMBMasterScanValue       *pxValue;
+  const uint8_t            *pucValues;
+  struct timespec           xNow;
+  uint16_t                  usByteCount;
+  uint16_t                  usOffset;
+  bool                      bBits;
+  int                       i;
+
+  bBits = pxBlock->ucFunctionCode == MB_FUNC_READ_COILS ||
+          pxBlock->ucFunctionCode == MB_FUNC_READ_DISCRETE_INPUTS;
+  usByteCount = bBits ? (pxBlock->usCount + 7) / 8 : pxBlock->usCount * 2;
+
+  if (usLen != MB_PDU_FUNC_READ_VALUES_OFF + usByteCount ||
+      pucFrame[MB_PDU_FUNC_READ_BYTECNT_OFF] != usByteCount)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  pucValues = &pucFrame[MB_PDU_FUNC_READ_VALUES_OFF];
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+
+  for (i = 0; i < pxBlock->usNPoints; i++)
+    {
+      pxPoint = &pxMBScanPoints[pusMBScanOrder[pxBlock->usFirst + i]];
+      pxValue = &pxMBScanValues[pusMBScanOrder[pxBlock->usFirst + i]];
+      usOffset = pxPoint->usAddress - pxBlock->usAddress;
+
+      if (bBits)
+        {
+          pxValue->usValue = (pucValues[usOffset / 8] >> (usOffset % 8)) & 1;
+        }
+      else
+        {
+          pxValue->usValue = pucValues[2 * usOffset] << 8 |
+                             pucValues[2 * usOffset + 1];
+        }
+
+      pxValue->eStatus = MB_MRE_NO_ERR;
+      pxValue->xTimestamp = xNow;
+    }
+
+  return MB_EX_NONE;
+}
+
+static pxMBFunctionHandler prvpxMBScanStandardHandler(uint8_t ucFunctionCode)
+{
+  switch (ucFunctionCode)
+    {
+#ifdef CONFIG_MB_MASTER_FUNC_READ_COILS_ENABLED
+    case MB_FUNC_READ_COILS:
+      return eMBMasterFuncReadCoils;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_DISCRETE_INPUTS_ENABLED
+    case MB_FUNC_READ_DISCRETE_INPUTS:
+      return eMBMasterFuncReadDiscreteInputs;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_HOLDING_ENABLED
+    case MB_FUNC_READ_HOLDING_REGISTER:
+      return eMBMasterFuncReadHoldingRegister;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_INPUT_ENABLED
+    case MB_FUNC_READ_INPUT_REGISTER:
+      return eMBMasterFuncReadInputRegister;
+#endif
+    default:
+      return NULL;
+    }
+}
+
+/* Function handler for the read functions while the scan list is active.
+ * It must not block: it runs in the thread calling eMBMasterPoll().
+ */
+
+static eMBException prveMBScanFuncRead(uint8_t *pucFrame, uint16_t *pusLen)
+{
+  xMBMasterScanBlock *pxBlock;
+  pxMBFunctionHandler pxHandler;
+  eMBException        eException;
+
+  pthread_mutex_lock(&xMBScanLock);
+  pxBlock = pxMBScanActive;
+
+  if (pxBlock != NULL &&
+      pxBlock->ucSlave == ucMBMasterGetDestAddress() &&
+      pxBlock->ucFunctionCode == pucFrame[MB_PDU_FUNC_OFF])
+    {
+      /* The response is consumed here, the bus may be handed to another
+       * requester before the scan thread is scheduled again.
+       */
+
+      eException = prveMBScanStore(pxBlock, pucFrame, *pusLen);
+      pxMBScanActive = NULL;
+      pthread_mutex_unlock(&xMBScanLock);
+      return eException;
+    }
+
+  pthread_mutex_unlock(&xMBScanLock);
+
+  /* A request of the application (eMBMasterReqRead...()) */
+
+  pxHandler = prvpxMBScanStandardHandler(pucFrame[MB_PDU_FUNC_OFF]);
+  return pxHandler != NULL ? pxHandler(pucFrame, pusLen) :
+                             MB_EX_ILLEGAL_FUNCTION;
+}
+
+/* eMBMasterRegisterCB() keeps one function code per handler */
+
+static eMBException prveMBScanFuncReadCoils(uint8_t *pucFrame,
+                                            uint16_t *pusLen)
+{
+  return prveMBScanFuncRead(pucFrame, pusLen);
+}
+
+static eMBException prveMBScanFuncReadDiscrete(uint8_t *pucFrame,
+                                               uint16_t *pusLen)
+{
+  return prveMBScanFuncRead(pucFrame, pusLen);
+}
+
+static eMBException prveMBScanFuncReadHolding(uint8_t *pucFrame,
+                                              uint16_t *pusLen)
+{
+  return prveMBScanFuncRead(pucFrame, pusLen);
+}
+
+static eMBException prveMBScanFuncReadInput(uint8_t *pucFrame,
+                                            uint16_t *pusLen)
+{
+  return prveMBScanFuncRead(pucFrame, pusLen);
+}
+
+/* Install (or remove) the scan list handlers of the four read functions.
+ * The old handler is removed first, the new one takes its slot.
+ */
+
+static eMBErrorCode prveMBScanHook(bool bInstall)
+{
+  static const xMBFunctionHandler axHandlers[] =
+  {
+    {MB_FUNC_READ_COILS, prveMBScanFuncReadCoils},
+    {MB_FUNC_READ_DISCRETE_INPUTS, prveMBScanFuncReadDiscrete},
+    {MB_FUNC_READ_HOLDING_REGISTER, prveMBScanFuncReadHolding},
+    {MB_FUNC_READ_INPUT_REGISTER, prveMBScanFuncReadInput}
+  };
+
+  pxMBFunctionHandler pxHandler;
+  uint8_t             ucFunctionCode;
+  eMBErrorCode        eStatus = MB_ENOERR;
+  int                 i;
+
+  for (i = 0; i < sizeof(axHandlers) / sizeof(axHandlers[0]); i++)
+    {
+      ucFunctionCode = axHandlers[i].ucFunctionCode;
+      pxHandler = bInstall ? axHandlers[i].pxHandler :
+                  prvpxMBScanStandardHandler(ucFunctionCode);
+
+      eMBMasterRegisterCB(ucFunctionCode, NULL);
+      if (pxHandler != NULL &&
+          eMBMasterRegisterCB(ucFunctionCode, pxHandler) != MB_ENOERR)
+        {
+          eStatus = MB_ENORES;
+        }
+    }
+
+  return eStatus;
+}
+
+/* Send the read request of a block and wait for its completion */
+
+static eMBMasterReqErrCode prveMBScanRequest(xMBMasterScanBlock *pxBlock)
+{
+  eMBMasterReqErrCode eErrStatus;
+  uint8_t            *pucMBFrame;
+  int                 i;
+
+  if (xMBMasterRunResTake(-1) == false)
+    {
+      return MB_MRE_MASTER_BUSY;
+    }
+
+  pthread_mutex_lock(&xMBScanLock);
+  pxMBScanActive = pxBlock;
+  pthread_mutex_unlock(&xMBScanLock);
+
+  vMBMasterGetPDUSndBuf(&pucMBFrame);
+  vMBMasterSetDestAddress(pxBlock->ucSlave);
+  pucMBFrame[MB_PDU_FUNC_OFF] = pxBlock->ucFunctionCode;
+  pucMBFrame[MB_PDU_REQ_READ_ADDR_OFF] = pxBlock->usAddress >> 8;
+  pucMBFrame[MB_PDU_REQ_READ_ADDR_OFF + 1] = pxBlock->usAddress;
+  pucMBFrame[MB_PDU_REQ_READ_CNT_OFF] = pxBlock->usCount >> 8;
+  pucMBFrame[MB_PDU_REQ_READ_CNT_OFF + 1] = pxBlock->usCount;
+  vMBMasterSetPDUSndLength(MB_PDU_SIZE_MIN + MB_PDU_REQ_READ_SIZE);
+  xMBMasterPortEventPost(EV_MASTER_FRAME_SENT);
+  eErrStatus = eMBMasterWaitRequestFinish();
+
+  pthread_mutex_lock(&xMBScanLock);
+  pxMBScanActive = NULL;
+  ulMBScanRequests++;
+
+  if (eErrStatus != MB_MRE_NO_ERR)
+    {
+      /* Keep the last values, their timestamps tell how old they are */
+
+      ulMBScanErrors++;
+      for (i = 0; i < pxBlock->usNPoints; i++)
+        {
+          pxMBScanValues[pusMBScanOrder[pxBlock->usFirst + i]].eStatus =
+            eErrStatus;
+        }
+    }
+
+  pthread_mutex_unlock(&xMBScanLock);
+  return eErrStatus;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+eMBErrorCode eMBMasterScanInit(const xMBMasterScanPoint *pxPoints,
+                               uint16_t usNPoints)
+{
+  struct timespec xNow;
+  eMBErrorCode    eStatus;
+  int             i;
+
+  if (pxPoints == NULL || usNPoints == 0)
+    {
+      return MB_EINVAL;
+    }
+
+  for (i = 0; i < usNPoints; i++)
+    {
+      if (pxPoints[i].ucSlave == MB_ADDRESS_BROADCAST ||
+          pxPoints[i].ucSlave > CONFIG_MB_MASTER_TOTAL_SLAVE_NUM ||
+          prvucMBScanFunctionCode(pxPoints[i].eTable) == 0 ||
+          pxPoints[i].ulPeriodMs == 0)
+        {
+          return MB_EINVAL;
+        }
+    }
+
+  pthread_mutex_lock(&xMBScanPollLock);
+
+  if (pxMBScanPoints != NULL)
+    {
+      pthread_mutex_unlock(&xMBScanPollLock);
+      return MB_EILLSTATE;
+    }
+
+  pusMBScanOrder = malloc(usNPoints * sizeof(uint16_t));
+  pxMBScanValues = calloc(usNPoints, sizeof(xMBMasterScanValue));
+  pxMBScanBlocks = malloc(usNPoints * sizeof(xMBMasterScanBlock));
+
+  if (pusMBScanOrder == NULL || pxMBScanValues == NULL ||
+      pxMBScanBlocks == NULL)
+    {
+      eStatus = MB_ENORES;
+      goto errout;
+    }
+
+  for (i = 0; i < usNPoints; i++)
+    {
+      pxMBScanValues[i].eStatus = MB_MRE_TIMEDOUT;
+    }
+
+  pxMBScanPoints = pxPoints;
+  usMBScanNPoints = usNPoints;
+  usMBScanNBlocks = prvusMBScanBuildBlocks();
+  ulMBScanRequests = 0;
+  ulMBScanErrors = 0;
+
+  /* Everything is due now */
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  for (i = 0; i < usMBScanNBlocks; i++)
+    {
+      pxMBScanBlocks[i].xDeadline = xNow;
+    }
+
+  eStatus = prveMBScanHook(true);
+  if (eStatus == MB_ENOERR)
+    {
+      pthread_mutex_unlock(&xMBScanPollLock);
+      return MB_ENOERR;
+    }
+
+  prveMBScanHook(false);
+  pxMBScanPoints = NULL;
+
+errout:
+  free(pusMBScanOrder);
+  free(pxMBScanValues);
+  free(pxMBScanBlocks);
+  pusMBScanOrder = NULL;
+  pxMBScanValues = NULL;
+  pxMBScanBlocks = NULL;
+  pthread_mutex_unlock(&xMBScanPollLock);
+  return eStatus;
+}
+
+eMBErrorCode eMBMasterScanClose(void)
+{
+  /* Wait for a read in progress in eMBMasterScanPoll() */
+
+  pthread_mutex_lock(&xMBScanPollLock);
+
+  if (pxMBScanPoints == NULL)
+    {
+      pthread_mutex_unlock(&xMBScanPollLock);
+      return MB_EILLSTATE;
+    }
+
+  prveMBScanHook(false);
+
+  pthread_mutex_lock(&xMBScanLock);
+  free(pusMBScanOrder);
+  free(pxMBScanValues);
+  free(pxMBScanBlocks);
+  pusMBScanOrder = NULL;
+  pxMBScanValues = NULL;
+  pxMBScanBlocks = NULL;
+  pxMBScanPoints = NULL;
+  usMBScanNPoints = 0;
+  usMBScanNBlocks = 0;
+  pthread_mutex_unlock(&xMBScanLock);
+
+  pthread_mutex_unlock(&xMBScanPollLock);
+  return MB_ENOERR;
+}
+
+eMBMasterReqErrCode eMBMasterScanPoll(void)
+{
+  xMBMasterScanBlock *pxBlock;
+  eMBMasterReqErrCode eErrStatus;
+  struct timespec     xNow;
+  int                 i;
+
+  pthread_mutex_lock(&xMBScanPollLock);
+
+  if (pxMBScanPoints == NULL)
+    {
+      pthread_mutex_unlock(&xMBScanPollLock);
+      return MB_MRE_ILL_ARG;
+    }
+
+  /* Earliest deadline first, whatever slave it belongs to */
+
+  pxBlock = &pxMBScanBlocks[0];
+  for (i = 1; i < usMBScanNBlocks; i++)
+    {
+      if (prvxMBScanBefore(&pxMBScanBlocks[i].xDeadline,
+                           &pxBlock->xDeadline))
+        {
+          pxBlock = &pxMBScanBlocks[i];
+        }
+    }
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                         &pxBlock->xDeadline, NULL) == EINTR);
+
+  eErrStatus = prveMBScanRequest(pxBlock);
+
+  /* Next deadline one period later.  A block which fell behind (slow or
+   * absent slave) skips the missed periods instead of hogging the bus.
+   */
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  prvvMBScanAddMs(&pxBlock->xDeadline, pxBlock->ulPeriodMs);
+  if (prvxMBScanBefore(&pxBlock->xDeadline, &xNow))
+    {
+      pxBlock->xDeadline = xNow;
+      prvvMBScanAddMs(&pxBlock->xDeadline, pxBlock->ulPeriodMs);
+    }
+
+  pthread_mutex_unlock(&xMBScanPollLock);
+  return eErrStatus;
+}
+
+eMBErrorCode eMBMasterScanGet(uint16_t usPoint, xMBMasterScanValue *pxValue)
+{
+  eMBErrorCode eStatus = MB_ENOERR;
+
+  pthread_mutex_lock(&xMBScanLock);
+
+  if (pxMBScanPoints == NULL)
+    {
+      eStatus = MB_EILLSTATE;
+    }
+  else if (usPoint >= usMBScanNPoints)
+    {
+      eStatus = MB_EINVAL;
+    }
+  else
+    {
+      *pxValue = pxMBScanValues[usPoint];
+    }
+
+  pthread_mutex_unlock(&xMBScanLock);
+  return eStatus;
+}
+
+void vMBMasterScanGetStats(uint16_t *pusBlocks, uint32_t *pulRequests,
+                           uint32_t *pulErrors)
+{
+  pthread_mutex_lock(&xMBScanLock);
+  *pusBlocks = usMBScanNBlocks;
+  *pulRequests = ulMBScanRequests;
+  *pulErrors = ulMBScanErrors;
+  pthread_mutex_unlock(&xMBScanLock);
+}
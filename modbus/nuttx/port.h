@@ -36,9 +36,14 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <assert.h>
+#include <termios.h>
+#include <time.h>
+
+#include "modbus/mbport.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -62,6 +67,24 @@ extern "C"
 #  define false  false
 #endif
 
+#ifdef CONFIG_MB_ASCII_ENABLED
+#  define MB_PORT_SERIAL_BUF_SIZE 513 /* must hold a complete ASCII frame. */
+#else
+#  define MB_PORT_SERIAL_BUF_SIZE 256 /* must hold a complete RTU frame. */
+#endif
+
+#define MB_PORT_EVENT_QUEUE_SIZE  4   /* Events pending per instance. */
+
+/* struct pollfd used per instance: the serial line, or the listening
+ * socket and the client connections of a Modbus TCP instance.
+ */
+
+#ifdef CONFIG_MB_TCP_ENABLED
+#  define MB_PORT_POLL_FDS        (1 + CONFIG_MB_TCP_CONNECTIONS)
+#else
+#  define MB_PORT_POLL_FDS        1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -74,6 +97,41 @@ typedef enum
   MB_LOG_DEBUG = 3
 } eMBPortLogLevel;
 
+/* Port state of one slave instance (see modbus/mbinstance.h). */
+
+typedef struct
+{
+  /* Serial line */
+
+  int             iSerialFd;
+  bool            bRxEnabled;
+  bool            bTxEnabled;
+  uint8_t         ucBuffer[MB_PORT_SERIAL_BUF_SIZE];
+  int             uiRxBufferPos;
+  int             uiTxBufferPos;
+  struct termios  xOldTIO;
+
+  /* Inter-frame timer, expires at xTimeExpire */
+
+  uint32_t        ulTimeOutUs;
+  bool            bTimeoutEnable;
+  struct timespec xTimeExpire;
+
+  /* Event queue */
+
+  eMBEventType    eQueuedEvents[MB_PORT_EVENT_QUEUE_SIZE];
+  uint8_t         ucEventHead;
+  uint8_t         ucEventCount;
+
+#ifdef CONFIG_MB_TCP_ENABLED
+  /* Modbus TCP, the client connections are kept in a pool shared by all
+   * instances (see porttcp.c).
+   */
+
+  int             iListenFd;
+#endif
+} xMBPortInstance;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -82,9 +140,9 @@ void vMBPortEnterCritical(void);
 void vMBPortExitCritical(void);
 void vMBPortLog(eMBPortLogLevel eLevel, const char *szModule,
                 const char *szFmt, ...) printf_like(3, 4);
-void vMBPortTimerPoll(void);
-bool xMBPortSerialPoll(void);
-bool xMBPortSerialSetTimeout(uint32_t dwTimeoutMs);
+void vMBPortInstanceInit(xMBInstance *pxInst);
+int  iMBPortTimerRemaining(xMBInstance *pxInst);
+void vMBPortTimerPoll(xMBInstance *pxInst);
 
 #if defined(CONFIG_MB_RTU_MASTER) || defined(CONFIG_MB_ASCII_MASTER)
   void vMBMasterPortEnterCritical(void);
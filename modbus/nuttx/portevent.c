@@ -33,60 +33,58 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
 #include "port.h"
-
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static eMBEventType eQueuedEvent;
-static bool xEventInQueue;
+#include "mbinstance.h"
 
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-bool xMBPortEventInit(void)
-{
-  xEventInQueue = false;
-  return true;
-}
-
-bool xMBPortEventPost(eMBEventType eEvent)
+bool xMBPortEventInit(xMBInstance *pxInst)
 {
-  xEventInQueue = true;
-  eQueuedEvent = eEvent;
+  pxInst->xPort.ucEventHead = 0;
+  pxInst->xPort.ucEventCount = 0;
   return true;
 }
 
-bool xMBPortEventGet(eMBEventType * eEvent)
+bool xMBPortEventPost(xMBInstance *pxInst, eMBEventType eEvent)
 {
-  bool xEventHappened = false;
+  xMBPortInstance *pxPort = &pxInst->xPort;
 
-  if (xEventInQueue)
+  if (pxPort->ucEventCount >= MB_PORT_EVENT_QUEUE_SIZE)
     {
-      *eEvent = eQueuedEvent;
-      xEventInQueue = false;
-      xEventHappened = true;
+      vMBPortLog(MB_LOG_WARN, "EVENT", "queue overflow, event %d lost\n",
+                 eEvent);
+      return false;
     }
-  else
-    {
-      /* Poll the serial device. The serial device timeouts if no
-       * characters have been received within for t3.5 during an
-       * active transmission or if nothing happens within a specified
-       * amount of time. Both timeouts are configured from the timer
-       * init functions.
-       */
 
-      xMBPortSerialPoll();
+  pxPort->eQueuedEvents[(pxPort->ucEventHead + pxPort->ucEventCount) %
+                        MB_PORT_EVENT_QUEUE_SIZE] = eEvent;
+  pxPort->ucEventCount++;
+  return true;
+}
+
+/* Events are only produced by the instance itself while it is dispatched
+ * (see xMBPortPollDispatch()), so this never has to wait.
+ */
 
-      /* Check if any of the timers have expired. */
+bool xMBPortEventGet(xMBInstance *pxInst, eMBEventType *eEvent)
+{
+  xMBPortInstance *pxPort = &pxInst->xPort;
 
-      vMBPortTimerPoll();
+  if (pxPort->ucEventCount == 0)
+    {
+      return false;
     }
 
-  return xEventHappened;
+  *eEvent = pxPort->eQueuedEvents[pxPort->ucEventHead];
+  pxPort->ucEventHead = (pxPort->ucEventHead + 1) %
+                        MB_PORT_EVENT_QUEUE_SIZE;
+  pxPort->ucEventCount--;
+  return true;
 }
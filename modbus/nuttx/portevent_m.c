@@ -276,7 +276,9 @@ void vMBMasterCBRequestSuccess(void)
 }
 
 /* This function will wait for Modbus Master request finish
- * and return result.
+ * and return result.  The running resource is released only after the
+ * result has been collected, so that concurrent requesters cannot pick up
+ * the completion of each other.
  */
 
 eMBMasterReqErrCode eMBMasterWaitRequestFinish(void)
@@ -309,6 +311,7 @@ eMBMasterReqErrCode eMBMasterWaitRequestFinish(void)
       eQueuedEvent &= ~WAITER_EVENTS;
     }
 
+  vMBMasterRunResRelease();
   return eErrStatus;
 }
 
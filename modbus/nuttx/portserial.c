@@ -40,105 +40,31 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
-#include <sys/time.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <assert.h>
 #include <termios.h>
 
 #include "port.h"
+#include "mbinstance.h"
 
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
-/****************************************************************************
- * Pre-processor Definitions
- ****************************************************************************/
-
-#ifdef CONFIG_MB_ASCII_ENABLED
-#define BUF_SIZE    513         /* must hold a complete ASCII frame. */
-#else
-#define BUF_SIZE    256         /* must hold a complete RTU frame. */
-#endif
-
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static int      iSerialFd = -1;
-static bool     bRxEnabled;
-static bool     bTxEnabled;
-
-static uint32_t ulTimeoutMs;
-static uint8_t  ucBuffer[BUF_SIZE];
-static int      uiRxBufferPos;
-static int      uiTxBufferPos;
-
-static struct termios xOldTIO;
-
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
 
-static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead);
-static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
+static bool prvbMBPortSerialWrite(xMBPortInstance *pxPort,
+                                  uint8_t *pucBuffer, uint16_t usNBytes);
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead)
-{
-  bool            bResult = true;
-  ssize_t         res;
-  fd_set          rfds;
-  struct timeval  tv;
-
-  tv.tv_sec = 0;
-  tv.tv_usec = 50000;
-  FD_ZERO(&rfds);
-  FD_SET(iSerialFd, &rfds);
-
-  /* Wait until character received or timeout. Recover in case of an
-   * interrupted read system call.
-   */
-
-  do
-    {
-      if (select(iSerialFd + 1, &rfds, NULL, NULL, &tv) == -1)
-        {
-          if (errno != EINTR)
-            {
-              bResult = false;
-            }
-        }
-      else if (FD_ISSET(iSerialFd, &rfds))
-        {
-          if ((res = read(iSerialFd, pucBuffer, usNBytes)) == -1)
-            {
-              bResult = false;
-            }
-          else
-            {
-              *usNBytesRead = (uint16_t)res;
-              break;
-            }
-        }
-      else
-        {
-          *usNBytesRead = 0;
-          break;
-        }
-    }
-
-  while (bResult == true);
-  return bResult;
-}
-
-static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
+static bool prvbMBPortSerialWrite(xMBPortInstance *pxPort,
+                                  uint8_t *pucBuffer, uint16_t usNBytes)
 {
   ssize_t res;
   size_t  left = (size_t) usNBytes;
@@ -146,7 +72,7 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
 
   while (left > 0)
     {
-      if ((res = write(iSerialFd, pucBuffer + done, left)) == -1)
+      if ((res = write(pxPort->iSerialFd, pucBuffer + done, left)) == -1)
         {
           if (errno != EINTR)
             {
@@ -169,54 +95,73 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
  * Public Functions
  ****************************************************************************/
 
-void vMBPortSerialEnable(bool bEnableRx, bool bEnableTx)
+void vMBPortInstanceInit(xMBInstance *pxInst)
 {
+  pxInst->xPort.iSerialFd = -1;
+  pxInst->xPort.bRxEnabled = false;
+  pxInst->xPort.bTxEnabled = false;
+  pxInst->xPort.bTimeoutEnable = false;
+  pxInst->xPort.ucEventHead = 0;
+  pxInst->xPort.ucEventCount = 0;
+#ifdef CONFIG_MB_TCP_ENABLED
+  pxInst->xPort.iListenFd = -1;
+#endif
+}
+
+void vMBPortSerialEnable(xMBInstance *pxInst, bool bEnableRx,
+                         bool bEnableTx)
+{
+  xMBPortInstance *pxPort = &pxInst->xPort;
+
   /* it is not allowed that both receiver and transmitter are enabled. */
 
   DEBUGASSERT(!bEnableRx || !bEnableTx);
 
   if (bEnableRx)
     {
-      tcflush(iSerialFd, TCIFLUSH);
-      uiRxBufferPos = 0;
-      bRxEnabled = true;
+      tcflush(pxPort->iSerialFd, TCIFLUSH);
+      pxPort->uiRxBufferPos = 0;
+      pxPort->bRxEnabled = true;
     }
   else
     {
-      bRxEnabled = false;
+      pxPort->bRxEnabled = false;
     }
 
   if (bEnableTx)
     {
-      bTxEnabled = true;
-      uiTxBufferPos = 0;
+      pxPort->bTxEnabled = true;
+      pxPort->uiTxBufferPos = 0;
     }
   else
     {
-      bTxEnabled = false;
+      pxPort->bTxEnabled = false;
     }
 }
 
-bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
-                       uint8_t ucDataBits, eMBParity eParity)
+bool xMBPortSerialInit(xMBInstance *pxInst, uint8_t ucPort,
+                       speed_t ulBaudRate, uint8_t ucDataBits,
+                       eMBParity eParity)
 {
+  xMBPortInstance *pxPort = &pxInst->xPort;
   char szDevice[16];
   bool bStatus = true;
   struct termios xNewTIO;
 
   snprintf(szDevice, 16, "/dev/ttyS%d", ucPort);
 
-  if ((iSerialFd = open(szDevice, O_RDWR | O_NOCTTY)) < 0)
+  if ((pxPort->iSerialFd = open(szDevice, O_RDWR | O_NOCTTY)) < 0)
     {
       vMBPortLog(MB_LOG_ERROR, "SER-INIT", "Can't open serial port %s: %d\n",
                  szDevice, errno);
       bStatus = false;
     }
-  else if (tcgetattr(iSerialFd, &xOldTIO) != 0)
+  else if (tcgetattr(pxPort->iSerialFd, &pxPort->xOldTIO) != 0)
     {
       vMBPortLog(MB_LOG_ERROR,
                  "SER-INIT", "Can't get settings from port %s: %d\n",
                  szDevice, errno);
+      bStatus = false;
     }
   else
     {
@@ -270,100 +215,152 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
            *     might not be
            */
 
-          if (cfsetispeed(&xNewTIO, ulBaudRate) != 0 /* || cfsetospeed(&xNewTIO, ulBaudRate) != 0 */)
+          if (cfsetispeed(&xNewTIO, ulBaudRate) != 0)
             {
               vMBPortLog(MB_LOG_ERROR, "SER-INIT",
                          "Can't set baud rate %ld for port %s: %d\n",
-                         ulBaudRate, szDevice, errno);
+                         (long)ulBaudRate, szDevice, errno);
+              bStatus = false;
             }
-          else if (tcsetattr(iSerialFd, TCSANOW, &xNewTIO) != 0)
+          else if (tcsetattr(pxPort->iSerialFd, TCSANOW, &xNewTIO) != 0)
             {
               vMBPortLog(MB_LOG_ERROR,
                          "SER-INIT", "Can't set settings for port %s: %d\n",
                          szDevice, errno);
+              bStatus = false;
             }
           else
             {
-              vMBPortSerialEnable(false, false);
+              vMBPortSerialEnable(pxInst, false, false);
               bStatus = true;
             }
         }
     }
 
+  if (!bStatus && pxPort->iSerialFd >= 0)
+    {
+      close(pxPort->iSerialFd);
+      pxPort->iSerialFd = -1;
+    }
+
   return bStatus;
 }
 
-bool xMBPortSerialSetTimeout(uint32_t ulNewTimeoutMs)
+void vMBPortClose(xMBInstance *pxInst)
 {
-  if (ulNewTimeoutMs > 0)
+  xMBPortInstance *pxPort = &pxInst->xPort;
+
+  if (pxPort->iSerialFd != -1)
     {
-      ulTimeoutMs = ulNewTimeoutMs;
+      tcsetattr(pxPort->iSerialFd, TCSANOW, &pxPort->xOldTIO);
+      close(pxPort->iSerialFd);
+      pxPort->iSerialFd = -1;
     }
-  else
+}
+
+int iMBPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds, int iNFds,
+                     int *piTimeoutMs)
+{
+  xMBPortInstance *pxPort = &pxInst->xPort;
+  int iRemain;
+
+  if (iNFds < 1)
     {
-      ulTimeoutMs = 1;
+      return 0;
     }
 
-  return true;
-}
+  /* The receiver waits for characters, the transmitter for room in the
+   * driver.  Nothing is polled while the instance is stopped.
+   */
 
-void vMBPortClose(void)
-{
-  if (iSerialFd != -1)
+  pxFds[0].fd = pxPort->iSerialFd;
+  pxFds[0].events = 0;
+  pxFds[0].revents = 0;
+
+  if (pxPort->bRxEnabled)
+    {
+      pxFds[0].events |= POLLIN;
+    }
+
+  if (pxPort->bTxEnabled)
     {
-      tcsetattr(iSerialFd, TCSANOW, &xOldTIO);
-      close(iSerialFd);
-      iSerialFd = -1;
+      pxFds[0].events |= POLLOUT;
     }
+
+  if (pxFds[0].events == 0)
+    {
+      pxFds[0].fd = -1;
+    }
+
+  /* Wake up when the t3.5 (RTU) or character (ASCII) timer expires.
+   * poll() rounds this up to the next system tick.
+   */
+
+  iRemain = iMBPortTimerRemaining(pxInst);
+  if (iRemain >= 0 && (*piTimeoutMs < 0 || iRemain < *piTimeoutMs))
+    {
+      *piTimeoutMs = iRemain;
+    }
+
+  return 1;
 }
 
-bool xMBPortSerialPoll(void)
+bool xMBPortPollDispatch(xMBInstance *pxInst, struct pollfd *pxFds,
+                         int iNFds)
 {
+  xMBPortInstance *pxPort = &pxInst->xPort;
   bool     bStatus = true;
-  uint16_t usBytesRead;
+  short    revents = 0;
+  ssize_t  res;
   int      i;
 
-  while (bRxEnabled)
+  if (iNFds >= 1 && pxFds[0].fd >= 0 &&
+      pxFds[0].fd == pxPort->iSerialFd)
     {
-      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
-        {
-          if (usBytesRead == 0)
-            {
-              /* timeout with no bytes. */
+      revents = pxFds[0].revents;
+    }
 
-              break;
-            }
-          else if (usBytesRead > 0)
+  if ((revents & (POLLIN | POLLERR | POLLHUP)) != 0 && pxPort->bRxEnabled)
+    {
+      res = read(pxPort->iSerialFd, pxPort->ucBuffer,
+                 MB_PORT_SERIAL_BUF_SIZE);
+      if (res < 0)
+        {
+          if (errno != EINTR && errno != EAGAIN)
             {
-              for (i = 0; i < usBytesRead; i++)
-                {
-                  /* Call the modbus stack and let him fill the buffers. */
-
-                  pxMBFrameCBByteReceived();
-                }
-
-              uiRxBufferPos = 0;
+              vMBPortLog(MB_LOG_ERROR,
+                         "SER-POLL", "read failed on serial device: %d\n",
+                         errno);
+              bStatus = false;
             }
         }
       else
         {
-          vMBPortLog(MB_LOG_ERROR,
-                     "SER-POLL", "read failed on serial device: %d\n",
-                     errno);
-          bStatus = false;
+          /* Call the modbus stack and let him fill the buffers. Each
+           * character restarts the inter-frame timer.
+           */
+
+          pxPort->uiRxBufferPos = 0;
+          for (i = 0; i < res && pxPort->bRxEnabled; i++)
+            {
+              pxInst->pxMBFrameCBByteReceived(pxInst);
+            }
+
+          pxPort->uiRxBufferPos = 0;
         }
     }
 
-  if (bTxEnabled)
+  if ((revents & POLLOUT) != 0 && pxPort->bTxEnabled)
     {
-      while (bTxEnabled)
+      while (pxPort->bTxEnabled)
         {
-          pxMBFrameCBTransmitterEmpty();
-
           /* Call the modbus stack to let him fill the buffer. */
+
+          pxInst->pxMBFrameCBTransmitterEmpty(pxInst);
         }
 
-      if (!prvbMBPortSerialWrite(&ucBuffer[0], uiTxBufferPos))
+      if (!prvbMBPortSerialWrite(pxPort, &pxPort->ucBuffer[0],
+                                 pxPort->uiTxBufferPos))
         {
           vMBPortLog(MB_LOG_ERROR,
                      "SER-POLL", "write failed on serial device: %d\n",
@@ -372,21 +369,29 @@ bool xMBPortSerialPoll(void)
         }
     }
 
+  /* Check if the timer has expired. */
+
+  vMBPortTimerPoll(pxInst);
+
   return bStatus;
 }
 
-bool xMBPortSerialPutByte(int8_t ucByte)
+bool xMBPortSerialPutByte(xMBInstance *pxInst, int8_t ucByte)
 {
-  DEBUGASSERT(uiTxBufferPos < BUF_SIZE);
-  ucBuffer[uiTxBufferPos] = ucByte;
-  uiTxBufferPos++;
+  xMBPortInstance *pxPort = &pxInst->xPort;
+
+  DEBUGASSERT(pxPort->uiTxBufferPos < MB_PORT_SERIAL_BUF_SIZE);
+  pxPort->ucBuffer[pxPort->uiTxBufferPos] = ucByte;
+  pxPort->uiTxBufferPos++;
   return true;
 }
 
-bool xMBPortSerialGetByte(int8_t *pucByte)
+bool xMBPortSerialGetByte(xMBInstance *pxInst, int8_t *pucByte)
 {
-  DEBUGASSERT(uiRxBufferPos < BUF_SIZE);
-  *pucByte = ucBuffer[uiRxBufferPos];
-  uiRxBufferPos++;
+  xMBPortInstance *pxPort = &pxInst->xPort;
+
+  DEBUGASSERT(pxPort->uiRxBufferPos < MB_PORT_SERIAL_BUF_SIZE);
+  *pucByte = pxPort->ucBuffer[pxPort->uiRxBufferPos];
+  pxPort->uiRxBufferPos++;
   return true;
 }
@@ -0,0 +1,446 @@
+/****************************************************************************
+ * apps/modbus/nuttx/porttcp.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "port.h"
+#include "mbinstance.h"
+
+#include "modbus/mb.h"
+#include "modbus/mbframe.h"
+#include "modbus/mbport.h"
+
+#include "mbtcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_TCP_DEFAULT_PORT   502
+#define MB_TCP_BUF_SIZE       (CONFIG_MB_TCP_PIPELINE_DEPTH * \
+                               MB_TCP_ADU_SIZE_MAX)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One client connection.  Requests are collected in ucRxBuf until they are
+ * complete and the responses are queued in ucTxBuf in request order, each
+ * one carrying the transaction identifier of its request.  A client which
+ * does not read its responses stops being read when ucTxBuf can not take
+ * another one, the other clients are not affected.
+ */
+
+typedef struct
+{
+  xMBInstance    *pxOwner;          /* NULL if the slot is free */
+  int             iFd;
+  time_t          xLastActivity;    /* CLOCK_MONOTONIC seconds */
+  uint16_t        usLastTID;        /* Last transaction identifier seen */
+  uint16_t        usRxLen;
+  uint16_t        usTxLen;
+  uint8_t         ucRxBuf[MB_TCP_BUF_SIZE];
+  uint8_t         ucTxBuf[MB_TCP_BUF_SIZE];
+} xMBTCPConn;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static xMBTCPConn xMBTCPConns[CONFIG_MB_TCP_CONNECTIONS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static time_t prvxMBTCPNow(void)
+{
+  struct timespec xNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  return xNow.tv_sec;
+}
+
+static void prvvMBTCPConnClose(xMBTCPConn *pxConn)
+{
+  vMBPortLog(MB_LOG_DEBUG, "MBTCP", "client %d closed, last TID %u\n",
+             pxConn->iFd, pxConn->usLastTID);
+
+  close(pxConn->iFd);
+  pxConn->iFd = -1;
+  pxConn->pxOwner = NULL;
+}
+
+/* Find a slot for a new client of pxInst.  If all slots are in use, the
+ * least recently active client of the same instance is dropped: a master
+ * which reconnects after a network failure must not be locked out by its
+ * own half-open connection.
+ */
+
+static xMBTCPConn *prvpxMBTCPConnAlloc(xMBInstance *pxInst)
+{
+  xMBTCPConn *pxOldest = NULL;
+  int         i;
+
+  for (i = 0; i < CONFIG_MB_TCP_CONNECTIONS; i++)
+    {
+      if (xMBTCPConns[i].pxOwner == NULL)
+        {
+          return &xMBTCPConns[i];
+        }
+
+      if (xMBTCPConns[i].pxOwner == pxInst &&
+          (pxOldest == NULL ||
+           xMBTCPConns[i].xLastActivity < pxOldest->xLastActivity))
+        {
+          pxOldest = &xMBTCPConns[i];
+        }
+    }
+
+  if (pxOldest != NULL)
+    {
+      vMBPortLog(MB_LOG_WARN, "MBTCP", "dropping idle client %d\n",
+                 pxOldest->iFd);
+      prvvMBTCPConnClose(pxOldest);
+    }
+
+  return pxOldest;
+}
+
+static void prvvMBTCPAccept(xMBInstance *pxInst)
+{
+  xMBTCPConn *pxConn;
+  int         iFd;
+
+  iFd = accept(pxInst->xPort.iListenFd, NULL, NULL);
+  if (iFd < 0)
+    {
+      if (errno != EINTR && errno != EAGAIN)
+        {
+          vMBPortLog(MB_LOG_ERROR, "MBTCP", "accept failed: %d\n", errno);
+        }
+
+      return;
+    }
+
+  pxConn = prvpxMBTCPConnAlloc(pxInst);
+  if (pxConn == NULL ||
+      fcntl(iFd, F_SETFL, fcntl(iFd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+      vMBPortLog(MB_LOG_WARN, "MBTCP", "client rejected\n");
+      close(iFd);
+      return;
+    }
+
+  pxConn->pxOwner = pxInst;
+  pxConn->iFd = iFd;
+  pxConn->xLastActivity = prvxMBTCPNow();
+  pxConn->usLastTID = 0;
+  pxConn->usRxLen = 0;
+  pxConn->usTxLen = 0;
+
+  vMBPortLog(MB_LOG_DEBUG, "MBTCP", "client %d connected\n", iFd);
+}
+
+/* Execute all complete requests in the receive buffer for which the
+ * transmit buffer has room.  Returns false on a framing error.
+ */
+
+static bool prvbMBTCPProcess(xMBTCPConn *pxConn)
+{
+  uint16_t usLength;
+  uint16_t usRspLength;
+
+  while (pxConn->usRxLen >= MB_TCP_FUNC)
+    {
+      /* The length field counts the unit identifier and the PDU */
+
+      usLength = pxConn->ucRxBuf[MB_TCP_LEN] << 8U;
+      usLength |= pxConn->ucRxBuf[MB_TCP_LEN + 1];
+
+      if (usLength < 1 + MB_PDU_SIZE_MIN || usLength > 1 + MB_PDU_SIZE_MAX)
+        {
+          vMBPortLog(MB_LOG_WARN, "MBTCP", "client %d: bad length %u\n",
+                     pxConn->iFd, usLength);
+          return false;
+        }
+
+      usLength += MB_TCP_UID;
+      if (pxConn->usRxLen < usLength ||
+          MB_TCP_BUF_SIZE - pxConn->usTxLen < MB_TCP_ADU_SIZE_MAX)
+        {
+          break;
+        }
+
+      pxConn->usLastTID = pxConn->ucRxBuf[MB_TCP_TID] << 8U;
+      pxConn->usLastTID |= pxConn->ucRxBuf[MB_TCP_TID + 1];
+
+      if (eMBTCPExecute(pxConn->ucRxBuf, usLength,
+                        &pxConn->ucTxBuf[pxConn->usTxLen],
+                        &usRspLength) == MB_ENOERR)
+        {
+          pxConn->usTxLen += usRspLength;
+        }
+
+      pxConn->usRxLen -= usLength;
+      memmove(pxConn->ucRxBuf, &pxConn->ucRxBuf[usLength], pxConn->usRxLen);
+    }
+
+  return true;
+}
+
+static bool prvbMBTCPReceive(xMBTCPConn *pxConn)
+{
+  ssize_t res;
+
+  res = recv(pxConn->iFd, &pxConn->ucRxBuf[pxConn->usRxLen],
+             MB_TCP_BUF_SIZE - pxConn->usRxLen, 0);
+  if (res < 0)
+    {
+      return errno == EINTR || errno == EAGAIN;
+    }
+  else if (res == 0)
+    {
+      return false;
+    }
+
+  pxConn->usRxLen += res;
+  pxConn->xLastActivity = prvxMBTCPNow();
+  return true;
+}
+
+/* Send as much of the queued responses as the socket takes */
+
+static bool prvbMBTCPSend(xMBTCPConn *pxConn)
+{
+  ssize_t res;
+
+  if (pxConn->usTxLen == 0)
+    {
+      return true;
+    }
+
+  res = send(pxConn->iFd, pxConn->ucTxBuf, pxConn->usTxLen, 0);
+  if (res < 0)
+    {
+      return errno == EINTR || errno == EAGAIN;
+    }
+
+  pxConn->usTxLen -= res;
+  memmove(pxConn->ucTxBuf, &pxConn->ucTxBuf[res], pxConn->usTxLen);
+  return true;
+}
+
+static void prvvMBTCPDispatchConn(xMBTCPConn *pxConn, short revents)
+{
+  bool bOk = true;
+
+  if ((revents & POLLOUT) != 0)
+    {
+      bOk = prvbMBTCPSend(pxConn);
+    }
+
+  if (bOk && (revents & (POLLIN | POLLERR | POLLHUP)) != 0)
+    {
+      bOk = prvbMBTCPReceive(pxConn);
+    }
+
+  /* Execute what has arrived (or was held back by a full transmit buffer)
+   * and try to answer right away, the rest goes out with POLLOUT.
+   */
+
+  if (bOk)
+    {
+      bOk = prvbMBTCPProcess(pxConn) && prvbMBTCPSend(pxConn);
+    }
+
+  if (!bOk)
+    {
+      prvvMBTCPConnClose(pxConn);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool xMBTCPPortInit(xMBInstance *pxInst, uint16_t usTCPPort)
+{
+  struct sockaddr_in xAddr;
+  int                iOn = 1;
+  int                iFd;
+
+  if (usTCPPort == MB_TCP_PORT_USE_DEFAULT)
+    {
+      usTCPPort = MB_TCP_DEFAULT_PORT;
+    }
+
+  iFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (iFd < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP", "socket failed: %d\n", errno);
+      return false;
+    }
+
+  setsockopt(iFd, SOL_SOCKET, SO_REUSEADDR, &iOn, sizeof(iOn));
+
+  memset(&xAddr, 0, sizeof(xAddr));
+  xAddr.sin_family = AF_INET;
+  xAddr.sin_port = htons(usTCPPort);
+  xAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(iFd, (struct sockaddr *)&xAddr, sizeof(xAddr)) < 0 ||
+      listen(iFd, CONFIG_MB_TCP_CONNECTIONS) < 0 ||
+      fcntl(iFd, F_SETFL, fcntl(iFd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP", "can't listen on port %u: %d\n",
+                 usTCPPort, errno);
+      close(iFd);
+      return false;
+    }
+
+  pxInst->xPort.iListenFd = iFd;
+  return true;
+}
+
+void vMBTCPPortDisable(xMBInstance *pxInst)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_CONNECTIONS; i++)
+    {
+      if (xMBTCPConns[i].pxOwner == pxInst)
+        {
+          prvvMBTCPConnClose(&xMBTCPConns[i]);
+        }
+    }
+}
+
+void vMBTCPPortClose(xMBInstance *pxInst)
+{
+  vMBTCPPortDisable(pxInst);
+
+  if (pxInst->xPort.iListenFd >= 0)
+    {
+      close(pxInst->xPort.iListenFd);
+      pxInst->xPort.iListenFd = -1;
+    }
+}
+
+int iMBTCPPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds,
+                        int iNFds, int *piTimeoutMs)
+{
+  xMBTCPConn *pxConn;
+  int         iUsed = 0;
+  int         i;
+
+  if (iNFds < 1)
+    {
+      return 0;
+    }
+
+  pxFds[iUsed].fd = pxInst->xPort.iListenFd;
+  pxFds[iUsed].events = POLLIN;
+  pxFds[iUsed].revents = 0;
+  iUsed++;
+
+  /* The clients in pool order, xMBTCPPortPollDispatch() relies on it */
+
+  for (i = 0; i < CONFIG_MB_TCP_CONNECTIONS && iUsed < iNFds; i++)
+    {
+      pxConn = &xMBTCPConns[i];
+      if (pxConn->pxOwner != pxInst)
+        {
+          continue;
+        }
+
+      pxFds[iUsed].fd = pxConn->iFd;
+      pxFds[iUsed].events = 0;
+      pxFds[iUsed].revents = 0;
+
+      /* Stop reading while a complete request waits for room in the
+       * transmit buffer.
+       */
+
+      if (pxConn->usRxLen < MB_TCP_BUF_SIZE &&
+          MB_TCP_BUF_SIZE - pxConn->usTxLen >= MB_TCP_ADU_SIZE_MAX)
+        {
+          pxFds[iUsed].events |= POLLIN;
+        }
+
+      if (pxConn->usTxLen > 0)
+        {
+          pxFds[iUsed].events |= POLLOUT;
+        }
+
+      iUsed++;
+    }
+
+  return iUsed;
+}
+
+bool xMBTCPPortPollDispatch(xMBInstance *pxInst, struct pollfd *pxFds,
+                            int iNFds)
+{
+  xMBTCPConn *pxConn;
+  int         iNext = 1;
+  int         i;
+
+  if (iNFds < 1 || pxFds[0].fd != pxInst->xPort.iListenFd)
+    {
+      return true;
+    }
+
+  for (i = 0; i < CONFIG_MB_TCP_CONNECTIONS && iNext < iNFds; i++)
+    {
+      pxConn = &xMBTCPConns[i];
+      if (pxConn->pxOwner == pxInst && pxConn->iFd == pxFds[iNext].fd)
+        {
+          if (pxFds[iNext].revents != 0)
+            {
+              prvvMBTCPDispatchConn(pxConn, pxFds[iNext].revents);
+            }
+
+          iNext++;
+        }
+    }
+
+  /* New clients last, they may take the slot of a dispatched one */
+
+  if ((pxFds[0].revents & POLLIN) != 0)
+    {
+      prvvMBTCPAccept(pxInst);
+    }
+
+  return true;
+}
@@ -35,81 +35,107 @@
 
 #include <nuttx/config.h>
 
-#include <sys/time.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
 #include <assert.h>
 
 #include "port.h"
+#include "mbinstance.h"
 
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
-/****************************************************************************
- * Public Data
- ****************************************************************************/
-
-uint32_t ulTimeOut;
-bool     bTimeoutEnable;
-
-static struct timeval xTimeLast;
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-bool xMBPortTimersInit(uint16_t usTim1Timerout50us)
+bool xMBPortTimersInit(xMBInstance *pxInst, uint32_t ulTim1Timerout50us)
 {
-  ulTimeOut = usTim1Timerout50us / 20U;
-  if (ulTimeOut == 0)
+  /* The expiry is kept in microseconds, but it is only noticed when
+   * poll() returns.  The poll() timeout is in milliseconds and expires on
+   * a system tick, so the timer fires up to one tick late (and at least
+   * 1ms after it was started).  At 19200 baud t3.5 is about 1.8ms: with
+   * the default 10ms tick a frame that follows within a tick may not be
+   * seen as a new frame.  Use a shorter CONFIG_USEC_PER_TICK or tickless
+   * mode where the peers send back to back.
+   */
+
+  pxInst->xPort.ulTimeOutUs = ulTim1Timerout50us * 50U;
+  if (pxInst->xPort.ulTimeOutUs == 0)
     {
-      ulTimeOut = 1;
+      pxInst->xPort.ulTimeOutUs = 50;
     }
 
-  return xMBPortSerialSetTimeout(ulTimeOut);
+  pxInst->xPort.bTimeoutEnable = false;
+  return true;
 }
 
-void xMBPortTimersClose(void)
+void xMBPortTimersClose(xMBInstance *pxInst)
 {
   /* Does not use any hardware resources. */
 }
 
-void vMBPortTimerPoll(void)
+/* Return the time in milliseconds (rounded up) until the timer expires,
+ * -1 if it is not running.  This is the poll() timeout, so the timer
+ * resolution is that of the system tick.
+ */
+
+int iMBPortTimerRemaining(xMBInstance *pxInst)
 {
-  uint32_t       ulDeltaMS;
-  struct timeval xTimeCur;
+  struct timespec xTimeCur;
+  int64_t llRemainUs;
 
-  /* Timers are called from the serial layer because we have no high
-   * res timer in Win32.
-   */
+  if (!pxInst->xPort.bTimeoutEnable)
+    {
+      return -1;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &xTimeCur);
+  llRemainUs = (int64_t)(pxInst->xPort.xTimeExpire.tv_sec -
+                         xTimeCur.tv_sec) * 1000000 +
+               (pxInst->xPort.xTimeExpire.tv_nsec - xTimeCur.tv_nsec) /
+               1000;
 
-  if (bTimeoutEnable)
+  if (llRemainUs <= 0)
     {
-      if (gettimeofday(&xTimeCur, NULL) != 0)
-        {
-          /* gettimeofday failed - retry next time. */
-        }
-      else
-        {
-          ulDeltaMS = (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000L +
-                      (xTimeCur.tv_usec - xTimeLast.tv_usec) * 1000L;
-          if (ulDeltaMS > ulTimeOut)
-            {
-              bTimeoutEnable = false;
-              pxMBPortCBTimerExpired();
-            }
-        }
+      return 0;
+    }
+
+  return (int)((llRemainUs + 999) / 1000);
+}
+
+void vMBPortTimerPoll(xMBInstance *pxInst)
+{
+  if (iMBPortTimerRemaining(pxInst) == 0)
+    {
+      pxInst->xPort.bTimeoutEnable = false;
+      pxInst->pxMBPortCBTimerExpired(pxInst);
     }
 }
 
-void vMBPortTimersEnable(void)
+void vMBPortTimersEnable(xMBInstance *pxInst)
 {
-  int res = gettimeofday(&xTimeLast, NULL);
+  xMBPortInstance *pxPort = &pxInst->xPort;
 
-  DEBUGASSERT(res == 0);
-  bTimeoutEnable = true;
+  clock_gettime(CLOCK_MONOTONIC, &pxPort->xTimeExpire);
+  pxPort->xTimeExpire.tv_sec += pxPort->ulTimeOutUs / 1000000;
+  pxPort->xTimeExpire.tv_nsec += (pxPort->ulTimeOutUs % 1000000) * 1000;
+  if (pxPort->xTimeExpire.tv_nsec >= 1000000000)
+    {
+      pxPort->xTimeExpire.tv_sec++;
+      pxPort->xTimeExpire.tv_nsec -= 1000000000;
+    }
+
+  pxPort->bTimeoutEnable = true;
+}
+
+void vMBPortTimersDisable(xMBInstance *pxInst)
+{
+  pxInst->xPort.bTimeoutEnable = false;
 }
 
-void vMBPortTimersDisable(void)
+void vMBPortTimersDelay(uint16_t usTimeOutMS)
 {
-  bTimeoutEnable = false;
+  usleep((useconds_t)usTimeOutMS * 1000);
 }
@@ -44,6 +44,7 @@
 #include "modbus/mbframe.h"
 #include "modbus/mbport.h"
 
+#include "mbinstance.h"
 #include "mbrtu.h"
 #include "mbcrc.h"
 
@@ -75,26 +76,13 @@ typedef enum
   STATE_TX_XMIT                 /* Transmitter is in transfer state. */
 } eMBSndState;
 
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static volatile eMBSndState eSndState;
-static volatile eMBRcvState eRcvState;
-
-volatile uint8_t  ucRTUBuf[MB_SER_PDU_SIZE_MAX];
-
-static volatile uint8_t *pucSndBufferCur;
-static volatile uint16_t usSndBufferCount;
-
-static volatile uint16_t usRcvBufferPos;
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBRTUInit(uint8_t ucSlaveAddress, uint8_t ucPort,
-                        speed_t ulBaudRate, eMBParity eParity)
+eMBErrorCode eMBRTUInit(xMBInstance *pxInst, uint8_t ucSlaveAddress,
+                        uint8_t ucPort, speed_t ulBaudRate,
+                        eMBParity eParity)
 {
   eMBErrorCode eStatus = MB_ENOERR;
   uint32_t usTimerT35_50us;
@@ -103,7 +91,7 @@ eMBErrorCode eMBRTUInit(uint8_t ucSlaveAddress, uint8_t ucPort,
 
   /* Modbus RTU uses 8 Databits. */
 
-  if (xMBPortSerialInit(ucPort, ulBaudRate, 8, eParity) != true)
+  if (xMBPortSerialInit(pxInst, ucPort, ulBaudRate, 8, eParity) != true)
     {
       eStatus = MB_EPORTERR;
     }
@@ -131,7 +119,7 @@ eMBErrorCode eMBRTUInit(uint8_t ucSlaveAddress, uint8_t ucPort,
           usTimerT35_50us = (7UL * 220000UL) / (2UL * ulBaudRate);
         }
 
-      if (xMBPortTimersInit((uint16_t) usTimerT35_50us) != true)
+      if (xMBPortTimersInit(pxInst, usTimerT35_50us) != true)
         {
           eStatus = MB_EPORTERR;
         }
@@ -141,7 +129,7 @@ eMBErrorCode eMBRTUInit(uint8_t ucSlaveAddress, uint8_t ucPort,
   return eStatus;
 }
 
-void eMBRTUStart(void)
+void eMBRTUStart(xMBInstance *pxInst)
 {
   ENTER_CRITICAL_SECTION();
 
@@ -151,49 +139,51 @@ void eMBRTUStart(void)
    * modbus protocol stack until the bus is free.
    */
 
-  eRcvState = STATE_RX_INIT;
-  vMBPortSerialEnable(true, false);
-  vMBPortTimersEnable();
+  pxInst->eRcvState = STATE_RX_INIT;
+  vMBPortSerialEnable(pxInst, true, false);
+  vMBPortTimersEnable(pxInst);
 
   EXIT_CRITICAL_SECTION();
 }
 
-void eMBRTUStop(void)
+void eMBRTUStop(xMBInstance *pxInst)
 {
   ENTER_CRITICAL_SECTION();
-  vMBPortSerialEnable(false, false);
-  vMBPortTimersDisable();
+  vMBPortSerialEnable(pxInst, false, false);
+  vMBPortTimersDisable(pxInst);
   EXIT_CRITICAL_SECTION();
 }
 
-eMBErrorCode eMBRTUReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
-                           uint16_t *pusLength)
+eMBErrorCode eMBRTUReceive(xMBInstance *pxInst, uint8_t *pucRcvAddress,
+                           uint8_t **pucFrame, uint16_t *pusLength)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
   ENTER_CRITICAL_SECTION();
-  DEBUGASSERT(usRcvBufferPos < MB_SER_PDU_SIZE_MAX);
+  DEBUGASSERT(pxInst->usRcvBufferPos < MB_SER_PDU_SIZE_MAX);
 
   /* Length and CRC check */
 
-  if ((usRcvBufferPos >= MB_SER_PDU_SIZE_MIN) &&
-      (usMBCRC16((uint8_t *) ucRTUBuf, usRcvBufferPos) == 0))
+  if ((pxInst->usRcvBufferPos >= MB_SER_PDU_SIZE_MIN) &&
+      (usMBCRC16((uint8_t *)pxInst->ucSerBuf,
+                 pxInst->usRcvBufferPos) == 0))
     {
       /* Save the address field. All frames are passed to the upper laid
        * and the decision if a frame is used is done there.
        */
 
-      *pucRcvAddress = ucRTUBuf[MB_SER_PDU_ADDR_OFF];
+      *pucRcvAddress = pxInst->ucSerBuf[MB_SER_PDU_ADDR_OFF];
 
       /* Total length of Modbus-PDU is Modbus-Serial-Line-PDU minus
        * size of address field and CRC checksum.
        */
 
-      *pusLength = (uint16_t)(usRcvBufferPos - MB_SER_PDU_PDU_OFF - MB_SER_PDU_SIZE_CRC);
+      *pusLength = (uint16_t)(pxInst->usRcvBufferPos - MB_SER_PDU_PDU_OFF -
+                              MB_SER_PDU_SIZE_CRC);
 
       /* Return the start of the Modbus PDU to the caller. */
 
-      *pucFrame = (uint8_t *) & ucRTUBuf[MB_SER_PDU_PDU_OFF];
+      *pucFrame = (uint8_t *) & pxInst->ucSerBuf[MB_SER_PDU_PDU_OFF];
     }
   else
     {
@@ -204,7 +194,8 @@ eMBErrorCode eMBRTUReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
   return eStatus;
 }
 
-eMBErrorCode eMBRTUSend(uint8_t ucSlaveAddress, const uint8_t *pucFrame, uint16_t usLength)
+eMBErrorCode eMBRTUSend(xMBInstance *pxInst, uint8_t ucSlaveAddress,
+                        const uint8_t *pucFrame, uint16_t usLength)
 {
   eMBErrorCode eStatus = MB_ENOERR;
   uint16_t usCRC16;
@@ -216,28 +207,30 @@ eMBErrorCode eMBRTUSend(uint8_t ucSlaveAddress, const uint8_t *pucFrame, uint16_
    * frame on the network. We have to abort sending the frame.
    */
 
-  if (eRcvState == STATE_RX_IDLE)
+  if (pxInst->eRcvState == STATE_RX_IDLE)
     {
       /* First byte before the Modbus-PDU is the slave address. */
 
-      pucSndBufferCur = (uint8_t *) pucFrame - 1;
-      usSndBufferCount = 1;
+      pxInst->pucSndBufferCur = (uint8_t *) pucFrame - 1;
+      pxInst->usSndBufferCount = 1;
 
       /* Now copy the Modbus-PDU into the Modbus-Serial-Line-PDU. */
 
-      pucSndBufferCur[MB_SER_PDU_ADDR_OFF] = ucSlaveAddress;
-      usSndBufferCount += usLength;
+      pxInst->pucSndBufferCur[MB_SER_PDU_ADDR_OFF] = ucSlaveAddress;
+      pxInst->usSndBufferCount += usLength;
 
       /* Calculate CRC16 checksum for Modbus-Serial-Line-PDU. */
 
-      usCRC16 = usMBCRC16((uint8_t *) pucSndBufferCur, usSndBufferCount);
-      ucRTUBuf[usSndBufferCount++] = (uint8_t)(usCRC16 & 0xFF);
-      ucRTUBuf[usSndBufferCount++] = (uint8_t)(usCRC16 >> 8);
+      usCRC16 = usMBCRC16((uint8_t *)pxInst->pucSndBufferCur,
+                          pxInst->usSndBufferCount);
+      pxInst->ucSerBuf[pxInst->usSndBufferCount++] =
+        (uint8_t)(usCRC16 & 0xFF);
+      pxInst->ucSerBuf[pxInst->usSndBufferCount++] = (uint8_t)(usCRC16 >> 8);
 
       /* Activate the transmitter. */
 
-      eSndState = STATE_TX_XMIT;
-      vMBPortSerialEnable(false, true);
+      pxInst->eSndState = STATE_TX_XMIT;
+      vMBPortSerialEnable(pxInst, false, true);
     }
   else
     {
@@ -248,25 +241,25 @@ eMBErrorCode eMBRTUSend(uint8_t ucSlaveAddress, const uint8_t *pucFrame, uint16_
   return eStatus;
 }
 
-bool xMBRTUReceiveFSM(void)
+bool xMBRTUReceiveFSM(xMBInstance *pxInst)
 {
   bool xTaskNeedSwitch = false;
   uint8_t ucByte;
 
-  DEBUGASSERT(eSndState == STATE_TX_IDLE);
+  DEBUGASSERT(pxInst->eSndState == STATE_TX_IDLE);
 
   /* Always read the character. */
 
-  xMBPortSerialGetByte((int8_t *) & ucByte);
+  xMBPortSerialGetByte(pxInst, (int8_t *) & ucByte);
 
-  switch (eRcvState)
+  switch (pxInst->eRcvState)
     {
       /* If we have received a character in the init state we have to
        * wait until the frame is finished.
        */
 
       case STATE_RX_INIT:
-        vMBPortTimersEnable();
+        vMBPortTimersEnable(pxInst);
         break;
 
       /* In the error state we wait until all characters in the
@@ -274,7 +267,7 @@ bool xMBRTUReceiveFSM(void)
        */
 
       case STATE_RX_ERROR:
-        vMBPortTimersEnable();
+        vMBPortTimersEnable(pxInst);
         break;
 
       /* In the idle state we wait for a new character. If a character
@@ -283,13 +276,13 @@ bool xMBRTUReceiveFSM(void)
        */
 
       case STATE_RX_IDLE:
-        usRcvBufferPos = 0;
-        ucRTUBuf[usRcvBufferPos++] = ucByte;
-        eRcvState = STATE_RX_RCV;
+        pxInst->usRcvBufferPos = 0;
+        pxInst->ucSerBuf[pxInst->usRcvBufferPos++] = ucByte;
+        pxInst->eRcvState = STATE_RX_RCV;
 
         /* Enable t3.5 timers. */
 
-        vMBPortTimersEnable();
+        vMBPortTimersEnable(pxInst);
         break;
 
       /* We are currently receiving a frame. Reset the timer after
@@ -299,29 +292,29 @@ bool xMBRTUReceiveFSM(void)
        */
 
       case STATE_RX_RCV:
-        if (usRcvBufferPos < MB_SER_PDU_SIZE_MAX)
+        if (pxInst->usRcvBufferPos < MB_SER_PDU_SIZE_MAX)
           {
-            ucRTUBuf[usRcvBufferPos++] = ucByte;
+            pxInst->ucSerBuf[pxInst->usRcvBufferPos++] = ucByte;
           }
         else
           {
-            eRcvState = STATE_RX_ERROR;
+            pxInst->eRcvState = STATE_RX_ERROR;
           }
 
-        vMBPortTimersEnable();
+        vMBPortTimersEnable(pxInst);
         break;
     }
 
   return xTaskNeedSwitch;
 }
 
-bool xMBRTUTransmitFSM(void)
+bool xMBRTUTransmitFSM(xMBInstance *pxInst)
 {
   bool xNeedPoll = false;
 
-  DEBUGASSERT(eRcvState == STATE_RX_IDLE);
+  DEBUGASSERT(pxInst->eRcvState == STATE_RX_IDLE);
 
-  switch (eSndState)
+  switch (pxInst->eSndState)
     {
       /* We should not get a transmitter event if the transmitter is in
        * idle state.
@@ -330,28 +323,28 @@ bool xMBRTUTransmitFSM(void)
     case STATE_TX_IDLE:
       /* enable receiver/disable transmitter. */
 
-      vMBPortSerialEnable(true, false);
+      vMBPortSerialEnable(pxInst, true, false);
       break;
 
     case STATE_TX_XMIT:
       /* check if we are finished. */
 
-      if (usSndBufferCount != 0)
+      if (pxInst->usSndBufferCount != 0)
         {
-          xMBPortSerialPutByte((int8_t)*pucSndBufferCur);
-          pucSndBufferCur++;  /* next byte in sendbuffer. */
-          usSndBufferCount--;
+          xMBPortSerialPutByte(pxInst, (int8_t)*pxInst->pucSndBufferCur);
+          pxInst->pucSndBufferCur++;  /* next byte in sendbuffer. */
+          pxInst->usSndBufferCount--;
         }
       else
         {
-          xNeedPoll = xMBPortEventPost(EV_FRAME_SENT);
+          xNeedPoll = xMBPortEventPost(pxInst, EV_FRAME_SENT);
 
           /* Disable transmitter. This prevents another transmit buffer
            * empty interrupt.
            */
 
-          vMBPortSerialEnable(true, false);
-          eSndState = STATE_TX_IDLE;
+          vMBPortSerialEnable(pxInst, true, false);
+          pxInst->eSndState = STATE_TX_IDLE;
         }
       break;
     }
@@ -359,16 +352,16 @@ bool xMBRTUTransmitFSM(void)
   return xNeedPoll;
 }
 
-bool xMBRTUTimerT35Expired(void)
+bool xMBRTUTimerT35Expired(xMBInstance *pxInst)
 {
   bool xNeedPoll = false;
 
-  switch (eRcvState)
+  switch (pxInst->eRcvState)
     {
       /* Timer t35 expired. Start-up phase is finished. */
 
       case STATE_RX_INIT:
-        xNeedPoll = xMBPortEventPost(EV_READY);
+        xNeedPoll = xMBPortEventPost(pxInst, EV_READY);
         break;
 
       /* A frame was received and t35 expired. Notify the listener that
@@ -376,7 +369,7 @@ bool xMBRTUTimerT35Expired(void)
        */
 
       case STATE_RX_RCV:
-        xNeedPoll = xMBPortEventPost(EV_FRAME_RECEIVED);
+        xNeedPoll = xMBPortEventPost(pxInst, EV_FRAME_RECEIVED);
         break;
 
       /* An error occurred while receiving the frame. */
@@ -387,13 +380,13 @@ bool xMBRTUTimerT35Expired(void)
       /* Function called in an illegal state. */
 
       default:
-        DEBUGASSERT((eRcvState == STATE_RX_INIT) ||
-               (eRcvState == STATE_RX_RCV) ||
-               (eRcvState == STATE_RX_ERROR));
+        DEBUGASSERT((pxInst->eRcvState == STATE_RX_INIT) ||
+                    (pxInst->eRcvState == STATE_RX_RCV) ||
+                    (pxInst->eRcvState == STATE_RX_ERROR));
     }
 
-  vMBPortTimersDisable();
-  eRcvState = STATE_RX_IDLE;
+  vMBPortTimersDisable(pxInst);
+  pxInst->eRcvState = STATE_RX_IDLE;
 
   return xNeedPoll;
 }
@@ -38,54 +38,23 @@
 #include <string.h>
 
 #include "modbus/mb.h"
+#include "modbus/mbframe.h"
 
 #include "port.h"
+#include "mbinstance.h"
 #include "mbtcp.h"
 
 #ifdef CONFIG_MB_TCP_ENABLED
 
-/****************************************************************************
- * Pre-processor Definitions
- ****************************************************************************/
-
-/* ----------------------- MBAP Header --------------------------------------*/
-/*
- *
- * <------------------------ MODBUS TCP/IP ADU(1) ------------------------->
- *              <----------- MODBUS PDU (1') ---------------->
- *  +-----------+---------------+------------------------------------------+
- *  | TID | PID | Length | UID  |Code | Data                               |
- *  +-----------+---------------+------------------------------------------+
- *  |     |     |        |      |
- * (2)   (3)   (4)      (5)    (6)
- *
- * (2)  ... MB_TCP_TID          = 0 (Transaction Identifier - 2 Byte)
- * (3)  ... MB_TCP_PID          = 2 (Protocol Identifier - 2 Byte)
- * (4)  ... MB_TCP_LEN          = 4 (Number of bytes - 2 Byte)
- * (5)  ... MB_TCP_UID          = 6 (Unit Identifier - 1 Byte)
- * (6)  ... MB_TCP_FUNC         = 7 (Modbus Function Code)
- *
- * (1)  ... Modbus TCP/IP Application Data Unit
- * (1') ... Modbus Protocol Data Unit
- */
-
-#define MB_TCP_TID          0
-#define MB_TCP_PID          2
-#define MB_TCP_LEN          4
-#define MB_TCP_UID          6
-#define MB_TCP_FUNC         7
-
-#define MB_TCP_PROTOCOL_ID  0   /* 0 = Modbus Protocol */
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort)
+eMBErrorCode eMBTCPDoInit(xMBInstance *pxInst, uint16_t ucTCPPort)
 {
   eMBErrorCode    eStatus = MB_ENOERR;
 
-  if (xMBTCPPortInit(ucTCPPort) == false)
+  if (xMBTCPPortInit(pxInst, ucTCPPort) == false)
     {
       eStatus = MB_EPORTERR;
     }
@@ -93,71 +62,59 @@ eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort)
    return eStatus;
 }
 
-void eMBTCPStart(void)
+void eMBTCPStart(xMBInstance *pxInst)
 {
 }
 
-void eMBTCPStop(void)
+void eMBTCPStop(xMBInstance *pxInst)
 {
    /* Make sure that no more clients are connected. */
 
-  vMBTCPPortDisable();
+  vMBTCPPortDisable(pxInst);
 }
 
-eMBErrorCode eMBTCPReceive(uint8_t *pucRcvAddress, uint8_t **ppucFrame, uint16_t *pusLength)
+/* Process one request ADU received on a client connection.  The porting
+ * layer owns the request and the response buffer of every connection, so
+ * clients never wait for each other and several requests of the same
+ * client can be queued.  pucResponse must hold MB_TCP_ADU_SIZE_MAX bytes.
+ * The response echoes the MBAP header (transaction identifier and unit
+ * identifier) of the request.  MB_EIO is returned if the request is not a
+ * Modbus request and must be dropped without a response.
+ */
+
+eMBErrorCode eMBTCPExecute(const uint8_t *pucRequest, uint16_t usLength,
+                           uint8_t *pucResponse, uint16_t *pusRspLength)
 {
-  eMBErrorCode    eStatus = MB_EIO;
-  uint8_t        *pucMBTCPFrame;
-  uint16_t        usLength;
   uint16_t        usPID;
+  uint16_t        usPDULength;
 
-  if (xMBTCPPortGetRequest(&pucMBTCPFrame, &usLength) != false)
-    {
-      usPID = pucMBTCPFrame[MB_TCP_PID] << 8U;
-      usPID |= pucMBTCPFrame[MB_TCP_PID + 1];
-
-      if (usPID == MB_TCP_PROTOCOL_ID)
-        {
-          *ppucFrame = &pucMBTCPFrame[MB_TCP_FUNC];
-          *pusLength = usLength - MB_TCP_FUNC;
-          eStatus = MB_ENOERR;
-
-          /* Modbus TCP does not use any addresses. Fake the source address such
-           * that the processing part deals with this frame.
-           */
+  usPID = pucRequest[MB_TCP_PID] << 8U;
+  usPID |= pucRequest[MB_TCP_PID + 1];
 
-          *pucRcvAddress = MB_TCP_PSEUDO_ADDRESS;
-        }
-    }
-  else
+  if (usPID != MB_TCP_PROTOCOL_ID || usLength <= MB_TCP_FUNC ||
+      usLength > MB_TCP_ADU_SIZE_MAX)
     {
-      eStatus = MB_EIO;
+      return MB_EIO;
     }
 
-  return eStatus;
-}
+  memcpy(pucResponse, pucRequest, usLength);
+  usPDULength = usLength - MB_TCP_FUNC;
 
-eMBErrorCode eMBTCPSend(uint8_t _unused, const uint8_t * pucFrame, uint16_t usLength)
-{
-  eMBErrorCode    eStatus = MB_ENOERR;
-  uint8_t        *pucMBTCPFrame = (uint8_t *) pucFrame - MB_TCP_FUNC;
-  uint16_t        usTCPLength = usLength + MB_TCP_FUNC;
-
-  /* The MBAP header is already initialized because the caller calls this
-   * function with the buffer returned by the previous call. Therefore we
-   * only have to update the length in the header. Note that the length
-   * header includes the size of the Modbus PDU and the UID Byte. Therefore
-   * the length is usLength plus one.
+  /* Modbus TCP does not use any addresses, the request is always
+   * executed.
    */
 
-  pucMBTCPFrame[MB_TCP_LEN] = (usLength + 1) >> 8U;
-  pucMBTCPFrame[MB_TCP_LEN + 1] = (usLength + 1) & 0xFF;
-  if (xMBTCPPortSendResponse(pucMBTCPFrame, usTCPLength) == false)
-    {
-      eStatus = MB_EIO;
-    }
+  eMBFrameExecute(&pucResponse[MB_TCP_FUNC], &usPDULength);
+
+  /* Note that the length header includes the size of the Modbus PDU and
+   * the UID Byte. Therefore the length is usPDULength plus one.
+   */
+
+  pucResponse[MB_TCP_LEN] = (usPDULength + 1) >> 8U;
+  pucResponse[MB_TCP_LEN + 1] = (usPDULength + 1) & 0xFF;
+  *pusRspLength = usPDULength + MB_TCP_FUNC;
 
-  return eStatus;
+  return MB_ENOERR;
 }
 
 #endif /* CONFIG_MB_TCP_ENABLED */
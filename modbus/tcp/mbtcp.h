@@ -41,19 +41,48 @@ extern "C"
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* ----------------------- MBAP Header --------------------------------------*/
+/*
+ *
+ * <------------------------ MODBUS TCP/IP ADU(1) ------------------------->
+ *              <----------- MODBUS PDU (1') ---------------->
+ *  +-----------+---------------+------------------------------------------+
+ *  | TID | PID | Length | UID  |Code | Data                               |
+ *  +-----------+---------------+------------------------------------------+
+ *  |     |     |        |      |
+ * (2)   (3)   (4)      (5)    (6)
+ *
+ * (2)  ... MB_TCP_TID          = 0 (Transaction Identifier - 2 Byte)
+ * (3)  ... MB_TCP_PID          = 2 (Protocol Identifier - 2 Byte)
+ * (4)  ... MB_TCP_LEN          = 4 (Number of bytes - 2 Byte)
+ * (5)  ... MB_TCP_UID          = 6 (Unit Identifier - 1 Byte)
+ * (6)  ... MB_TCP_FUNC         = 7 (Modbus Function Code)
+ *
+ * (1)  ... Modbus TCP/IP Application Data Unit
+ * (1') ... Modbus Protocol Data Unit
+ */
+
+#define MB_TCP_TID          0
+#define MB_TCP_PID          2
+#define MB_TCP_LEN          4
+#define MB_TCP_UID          6
+#define MB_TCP_FUNC         7
+
+#define MB_TCP_PROTOCOL_ID  0   /* 0 = Modbus Protocol */
+
+#define MB_TCP_ADU_SIZE_MAX (MB_TCP_FUNC + MB_PDU_SIZE_MAX)
+
 #define MB_TCP_PSEUDO_ADDRESS   255
 
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
 
-eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort);
-void         eMBTCPStart(void);
-void         eMBTCPStop(void);
-eMBErrorCode eMBTCPReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
-                           uint16_t *pusLength);
-eMBErrorCode eMBTCPSend(uint8_t _unused, const uint8_t *pucFrame,
-                        uint16_t usLength);
+eMBErrorCode eMBTCPDoInit(xMBInstance *pxInst, uint16_t ucTCPPort);
+void         eMBTCPStart(xMBInstance *pxInst);
+void         eMBTCPStop(xMBInstance *pxInst);
+eMBErrorCode eMBTCPExecute(const uint8_t *pucRequest, uint16_t usLength,
+                           uint8_t *pucResponse, uint16_t *pusRspLength);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,953 @@
+/****************************************************************************
+ * apps/netutils/telnetd/telnetd_mux.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sched.h>
+#include <spawn.h>
+#include <termios.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <netinet/in.h>
+
+#include "netutils/telnetd.h"
+
+#ifdef CONFIG_NETUTILS_TELNETD_MUX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MUX_NSESSIONS   CONFIG_NETUTILS_TELNETD_MUX_SESSIONS
+#define MUX_BUFSIZE     CONFIG_NETUTILS_TELNETD_MUX_BUFSIZE
+
+/* Telnet commands and options (RFC 854, 857, 858, 1073) */
+
+#define TELNET_SE       240
+#define TELNET_IP       244
+#define TELNET_SB       250
+#define TELNET_WILL     251
+#define TELNET_WONT     252
+#define TELNET_DO       253
+#define TELNET_DONT     254
+#define TELNET_IAC      255
+
+#define TELOPT_ECHO     1
+#define TELOPT_SGA      3
+#define TELOPT_NAWS     31
+
+/* Longest sub-negotiation that is kept (NAWS needs 5 bytes) */
+
+#define MUX_SBSIZE      8
+
+/* Room kept in the output buffer for negotiation replies */
+
+#define MUX_REPLYSIZE   3
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Receive state of the telnet protocol parser */
+
+enum mux_state_e
+{
+  STATE_NORMAL = 0,                /* Plain data */
+  STATE_IAC,                       /* Received IAC */
+  STATE_OPT,                       /* Received IAC WILL/WONT/DO/DONT */
+  STATE_SB,                        /* Inside a sub-negotiation */
+  STATE_SBIAC,                     /* Received IAC inside SB */
+  STATE_CR                         /* Received CR */
+};
+
+/* A byte FIFO between a socket and a pty master */
+
+struct mux_buffer_s
+{
+  uint16_t head;                   /* Index of the first valid byte */
+  uint16_t tail;                   /* Index after the last valid byte */
+  uint8_t data[MUX_BUFSIZE];
+};
+
+/* One client connection and the NSH session that serves it */
+
+struct mux_session_s
+{
+  int sd;                          /* Client socket, -1 if slot is free */
+  int ptyfd;                       /* Master side of the session's pty */
+  uint8_t state;                   /* See enum mux_state_e */
+  uint8_t cmd;                     /* WILL/WONT/DO/DONT being received */
+  uint8_t sblen;                   /* Bytes of the current sub-negotiation */
+  uint8_t sb[MUX_SBSIZE];          /* Current sub-negotiation */
+  struct mux_buffer_s rxbuf;       /* Cooked input for the pty */
+  struct mux_buffer_s txbuf;       /* Escaped output for the socket */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Sent to each new client: the server echoes and runs in character mode,
+ * and would like to know the window size.
+ */
+
+static const uint8_t g_negotiate[] =
+{
+  TELNET_IAC, TELNET_WILL, TELOPT_ECHO,
+  TELNET_IAC, TELNET_WILL, TELOPT_SGA,
+  TELNET_IAC, TELNET_DO, TELOPT_NAWS
+};
+
+static const char g_busymsg[] = "Too many telnet sessions\r\n";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mux_used
+ ****************************************************************************/
+
+static inline size_t mux_used(FAR struct mux_buffer_s *buf)
+{
+  return buf->tail - buf->head;
+}
+
+/****************************************************************************
+ * Name: mux_room
+ ****************************************************************************/
+
+static inline size_t mux_room(FAR struct mux_buffer_s *buf)
+{
+  return MUX_BUFSIZE - mux_used(buf);
+}
+
+/****************************************************************************
+ * Name: mux_compact
+ *
+ * Description:
+ *   Move the valid bytes to the start of the buffer so that all free room
+ *   is at its end.
+ *
+ ****************************************************************************/
+
+static void mux_compact(FAR struct mux_buffer_s *buf)
+{
+  if (buf->head > 0)
+    {
+      memmove(buf->data, &buf->data[buf->head], mux_used(buf));
+      buf->tail -= buf->head;
+      buf->head  = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: mux_putc
+ ****************************************************************************/
+
+static inline void mux_putc(FAR struct mux_buffer_s *buf, uint8_t ch)
+{
+  if (buf->tail < MUX_BUFSIZE)
+    {
+      buf->data[buf->tail++] = ch;
+    }
+}
+
+/****************************************************************************
+ * Name: mux_flush
+ *
+ * Description:
+ *   Write as much of 'buf' to the non-blocking 'fd' as it accepts.
+ *   Returns ERROR if the peer is gone.
+ *
+ ****************************************************************************/
+
+static int mux_flush(int fd, FAR struct mux_buffer_s *buf)
+{
+  ssize_t nwritten;
+
+  if (mux_used(buf) == 0)
+    {
+      return OK;
+    }
+
+  nwritten = write(fd, &buf->data[buf->head], mux_used(buf));
+  if (nwritten < 0)
+    {
+      return errno == EAGAIN || errno == EINTR ? OK : ERROR;
+    }
+
+  buf->head += nwritten;
+  if (buf->head == buf->tail)
+    {
+      buf->head = 0;
+      buf->tail = 0;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mux_reply
+ *
+ * Description:
+ *   Queue a three byte option negotiation reply for the client.
+ *
+ ****************************************************************************/
+
+static void mux_reply(FAR struct mux_session_s *session, uint8_t cmd,
+                      uint8_t opt)
+{
+  FAR struct mux_buffer_s *buf = &session->txbuf;
+
+  mux_compact(buf);
+  if (mux_room(buf) >= MUX_REPLYSIZE)
+    {
+      mux_putc(buf, TELNET_IAC);
+      mux_putc(buf, cmd);
+      mux_putc(buf, opt);
+    }
+}
+
+/****************************************************************************
+ * Name: mux_option
+ *
+ * Description:
+ *   Answer an option request from the client.  ECHO and SGA are the only
+ *   options the server performs, and NAWS is the only one it accepts from
+ *   the client.  Everything else is refused.  Acknowledgments of our own
+ *   requests need no answer.
+ *
+ ****************************************************************************/
+
+static void mux_option(FAR struct mux_session_s *session, uint8_t opt)
+{
+  switch (session->cmd)
+    {
+      case TELNET_DO:
+        if (opt != TELOPT_ECHO && opt != TELOPT_SGA)
+          {
+            mux_reply(session, TELNET_WONT, opt);
+          }
+        break;
+
+      case TELNET_WILL:
+        if (opt != TELOPT_NAWS)
+          {
+            mux_reply(session, TELNET_DONT, opt);
+          }
+        break;
+
+      default:
+        break;
+    }
+}
+
+/****************************************************************************
+ * Name: mux_subnegotiation
+ ****************************************************************************/
+
+static void mux_subnegotiation(FAR struct mux_session_s *session)
+{
+#ifdef TIOCSWINSZ
+  /* NAWS: width and height as 16-bit big endian values */
+
+  if (session->sblen == 5 && session->sb[0] == TELOPT_NAWS)
+    {
+      struct winsize ws;
+
+      memset(&ws, 0, sizeof(ws));
+      ws.ws_col = (session->sb[1] << 8) | session->sb[2];
+      ws.ws_row = (session->sb[3] << 8) | session->sb[4];
+      ioctl(session->ptyfd, TIOCSWINSZ, (unsigned long)((uintptr_t)&ws));
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: mux_receive
+ *
+ * Description:
+ *   Strip the telnet protocol from the bytes received from the client and
+ *   queue the remaining data for the NSH session.  The cooked data is
+ *   never longer than the raw data, so 'data' may be the free room of the
+ *   session's rxbuf and is then cooked in place.
+ *
+ ****************************************************************************/
+
+static void mux_receive(FAR struct mux_session_s *session,
+                        FAR const uint8_t *data, size_t len)
+{
+  FAR struct mux_buffer_s *buf = &session->rxbuf;
+  uint8_t ch;
+
+  while (len-- > 0)
+    {
+      ch = *data++;
+
+      /* CR LF and CR NUL both end a line, the CR was already passed on */
+
+      if (session->state == STATE_CR)
+        {
+          session->state = STATE_NORMAL;
+          if (ch == '\n' || ch == '\0')
+            {
+              continue;
+            }
+        }
+
+      switch (session->state)
+        {
+          case STATE_NORMAL:
+            if (ch == TELNET_IAC)
+              {
+                session->state = STATE_IAC;
+              }
+            else if (ch == '\r')
+              {
+                mux_putc(buf, '\n');
+                session->state = STATE_CR;
+              }
+            else
+              {
+                mux_putc(buf, ch);
+              }
+            break;
+
+          case STATE_IAC:
+            session->state = STATE_NORMAL;
+            switch (ch)
+              {
+                case TELNET_IAC:
+                  mux_putc(buf, TELNET_IAC);
+                  break;
+
+                case TELNET_IP:
+
+                  /* Interrupt process: pass control-C to the session */
+
+                  mux_putc(buf, 0x03);
+                  break;
+
+                case TELNET_WILL:
+                case TELNET_WONT:
+                case TELNET_DO:
+                case TELNET_DONT:
+                  session->cmd   = ch;
+                  session->state = STATE_OPT;
+                  break;
+
+                case TELNET_SB:
+                  session->sblen = 0;
+                  session->state = STATE_SB;
+                  break;
+
+                default:
+                  break;
+              }
+            break;
+
+          case STATE_OPT:
+            mux_option(session, ch);
+            session->state = STATE_NORMAL;
+            break;
+
+          case STATE_SB:
+            if (ch == TELNET_IAC)
+              {
+                session->state = STATE_SBIAC;
+              }
+            else if (session->sblen < MUX_SBSIZE)
+              {
+                session->sb[session->sblen++] = ch;
+              }
+            break;
+
+          case STATE_SBIAC:
+            if (ch == TELNET_SE)
+              {
+                mux_subnegotiation(session);
+                session->state = STATE_NORMAL;
+              }
+            else
+              {
+                /* IAC IAC is a 255 data byte inside the sub-negotiation */
+
+                if (session->sblen < MUX_SBSIZE)
+                  {
+                    session->sb[session->sblen++] = ch;
+                  }
+
+                session->state = STATE_SB;
+              }
+            break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: mux_send
+ *
+ * Description:
+ *   Queue output of the NSH session for the client, converting LF to
+ *   CR LF and escaping IAC.  Each input byte takes at most two bytes, so
+ *   'data' may lie at the end of the session's txbuf as long as there are
+ *   at least 'len' free bytes in front of it.
+ *
+ ****************************************************************************/
+
+static void mux_send(FAR struct mux_session_s *session,
+                     FAR const uint8_t *data, size_t len)
+{
+  FAR struct mux_buffer_s *buf = &session->txbuf;
+
+  while (len-- > 0)
+    {
+      uint8_t ch = *data++;
+
+      if (ch == '\n')
+        {
+          mux_putc(buf, '\r');
+        }
+      else if (ch == TELNET_IAC)
+        {
+          mux_putc(buf, TELNET_IAC);
+        }
+
+      mux_putc(buf, ch);
+    }
+}
+
+/****************************************************************************
+ * Name: mux_highfd
+ *
+ * Description:
+ *   The daemon runs with stdin, stdout and stderr closed and points them at
+ *   the slave pty of each new session for a moment.  Keep the descriptors
+ *   that the daemon holds on to out of that range.
+ *
+ ****************************************************************************/
+
+static int mux_highfd(int fd)
+{
+  int newfd;
+
+  if (fd < 0 || fd > 2)
+    {
+      return fd;
+    }
+
+  newfd = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+  close(fd);
+  return newfd;
+}
+
+/****************************************************************************
+ * Name: mux_close
+ ****************************************************************************/
+
+static void mux_close(FAR struct mux_session_s *session)
+{
+  ninfo("Closing telnet session on socket %d\n", session->sd);
+
+  /* Closing the master makes the session see the end of its input */
+
+  close(session->ptyfd);
+  close(session->sd);
+  session->sd    = -1;
+  session->ptyfd = -1;
+}
+
+/****************************************************************************
+ * Name: mux_spawn
+ *
+ * Description:
+ *   Start an NSH session on the slave side of a new pty.  Returns the
+ *   master file descriptor.
+ *
+ ****************************************************************************/
+
+static int mux_spawn(FAR const struct telnetd_config_s *config)
+{
+  struct termios tio;
+  char devpath[16];
+  int ptyfd;
+  int ptsfd;
+  int ret = ERROR;
+
+  ptyfd = mux_highfd(open("/dev/ptmx", O_RDWR | O_NOCTTY | O_CLOEXEC));
+  if (ptyfd < 0)
+    {
+      nerr("ERROR: open(/dev/ptmx) failed: %d\n", errno);
+      return ERROR;
+    }
+
+  if (grantpt(ptyfd) < 0 || unlockpt(ptyfd) < 0 ||
+      ptsname_r(ptyfd, devpath, sizeof(devpath)) < 0)
+    {
+      nerr("ERROR: Failed to set up the pty: %d\n", errno);
+      goto errout_with_pty;
+    }
+
+  ptsfd = open(devpath, O_RDWR | O_NOCTTY);
+  if (ptsfd < 0)
+    {
+      nerr("ERROR: Failed to open %s: %d\n", devpath, errno);
+      goto errout_with_pty;
+    }
+
+  /* The daemon does the CR/LF handling of the telnet protocol */
+
+  if (tcgetattr(ptsfd, &tio) == 0)
+    {
+      tio.c_iflag &= ~(ICRNL | INLCR | IGNCR);
+      tio.c_oflag &= ~(OPOST | ONLCR);
+      tcsetattr(ptsfd, TCSANOW, &tio);
+    }
+
+  /* Use the slave as stdin, stdout, and stderr of the new session */
+
+  dup2(ptsfd, 0);
+  dup2(ptsfd, 1);
+  dup2(ptsfd, 2);
+
+  if (ptsfd > 2)
+    {
+      close(ptsfd);
+    }
+
+#ifndef CONFIG_BUILD_KERNEL
+  if (config->t_entry)
+    {
+      ret = task_create("Telnet session", config->t_priority,
+                        config->t_stacksize, config->t_entry, NULL);
+    }
+#endif
+
+#ifdef CONFIG_LIBC_EXECFUNCS
+  if (ret < 0 && config->t_path)
+    {
+      struct sched_param param;
+      posix_spawnattr_t attr;
+      pid_t pid;
+
+      sched_getparam(0, &param);
+      param.sched_priority = config->t_priority;
+
+      posix_spawnattr_init(&attr);
+      posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSCHEDPARAM);
+      posix_spawnattr_setschedparam(&attr, &param);
+      posix_spawnattr_setstacksize(&attr, config->t_stacksize);
+
+      ret = posix_spawnp(&pid, config->t_path, NULL, &attr,
+                         config->t_argv, NULL);
+      ret = ret == 0 ? pid : ERROR;
+    }
+#endif
+
+  /* The session owns the slave now, the daemon goes silent again */
+
+  close(0);
+  close(1);
+  close(2);
+
+  if (ret < 0)
+    {
+      nerr("ERROR: Failed to start the telnet session\n");
+      goto errout_with_pty;
+    }
+
+  return ptyfd;
+
+errout_with_pty:
+  close(ptyfd);
+  return ERROR;
+}
+
+/****************************************************************************
+ * Name: mux_accept
+ ****************************************************************************/
+
+static void mux_accept(FAR const struct telnetd_config_s *config,
+                       FAR struct mux_session_s *sessions, int listensd)
+{
+  FAR struct mux_session_s *session = NULL;
+  int sd;
+  int i;
+
+  sd = mux_highfd(accept4(listensd, NULL, NULL, SOCK_CLOEXEC));
+  if (sd < 0)
+    {
+      nerr("ERROR: accept failed: %d\n", errno);
+      return;
+    }
+
+  for (i = 0; i < MUX_NSESSIONS; i++)
+    {
+      if (sessions[i].sd < 0)
+        {
+          session = &sessions[i];
+          break;
+        }
+    }
+
+  /* The number of sessions is bounded, turn the client away if all of
+   * them are in use.
+   */
+
+  if (session == NULL)
+    {
+      write(sd, g_busymsg, sizeof(g_busymsg) - 1);
+      close(sd);
+      return;
+    }
+
+  memset(session, 0, sizeof(*session));
+  session->ptyfd = mux_spawn(config);
+  if (session->ptyfd < 0)
+    {
+      session->sd = -1;
+      close(sd);
+      return;
+    }
+
+  session->sd = sd;
+  fcntl(sd, F_SETFL, fcntl(sd, F_GETFL) | O_NONBLOCK);
+  fcntl(session->ptyfd, F_SETFL,
+        fcntl(session->ptyfd, F_GETFL) | O_NONBLOCK);
+
+  memcpy(session->txbuf.data, g_negotiate, sizeof(g_negotiate));
+  session->txbuf.tail = sizeof(g_negotiate);
+
+  ninfo("New telnet session on socket %d\n", sd);
+}
+
+/****************************************************************************
+ * Name: mux_service
+ *
+ * Description:
+ *   Move data through one session according to the poll() results.
+ *   Returns ERROR if the session has ended.
+ *
+ ****************************************************************************/
+
+static int mux_service(FAR struct mux_session_s *session,
+                       FAR struct pollfd *sdfd, FAR struct pollfd *ptyfd)
+{
+  FAR uint8_t *raw;
+  ssize_t nread;
+  size_t room;
+
+  /* Client -> session.  The raw data is read into the free room of the
+   * buffer and cooked in place.
+   */
+
+  if (sdfd->revents & POLLIN)
+    {
+      mux_compact(&session->rxbuf);
+      room  = mux_room(&session->rxbuf);
+      raw   = &session->rxbuf.data[session->rxbuf.tail];
+      nread = read(session->sd, raw, room);
+      if (nread == 0 || (nread < 0 && errno != EAGAIN && errno != EINTR))
+        {
+          return ERROR;
+        }
+      else if (nread > 0)
+        {
+          mux_receive(session, raw, nread);
+        }
+    }
+
+  if (mux_flush(session->ptyfd, &session->rxbuf) < 0)
+    {
+      return ERROR;
+    }
+
+  /* Session -> client.  Keep room for escaping and replies.  The raw data
+   * is read into the end of the buffer and escaped towards its tail.
+   */
+
+  if (ptyfd->revents & POLLIN)
+    {
+      mux_compact(&session->txbuf);
+      room = mux_room(&session->txbuf);
+      if (room > MUX_REPLYSIZE)
+        {
+          room  = (room - MUX_REPLYSIZE) / 2;
+          raw   = &session->txbuf.data[MUX_BUFSIZE - room];
+          nread = read(session->ptyfd, raw, room);
+          if (nread == 0 ||
+              (nread < 0 && errno != EAGAIN && errno != EINTR))
+            {
+              /* The session has exited, send what is left */
+
+              mux_flush(session->sd, &session->txbuf);
+              return ERROR;
+            }
+          else if (nread > 0)
+            {
+              mux_send(session, raw, nread);
+            }
+        }
+    }
+  else if (ptyfd->revents & (POLLHUP | POLLERR))
+    {
+      mux_flush(session->sd, &session->txbuf);
+      return ERROR;
+    }
+
+  if (sdfd->revents & (POLLHUP | POLLERR))
+    {
+      return ERROR;
+    }
+
+  return mux_flush(session->sd, &session->txbuf);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: telnetd_mux
+ *
+ * Description:
+ *   Run the multiplexed Telnet daemon loop.  See include/netutils/telnetd.h.
+ *
+ ****************************************************************************/
+
+int telnetd_mux(FAR const struct telnetd_config_s *config)
+{
+  union
+  {
+    struct sockaddr     generic;
+#ifdef CONFIG_NET_IPv4
+    struct sockaddr_in  ipv4;
+#endif
+#ifdef CONFIG_NET_IPv6
+    struct sockaddr_in6 ipv6;
+#endif
+  } addr;
+
+  FAR struct mux_session_s *sessions;
+  struct pollfd fds[1 + 2 * MUX_NSESSIONS];
+  socklen_t addrlen;
+  int listensd;
+  int nfds;
+  int ret;
+  int i;
+#ifdef CONFIG_NET_SOCKOPTS
+  int optval;
+#endif
+
+  /* Session tasks exit on their own, do not keep them as zombies */
+
+#ifdef CONFIG_SCHED_HAVE_PARENT
+  signal(SIGCHLD, SIG_IGN);
+#endif
+
+  sessions = calloc(MUX_NSESSIONS, sizeof(struct mux_session_s));
+  if (sessions == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < MUX_NSESSIONS; i++)
+    {
+      sessions[i].sd    = -1;
+      sessions[i].ptyfd = -1;
+    }
+
+  listensd = mux_highfd(socket(config->d_family,
+                                SOCK_STREAM | SOCK_CLOEXEC, 0));
+  if (listensd < 0)
+    {
+      nerr("ERROR: socket() failed for family %u: %d\n",
+           config->d_family, errno);
+      ret = -errno;
+      goto errout_with_sessions;
+    }
+
+#ifdef CONFIG_NET_SOCKOPTS
+  optval = 1;
+  setsockopt(listensd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(int));
+#endif
+
+  memset(&addr, 0, sizeof(addr));
+
+#ifdef CONFIG_NET_IPv4
+  if (config->d_family == AF_INET)
+    {
+      addr.ipv4.sin_family      = AF_INET;
+      addr.ipv4.sin_port        = config->d_port;
+      addr.ipv4.sin_addr.s_addr = INADDR_ANY;
+      addrlen                   = sizeof(struct sockaddr_in);
+    }
+  else
+#endif
+#ifdef CONFIG_NET_IPv6
+  if (config->d_family == AF_INET6)
+    {
+      addr.ipv6.sin6_family     = AF_INET6;
+      addr.ipv6.sin6_port       = config->d_port;
+      addrlen                   = sizeof(struct sockaddr_in6);
+    }
+  else
+#endif
+    {
+      nerr("ERROR: Unsupported address family: %u", config->d_family);
+      ret = -EAFNOSUPPORT;
+      goto errout_with_socket;
+    }
+
+  if (bind(listensd, &addr.generic, addrlen) < 0 ||
+      listen(listensd, MUX_NSESSIONS) < 0)
+    {
+      nerr("ERROR: bind/listen failure: %d\n", errno);
+      ret = -errno;
+      goto errout_with_socket;
+    }
+
+  /* Go silent, the sessions get the slave side of their pty as stdio */
+
+  close(0);
+  close(1);
+  close(2);
+
+  ninfo("Accepting connections on port %d\n", ntohs(config->d_port));
+
+  for (; ; )
+    {
+      /* Slot 0 is the listener, then a socket/pty pair per session.  Only
+       * ask for the events that the buffers can take.
+       */
+
+      fds[0].fd     = listensd;
+      fds[0].events = POLLIN;
+      nfds = 1;
+
+      for (i = 0; i < MUX_NSESSIONS; i++)
+        {
+          FAR struct mux_session_s *session = &sessions[i];
+          FAR struct pollfd *pfd = &fds[1 + 2 * i];
+
+          pfd[0].fd      = session->sd;
+          pfd[0].events  = 0;
+          pfd[0].revents = 0;
+          pfd[1].fd      = session->ptyfd;
+          pfd[1].events  = 0;
+          pfd[1].revents = 0;
+
+          if (session->sd < 0)
+            {
+              continue;
+            }
+
+          if (mux_room(&session->rxbuf) > 0)
+            {
+              pfd[0].events |= POLLIN;
+            }
+
+          if (mux_used(&session->txbuf) > 0)
+            {
+              pfd[0].events |= POLLOUT;
+            }
+
+          if (mux_room(&session->txbuf) > MUX_REPLYSIZE + 1)
+            {
+              pfd[1].events |= POLLIN;
+            }
+
+          if (mux_used(&session->rxbuf) > 0)
+            {
+              pfd[1].events |= POLLOUT;
+            }
+
+          nfds = 3 + 2 * i;
+        }
+
+      ret = poll(fds, nfds, -1);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          nerr("ERROR: poll failed: %d\n", errno);
+          ret = -errno;
+          break;
+        }
+
+      for (i = 0; i < MUX_NSESSIONS; i++)
+        {
+          FAR struct pollfd *pfd = &fds[1 + 2 * i];
+
+          if (1 + 2 * i >= nfds || sessions[i].sd < 0 ||
+              (pfd[0].revents | pfd[1].revents) == 0)
+            {
+              continue;
+            }
+
+          if (mux_service(&sessions[i], &pfd[0], &pfd[1]) < 0)
+            {
+              mux_close(&sessions[i]);
+            }
+        }
+
+      if (fds[0].revents & POLLIN)
+        {
+          mux_accept(config, sessions, listensd);
+        }
+    }
+
+  for (i = 0; i < MUX_NSESSIONS; i++)
+    {
+      if (sessions[i].sd >= 0)
+        {
+          mux_close(&sessions[i]);
+        }
+    }
+
+errout_with_socket:
+  close(listensd);
+
+errout_with_sessions:
+  free(sessions);
+  return ret;
+}
+
+#endif /* CONFIG_NETUTILS_TELNETD_MUX */
@@ -63,6 +63,9 @@
 #include <fnmatch.h>
 
 #include "netutils/thttpd.h"
+#ifdef CONFIG_THTTPD_GENERATE_INDICES
+#  include "fsutils/dirscan.h"
+#endif
 
 #include "config.h"
 #include "timers.h"
@@ -1577,27 +1580,12 @@ done:
     }
 }
 
-/* qsort comparison routine. */
-
 #ifdef CONFIG_THTTPD_GENERATE_INDICES
-static int name_compare(FAR const void *a, FAR const void *b)
-{
-  return strcmp(*((FAR char **)a), *((FAR char **)b));
-}
-
 static void ls_child(int argc, char **argv)
 {
   FAR httpd_conn *hc = (FAR httpd_conn *)strtoul(argv[1], NULL, 16);
-  DIR *dirp;
-  struct dirent *de;
-  int namlen;
-  static int maxnames = 0;
-  int oldmax;
-  int nnames;
-  static char *names;
-  static char **nameptrs;
-  static char *name;
-  static size_t maxname = 0;
+  FAR struct dirscan_s *scan;
+  FAR const char *entname;
   static char *rname;
   static size_t maxrname = 0;
   static char *encrname;
@@ -1614,9 +1602,21 @@ static void ls_child(int argc, char **argv)
   char *fileclass;
   time_t now;
   char *timestr;
-  int i;
+  size_t i;
 
   httpd_unlisten(hc->hs);
+
+  /* Read and stat the directory entries, sorted by name */
+
+  scan = dirscan_open(hc->expnfilename, DIRSCAN_STAT);
+  if (scan == NULL)
+    {
+      nerr("ERROR: opendir %s: %d\n", hc->expnfilename, errno);
+      httpd_send_err(hc, 404, err404title, "", err404form, hc->encodedurl);
+      httpd_write_response(hc);
+      exit(1);
+    }
+
   send_mime(hc, 200, ok200title, "", "", "text/html; charset=%s",
             (off_t) - 1, hc->sb.st_mtime);
   httpd_write_response(hc);
@@ -1634,7 +1634,7 @@ static void ls_child(int argc, char **argv)
       INTERNALERROR("fdopen");
       httpd_send_err(hc, 500, err500title, "", err500form, hc->encodedurl);
       httpd_write_response(hc);
-      closedir(dirp);
+      dirscan_close(scan);
       exit(1);
     }
 
@@ -1649,88 +1649,35 @@ static void ls_child(int argc, char **argv)
   fputs(html_crlf, fp);
   fputs("<PRE>\r\nmode  links  bytes  last-changed  name\r\n<HR>", fp);
 
-  /* Read in names. */
-
-  nnames = 0;
-  while ((de = readdir(dirp)) != 0)     /* dirent or direct */
-    {
-      if (nnames >= maxnames)
-        {
-          if (maxnames == 0)
-            {
-              maxnames = 100;
-              names    = NEW(char, maxnames * PATH_MAX);
-              nameptrs = NEW(char *, maxnames);
-            }
-          else
-            {
-              oldmax    = maxnames;
-              maxnames *= 2;
-              names     = RENEW(names, char, oldmax * PATH_MAX,
-                                maxnames * PATH_MAX);
-              nameptrs  = RENEW(nameptrs, char *, oldmax, maxnames);
-            }
-
-          if (!names || !nameptrs)
-            {
-              nerr("ERROR: out of memory reallocating directory names\n");
-              exit(1);
-            }
-
-          for (i = 0; i < maxnames; ++i)
-            {
-              nameptrs[i] = &names[i * PATH_MAX];
-            }
-        }
-
-      strlcpy(nameptrs[nnames], de->d_name, PATH_MAX);
-      ++nnames;
-    }
-
-  closedir(dirp);
-
-  /* Sort the names. */
-
-  qsort(nameptrs, nnames, sizeof(*nameptrs), name_compare);
-
   /* Generate output. */
 
-  for (i = 0; i < nnames; ++i)
+  for (i = 0; i < scan->nentries; ++i)
     {
-      httpd_realloc_str(&name, &maxname,
-                        strlen(hc->expnfilename) + 1 +
-                        strlen(nameptrs[i]));
+      entname = scan->entries[i].name;
       httpd_realloc_str(&rname, &maxrname,
-                        strlen(hc->origfilename) + 1 +
-                        strlen(nameptrs[i]));
+                        strlen(hc->origfilename) + 1 + strlen(entname));
 
-      if (hc->expnfilename[0] == '\0' || strcmp(hc->expnfilename, ".") == 0)
+      if (hc->expnfilename[0] == '\0' ||
+          strcmp(hc->expnfilename, ".") == 0 ||
+          strcmp(hc->origfilename, ".") == 0)
         {
-          strlcpy(name, nameptrs[i], maxname + 1);
-          strlcpy(rname, nameptrs[i], maxrname + 1);
+          strlcpy(rname, entname, maxrname + 1);
         }
       else
         {
-          snprintf(name, maxname, "%s/%s", hc->expnfilename, nameptrs[i]);
-          if (strcmp(hc->origfilename, ".") == 0)
-            {
-              snprintf(rname, maxrname, "%s", nameptrs[i]);
-            }
-          else
-            {
-              snprintf(rname, maxrname, "%s%s",
-                       hc->origfilename, nameptrs[i]);
-            }
+          snprintf(rname, maxrname, "%s%s", hc->origfilename, entname);
         }
 
       httpd_realloc_str(&encrname, &maxencrname, 3 * strlen(rname) + 1);
       httpd_strencode(encrname, maxencrname, rname);
 
-      if (stat(name, &sb) < 0)
+      if (scan->entries[i].staterr != 0)
         {
           continue;
         }
 
+      sb = scan->entries[i].st;
+
       linkprefix = "";
       link[0] = '\0';
 
@@ -1836,10 +1783,12 @@ static void ls_child(int argc, char **argv)
       fprintf(fp,
               "%s %3ld  %10lld  %s  <A HREF=\"/%.500s%s\">%s</A>%s%s%s\n",
               modestr, 0, (int16_t)sb.st_size, timestr, encrname,
-              S_ISDIR(sb.st_mode) ? "/" : "", nameptrs[i], linkprefix,
+              S_ISDIR(sb.st_mode) ? "/" : "", entname, linkprefix,
               link, fileclass);
     }
 
+  dirscan_close(scan);
+
   fputs("</PRE>", fp);
   fputs(html_endbody, fp);
   fputs(html_endhtml, fp);
@@ -458,6 +458,9 @@
 #if !defined(CONFIG_FS_PROCFS) || defined(CONFIG_FS_PROCFS_EXCLUDE_PROCESS)
 #  undef  CONFIG_NSH_DISABLE_PS          /* 'ps' depends on process procfs */
 #  define CONFIG_NSH_DISABLE_PS 1
+
+#  undef  CONFIG_NSH_DISABLE_TOP         /* 'top' depends on process procfs */
+#  define CONFIG_NSH_DISABLE_TOP 1
 #endif
 
 #define NSH_HAVE_CPULOAD  1
@@ -513,6 +516,7 @@
 #define NSH_HAVE_FOREACH_DIRENTRY 1
 #define NSH_HAVE_TRIMDIR          1
 #define NSH_HAVE_TRIMSPACES       1
+#define NSH_HAVE_COPY             1
 
 #if !defined(CONFIG_FS_PROCFS) || defined(CONFIG_DISABLE_ENVIRON) || \
      defined(CONFIG_FS_PROCFS_EXCLUDE_ENVIRON) || !defined(NSH_HAVE_CATFILE)
@@ -543,12 +547,13 @@
 #endif
 
 /* nsh_foreach_direntry used by the commands:
- * ls, ps, fdinfo, rptun, pmconfig
+ * ps, top, fdinfo, rptun, rpmsg, pmconfig, pidof
  */
 
-#if defined(CONFIG_NSH_DISABLE_LS) && defined(CONFIG_NSH_DISABLE_PS) && \
+#if defined(CONFIG_NSH_DISABLE_PS) && defined(CONFIG_NSH_DISABLE_TOP) && \
     defined(CONFIG_NSH_DISABLE_RPTUN) && defined(CONFIG_NSH_DISABLE_PMCONFIG) && \
-    defined(CONFIG_NSH_DISABLE_FDINFO) && defined(CONFIG_NSH_DISABLE_PIDOF)
+    defined(CONFIG_NSH_DISABLE_FDINFO) && defined(CONFIG_NSH_DISABLE_PIDOF) && \
+    defined(CONFIG_NSH_DISABLE_RPMSG)
 #  undef NSH_HAVE_FOREACH_DIRENTRY
 #endif
 
@@ -556,6 +561,12 @@
 #  undef NSH_HAVE_TRIMDIR
 #endif
 
+/* nsh_copy used by the cp and dd commands */
+
+#if defined(CONFIG_NSH_DISABLE_CP) && defined(CONFIG_NSH_DISABLE_DD)
+#  undef NSH_HAVE_COPY
+#endif
+
 /* nsh_trimspaces used by the set and ps commands */
 
 #if defined(CONFIG_NSH_DISABLE_SET) && defined(CONFIG_NSH_DISABLE_PS)
@@ -723,6 +734,26 @@ typedef CODE int (*nsh_direntry_handler_t)(FAR struct nsh_vtbl_s *vtbl,
                                            FAR struct dirent *entryp,
                                            FAR void *pvarg);
 
+#ifdef NSH_HAVE_COPY
+/* Describes one transfer done by nsh_copy() */
+
+struct nsh_copy_s
+{
+  FAR const char *cmd;     /* Command name used in error reports */
+  int       infd;          /* File to copy from */
+  int       outfd;         /* File to copy to */
+  size_t    blksize;       /* Size of one read/write block */
+  uint32_t  maxblocks;     /* Blocks to copy, 0: up to the end of input */
+  bool      progress;      /* Report the throughput while copying */
+
+  /* Set by nsh_copy() */
+
+  uint32_t  nblocks;       /* Number of blocks written */
+  uint64_t  nbytes;        /* Number of bytes written */
+  uint64_t  elapsed;       /* Duration of the transfer in microseconds */
+};
+#endif
+
 #if defined(CONFIG_NSH_VARS) && !defined(CONFIG_NSH_DISABLE_SET)
 /* Used with nsh_foreach_var() */
 
@@ -924,6 +955,9 @@ void nsh_usbtrace(void);
 #ifndef CONFIG_NSH_DISABLE_PS
   int cmd_ps(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
+#ifndef CONFIG_NSH_DISABLE_TOP
+  int cmd_top(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_NSH_DISABLE_PIDOF)
   int cmd_pidof(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
@@ -1361,6 +1395,31 @@ int nsh_foreach_direntry(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                          nsh_direntry_handler_t handler, void *pvarg);
 #endif
 
+/****************************************************************************
+ * Name: nsh_copy
+ *
+ * Description:
+ *   Copy data between two open files.  Data is moved in blocks of
+ *   'blksize' bytes through aligned buffers.  If more than one buffer is
+ *   configured, a reader thread fills the next buffers while the current
+ *   one is written, so that the copy runs at the speed of the slower of
+ *   the two devices.
+ *
+ * Input Parameters:
+ *   vtbl - The console vtable
+ *   copy - Describes the transfer.  The nblocks, nbytes and elapsed
+ *          fields are updated on return.
+ *
+ * Returned Value:
+ *   Zero (OK) returned on success; -1 (ERROR) returned on failure.  The
+ *   failure has already been reported on the console.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_HAVE_COPY
+int nsh_copy(FAR struct nsh_vtbl_s *vtbl, FAR struct nsh_copy_s *copy);
+#endif
+
 /****************************************************************************
  * Name: nsh_getpid
  *
@@ -186,9 +186,10 @@ static const struct cmdmap_s g_cmdmap[] =
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_DD
-  CMD_MAP("dd",       cmd_dd,       3, 7,
+  CMD_MAP("dd",       cmd_dd,       3, 10,
     "if=<infile> of=<outfile> [bs=<sectsize>] [count=<sectors>] "
-    "[skip=<sectors>] [seek=<sectors>] [verify]"),
+    "[skip=<sectors>] [seek=<sectors>] [verify] [iflag=direct] "
+    "[oflag=direct] [status=progress]"),
 #endif
 
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ROUTE) && !defined(CONFIG_NSH_DISABLE_DELROUTE)
@@ -598,6 +599,12 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("timedatectl", cmd_timedatectl, 1, 3, "[set-timezone TZ]"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_TOP
+  CMD_MAP("top",      cmd_top,      1, 11,
+    "[-b] [-d <secs>] [-n <count>] [-l <lines>] "
+    "[-s cpu|pid|pri|stack|heap|name]"),
+#endif
+
 #ifndef CONFIG_NSH_DISABLESCRIPT
   CMD_MAP("true",     cmd_true,     1, 1, NULL),
 #endif
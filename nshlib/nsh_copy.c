@@ -0,0 +1,527 @@
+/****************************************************************************
+ * apps/nshlib/nsh_copy.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <nuttx/clock.h>
+
+#include <sys/types.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+
+#ifndef CONFIG_DISABLE_PTHREAD
+#  include <pthread.h>
+#  include <semaphore.h>
+#endif
+
+#include "nsh.h"
+#include "nsh_console.h"
+
+#ifdef NSH_HAVE_COPY
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* With more than one buffer, a reader thread fills the free buffers while
+ * the calling thread writes out the full ones.
+ */
+
+#if CONFIG_NSH_CMDOPT_COPY_NBUFFERS > 1 && !defined(CONFIG_DISABLE_PTHREAD)
+#  define NSH_COPY_ASYNC 1
+#  define NSH_COPY_NBUFFERS CONFIG_NSH_CMDOPT_COPY_NBUFFERS
+#else
+#  define NSH_COPY_NBUFFERS 1
+#endif
+
+/* Interval between two progress reports */
+
+#define NSH_COPY_PROGRESS_USEC USEC_PER_SEC
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One copy buffer */
+
+struct nsh_copybuf_s
+{
+  FAR uint8_t *data;               /* Block data (aligned) */
+  ssize_t nbytes;                  /* >0: valid bytes, 0: EOF, <0: -errno */
+};
+
+/* State shared by the reader and the writer */
+
+struct nsh_copyctx_s
+{
+  FAR struct nsh_vtbl_s *vtbl;
+  FAR struct nsh_copy_s *copy;
+  struct nsh_copybuf_s bufs[NSH_COPY_NBUFFERS];
+#ifdef NSH_COPY_ASYNC
+  sem_t freesem;                   /* Counts buffers ready to be filled */
+  sem_t fullsem;                   /* Counts buffers ready to be written */
+  volatile bool abort;             /* The writer gave up */
+#endif
+  struct timespec start;           /* Start of the transfer */
+  uint64_t lastreport;             /* Time of the last progress report */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: copy_elapsed
+ *
+ * Description:
+ *   Return the time in microseconds since the transfer was started.
+ *
+ ****************************************************************************/
+
+static uint64_t copy_elapsed(FAR struct nsh_copyctx_s *ctx)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - ctx->start.tv_sec) * USEC_PER_SEC +
+         (now.tv_nsec - ctx->start.tv_nsec) / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: copy_report
+ ****************************************************************************/
+
+static void copy_report(FAR struct nsh_copyctx_s *ctx, uint64_t elapsed)
+{
+  FAR struct nsh_copy_s *copy = ctx->copy;
+  uint64_t rate = 0;
+
+  if (elapsed > 0)
+    {
+      rate = copy->nbytes * USEC_PER_SEC / 1024 / elapsed;
+    }
+
+  nsh_output(ctx->vtbl, "\r%" PRIu64 " bytes copied, %" PRIu64 ".%03u s, "
+             "%" PRIu64 " KB/s", copy->nbytes, elapsed / USEC_PER_SEC,
+             (unsigned int)(elapsed % USEC_PER_SEC / USEC_PER_MSEC), rate);
+}
+
+/****************************************************************************
+ * Name: copy_readblock
+ *
+ * Description:
+ *   Read one full block unless the end of the input is reached first.
+ *   Returns the number of bytes read, zero at the end of the input, or a
+ *   negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static ssize_t copy_readblock(int fd, FAR uint8_t *buffer, size_t blksize)
+{
+  size_t total = 0;
+  ssize_t nbytes;
+
+  do
+    {
+      nbytes = read(fd, &buffer[total], blksize - total);
+      if (nbytes < 0)
+        {
+          return -errno;
+        }
+
+      total += nbytes;
+    }
+  while (total < blksize && nbytes > 0);
+
+  return total;
+}
+
+/****************************************************************************
+ * Name: copy_writeblock
+ ****************************************************************************/
+
+static int copy_writeblock(int fd, FAR const uint8_t *buffer, size_t nbytes)
+{
+  ssize_t written;
+
+  while (nbytes > 0)
+    {
+      written = write(fd, buffer, nbytes);
+      if (written < 0)
+        {
+          return -errno;
+        }
+
+      buffer += written;
+      nbytes -= written;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: copy_fillbuffer
+ *
+ * Description:
+ *   Fill the next buffer from the input, honouring the block limit.
+ *
+ ****************************************************************************/
+
+static void copy_fillbuffer(FAR struct nsh_copyctx_s *ctx,
+                            FAR struct nsh_copybuf_s *buf, uint32_t block)
+{
+  FAR struct nsh_copy_s *copy = ctx->copy;
+
+  if (copy->maxblocks > 0 && block >= copy->maxblocks)
+    {
+      buf->nbytes = 0;
+    }
+  else
+    {
+      buf->nbytes = copy_readblock(copy->infd, buf->data, copy->blksize);
+    }
+}
+
+/****************************************************************************
+ * Name: copy_error
+ ****************************************************************************/
+
+static void copy_error(FAR struct nsh_copyctx_s *ctx,
+                       FAR const char *op, int errcode)
+{
+  FAR struct nsh_vtbl_s *vtbl = ctx->vtbl;
+
+  /* EINTR is not an error (but will still stop the copy) */
+
+  if (errcode == EINTR)
+    {
+      nsh_error(vtbl, g_fmtsignalrecvd, ctx->copy->cmd);
+    }
+  else
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, ctx->copy->cmd, op,
+                NSH_ERRNO_OF(errcode));
+    }
+
+  UNUSED(vtbl);
+}
+
+/****************************************************************************
+ * Name: copy_drain
+ *
+ * Description:
+ *   Write out one full buffer.  Returns 1 if the copy should go on, 0 at
+ *   the end of the input, or ERROR on failure.
+ *
+ ****************************************************************************/
+
+static int copy_drain(FAR struct nsh_copyctx_s *ctx,
+                      FAR struct nsh_copybuf_s *buf)
+{
+  FAR struct nsh_copy_s *copy = ctx->copy;
+  uint64_t elapsed;
+  int ret;
+
+  if (buf->nbytes < 0)
+    {
+      copy_error(ctx, "read", -buf->nbytes);
+      return ERROR;
+    }
+  else if (buf->nbytes == 0)
+    {
+      return 0;
+    }
+
+  ret = copy_writeblock(copy->outfd, buf->data, buf->nbytes);
+  if (ret < 0)
+    {
+      copy_error(ctx, "write", -ret);
+      return ERROR;
+    }
+
+  copy->nblocks++;
+  copy->nbytes += buf->nbytes;
+
+  if (copy->progress)
+    {
+      elapsed = copy_elapsed(ctx);
+      if (elapsed - ctx->lastreport >= NSH_COPY_PROGRESS_USEC)
+        {
+          ctx->lastreport = elapsed;
+          copy_report(ctx, elapsed);
+        }
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * Name: copy_sync
+ *
+ * Description:
+ *   Alternate reads and writes on a single buffer.
+ *
+ ****************************************************************************/
+
+static int copy_sync(FAR struct nsh_copyctx_s *ctx)
+{
+  FAR struct nsh_copybuf_s *buf = &ctx->bufs[0];
+  uint32_t block;
+  int ret;
+
+  for (block = 0; ; block++)
+    {
+      copy_fillbuffer(ctx, buf, block);
+      ret = copy_drain(ctx, buf);
+      if (ret <= 0)
+        {
+          return ret;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: copy_semwait
+ ****************************************************************************/
+
+#ifdef NSH_COPY_ASYNC
+static int copy_semwait(FAR sem_t *sem, bool interruptible)
+{
+  while (sem_wait(sem) < 0)
+    {
+      if (errno != EINTR || interruptible)
+        {
+          return -errno;
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: copy_reader
+ *
+ * Description:
+ *   Reader thread: fill each free buffer in turn until the end of the
+ *   input, a read error or until the writer aborts.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_COPY_ASYNC
+static FAR void *copy_reader(FAR void *arg)
+{
+  FAR struct nsh_copyctx_s *ctx = arg;
+  FAR struct nsh_copybuf_s *buf;
+  uint32_t block;
+
+  for (block = 0; ; block++)
+    {
+      copy_semwait(&ctx->freesem, false);
+      if (ctx->abort)
+        {
+          break;
+        }
+
+      buf = &ctx->bufs[block % NSH_COPY_NBUFFERS];
+      copy_fillbuffer(ctx, buf, block);
+      sem_post(&ctx->fullsem);
+
+      if (buf->nbytes <= 0)
+        {
+          break;
+        }
+    }
+
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: copy_async
+ *
+ * Description:
+ *   Let a reader thread fill the buffers while this thread writes them
+ *   out, so that both devices stay busy.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_COPY_ASYNC
+static int copy_async(FAR struct nsh_copyctx_s *ctx)
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  pthread_t reader;
+  uint32_t block;
+  int ret;
+
+  sem_init(&ctx->freesem, 0, NSH_COPY_NBUFFERS);
+  sem_init(&ctx->fullsem, 0, 0);
+
+  /* Run the reader at the priority of the shell */
+
+  pthread_attr_init(&attr);
+  if (sched_getparam(0, &param) == 0)
+    {
+      pthread_attr_setschedparam(&attr, &param);
+    }
+
+  ret = pthread_create(&reader, &attr, copy_reader, ctx);
+  pthread_attr_destroy(&attr);
+  if (ret != 0)
+    {
+      /* Still do the copy, just without overlapping the I/O */
+
+      ret = copy_sync(ctx);
+      goto errout_with_sem;
+    }
+
+  pthread_setname_np(reader, "nsh_copy");
+
+  for (block = 0; ; block++)
+    {
+      /* Control-C interrupts the wait for the reader */
+
+      ret = copy_semwait(&ctx->fullsem, true);
+      if (ret < 0)
+        {
+          copy_error(ctx, "sem_wait", -ret);
+          ret = ERROR;
+          break;
+        }
+
+      ret = copy_drain(ctx, &ctx->bufs[block % NSH_COPY_NBUFFERS]);
+      if (ret <= 0)
+        {
+          break;
+        }
+
+      sem_post(&ctx->freesem);
+    }
+
+  /* Wake the reader up if it is still waiting for a free buffer.  After
+   * Control-C or an error it may instead be blocked in read() on an input
+   * that delivers nothing more (a console or a pipe), so cancel it: both
+   * read() and sem_wait() are cancellation points.
+   */
+
+  ctx->abort = true;
+  sem_post(&ctx->freesem);
+  if (ret < 0)
+    {
+      pthread_cancel(reader);
+    }
+
+  pthread_join(reader, NULL);
+
+errout_with_sem:
+  sem_destroy(&ctx->fullsem);
+  sem_destroy(&ctx->freesem);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nsh_copy
+ *
+ * Description:
+ *   Copy data between two open files as described by 'copy'.
+ *
+ ****************************************************************************/
+
+int nsh_copy(FAR struct nsh_vtbl_s *vtbl, FAR struct nsh_copy_s *copy)
+{
+  struct nsh_copyctx_s ctx;
+  FAR uint8_t *data;
+  size_t bufsize;
+  int ret;
+  int i;
+
+  copy->nblocks = 0;
+  copy->nbytes  = 0;
+  copy->elapsed = 0;
+
+  if (copy->blksize == 0)
+    {
+      nsh_error(vtbl, g_fmtarginvalid, copy->cmd);
+      return ERROR;
+    }
+
+  /* All buffers come from one allocation.  Each one starts on an aligned
+   * boundary so that block drivers can transfer directly from and to it,
+   * which matters most for files opened with O_DIRECT.
+   */
+
+  bufsize = (copy->blksize + CONFIG_NSH_CMDOPT_COPY_ALIGN - 1) /
+            CONFIG_NSH_CMDOPT_COPY_ALIGN * CONFIG_NSH_CMDOPT_COPY_ALIGN;
+  data = memalign(CONFIG_NSH_CMDOPT_COPY_ALIGN,
+                  bufsize * NSH_COPY_NBUFFERS);
+  if (data == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, copy->cmd);
+      return ERROR;
+    }
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.vtbl = vtbl;
+  ctx.copy = copy;
+
+  for (i = 0; i < NSH_COPY_NBUFFERS; i++)
+    {
+      ctx.bufs[i].data = &data[i * bufsize];
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &ctx.start);
+
+#ifdef NSH_COPY_ASYNC
+  ret = copy_async(&ctx);
+#else
+  ret = copy_sync(&ctx);
+#endif
+
+  copy->elapsed = copy_elapsed(&ctx);
+  if (copy->progress)
+    {
+      copy_report(&ctx, copy->elapsed);
+      nsh_output(vtbl, "\n");
+    }
+
+  free(data);
+  return ret < 0 ? ERROR : OK;
+}
+
+#endif /* NSH_HAVE_COPY */
@@ -78,46 +78,18 @@ struct dd_s
   uint32_t     seek;       /* The number of bytes skipped on output */
   bool         eof;        /* true: The end of the input or output file has been hit */
   bool         verify;     /* true: Verify infile and outfile correctness */
+  bool         progress;   /* true: Report the throughput while copying */
+  int          iflags;     /* Extra open flags for the input file */
+  int          oflags;     /* Extra open flags for the output file */
   size_t       sectsize;   /* Size of one sector */
   size_t       nbytes;     /* Number of valid bytes in the buffer */
-  FAR uint8_t *buffer;     /* Buffer of data to write to the output file */
+  FAR uint8_t *buffer;     /* Buffer of input data used by verify */
 };
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************
- * Name: dd_write
- ****************************************************************************/
-
-static int dd_write(FAR struct dd_s *dd)
-{
-  FAR uint8_t *buffer = dd->buffer;
-  size_t written;
-  ssize_t nbytes;
-
-  /* Is the out buffer full (or is this the last one)? */
-
-  written = 0;
-  do
-    {
-      nbytes = write(dd->outfd, buffer, dd->nbytes - written);
-      if (nbytes < 0)
-        {
-          FAR struct nsh_vtbl_s *vtbl = dd->vtbl;
-          nsh_error(vtbl, g_fmtcmdfailed, g_dd, "write", NSH_ERRNO);
-          return ERROR;
-        }
-
-      written += nbytes;
-      buffer  += nbytes;
-    }
-  while (written < dd->nbytes);
-
-  return OK;
-}
-
 /****************************************************************************
  * Name: dd_read
  ****************************************************************************/
@@ -153,7 +125,7 @@ static int dd_read(FAR struct dd_s *dd)
 
 static inline int dd_infopen(FAR const char *name, FAR struct dd_s *dd)
 {
-  dd->infd = open(name, O_RDONLY);
+  dd->infd = open(name, O_RDONLY | dd->iflags);
   if (dd->infd < 0)
     {
       FAR struct nsh_vtbl_s *vtbl = dd->vtbl;
@@ -171,7 +143,7 @@ static inline int dd_infopen(FAR const char *name, FAR struct dd_s *dd)
 static inline int dd_outfopen(FAR const char *name, FAR struct dd_s *dd)
 {
   dd->outfd = open(name, (dd->verify ? O_RDWR : O_WRONLY) |
-                          O_CREAT | O_TRUNC, 0644);
+                          O_CREAT | O_TRUNC | dd->oflags, 0644);
   if (dd->outfd < 0)
     {
       FAR struct nsh_vtbl_s *vtbl = dd->vtbl;
@@ -263,16 +235,10 @@ static int dd_verify(FAR const char *infile, FAR const char *outfile,
 
 int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 {
+  struct nsh_copy_s copy;
   struct dd_s dd;
   FAR char *infile = NULL;
   FAR char *outfile = NULL;
-#ifdef CONFIG_NSH_CMDOPT_DD_STATS
-  struct timespec ts0;
-  struct timespec ts1;
-  uint64_t elapsed;
-  uint64_t total;
-#endif
-  uint32_t sector = 0;
   int ret = ERROR;
   int i;
 
@@ -341,6 +307,18 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
         {
           dd.verify = true;
         }
+      else if (strcmp(argv[i], "iflag=direct") == 0)
+        {
+          dd.iflags |= O_DIRECT;
+        }
+      else if (strcmp(argv[i], "oflag=direct") == 0)
+        {
+          dd.oflags |= O_DIRECT;
+        }
+      else if (strcmp(argv[i], "status=progress") == 0)
+        {
+          dd.progress = true;
+        }
     }
 
 #ifndef CAN_PIPE_FROM_STD
@@ -351,13 +329,16 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
     }
 #endif
 
-  /* Allocate the I/O buffer */
+  /* Allocate the buffer used to verify the copy */
 
-  dd.buffer = malloc(dd.sectsize);
-  if (!dd.buffer)
+  if (dd.verify)
     {
-      nsh_error(vtbl, g_fmtcmdoutofmemory, g_dd);
-      goto errout_with_paths;
+      dd.buffer = malloc(dd.sectsize);
+      if (!dd.buffer)
+        {
+          nsh_error(vtbl, g_fmtcmdoutofmemory, g_dd);
+          goto errout_with_paths;
+        }
     }
 
   /* Open the input file */
@@ -378,10 +359,6 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
   /* Then perform the data transfer */
 
-#ifdef CONFIG_NSH_CMDOPT_DD_STATS
-  clock_gettime(CLOCK_MONOTONIC, &ts0);
-#endif
-
   if (dd.skip)
     {
       ret = lseek(dd.infd, dd.skip * dd.sectsize, SEEK_SET);
@@ -404,50 +381,26 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
         }
     }
 
-  while (!dd.eof && sector < dd.nsectors)
-    {
-      /* Read one sector from from the input */
-
-      ret = dd_read(&dd);
-      if (ret < 0)
-        {
-          goto errout_with_outf;
-        }
-
-      /* Has the incoming data stream ended? */
+  memset(&copy, 0, sizeof(copy));
+  copy.cmd       = g_dd;
+  copy.infd      = dd.infd;
+  copy.outfd     = dd.outfd;
+  copy.blksize   = dd.sectsize;
+  copy.maxblocks = dd.nsectors;
+  copy.progress  = dd.progress;
 
-      if (!dd.eof)
-        {
-          /* Write one sector to the output file */
-
-          ret = dd_write(&dd);
-          if (ret < 0)
-            {
-              goto errout_with_outf;
-            }
-
-          /* Increment the sector number */
-
-          sector++;
-        }
+  ret = dd.nsectors > 0 ? nsh_copy(vtbl, &copy) : OK;
+  if (ret < 0)
+    {
+      goto errout_with_outf;
     }
 
-  ret = OK;
-
 #ifdef CONFIG_NSH_CMDOPT_DD_STATS
-  clock_gettime(CLOCK_MONOTONIC, &ts1);
-
-  elapsed  = (((uint64_t)ts1.tv_sec * NSEC_PER_SEC) + ts1.tv_nsec);
-  elapsed -= (((uint64_t)ts0.tv_sec * NSEC_PER_SEC) + ts0.tv_nsec);
-  elapsed /= NSEC_PER_USEC; /* usec */
-
-  total = ((uint64_t)sector * (uint64_t)dd.sectsize);
-
   nsh_output(vtbl, "%llu bytes copied, %u usec, ",
-             total, (unsigned int)elapsed);
+             (unsigned long long)copy.nbytes, (unsigned int)copy.elapsed);
   nsh_output(vtbl, "%u KB/s\n" ,
-             (unsigned int)(((double)total / 1024)
-             / ((double)elapsed / USEC_PER_SEC)));
+             (unsigned int)(((double)copy.nbytes / 1024)
+             / ((double)copy.elapsed / USEC_PER_SEC)));
 #endif
 
   if (ret == 0 && dd.verify)
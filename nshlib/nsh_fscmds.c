@@ -75,6 +75,10 @@
 #  include "fsutils/mkfatfs.h"
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_LS
+#  include "fsutils/dirscan.h"
+#endif
+
 #include "nsh.h"
 #include "nsh_console.h"
 
@@ -104,6 +108,7 @@
 static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
                       FAR const char *destpath)
 {
+  struct nsh_copy_s copy;
   struct stat buf;
   FAR char *allocpath = NULL;
   int oflags = O_WRONLY | O_CREAT | O_TRUNC;
@@ -161,70 +166,15 @@ static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
       goto errout_with_allocpath;
     }
 
-  for (; ; )
-    {
-      int nbytesread;
-      int nbyteswritten;
-      FAR char *iobuffer = vtbl->iobuffer;
-
-      nbytesread = read(rdfd, iobuffer, IOBUFFERSIZE);
-      if (nbytesread == 0)
-        {
-          /* End of file */
-
-          ret = OK;
-          goto errout_with_wrfd;
-        }
-      else if (nbytesread < 0)
-        {
-          /* EINTR is not an error (but will still stop the copy) */
-
-          if (errno == EINTR)
-            {
-              nsh_error(vtbl, g_fmtsignalrecvd, "cp");
-            }
-          else
-            {
-              /* Read error */
-
-              nsh_error(vtbl, g_fmtcmdfailed, "cp", "read",
-                        NSH_ERRNO);
-            }
-
-          goto errout_with_wrfd;
-        }
-
-      do
-        {
-          nbyteswritten = write(wrfd, iobuffer, nbytesread);
-          if (nbyteswritten >= 0)
-            {
-              nbytesread -= nbyteswritten;
-              iobuffer += nbyteswritten;
-            }
-          else
-            {
-              /* EINTR is not an error (but will still stop the copy) */
-
-              if (errno == EINTR)
-                {
-                  nsh_error(vtbl, g_fmtsignalrecvd, "cp");
-                }
-              else
-                {
-                  /* Read error */
+  /* Copy through the shared copy engine */
 
-                  nsh_error(vtbl, g_fmtcmdfailed, "cp", "write",
-                            NSH_ERRNO);
-                }
+  memset(&copy, 0, sizeof(copy));
+  copy.cmd     = "cp";
+  copy.infd    = rdfd;
+  copy.outfd   = wrfd;
+  copy.blksize = CONFIG_NSH_CMDOPT_COPY_BUFSIZE;
 
-              goto errout_with_wrfd;
-            }
-        }
-      while (nbytesread > 0);
-    }
-
-errout_with_wrfd:
+  ret = nsh_copy(vtbl, &copy);
   close(wrfd);
 
 errout_with_allocpath:
@@ -342,44 +292,32 @@ static inline int ls_specialdir(FAR const char *dir)
 
 /****************************************************************************
  * Name: ls_handler
+ *
+ * Description:
+ *   Show one entry of a listing.  A single file is passed as an entry that
+ *   is named by its path and has no type.
+ *
  ****************************************************************************/
 
 #if !defined(CONFIG_NSH_DISABLE_LS)
-static int ls_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
-                      FAR struct dirent *entryp, FAR void *pvarg)
+static int ls_handler(FAR struct nsh_vtbl_s *vtbl,
+                      FAR const struct dirscan_entry_s *entry,
+                      unsigned int lsflags)
 {
-  unsigned int lsflags = (unsigned int)((uintptr_t)pvarg);
 #ifdef CONFIG_PSEUDOFS_SOFTLINKS
   bool isdir = false;
 #endif
-  int ret;
 
   /* Check if any options will require that we stat the file */
 
   if ((lsflags & (LSFLAGS_SIZE | LSFLAGS_LONG | LSFLAGS_UID_GID)) != 0)
     {
-      struct stat buf;
-
-      memset(&buf, 0, sizeof(struct stat));
-
-      /* stat the file */
-
-      if (entryp != NULL)
-        {
-          FAR char *fullpath = nsh_getdirpath(vtbl, dirpath, entryp->d_name);
-          ret = stat(fullpath, &buf);
-          free(fullpath);
-        }
-      else
-        {
-          /* NULL entry signifies that we are running ls on a single file */
-
-          ret = stat(dirpath, &buf);
-        }
+      FAR const struct stat *buf = &entry->st;
 
-      if (ret != 0)
+      if (entry->staterr != 0)
         {
-          nsh_error(vtbl, g_fmtcmdfailed, "ls", "stat", NSH_ERRNO);
+          nsh_error(vtbl, g_fmtcmdfailed, "ls", "stat",
+                    NSH_ERRNO_OF(entry->staterr));
           return ERROR;
         }
 
@@ -388,117 +326,117 @@ static int ls_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
           char details[] = "----------";
 
 #ifdef CONFIG_PSEUDOFS_SOFTLINKS
-          if (S_ISLNK(buf.st_mode))
+          if (S_ISLNK(buf->st_mode))
             {
               details[0] = 'l';  /* Takes precedence over type of the target */
-              isdir = S_ISDIR(buf.st_mode);
+              isdir = S_ISDIR(buf->st_mode);
             }
           else
 #endif
-          if (S_ISBLK(buf.st_mode))
+          if (S_ISBLK(buf->st_mode))
             {
               details[0] = 'b';
             }
-          else if (S_ISCHR(buf.st_mode))
+          else if (S_ISCHR(buf->st_mode))
             {
               details[0] = 'c';
             }
-          else if (S_ISDIR(buf.st_mode))
+          else if (S_ISDIR(buf->st_mode))
             {
               details[0] = 'd';
             }
 #ifdef CONFIG_MTD
-          else if (S_ISMTD(buf.st_mode))
+          else if (S_ISMTD(buf->st_mode))
             {
               details[0] = 'f';
             }
 #endif
 #ifdef CONFIG_FS_SHMFS
-          else if (S_ISSHM(buf.st_mode))
+          else if (S_ISSHM(buf->st_mode))
             {
               details[0] = 'h';
             }
 #endif
 #ifndef CONFIG_DISABLE_MQUEUE
-          else if (S_ISMQ(buf.st_mode))
+          else if (S_ISMQ(buf->st_mode))
             {
               details[0] = 'm';
             }
 #endif
 #ifdef CONFIG_NET
-          else if (S_ISSOCK(buf.st_mode))
+          else if (S_ISSOCK(buf->st_mode))
             {
               details[0] = 'n';
             }
 #endif
 #ifdef CONFIG_FS_NAMED_SEMAPHORES
-          else if (S_ISSEM(buf.st_mode))
+          else if (S_ISSEM(buf->st_mode))
             {
               details[0] = 's';
             }
 #endif
-          else if (!S_ISREG(buf.st_mode))
+          else if (!S_ISREG(buf->st_mode))
             {
               details[0] = '?';
             }
 
-          if ((buf.st_mode & S_IRUSR) != 0)
+          if ((buf->st_mode & S_IRUSR) != 0)
             {
               details[1] = 'r';
             }
 
-          if ((buf.st_mode & S_IWUSR) != 0)
+          if ((buf->st_mode & S_IWUSR) != 0)
             {
               details[2] = 'w';
             }
 
-          if ((buf.st_mode & S_IXUSR) != 0 && (buf.st_mode & S_ISUID) != 0)
+          if ((buf->st_mode & S_IXUSR) != 0 && (buf->st_mode & S_ISUID) != 0)
             {
               details[3] = 's';
             }
-          else if ((buf.st_mode & S_ISUID) != 0)
+          else if ((buf->st_mode & S_ISUID) != 0)
             {
               details[3] = 'S';
             }
-          else if ((buf.st_mode & S_IXUSR) != 0)
+          else if ((buf->st_mode & S_IXUSR) != 0)
             {
               details[3] = 'x';
             }
 
-          if ((buf.st_mode & S_IRGRP) != 0)
+          if ((buf->st_mode & S_IRGRP) != 0)
             {
               details[4] = 'r';
             }
 
-          if ((buf.st_mode & S_IWGRP) != 0)
+          if ((buf->st_mode & S_IWGRP) != 0)
             {
               details[5] = 'w';
             }
 
-          if ((buf.st_mode & S_IXGRP) != 0 && (buf.st_mode & S_ISGID) != 0)
+          if ((buf->st_mode & S_IXGRP) != 0 && (buf->st_mode & S_ISGID) != 0)
             {
               details[6] = 's';
             }
-          else if ((buf.st_mode & S_ISGID) != 0)
+          else if ((buf->st_mode & S_ISGID) != 0)
             {
               details[6] = 'S';
             }
-          else if ((buf.st_mode & S_IXGRP) != 0)
+          else if ((buf->st_mode & S_IXGRP) != 0)
             {
               details[6] = 'x';
             }
 
-          if ((buf.st_mode & S_IROTH) != 0)
+          if ((buf->st_mode & S_IROTH) != 0)
             {
               details[7] = 'r';
             }
 
-          if ((buf.st_mode & S_IWOTH) != 0)
+          if ((buf->st_mode & S_IWOTH) != 0)
             {
               details[8] = 'w';
             }
 
-          if ((buf.st_mode & S_IXOTH) != 0)
+          if ((buf->st_mode & S_IXOTH) != 0)
             {
               details[9] = 'x';
             }
@@ -509,85 +447,69 @@ static int ls_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
 #ifdef CONFIG_SCHED_USER_IDENTITY
       if ((lsflags & LSFLAGS_UID_GID) != 0)
         {
-          nsh_output(vtbl, "%8d", buf.st_uid);
-          nsh_output(vtbl, "%8d", buf.st_gid);
+          nsh_output(vtbl, "%8d", buf->st_uid);
+          nsh_output(vtbl, "%8d", buf->st_gid);
         }
 #endif
 
       if ((lsflags & LSFLAGS_SIZE) != 0)
         {
-          if (lsflags & LSFLAGS_HUMANREADBLE && buf.st_size >= KB)
+          if (lsflags & LSFLAGS_HUMANREADBLE && buf->st_size >= KB)
             {
-              if (buf.st_size >= GB)
+              if (buf->st_size >= GB)
                 {
-                  nsh_output(vtbl, "%11.1fG", (float)buf.st_size / GB);
+                  nsh_output(vtbl, "%11.1fG", (float)buf->st_size / GB);
                 }
-              else if (buf.st_size >= MB)
+              else if (buf->st_size >= MB)
                 {
-                  nsh_output(vtbl, "%11.1fM", (float)buf.st_size / MB);
+                  nsh_output(vtbl, "%11.1fM", (float)buf->st_size / MB);
                 }
               else
                 {
-                  nsh_output(vtbl, "%11.1fK", (float)buf.st_size / KB);
+                  nsh_output(vtbl, "%11.1fK", (float)buf->st_size / KB);
                 }
             }
           else
             {
-              nsh_output(vtbl, "%12" PRIdOFF, buf.st_size);
+              nsh_output(vtbl, "%12" PRIdOFF, buf->st_size);
             }
         }
     }
 
   /* Then provide the filename that is common to normal and verbose output */
 
-  if (entryp != NULL)
-    {
-      nsh_output(vtbl, " %s", entryp->d_name);
+  nsh_output(vtbl, " %s", entry->name);
 
 #ifdef CONFIG_PSEUDOFS_SOFTLINKS
-      if (DIRENT_ISLINK(entryp->d_type))
-        {
-          FAR char *fullpath;
-          ssize_t len;
-
-          /* Get the target of the symbolic link */
-
-          fullpath = nsh_getdirpath(vtbl, dirpath, entryp->d_name);
-          len = readlink(fullpath, vtbl->iobuffer, IOBUFFERSIZE);
-          free(fullpath);
-
-          if (len < 0)
-            {
-              nsh_error(vtbl, g_fmtcmdfailed, "ls", "readlink", NSH_ERRNO);
-              return ERROR;
-            }
+  if (DIRENT_ISLINK(entry->type))
+    {
+      /* Show the target of the symbolic link */
 
-          if (isdir)
-            {
-              nsh_output(vtbl, "/ ->%s\n", vtbl->iobuffer);
-            }
-          else
-            {
-              nsh_output(vtbl, " ->%s\n", vtbl->iobuffer);
-            }
+      if (entry->link == NULL)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, "ls", "readlink",
+                    NSH_ERRNO_OF(entry->linkerr));
+          return ERROR;
         }
-      else
-#endif
-      if (DIRENT_ISDIRECTORY(entryp->d_type) &&
-          !ls_specialdir(entryp->d_name))
+
+      if (isdir)
         {
-          nsh_output(vtbl, "/\n");
+          nsh_output(vtbl, "/ ->%s\n", entry->link);
         }
       else
         {
-          nsh_output(vtbl, "\n");
+          nsh_output(vtbl, " ->%s\n", entry->link);
         }
     }
   else
+#endif
+  if (DIRENT_ISDIRECTORY(entry->type) && !ls_specialdir(entry->name))
     {
-      /* A single file */
-
-      nsh_output(vtbl, " %s\n", dirpath);
+      nsh_output(vtbl, "/\n");
+    }
+  else
+    {
+      nsh_output(vtbl, "\n");
     }
 
   return OK;
@@ -595,42 +517,69 @@ static int ls_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
 #endif
 
 /****************************************************************************
- * Name: ls_recursive
+ * Name: ls_listdir
+ *
+ * Description:
+ *   List a directory in name order and, with -R, the directories within it.
+ *
  ****************************************************************************/
 
 #if !defined(CONFIG_NSH_DISABLE_LS)
-static int ls_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
-                        FAR struct dirent *entryp, FAR void *pvarg)
+static int ls_listdir(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
+                      unsigned int lsflags)
 {
+  FAR const struct dirscan_entry_s *entry;
+  FAR struct dirscan_s *scan;
+  FAR char *newpath;
+  unsigned int flags = 0;
   int ret = OK;
+  size_t i;
 
-  /* Is this entry a directory (not a special directories, e.g. . and ..)? */
-
-  if (DIRENT_ISDIRECTORY(entryp->d_type) && !ls_specialdir(entryp->d_name))
+  if ((lsflags & (LSFLAGS_SIZE | LSFLAGS_LONG | LSFLAGS_UID_GID)) != 0)
     {
-      /* Yes.. */
+      flags |= DIRSCAN_STAT;
+    }
+
+#ifdef CONFIG_PSEUDOFS_SOFTLINKS
+  flags |= DIRSCAN_READLINK;
+#endif
 
-      FAR char *newpath;
-      newpath = nsh_getdirpath(vtbl, dirpath, entryp->d_name);
+  nsh_output(vtbl, "%s:\n", dirpath);
 
-      /* List the directory contents */
+  scan = dirscan_open(dirpath, flags);
+  if (scan == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, "ls", "opendir", NSH_ERRNO);
+      return ERROR;
+    }
 
-      nsh_output(vtbl, "%s:\n", newpath);
+  for (i = 0; i < scan->nentries && ret == OK; i++)
+    {
+      ret = ls_handler(vtbl, &scan->entries[i], lsflags);
+    }
 
-      /* Traverse the directory  */
+  /* Then recurse to list each directory within the directory */
 
-      ret = nsh_foreach_direntry(vtbl, "ls", newpath, ls_handler, pvarg);
-      if (ret == 0)
+  for (i = 0; i < scan->nentries && ret == OK &&
+              (lsflags & LSFLAGS_RECURSIVE) != 0; i++)
+    {
+      entry = &scan->entries[i];
+      if (DIRENT_ISDIRECTORY(entry->type) && !ls_specialdir(entry->name))
         {
-          /* Then recurse to list each directory within the directory */
+          newpath = nsh_getdirpath(vtbl, dirpath, entry->name);
+          if (newpath == NULL)
+            {
+              nsh_error(vtbl, g_fmtcmdoutofmemory, "ls");
+              ret = ERROR;
+              break;
+            }
 
-          ret = nsh_foreach_direntry(vtbl, "ls", newpath, ls_recursive,
-                                     pvarg);
+          ret = ls_listdir(vtbl, newpath, lsflags);
+          free(newpath);
         }
-
-      free(newpath);
     }
 
+  dirscan_close(scan);
   return ret;
 }
 
@@ -1585,28 +1534,21 @@ int cmd_ls(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
     }
   else if (!S_ISDIR(st.st_mode))
     {
-      /* Pass a null dirent to ls_handler to signify that this is a single
-       * file
-       */
+      /* A single file is shown by its path */
 
-      ret = ls_handler(vtbl, fullpath, NULL,
-                       (FAR void *)((uintptr_t)lsflags));
+      struct dirscan_entry_s entry;
+
+      memset(&entry, 0, sizeof(entry));
+      entry.name = fullpath;
+      entry.st   = st;
+
+      ret = ls_handler(vtbl, &entry, lsflags);
     }
   else
     {
       /* List the directory contents */
 
-      nsh_output(vtbl, "%s:\n", fullpath);
-
-      ret = nsh_foreach_direntry(vtbl, "ls", fullpath, ls_handler,
-                                 (FAR void *)((uintptr_t)lsflags));
-      if (ret == OK && (lsflags & LSFLAGS_RECURSIVE) != 0)
-        {
-          /* Then recurse to list each directory within the directory */
-
-          ret = nsh_foreach_direntry(vtbl, "ls", fullpath, ls_recursive,
-                                     (FAR void *)((uintptr_t)lsflags));
-        }
+      ret = ls_listdir(vtbl, fullpath, lsflags);
     }
 
   nsh_freefullpath(fullpath);
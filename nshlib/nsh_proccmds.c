@@ -33,10 +33,14 @@
 #include <dirent.h>
 #include <errno.h>
 #include <signal.h>
+#include <poll.h>
+#include <stdarg.h>
 #include <sys/sysinfo.h>
 #include <sys/param.h>
 #include <time.h>
 
+#include <nuttx/clock.h>
+
 #include "nsh.h"
 #include "nsh_console.h"
 
@@ -68,6 +72,34 @@
 #  endif
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_TOP
+#  define TOP_LINE_WIDTH   80   /* Width of one formatted screen row */
+#  define TOP_HEADER_LINES 3    /* Summary, blank and column title rows */
+#  define TOP_NAME_SIZE    16   /* Longest task name kept per task */
+#  define TOP_DEFAULT_SECS 3    /* Default refresh interval */
+
+/* Per-task CPU usage comes from the cumulative run time reported by the
+ * critical section monitor if available.  That gives the exact usage over
+ * the refresh interval.  Otherwise fall back to the kernel's own CPU load
+ * estimate.
+ */
+
+#  if defined(CONFIG_SCHED_CRITMONITOR)
+#    define TOP_HAVE_RUNTIME
+#  elif !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD) && \
+        !defined(CONFIG_SCHED_CPULOAD_NONE)
+#    define TOP_HAVE_LOADAVG
+#  endif
+
+#  if defined(TOP_HAVE_RUNTIME) || defined(TOP_HAVE_LOADAVG)
+#    define TOP_HAVE_CPU
+#  endif
+
+#  if CONFIG_MM_BACKTRACE >= 0
+#    define TOP_HAVE_HEAP
+#  endif
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -127,6 +159,78 @@ static const char g_stackused[] = "StackUsed:";
 #endif /* !CONFIG_NSH_DISABLE_PSSTACKUSAGE */
 #endif /* !CONFIG_NSH_DISABLE_PS */
 
+#ifndef CONFIG_NSH_DISABLE_TOP
+/* Columns that 'top' can sort by */
+
+enum nsh_topsort_e
+{
+  TOP_SORT_CPU = 0,                /* CPU usage, highest first */
+  TOP_SORT_PID,                    /* Task ID, lowest first */
+  TOP_SORT_PRI,                    /* Priority, highest first */
+  TOP_SORT_STACK,                  /* Stack high-water, highest first */
+  TOP_SORT_HEAP,                   /* Heap allocated, highest first */
+  TOP_SORT_NAME                    /* Task name, alphabetical */
+};
+
+/* The procfs handles and the most recent sample of one task.  The files
+ * stay open between refreshes so that each sample is just a seek and a
+ * read.
+ */
+
+struct nsh_toptask_s
+{
+  pid_t pid;                       /* Task ID */
+  bool seen;                       /* Found in the latest /proc scan */
+  bool sampled;                    /* Holds a previous sample */
+  int statusfd;                    /* /proc/<pid>/status */
+  int stackfd;                     /* /proc/<pid>/stack */
+#ifdef TOP_HAVE_HEAP
+  int heapfd;                      /* /proc/<pid>/heap */
+#endif
+#ifdef TOP_HAVE_CPU
+  int cpufd;                       /* /proc/<pid>/critmon or loadavg */
+#endif
+  uint8_t priority;                /* Current priority */
+  char state;                      /* First letter of the task state */
+  char name[TOP_NAME_SIZE + 1];    /* Task name */
+#ifdef TOP_HAVE_RUNTIME
+  uint64_t runtime;                /* Cumulative run time in ns */
+#endif
+#ifdef TOP_HAVE_CPU
+  uint32_t cpuload;                /* CPU usage in 0.1% units */
+#endif
+  unsigned long stacksize;         /* Stack size in bytes */
+  unsigned long stackused;         /* Stack high-water in bytes */
+#ifdef TOP_HAVE_HEAP
+  unsigned long heapsize;          /* Heap bytes allocated by the task */
+  long heapdelta;                  /* Change since the previous sample */
+#endif
+};
+
+/* State of one 'top' invocation */
+
+struct nsh_top_s
+{
+  FAR struct nsh_vtbl_s *vtbl;     /* Console to draw on */
+  FAR struct nsh_toptask_s *tasks; /* Known tasks, in /proc order */
+  FAR struct nsh_toptask_s **sorted; /* Tasks in display order */
+  size_t ntasks;                   /* Number of valid entries in 'tasks' */
+  size_t nalloc;                   /* Number of allocated entries */
+  enum nsh_topsort_e sortkey;      /* Display order */
+  bool batch;                      /* Plain output without cursor motion */
+  int maxlines;                    /* Maximum number of task rows */
+  int nrows;                       /* Rows drawn in the previous frame */
+  FAR char *frame;                 /* Previous frame, TOP_LINE_WIDTH/row */
+  FAR char *outbuf;                /* Terminal output of one refresh */
+  size_t outsize;                  /* Size of 'outbuf' */
+  size_t outlen;                   /* Bytes queued in 'outbuf' */
+#ifdef TOP_HAVE_RUNTIME
+  struct timespec last;            /* Time of the previous sample */
+  uint64_t elapsed;                /* ns between the last two samples */
+#endif
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -585,6 +689,759 @@ static int ps_callback(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
 }
 #endif
 
+/****************************************************************************
+ * Name: top_sigint
+ *
+ * Description:
+ *   Catch SIGINT while 'top' is running so that control-C interrupts the
+ *   wait for the next refresh instead of terminating the shell.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static void top_sigint(int signo)
+{
+  UNUSED(signo);
+}
+#endif
+
+/****************************************************************************
+ * Name: top_openfile
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_openfile(FAR const char *dirpath, FAR const char *pid,
+                        FAR const char *file)
+{
+  FAR char *filepath = NULL;
+  int fd;
+
+  if (asprintf(&filepath, "%s/%s/%s", dirpath, pid, file) < 0 ||
+      filepath == NULL)
+    {
+      return ERROR;
+    }
+
+  fd = open(filepath, O_RDONLY | O_CLOEXEC);
+  free(filepath);
+  return fd;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_readfile
+ *
+ * Description:
+ *   Re-read a procfs file that was opened by top_openfile().  The content
+ *   is NUL-terminated in 'buffer'.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_readfile(int fd, FAR char *buffer, size_t buflen)
+{
+  size_t total = 0;
+  ssize_t nread;
+
+  if (fd < 0 || lseek(fd, 0, SEEK_SET) < 0)
+    {
+      return ERROR;
+    }
+
+  while (total < buflen - 1)
+    {
+      nread = read(fd, &buffer[total], buflen - 1 - total);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return ERROR;
+        }
+      else if (nread == 0)
+        {
+          break;
+        }
+
+      total += nread;
+    }
+
+  buffer[total] = '\0';
+  return total > 0 ? OK : ERROR;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_field
+ *
+ * Description:
+ *   Return the value following 'tag' in a "Tag:   value" formatted procfs
+ *   file, or NULL if there is no such line.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static FAR char *top_field(FAR char *buffer, FAR const char *tag)
+{
+  size_t len = strlen(tag);
+  FAR char *line = buffer;
+
+  while (line != NULL && *line != '\0')
+    {
+      if (strncmp(line, tag, len) == 0)
+        {
+          line += len;
+          while (*line == ' ' || *line == '\t')
+            {
+              line++;
+            }
+
+          return line;
+        }
+
+      line = strchr(line, '\n');
+      if (line != NULL)
+        {
+          line++;
+        }
+    }
+
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_parsedecimal
+ *
+ * Description:
+ *   Convert a "N.N..." decimal string into the value scaled by 'scale'
+ *   (e.g. 10 for tenths or 1000000000 for nanoseconds).
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static uint64_t top_parsedecimal(FAR const char *str, uint32_t scale)
+{
+  FAR char *endptr;
+  uint64_t value;
+
+  value = strtoul(str, &endptr, 10) * (uint64_t)scale;
+  if (*endptr == '.')
+    {
+      for (endptr++; isdigit(*endptr) && scale > 1; endptr++)
+        {
+          scale /= 10;
+          value += (*endptr - '0') * scale;
+        }
+    }
+
+  return value;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_opentask
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_opentask(FAR struct nsh_toptask_s *task,
+                        FAR const char *dirpath, FAR const char *name)
+{
+  memset(task, 0, sizeof(*task));
+  task->pid      = atoi(name);
+  task->statusfd = top_openfile(dirpath, name, "status");
+  if (task->statusfd < 0)
+    {
+      return ERROR;
+    }
+
+  task->stackfd  = top_openfile(dirpath, name, "stack");
+#ifdef TOP_HAVE_HEAP
+  task->heapfd   = top_openfile(dirpath, name, "heap");
+#endif
+#if defined(TOP_HAVE_RUNTIME)
+  task->cpufd    = top_openfile(dirpath, name, "critmon");
+#elif defined(TOP_HAVE_LOADAVG)
+  task->cpufd    = top_openfile(dirpath, name, "loadavg");
+#endif
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_closetask
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static void top_closetask(FAR struct nsh_toptask_s *task)
+{
+  close(task->statusfd);
+
+  if (task->stackfd >= 0)
+    {
+      close(task->stackfd);
+    }
+
+#ifdef TOP_HAVE_HEAP
+  if (task->heapfd >= 0)
+    {
+      close(task->heapfd);
+    }
+#endif
+
+#ifdef TOP_HAVE_CPU
+  if (task->cpufd >= 0)
+    {
+      close(task->cpufd);
+    }
+#endif
+}
+#endif
+
+/****************************************************************************
+ * Name: top_sampletask
+ *
+ * Description:
+ *   Take a new sample of one task and compute the changes since the
+ *   previous one.  Returns ERROR if the task no longer exists.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_sampletask(FAR struct nsh_top_s *top,
+                          FAR struct nsh_toptask_s *task)
+{
+  FAR char *buffer = top->vtbl->iobuffer;
+  FAR char *value;
+  size_t len;
+
+  /* The status file disappears (or stops reading) with the task */
+
+  if (top_readfile(task->statusfd, buffer, IOBUFFERSIZE) < 0)
+    {
+      return ERROR;
+    }
+
+  value = top_field(buffer, "Name:");
+  if (value != NULL)
+    {
+      len = strcspn(value, "\n");
+      len = MIN(len, TOP_NAME_SIZE);
+      memcpy(task->name, value, len);
+      task->name[len] = '\0';
+    }
+
+  value = top_field(buffer, "State:");
+  task->state = value != NULL && *value != '\n' ? *value : '?';
+
+  /* With priority inheritance the current priority comes first */
+
+  value = top_field(buffer, "Priority:");
+  task->priority = value != NULL ? strtoul(value, NULL, 10) : 0;
+
+  if (top_readfile(task->stackfd, buffer, IOBUFFERSIZE) >= 0)
+    {
+      value = top_field(buffer, "StackSize:");
+      task->stacksize = value != NULL ? strtoul(value, NULL, 0) : 0;
+
+      value = top_field(buffer, "StackUsed:");
+      task->stackused = value != NULL ? strtoul(value, NULL, 0) : 0;
+    }
+
+#ifdef TOP_HAVE_HEAP
+  if (top_readfile(task->heapfd, buffer, IOBUFFERSIZE) >= 0)
+    {
+      unsigned long heapsize;
+
+      value = top_field(buffer, "AllocSize:");
+      heapsize = value != NULL ? strtoul(value, NULL, 0) : 0;
+      task->heapdelta = task->sampled ? (long)(heapsize - task->heapsize) :
+                                        0;
+      task->heapsize = heapsize;
+    }
+#endif
+
+#if defined(TOP_HAVE_RUNTIME)
+  /* Format: max preemption,max csection,max run,total run time */
+
+  task->cpuload = 0;
+  if (top_readfile(task->cpufd, buffer, IOBUFFERSIZE) >= 0)
+    {
+      uint64_t runtime;
+      int i;
+
+      value = buffer;
+      for (i = 0; i < 3 && value != NULL; i++)
+        {
+          value = strchr(value, ',');
+          if (value != NULL)
+            {
+              value++;
+            }
+        }
+
+      if (value != NULL)
+        {
+          runtime = top_parsedecimal(value, NSEC_PER_SEC);
+          if (task->sampled && top->elapsed > 0 && runtime >= task->runtime)
+            {
+              task->cpuload = (runtime - task->runtime) * 1000 /
+                              top->elapsed;
+            }
+
+          task->runtime = runtime;
+        }
+    }
+#elif defined(TOP_HAVE_LOADAVG)
+  /* Format: "  N.N%" */
+
+  task->cpuload = 0;
+  if (top_readfile(task->cpufd, buffer, IOBUFFERSIZE) >= 0)
+    {
+      task->cpuload = top_parsedecimal(buffer, 10);
+    }
+#endif
+
+  task->sampled = true;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_callback
+ *
+ * Description:
+ *   Called for each entry in /proc.  Samples the known tasks and opens
+ *   the files of tasks that appeared since the last refresh.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_callback(FAR struct nsh_vtbl_s *vtbl,
+                        FAR const char *dirpath,
+                        FAR struct dirent *entryp, FAR void *pvarg)
+{
+  FAR struct nsh_top_s *top = pvarg;
+  FAR struct nsh_toptask_s *task = NULL;
+  pid_t pid;
+  size_t i;
+
+  UNUSED(vtbl);
+
+  /* Only the all-numeric directories are tasks */
+
+  if (!DIRENT_ISDIRECTORY(entryp->d_type))
+    {
+      return OK;
+    }
+
+  for (i = 0; i < NAME_MAX && entryp->d_name[i] != '\0'; i++)
+    {
+      if (!isdigit(entryp->d_name[i]))
+        {
+          return OK;
+        }
+    }
+
+  pid = atoi(entryp->d_name);
+  for (i = 0; i < top->ntasks; i++)
+    {
+      if (top->tasks[i].pid == pid)
+        {
+          task = &top->tasks[i];
+          break;
+        }
+    }
+
+  if (task == NULL)
+    {
+      if (top->ntasks >= top->nalloc)
+        {
+          FAR struct nsh_toptask_s *tasks;
+          size_t nalloc = top->nalloc + 16;
+
+          tasks = realloc(top->tasks, nalloc * sizeof(*tasks));
+          if (tasks == NULL)
+            {
+              return ERROR;
+            }
+
+          top->tasks  = tasks;
+          top->nalloc = nalloc;
+        }
+
+      task = &top->tasks[top->ntasks];
+      if (top_opentask(task, dirpath, entryp->d_name) < 0)
+        {
+          /* The task exited while /proc was being scanned */
+
+          return OK;
+        }
+
+      top->ntasks++;
+    }
+
+  task->seen = top_sampletask(top, task) >= 0;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_compare
+ *
+ * Description:
+ *   Return true if task 'a' should be displayed before task 'b'.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static bool top_compare(FAR const struct nsh_toptask_s *a,
+                        FAR const struct nsh_toptask_s *b,
+                        enum nsh_topsort_e sortkey)
+{
+  switch (sortkey)
+    {
+#ifdef TOP_HAVE_CPU
+      case TOP_SORT_CPU:
+        if (a->cpuload != b->cpuload)
+          {
+            return a->cpuload > b->cpuload;
+          }
+        break;
+#endif
+
+      case TOP_SORT_PRI:
+        if (a->priority != b->priority)
+          {
+            return a->priority > b->priority;
+          }
+        break;
+
+      case TOP_SORT_STACK:
+        if (a->stackused != b->stackused)
+          {
+            return a->stackused > b->stackused;
+          }
+        break;
+
+#ifdef TOP_HAVE_HEAP
+      case TOP_SORT_HEAP:
+        if (a->heapsize != b->heapsize)
+          {
+            return a->heapsize > b->heapsize;
+          }
+        break;
+#endif
+
+      case TOP_SORT_NAME:
+        if (strcmp(a->name, b->name) != 0)
+          {
+            return strcmp(a->name, b->name) < 0;
+          }
+        break;
+
+      default:
+        break;
+    }
+
+  return a->pid < b->pid;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_update
+ *
+ * Description:
+ *   Sample all tasks, drop the ones that exited and sort the remaining
+ *   ones for display.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static int top_update(FAR struct nsh_top_s *top)
+{
+  FAR struct nsh_toptask_s **sorted;
+  FAR struct nsh_toptask_s *task;
+  size_t count;
+  size_t i;
+  size_t j;
+  int ret;
+
+#ifdef TOP_HAVE_RUNTIME
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  top->elapsed = (uint64_t)(now.tv_sec - top->last.tv_sec) * NSEC_PER_SEC +
+                 now.tv_nsec - top->last.tv_nsec;
+  top->last    = now;
+#endif
+
+  for (i = 0; i < top->ntasks; i++)
+    {
+      top->tasks[i].seen = false;
+    }
+
+  ret = nsh_foreach_direntry(top->vtbl, "top", CONFIG_NSH_PROC_MOUNTPOINT,
+                             top_callback, top);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Close the files of the tasks that have exited */
+
+  for (i = 0, count = 0; i < top->ntasks; i++)
+    {
+      if (top->tasks[i].seen)
+        {
+          top->tasks[count++] = top->tasks[i];
+        }
+      else
+        {
+          top_closetask(&top->tasks[i]);
+        }
+    }
+
+  top->ntasks = count;
+
+  sorted = realloc(top->sorted, MAX(count, 1) * sizeof(*sorted));
+  if (sorted == NULL)
+    {
+      return ERROR;
+    }
+
+  top->sorted = sorted;
+
+  /* The task list is short and mostly sorted already from the previous
+   * refresh, so a simple insertion sort is sufficient.
+   */
+
+  for (i = 0; i < count; i++)
+    {
+      task = &top->tasks[i];
+      for (j = i; j > 0 && top_compare(task, sorted[j - 1], top->sortkey);
+           j--)
+        {
+          sorted[j] = sorted[j - 1];
+        }
+
+      sorted[j] = task;
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: top_putrow
+ *
+ * Description:
+ *   Queue one screen row for output.  In interactive mode, the row is only
+ *   redrawn if it differs from the same row of the previous frame.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static void top_putrow(FAR struct nsh_top_s *top, int row,
+                       FAR const char *fmt, ...)
+{
+  char line[TOP_LINE_WIDTH];
+  FAR char *prev;
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+
+  if (top->batch)
+    {
+      nsh_output(top->vtbl, "%s\n", line);
+      return;
+    }
+
+  prev = &top->frame[row * TOP_LINE_WIDTH];
+  if (row < top->nrows && strcmp(prev, line) == 0)
+    {
+      return;
+    }
+
+  strlcpy(prev, line, TOP_LINE_WIDTH);
+  len = snprintf(&top->outbuf[top->outlen], top->outsize - top->outlen,
+                 "\033[%d;1H%s\033[K", row + 1, line);
+  if (len > 0)
+    {
+      top->outlen = MIN(top->outlen + len, top->outsize - 1);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: top_display
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static void top_display(FAR struct nsh_top_s *top, unsigned int delay)
+{
+  static const char *const sortnames[] =
+  {
+    "cpu", "pid", "pri", "stack", "heap", "name"
+  };
+
+  FAR struct nsh_toptask_s *task;
+  int nrows;
+  int row;
+
+  top->outlen = 0;
+
+  top_putrow(top, 0, "top - %zu tasks, refresh %us, sorted by %s",
+             top->ntasks, delay, sortnames[top->sortkey]);
+  top_putrow(top, 1, "%s", "");
+  top_putrow(top, 2, "%5s %3s %1s "
+#ifdef TOP_HAVE_CPU
+             "%6s "
+#endif
+             "%6s %6s %4s "
+#ifdef TOP_HAVE_HEAP
+             "%8s %7s "
+#endif
+             "%s",
+             "PID", "PRI", "S",
+#ifdef TOP_HAVE_CPU
+             "CPU%",
+#endif
+             "STACK", "USED", "USE%",
+#ifdef TOP_HAVE_HEAP
+             "HEAP", "DHEAP",
+#endif
+             "NAME");
+
+  nrows = TOP_HEADER_LINES + MIN((int)top->ntasks, top->maxlines);
+  for (row = TOP_HEADER_LINES; row < nrows; row++)
+    {
+      task = top->sorted[row - TOP_HEADER_LINES];
+      top_putrow(top, row, "%5d %3u %c "
+#ifdef TOP_HAVE_CPU
+                 "%4" PRIu32 ".%" PRIu32 " "
+#endif
+                 "%6lu %6lu %3lu%% "
+#ifdef TOP_HAVE_HEAP
+                 "%8lu %+7ld "
+#endif
+                 "%s",
+                 (int)task->pid, task->priority, task->state,
+#ifdef TOP_HAVE_CPU
+                 task->cpuload / 10, task->cpuload % 10,
+#endif
+                 task->stacksize, task->stackused,
+                 task->stacksize > 0 ?
+                 task->stackused * 100 / task->stacksize : 0,
+#ifdef TOP_HAVE_HEAP
+                 task->heapsize, task->heapdelta,
+#endif
+                 task->name);
+    }
+
+  if (top->batch)
+    {
+      nsh_output(top->vtbl, "\n");
+      return;
+    }
+
+  /* Erase whatever is left of a longer previous frame and park the cursor
+   * below the table.
+   */
+
+  top->outlen += snprintf(&top->outbuf[top->outlen],
+                          top->outsize - top->outlen, "\033[%d;1H%s",
+                          nrows + 1, nrows < top->nrows ? "\033[J" : "");
+  top->outlen  = MIN(top->outlen, top->outsize - 1);
+  top->nrows   = nrows;
+
+  nsh_write(top->vtbl, top->outbuf, top->outlen);
+}
+#endif
+
+/****************************************************************************
+ * Name: top_wait
+ *
+ * Description:
+ *   Wait for the next refresh and handle keyboard commands.  Returns false
+ *   if 'top' should terminate.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+static bool top_wait(FAR struct nsh_top_s *top, unsigned int delay)
+{
+  struct pollfd fds;
+  char ch;
+  int ret;
+
+  fds.fd      = STDIN_FILENO;
+  fds.events  = POLLIN;
+  fds.revents = 0;
+
+  ret = poll(&fds, 1, delay * 1000);
+  if (ret < 0)
+    {
+      /* Interrupted by control-C */
+
+      return false;
+    }
+  else if (ret == 0 || (fds.revents & POLLIN) == 0)
+    {
+      return true;
+    }
+  else if (read(STDIN_FILENO, &ch, 1) != 1)
+    {
+      /* No console input (e.g. end of file), just wait */
+
+      sleep(delay);
+      return true;
+    }
+
+  switch (ch)
+    {
+      case 'q':
+      case 'Q':
+      case 0x03:
+        return false;
+
+      case 'c':
+        top->sortkey = TOP_SORT_CPU;
+        break;
+
+      case 'p':
+        top->sortkey = TOP_SORT_PID;
+        break;
+
+      case 'r':
+        top->sortkey = TOP_SORT_PRI;
+        break;
+
+      case 's':
+        top->sortkey = TOP_SORT_STACK;
+        break;
+
+      case 'h':
+        top->sortkey = TOP_SORT_HEAP;
+        break;
+
+      case 'n':
+        top->sortkey = TOP_SORT_NAME;
+        break;
+
+      default:
+        break;
+    }
+
+  return true;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -670,6 +1527,179 @@ int cmd_ps(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 }
 #endif
 
+/****************************************************************************
+ * Name: cmd_top
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TOP
+int cmd_top(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR const char *errfmt = g_fmtarginvalid;
+  struct nsh_top_s top;
+  sighandler_t oldhandler;
+  unsigned int delay = TOP_DEFAULT_SECS;
+  long iterations = -1;
+  int option;
+  int value;
+  int ret = ERROR;
+
+  memset(&top, 0, sizeof(top));
+  top.vtbl     = vtbl;
+  top.maxlines = CONFIG_NSH_CMDOPT_TOP_LINES;
+  top.sortkey  = TOP_SORT_CPU;
+
+  /* top [-b] [-d <secs>] [-n <count>] [-l <lines>] [-s <column>] */
+
+  while ((option = getopt(argc, argv, "bd:n:l:s:")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'b':
+            top.batch = true;
+            break;
+
+          case 'd':
+            value = atoi(optarg);
+            if (value <= 0)
+              {
+                errfmt = g_fmtargrange;
+                goto errout;
+              }
+
+            delay = value;
+            break;
+
+          case 'n':
+            iterations = atol(optarg);
+            if (iterations <= 0)
+              {
+                errfmt = g_fmtargrange;
+                goto errout;
+              }
+            break;
+
+          case 'l':
+            top.maxlines = atoi(optarg);
+            if (top.maxlines <= 0)
+              {
+                errfmt = g_fmtargrange;
+                goto errout;
+              }
+            break;
+
+          case 's':
+            if (strcmp(optarg, "cpu") == 0)
+              {
+                top.sortkey = TOP_SORT_CPU;
+              }
+            else if (strcmp(optarg, "pid") == 0)
+              {
+                top.sortkey = TOP_SORT_PID;
+              }
+            else if (strcmp(optarg, "pri") == 0)
+              {
+                top.sortkey = TOP_SORT_PRI;
+              }
+            else if (strcmp(optarg, "stack") == 0)
+              {
+                top.sortkey = TOP_SORT_STACK;
+              }
+            else if (strcmp(optarg, "heap") == 0)
+              {
+                top.sortkey = TOP_SORT_HEAP;
+              }
+            else if (strcmp(optarg, "name") == 0)
+              {
+                top.sortkey = TOP_SORT_NAME;
+              }
+            else
+              {
+                goto errout;
+              }
+            break;
+
+          default:
+            goto errout;
+        }
+    }
+
+  if (optind < argc)
+    {
+      errfmt = g_fmttoomanyargs;
+      goto errout;
+    }
+
+  if (!top.batch)
+    {
+      int nrows = TOP_HEADER_LINES + top.maxlines;
+
+      /* Every row may need a cursor position and an erase-to-EOL sequence
+       * on top of its text.
+       */
+
+      top.outsize = nrows * (TOP_LINE_WIDTH + 16) + 32;
+      top.frame   = calloc(nrows, TOP_LINE_WIDTH);
+      top.outbuf  = malloc(top.outsize);
+      if (top.frame == NULL || top.outbuf == NULL)
+        {
+          nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+          goto errout_with_top;
+        }
+
+      nsh_output(vtbl, "\033[H\033[J");
+    }
+
+#ifdef TOP_HAVE_RUNTIME
+  /* Take an initial sample so that the first frame already shows the CPU
+   * usage over a short period.
+   */
+
+  clock_gettime(CLOCK_MONOTONIC, &top.last);
+  if (top_update(&top) >= 0)
+    {
+      usleep(200 * 1000);
+    }
+#endif
+
+  oldhandler = signal(SIGINT, top_sigint);
+
+  for (; ; )
+    {
+      ret = top_update(&top);
+      if (ret < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, argv[0], "sample", NSH_ERRNO);
+          break;
+        }
+
+      top_display(&top, delay);
+
+      if ((iterations > 0 && --iterations == 0) || !top_wait(&top, delay))
+        {
+          break;
+        }
+    }
+
+  signal(SIGINT, oldhandler);
+
+errout_with_top:
+  while (top.ntasks > 0)
+    {
+      top_closetask(&top.tasks[--top.ntasks]);
+    }
+
+  free(top.tasks);
+  free(top.sorted);
+  free(top.frame);
+  free(top.outbuf);
+  return ret;
+
+errout:
+  nsh_error(vtbl, errfmt, argv[0]);
+  return ERROR;
+}
+#endif
+
 /****************************************************************************
  * Name: cmd_pidof
  ****************************************************************************/
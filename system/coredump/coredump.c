@@ -32,9 +32,13 @@
 #include <elf.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 #include <nuttx/binfmt/binfmt.h>
+#include <nuttx/memoryregion.h>
 #include <nuttx/streams.h>
 
 /****************************************************************************
@@ -44,10 +48,259 @@
 typedef CODE void (*dumpfile_cb_t)(FAR char *path, FAR const char *filename,
                                    FAR void *arg);
 
+/* Double-buffered output stream: the producer (core_dump() or the restore
+ * loop) fills one buffer while the writer thread writes the other one to
+ * the file.  Output beyond 'limit' bytes is dropped.
+ */
+
+struct coredump_aiostream_s
+{
+  struct lib_outstream_s common;
+  pthread_t writer;
+  sem_t empty;                 /* Posted when the writer returns a buffer */
+  sem_t full;                  /* Posted when a buffer is ready to write */
+  int fd;
+  int fill;                    /* Buffer being filled by the producer */
+  FAR uint8_t *buf[2];
+  size_t len[2];
+  size_t limit;                /* 0: no limit */
+  size_t total;
+  bool truncated;
+  int error;
+};
+
+struct coredump_option_s
+{
+  FAR char *filename;
+  size_t limit;                /* Total size budget */
+  size_t region_limit;         /* Budget of every extra memory region */
+  bool binary;
+  int nregions;
+  struct memory_region_s regions[CONFIG_SYSTEM_COREDUMP_MAXREGIONS + 1];
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * aiostream_writer
+ ****************************************************************************/
+
+static FAR void *aiostream_writer(FAR void *arg)
+{
+  FAR struct coredump_aiostream_s *stream = arg;
+  FAR uint8_t *ptr;
+  ssize_t nwritten;
+  size_t remain;
+  int drain = 0;
+
+  for (; ; )
+    {
+      sem_wait(&stream->full);
+
+      /* A zero length buffer is the stop request */
+
+      if (stream->len[drain] == 0)
+        {
+          break;
+        }
+
+      ptr = stream->buf[drain];
+      remain = stream->len[drain];
+
+      while (remain > 0 && stream->error == 0)
+        {
+          nwritten = write(stream->fd, ptr, remain);
+          if (nwritten < 0)
+            {
+              if (errno != EINTR)
+                {
+                  stream->error = -errno;
+                }
+
+              continue;
+            }
+
+          ptr += nwritten;
+          remain -= nwritten;
+        }
+
+      stream->len[drain] = 0;
+      drain ^= 1;
+      sem_post(&stream->empty);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * aiostream_submit
+ *
+ *   Hand the buffer being filled over to the writer and wait for the other
+ *   one to become free.
+ *
+ ****************************************************************************/
+
+static void aiostream_submit(FAR struct coredump_aiostream_s *stream)
+{
+  sem_post(&stream->full);
+  stream->fill ^= 1;
+
+  sem_wait(&stream->empty);
+}
+
+/****************************************************************************
+ * aiostream_puts
+ ****************************************************************************/
+
+static int aiostream_puts(FAR struct lib_outstream_s *self,
+                          FAR const void *buf, int len)
+{
+  FAR struct coredump_aiostream_s *stream = (FAR void *)self;
+  FAR const uint8_t *ptr = buf;
+  size_t accept = len;
+  size_t chunk;
+  int fill;
+
+  if (stream->error < 0)
+    {
+      return stream->error;
+    }
+
+  if (stream->limit > 0 && stream->total + accept > stream->limit)
+    {
+      accept = stream->limit - stream->total;
+      stream->truncated = true;
+    }
+
+  stream->total += accept;
+  self->nput += accept;
+
+  while (accept > 0)
+    {
+      fill = stream->fill;
+      chunk = CONFIG_SYSTEM_COREDUMP_BUFSIZE - stream->len[fill];
+      if (chunk > accept)
+        {
+          chunk = accept;
+        }
+
+      memcpy(stream->buf[fill] + stream->len[fill], ptr, chunk);
+      stream->len[fill] += chunk;
+      ptr += chunk;
+      accept -= chunk;
+
+      if (stream->len[fill] == CONFIG_SYSTEM_COREDUMP_BUFSIZE)
+        {
+          aiostream_submit(stream);
+        }
+    }
+
+  /* Stop the producer as soon as the budget is used up */
+
+  return stream->truncated ? -ENOSPC : len;
+}
+
+/****************************************************************************
+ * aiostream_putc
+ ****************************************************************************/
+
+static void aiostream_putc(FAR struct lib_outstream_s *self, int ch)
+{
+  uint8_t c = ch;
+
+  aiostream_puts(self, &c, 1);
+}
+
+/****************************************************************************
+ * aiostream_flush
+ *
+ *   Submit the partially filled buffer and wait until everything has been
+ *   written.
+ *
+ ****************************************************************************/
+
+static int aiostream_flush(FAR struct lib_outstream_s *self)
+{
+  FAR struct coredump_aiostream_s *stream = (FAR void *)self;
+
+  if (stream->len[stream->fill] > 0)
+    {
+      aiostream_submit(stream);
+    }
+
+  /* The other buffer may still be in flight */
+
+  sem_wait(&stream->empty);
+  sem_post(&stream->empty);
+
+  return stream->error;
+}
+
+/****************************************************************************
+ * aiostream_open
+ ****************************************************************************/
+
+static FAR struct coredump_aiostream_s *aiostream_open(int fd, size_t limit)
+{
+  FAR struct coredump_aiostream_s *stream;
+  int ret;
+
+  stream = zalloc(sizeof(*stream) + 2 * CONFIG_SYSTEM_COREDUMP_BUFSIZE);
+  if (stream == NULL)
+    {
+      return NULL;
+    }
+
+  stream->common.putc  = aiostream_putc;
+  stream->common.puts  = aiostream_puts;
+  stream->common.flush = aiostream_flush;
+  stream->buf[0] = (FAR uint8_t *)(stream + 1);
+  stream->buf[1] = stream->buf[0] + CONFIG_SYSTEM_COREDUMP_BUFSIZE;
+  stream->fd = fd;
+  stream->limit = limit;
+
+  /* The producer holds buf[0], buf[1] is free */
+
+  sem_init(&stream->empty, 0, 1);
+  sem_init(&stream->full, 0, 0);
+
+  ret = pthread_create(&stream->writer, NULL, aiostream_writer, stream);
+  if (ret != 0)
+    {
+      sem_destroy(&stream->full);
+      sem_destroy(&stream->empty);
+      free(stream);
+      return NULL;
+    }
+
+  return stream;
+}
+
+/****************************************************************************
+ * aiostream_close
+ ****************************************************************************/
+
+static int aiostream_close(FAR struct coredump_aiostream_s *stream)
+{
+  int ret;
+
+  ret = aiostream_flush(&stream->common);
+
+  /* Stop the writer with an empty buffer */
+
+  stream->len[stream->fill] = 0;
+  sem_post(&stream->full);
+  pthread_join(stream->writer, NULL);
+
+  sem_destroy(&stream->full);
+  sem_destroy(&stream->empty);
+  free(stream);
+
+  return ret;
+}
+
 /****************************************************************************
  * dumpfile_iterate
  ****************************************************************************/
@@ -113,9 +366,11 @@ static void dumpfile_delete(FAR char *path, FAR const char *filename,
 
 static void coredump_restore(FAR char *savepath, size_t maxfile)
 {
+  FAR struct coredump_aiostream_s *stream;
   FAR struct coredump_info_s *info;
   unsigned char *swap;
   char dumppath[PATH_MAX];
+  size_t chunk;
   struct geometry geo;
   ssize_t writesize;
   ssize_t readsize;
@@ -200,24 +455,43 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
       goto info_err;
     }
 
-  swap = malloc(geo.geo_sectorsize);
+  /* Read as many whole sectors as fit in one writer buffer, the writer
+   * thread stores the previous chunk to the file meanwhile.
+   */
+
+  chunk = CONFIG_SYSTEM_COREDUMP_BUFSIZE / geo.geo_sectorsize;
+  chunk = (chunk > 0 ? chunk : 1) * geo.geo_sectorsize;
+
+  swap = malloc(chunk);
   if (swap == NULL)
     {
       printf("Malloc fail\n");
       goto fd_err;
     }
 
+  stream = aiostream_open(dumpfd, 0);
+  if (stream == NULL)
+    {
+      printf("Malloc fail\n");
+      goto swap_err;
+    }
+
   lseek(blkfd, 0, SEEK_SET);
   while (offset < info->size)
     {
-      readsize = read(blkfd, swap, geo.geo_sectorsize);
-      if (readsize < 0)
+      readsize = read(blkfd, swap, chunk);
+      if (readsize <= 0)
         {
           printf("Read %s fail\n", CONFIG_BOARD_COREDUMP_BLKDEV_PATH);
           break;
         }
 
-      writesize = write(dumpfd, swap, readsize);
+      if (readsize > info->size - offset)
+        {
+          readsize = info->size - offset;
+        }
+
+      writesize = aiostream_puts(&stream->common, swap, readsize);
       if (writesize != readsize)
         {
           printf("Write %s fail\n", dumppath);
@@ -227,10 +501,16 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
       offset += writesize;
     }
 
+  if (aiostream_close(stream) < 0)
+    {
+      printf("Write %s fail\n", dumppath);
+    }
+
   printf("Coredump finish [%s][%zu]\n", dumppath, info->size);
   info->magic = 0;
   lseek(blkfd, (geo.geo_nsectors - 1) * geo.geo_sectorsize, SEEK_SET);
   write(blkfd, info, geo.geo_sectorsize);
+swap_err:
   free(swap);
 fd_err:
   close(dumpfd);
@@ -242,12 +522,109 @@ blkfd_err:
 
 #endif
 
+/****************************************************************************
+ * coredump_binary
+ *
+ *   Write the raw (optionally LZF compressed) ELF core to a file through
+ *   the double-buffered writer, within opt->limit bytes.  The kernel emits
+ *   all stacks first and then the extra memory regions in the given order,
+ *   so the stacks are the last thing to be cut by the budget.
+ *
+ ****************************************************************************/
+
+static int coredump_binary(int pid, FAR struct coredump_option_s *opt)
+{
+  FAR struct coredump_aiostream_s *astream;
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+  FAR struct lib_lzfoutstream_s *lstream;
+#endif
+  FAR struct lib_outstream_s *stream;
+  bool truncated;
+  size_t total;
+  int logmask;
+  int ret;
+  int fd;
+  int i;
+
+  fd = open(opt->filename, O_CREAT | O_WRONLY | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  astream = aiostream_open(fd, opt->limit);
+  if (astream == NULL)
+    {
+      close(fd);
+      return -ENOMEM;
+    }
+
+  stream = &astream->common;
+
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+  lstream = malloc(sizeof(*lstream));
+  if (lstream == NULL)
+    {
+      aiostream_close(astream);
+      close(fd);
+      return -ENOMEM;
+    }
+
+  lib_lzfoutstream(lstream, stream);
+  stream = (FAR struct lib_outstream_s *)lstream;
+#endif
+
+  for (i = 0; i < opt->nregions; i++)
+    {
+      FAR struct memory_region_s *region = &opt->regions[i];
+
+      if (opt->region_limit > 0 &&
+          region->end - region->start > opt->region_limit)
+        {
+          region->end = region->start + opt->region_limit;
+        }
+    }
+
+  printf("Start coredump:\n");
+  logmask = setlogmask(LOG_ALERT);
+
+  ret = core_dump(opt->nregions > 0 ? opt->regions : NULL, stream, pid);
+  lib_stream_flush(stream);
+
+  setlogmask(logmask);
+
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+  free(lstream);
+#endif
+
+  truncated = astream->truncated;
+  total = astream->total;
+
+  if (aiostream_close(astream) < 0)
+    {
+      ret = -EIO;
+    }
+
+  close(fd);
+
+  printf("Finish coredump [%s][%zu]%s%s.\n", opt->filename, total,
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+         " (Compression Enabled)",
+#else
+         "",
+#endif
+         truncated ? " (Truncated)" : "");
+
+  return truncated ? OK : ret;
+}
+
 /****************************************************************************
  * coredump_now
  ****************************************************************************/
 
-static int coredump_now(int pid, FAR char *filename)
+static int coredump_now(int pid, FAR struct coredump_option_s *opt)
 {
+  FAR char *filename = opt->filename;
   FAR struct lib_stdoutstream_s *outstream;
   FAR struct lib_hexdumpstream_s *hstream;
 #ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
@@ -257,6 +634,11 @@ static int coredump_now(int pid, FAR char *filename)
   FAR FILE *file;
   int logmask;
 
+  if (opt->binary)
+    {
+      return coredump_binary(pid, opt);
+    }
+
   if (filename != NULL)
     {
       file = fopen(filename, "w");
@@ -331,6 +713,43 @@ static int coredump_now(int pid, FAR char *filename)
   return 0;
 }
 
+/****************************************************************************
+ * coredump_parse_region
+ *
+ *   Parse "<start>,<end>" into the next extra memory region.
+ *
+ ****************************************************************************/
+
+static int coredump_parse_region(FAR struct coredump_option_s *opt,
+                                 FAR const char *arg)
+{
+  FAR struct memory_region_s *region;
+  FAR char *endptr;
+
+  if (opt->nregions >= CONFIG_SYSTEM_COREDUMP_MAXREGIONS)
+    {
+      return -E2BIG;
+    }
+
+  region = &opt->regions[opt->nregions];
+  region->start = strtoul(arg, &endptr, 0);
+  if (*endptr != ',')
+    {
+      return -EINVAL;
+    }
+
+  region->end = strtoul(endptr + 1, &endptr, 0);
+  if (*endptr != '\0' || region->end <= region->start)
+    {
+      return -EINVAL;
+    }
+
+  region->flags = 0;
+  opt->nregions++;
+
+  return OK;
+}
+
 /****************************************************************************
  * usage
  ****************************************************************************/
@@ -341,6 +760,16 @@ static void usage(FAR const char *progname, int exitcode)
   fprintf(stderr, "Default usage, will coredump directly\n");
   fprintf(stderr, "\t -p, --pid <pid>, Default, all thread\n");
   fprintf(stderr, "\t -f, --filename <filename>, Default stdout\n");
+  fprintf(stderr, "\t -b, --binary, Binary ELF core to <filename>"
+                  " instead of hex text\n");
+  fprintf(stderr, "\t -l, --limit <bytes>, Size budget of the binary"
+                  " core (with -b), Default unlimited\n");
+  fprintf(stderr, "\t -r, --region <start>,<end>, Also dump this memory"
+                  " (e.g. heap) after the stacks (with -b), up to %d"
+                  " times\n",
+                  CONFIG_SYSTEM_COREDUMP_MAXREGIONS);
+  fprintf(stderr, "\t -R, --region-limit <bytes>, Budget of every"
+                  " region given by -r (with -b)\n");
 
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
   fprintf(stderr, "Second usage, will restore coredump"
@@ -367,22 +796,30 @@ int main(int argc, FAR char *argv[])
   FAR char *savepath = NULL;
   size_t maxfile = 1;
 #endif
-  char *name = NULL;
+  struct coredump_option_s opt;
   int pid = INVALID_PROCESS_ID;
+  bool binopt = false;
   int ret;
 
   struct option options[] =
     {
       {"pid", 1, NULL, 'p'},
       {"filename", 1, NULL, 'f'},
+      {"binary", 0, NULL, 'b'},
+      {"limit", 1, NULL, 'l'},
+      {"region", 1, NULL, 'r'},
+      {"region-limit", 1, NULL, 'R'},
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
       {"savepath", 1, NULL, 's'},
       {"maxfile", 1, NULL, 'm'},
 #endif
-      {"help", 0, NULL, 'h'}
+      {"help", 0, NULL, 'h'},
+      {NULL, 0, NULL, 0}
     };
 
-  while ((ret = getopt_long(argc, argv, "p:f:s:m:h", options, NULL))
+  memset(&opt, 0, sizeof(opt));
+
+  while ((ret = getopt_long(argc, argv, "p:f:bl:r:R:s:m:h", options, NULL))
          != ERROR)
     {
       switch (ret)
@@ -391,7 +828,26 @@ int main(int argc, FAR char *argv[])
             pid = atoi(optarg);
             break;
           case 'f':
-            name = optarg;
+            opt.filename = optarg;
+            break;
+          case 'b':
+            opt.binary = true;
+            break;
+          case 'l':
+            opt.limit = strtoul(optarg, NULL, 0);
+            binopt = true;
+            break;
+          case 'r':
+            if (coredump_parse_region(&opt, optarg) < 0)
+              {
+                usage(argv[0], EXIT_FAILURE);
+              }
+
+            binopt = true;
+            break;
+          case 'R':
+            opt.region_limit = strtoul(optarg, NULL, 0);
+            binopt = true;
             break;
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
           case 's':
@@ -408,6 +864,14 @@ int main(int argc, FAR char *argv[])
         }
     }
 
+  /* The size budgets and extra regions only apply to the binary core */
+
+  if (binopt && !opt.binary)
+    {
+      fprintf(stderr, "-l, -r and -R require -b\n");
+      usage(argv[0], EXIT_FAILURE);
+    }
+
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
   if (savepath != NULL)
     {
@@ -416,7 +880,12 @@ int main(int argc, FAR char *argv[])
   else
 #endif
     {
-      coredump_now(pid, name);
+      if (opt.binary && opt.filename == NULL)
+        {
+          usage(argv[0], EXIT_FAILURE);
+        }
+
+      coredump_now(pid, &opt);
     }
 
   return 0;
@@ -47,6 +47,11 @@
 #  include <netdb.h>
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+#  include <semaphore.h>
+#  include <stdatomic.h>
+#endif
+
 #include <netutils/netlib.h>
 #include <nuttx/audio/audio.h>
 
@@ -68,6 +73,22 @@
 #  define CONFIG_NXPLAYER_PLAYTHREAD_STACKSIZE    1500
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+#  ifndef CONFIG_NXPLAYER_PREFETCH_DEPTH
+#    define CONFIG_NXPLAYER_PREFETCH_DEPTH        4
+#  endif
+#  ifndef CONFIG_NXPLAYER_READTHREAD_STACKSIZE
+#    define CONFIG_NXPLAYER_READTHREAD_STACKSIZE  1500
+#  endif
+#  define NXPLAYER_NPREFETCH  CONFIG_NXPLAYER_PREFETCH_DEPTH
+#else
+#  define NXPLAYER_NPREFETCH  0
+#endif
+
+/* Sent by the reader thread when the play thread is waiting for data */
+
+#define NXPLAYER_MSG_REFILL      AUDIO_MSG_USER
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
@@ -81,6 +102,38 @@ struct nxplayer_ext_fmt_s
 };
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+/* Single producer, single consumer ring of audio buffer pointers.  head is
+ * only written by the producer and tail only by the consumer, so the two
+ * threads never need a lock to pass buffers.  The ring is sized to hold
+ * every buffer of the stream, so a push can never fail.
+ */
+
+struct nxplayer_ring_s
+{
+  FAR struct ap_buffer_s **slot;     /* mask + 1 buffer pointers */
+  unsigned int             mask;     /* Ring size - 1, size is 2^n */
+  atomic_uint              head;     /* Next slot to write */
+  atomic_uint              tail;     /* Next slot to read */
+};
+
+/* State shared between the play thread and the reader thread */
+
+struct nxplayer_prefetch_s
+{
+  FAR struct nxplayer_s   *pplayer;
+  struct nxplayer_ring_s   ready;    /* Decoded buffers: reader -> play */
+  struct nxplayer_ring_s   empty;    /* Free buffers: play -> reader */
+  sem_t                    nempty;   /* Counts pushes to the empty ring */
+  atomic_bool              waiting;  /* Play thread wants a REFILL message */
+  atomic_bool              exit;     /* Reader must stop reading */
+  pthread_t                id;       /* Reader thread */
+  int                      owed;     /* Buffers the device is short of */
+  int                      depth;    /* Number of spare buffers */
+  bool                     primed;   /* Ready ring has been full once */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -776,6 +829,403 @@ static void nxplayer_jointhread(FAR struct nxplayer_s *pplayer)
     }
 }
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+/****************************************************************************
+ * Name: nxplayer_ring_init
+ ****************************************************************************/
+
+static int nxplayer_ring_init(FAR struct nxplayer_ring_s *ring,
+                              unsigned int nslots)
+{
+  unsigned int size = 1;
+
+  while (size < nslots)
+    {
+      size <<= 1;
+    }
+
+  ring->slot = (FAR struct ap_buffer_s **)
+    malloc(size * sizeof(FAR struct ap_buffer_s *));
+  if (ring->slot == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ring->mask = size - 1;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxplayer_ring_count
+ ****************************************************************************/
+
+static unsigned int nxplayer_ring_count(FAR struct nxplayer_ring_s *ring)
+{
+  return atomic_load_explicit(&ring->head, memory_order_acquire) -
+         atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+/****************************************************************************
+ * Name: nxplayer_ring_push
+ *
+ *   Add a buffer to the ring.  Only called by the producer of the ring.
+ *
+ ****************************************************************************/
+
+static void nxplayer_ring_push(FAR struct nxplayer_ring_s *ring,
+                               FAR struct ap_buffer_s *apb)
+{
+  unsigned int head = atomic_load_explicit(&ring->head,
+                                           memory_order_relaxed);
+
+  DEBUGASSERT(head - atomic_load_explicit(&ring->tail,
+                                          memory_order_acquire) <=
+              ring->mask);
+
+  ring->slot[head & ring->mask] = apb;
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/****************************************************************************
+ * Name: nxplayer_ring_pop
+ *
+ *   Remove the oldest buffer from the ring, or return NULL if the ring is
+ *   empty.  Only called by the consumer of the ring.
+ *
+ ****************************************************************************/
+
+static FAR struct ap_buffer_s *
+nxplayer_ring_pop(FAR struct nxplayer_ring_s *ring)
+{
+  FAR struct ap_buffer_s *apb;
+  unsigned int tail = atomic_load_explicit(&ring->tail,
+                                           memory_order_relaxed);
+
+  if (tail == atomic_load_explicit(&ring->head, memory_order_acquire))
+    {
+      return NULL;
+    }
+
+  apb = ring->slot[tail & ring->mask];
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return apb;
+}
+
+/****************************************************************************
+ * Name: nxplayer_readthread
+ *
+ *  Reads and decodes the media file into the buffers the play thread puts
+ *  on the empty ring, and hands them back on the ready ring.  The play
+ *  thread is only woken up with a message when it found the ready ring
+ *  empty, so in the steady state no message is sent at all.
+ *
+ ****************************************************************************/
+
+static FAR void *nxplayer_readthread(pthread_addr_t pvarg)
+{
+  FAR struct nxplayer_prefetch_s *pf = (FAR struct nxplayer_prefetch_s *)
+                                       pvarg;
+  FAR struct nxplayer_s          *pplayer = pf->pplayer;
+  FAR struct ap_buffer_s         *apb;
+  struct audio_msg_s              msg;
+  bool                            final = false;
+
+  audinfo("Entry\n");
+
+  while (!final)
+    {
+      if (sem_wait(&pf->nempty) < 0)
+        {
+          continue;
+        }
+
+      if (atomic_load(&pf->exit))
+        {
+          break;
+        }
+
+      apb = nxplayer_ring_pop(&pf->empty);
+      if (apb == NULL)
+        {
+          continue;
+        }
+
+      if (nxplayer_readbuffer(pplayer, apb) != OK)
+        {
+          /* The file was already closed without a final buffer.  Pass an
+           * empty one so the device still sees the end of the stream.
+           */
+
+          apb->nbytes  = 0;
+          apb->curbyte = 0;
+          apb->flags   = AUDIO_APB_FINAL;
+        }
+
+      final = (apb->flags & AUDIO_APB_FINAL) != 0;
+      nxplayer_ring_push(&pf->ready, apb);
+
+      /* Pairs with the fence in nxplayer_prefetch_refill(): either the play
+       * thread sees the buffer we just pushed, or we see its waiting flag.
+       */
+
+      atomic_thread_fence(memory_order_seq_cst);
+      if (atomic_exchange(&pf->waiting, false))
+        {
+          msg.msg_id = NXPLAYER_MSG_REFILL;
+          msg.u.data = 0;
+          mq_send(pplayer->mq, (FAR const char *)&msg, sizeof(msg),
+                  CONFIG_NXPLAYER_MSG_PRIO);
+        }
+    }
+
+  audinfo("Exit\n");
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_start
+ *
+ *  Set up the buffer rings, give the spare buffers to the reader and start
+ *  the reader thread.  Returns NULL if that is not possible, in which case
+ *  the play thread keeps reading the file itself.
+ *
+ ****************************************************************************/
+
+static FAR struct nxplayer_prefetch_s *
+nxplayer_prefetch_start(FAR struct nxplayer_s *pplayer,
+                        FAR struct ap_buffer_s **spare, int nspare,
+                        int nbuffers)
+{
+  FAR struct nxplayer_prefetch_s *pf;
+  pthread_attr_t                  tattr;
+  int                             ret;
+  int                             x;
+
+  pf = (FAR struct nxplayer_prefetch_s *)
+    calloc(1, sizeof(struct nxplayer_prefetch_s));
+  if (pf == NULL)
+    {
+      return NULL;
+    }
+
+  pf->pplayer = pplayer;
+  pf->depth   = nspare;
+  if (nxplayer_ring_init(&pf->ready, nbuffers) < 0)
+    {
+      goto err_pf;
+    }
+
+  if (nxplayer_ring_init(&pf->empty, nbuffers) < 0)
+    {
+      goto err_ready;
+    }
+
+  atomic_init(&pf->waiting, false);
+  atomic_init(&pf->exit, false);
+  sem_init(&pf->nempty, 0, 0);
+
+  for (x = 0; x < nspare; x++)
+    {
+      nxplayer_ring_push(&pf->empty, spare[x]);
+      sem_post(&pf->nempty);
+    }
+
+  /* The reader runs at the default priority, below the play thread, so
+   * decoding never delays returning buffers to the device.
+   */
+
+  pthread_attr_init(&tattr);
+  pthread_attr_setstacksize(&tattr, CONFIG_NXPLAYER_READTHREAD_STACKSIZE);
+
+  ret = pthread_create(&pf->id, &tattr, nxplayer_readthread,
+                       (pthread_addr_t)pf);
+  pthread_attr_destroy(&tattr);
+  if (ret != OK)
+    {
+      auderr("ERROR: Failed to create readthread: %d\n", ret);
+      sem_destroy(&pf->nempty);
+      free(pf->empty.slot);
+      goto err_ready;
+    }
+
+  pthread_setname_np(pf->id, "readthread");
+
+  pthread_mutex_lock(&pplayer->mutex);
+  pplayer->prefetch = pf;
+  pplayer->status.minprefetch = nspare;
+  pthread_mutex_unlock(&pplayer->mutex);
+  return pf;
+
+err_ready:
+  free(pf->ready.slot);
+
+err_pf:
+  free(pf);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_cancel
+ *
+ *  Tell the reader to stop reading.  It finishes the buffer in progress,
+ *  if any, and exits.
+ *
+ ****************************************************************************/
+
+static void nxplayer_prefetch_cancel(FAR struct nxplayer_prefetch_s *pf)
+{
+  atomic_store(&pf->exit, true);
+  sem_post(&pf->nempty);
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_stop
+ *
+ *  Stop and join the reader thread and free the rings.  The buffers
+ *  themselves belong to the play thread.
+ *
+ ****************************************************************************/
+
+static void nxplayer_prefetch_stop(FAR struct nxplayer_s *pplayer,
+                                   FAR struct nxplayer_prefetch_s *pf)
+{
+  FAR void *value;
+
+  nxplayer_prefetch_cancel(pf);
+  pthread_join(pf->id, &value);
+
+  pthread_mutex_lock(&pplayer->mutex);
+  pplayer->prefetch = NULL;
+  pthread_mutex_unlock(&pplayer->mutex);
+
+  sem_destroy(&pf->nempty);
+  free(pf->empty.slot);
+  free(pf->ready.slot);
+  free(pf);
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_refill
+ *
+ *  Enqueue decoded buffers with the device for every buffer it is short
+ *  of.  If the reader has not caught up, ask it for a REFILL message.
+ *
+ * Returned Value:
+ *   OK while streaming, -ENODATA once the final buffer has been enqueued,
+ *   or the negated errno of a failed enqueue.
+ *
+ ****************************************************************************/
+
+static int nxplayer_prefetch_refill(FAR struct nxplayer_s *pplayer,
+                                    FAR struct nxplayer_prefetch_s *pf,
+                                    FAR int *outstanding)
+{
+  FAR struct ap_buffer_s *apb;
+  unsigned int            level;
+  int                     ret;
+
+  while (pf->owed > 0)
+    {
+      /* Track the lowest level once the reader has filled all spare
+       * buffers, so the start of the stream does not count.  Only this
+       * thread writes the status, nxplayer_getstatus() reads it under the
+       * player mutex.
+       */
+
+      level = nxplayer_ring_count(&pf->ready);
+      if (level >= pf->depth)
+        {
+          pf->primed = true;
+        }
+      else if (pf->primed && level < pplayer->status.minprefetch)
+        {
+          pthread_mutex_lock(&pplayer->mutex);
+          pplayer->status.minprefetch = level;
+          pthread_mutex_unlock(&pplayer->mutex);
+        }
+
+      apb = nxplayer_ring_pop(&pf->ready);
+      if (apb == NULL)
+        {
+          /* Set the flag first and then look again, in case the reader
+           * pushed a buffer before it could see the flag.
+           */
+
+          atomic_store(&pf->waiting, true);
+          atomic_thread_fence(memory_order_seq_cst);
+
+          apb = nxplayer_ring_pop(&pf->ready);
+          if (apb == NULL)
+            {
+              return OK;
+            }
+
+          /* At worst this leaves a REFILL message with nothing owed */
+
+          atomic_store(&pf->waiting, false);
+        }
+
+      ret = nxplayer_enqueuebuffer(pplayer, apb);
+      if (ret != OK)
+        {
+          return ret;
+        }
+
+      pf->owed--;
+      (*outstanding)++;
+
+      if ((apb->flags & AUDIO_APB_FINAL) != 0)
+        {
+          return -ENODATA;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_recycle
+ *
+ *  Return a buffer dequeued by the device to the reader and replace it
+ *  with a decoded one.
+ *
+ ****************************************************************************/
+
+static int nxplayer_prefetch_recycle(FAR struct nxplayer_s *pplayer,
+                                     FAR struct nxplayer_prefetch_s *pf,
+                                     FAR struct ap_buffer_s *apb,
+                                     FAR int *outstanding)
+{
+  int ret;
+
+  nxplayer_ring_push(&pf->empty, apb);
+  sem_post(&pf->nempty);
+
+  pf->owed++;
+  ret = nxplayer_prefetch_refill(pplayer, pf, outstanding);
+  if (ret == OK && pf->owed > 0)
+    {
+      /* The reader is behind.  The device is still playing what is left
+       * in its queue, which is an underrun once that reaches zero.
+       */
+
+      pthread_mutex_lock(&pplayer->mutex);
+      pplayer->status.late++;
+      pplayer->status.minprefetch = 0;
+      if (*outstanding == 0)
+        {
+          pplayer->status.underruns++;
+        }
+
+      pthread_mutex_unlock(&pplayer->mutex);
+    }
+
+  return ret;
+}
+#endif /* CONFIG_NXPLAYER_PREFETCH */
+
 /****************************************************************************
  * Name: nxplayer_thread_playthread
  *
@@ -795,10 +1245,12 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
   bool                    failed = false;
   struct ap_buffer_info_s buf_info;
   FAR struct ap_buffer_s  **buffers;
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  FAR struct nxplayer_prefetch_s *pf = NULL;
+#endif
   unsigned int            prio;
-#ifdef CONFIG_DEBUG_FEATURES
   int                     outstanding = 0;
-#endif
+  int                     nbuffers;
   int                     x;
   int                     ret;
 
@@ -815,10 +1267,23 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
       buf_info.nbuffers = CONFIG_AUDIO_NUM_BUFFERS;
     }
 
+  /* With prefetch enabled, the reader gets spare buffers beyond the ones
+   * queued with the device.
+   */
+
+  nbuffers = buf_info.nbuffers + NXPLAYER_NPREFETCH;
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  pthread_mutex_lock(&pplayer->mutex);
+  memset(&pplayer->status, 0, sizeof(pplayer->status));
+  pplayer->status.nbuffers = nbuffers;
+  pthread_mutex_unlock(&pplayer->mutex);
+#endif
+
   /* Create array of pointers to buffers */
 
   buffers = (FAR struct ap_buffer_s **)
-    malloc(buf_info.nbuffers * sizeof(FAR void *));
+    malloc(nbuffers * sizeof(FAR void *));
   if (buffers == NULL)
     {
       /* Error allocating memory for buffer storage! */
@@ -830,12 +1295,12 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 
   /* Create our audio pipeline buffers to use for queueing up data */
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       buffers[x] = NULL;
     }
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       /* Fill in the buffer descriptor struct to issue an alloc request */
 
@@ -921,20 +1386,30 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
                failed = true;
                break;
             }
-#ifdef CONFIG_DEBUG_FEATURES
           else
             {
               /* The audio driver has one more buffer */
 
               outstanding++;
             }
-#endif
         }
     }
 
   audinfo("%d buffers queued, running=%d streaming=%d\n",
           x, running, streaming);
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  /* Start reading ahead into the spare buffers.  If the reader cannot be
+   * started, we carry on reading from this thread.
+   */
+
+  if (running && !failed && streaming)
+    {
+      pf = nxplayer_prefetch_start(pplayer, &buffers[buf_info.nbuffers],
+                                   NXPLAYER_NPREFETCH, nbuffers);
+    }
+#endif
+
   /* Start the audio device */
 
   if (running && !failed)
@@ -1030,7 +1505,31 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
              */
 
             DEBUGASSERT(msg.u.ptr && outstanding > 0);
+#endif
             outstanding--;
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+            /* Hand the buffer to the reader and enqueue one that it has
+             * already decoded.
+             */
+
+            if (streaming && pf != NULL)
+              {
+                ret = nxplayer_prefetch_recycle(pplayer, pf, msg.u.ptr,
+                                                &outstanding);
+                if (ret != OK)
+                  {
+                    /* Either the final buffer was enqueued or the driver
+                     * refused a buffer.  Either way we stop streaming.
+                     */
+
+                    nxplayer_prefetch_cancel(pf);
+                    streaming = false;
+                    failed = (ret != -ENODATA);
+                  }
+
+                break;
+              }
 #endif
 
             /* Read data from the file directly into this buffer and
@@ -1078,18 +1577,33 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
                         streaming = false;
                         failed = true;
                       }
-#ifdef CONFIG_DEBUG_FEATURES
                     else
                       {
                         /* The audio driver has one more buffer */
 
                         outstanding++;
                       }
-#endif
                   }
               }
             break;
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+          /* The reader has decoded data we were waiting for */
+
+          case NXPLAYER_MSG_REFILL:
+            if (streaming && pf != NULL)
+              {
+                ret = nxplayer_prefetch_refill(pplayer, pf, &outstanding);
+                if (ret != OK)
+                  {
+                    nxplayer_prefetch_cancel(pf);
+                    streaming = false;
+                    failed = (ret != -ENODATA);
+                  }
+              }
+            break;
+#endif
+
           /* Someone wants to stop the playback. */
 
           case AUDIO_MSG_STOP:
@@ -1106,6 +1620,14 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 #else
             ioctl(pplayer->dev_fd, AUDIOIOC_STOP, 0);
 #endif
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+            if (pf != NULL)
+              {
+                nxplayer_prefetch_cancel(pf);
+              }
+#endif
+
             /* Stay in the running loop (without sending more data).
              * we will need to recover our audio buffers.  We will
              * loop until AUDIO_MSG_COMPLETE is received.
@@ -1136,10 +1658,19 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 err_out:
   audinfo("Clean-up and exit\n");
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  /* The reader may still be using the file and the buffers */
+
+  if (pf != NULL)
+    {
+      nxplayer_prefetch_stop(pplayer, pf);
+    }
+#endif
+
   if (buffers != NULL)
     {
       audinfo("Freeing buffers\n");
-      for (x = 0; x < buf_info.nbuffers; x++)
+      for (x = 0; x < nbuffers; x++)
         {
           /* Fill in the buffer descriptor struct to issue a free request */
 
@@ -2186,6 +2717,10 @@ FAR struct nxplayer_s *nxplayer_create(void)
   pplayer->mq = 0;
   pplayer->play_id = 0;
   pplayer->crefs = 1;
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  pplayer->prefetch = NULL;
+  memset(&pplayer->status, 0, sizeof(pplayer->status));
+#endif
 
 #ifndef CONFIG_AUDIO_EXCLUDE_TONE
   pplayer->bass = 50;
@@ -2271,6 +2806,33 @@ void nxplayer_reference(FAR struct nxplayer_s *pplayer)
   pthread_mutex_unlock(&pplayer->mutex);
 }
 
+/****************************************************************************
+ * Name: nxplayer_getstatus
+ *
+ *   nxplayer_getstatus() returns the underrun counters and the prefetch
+ *   level of the current or last playback.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+int nxplayer_getstatus(FAR struct nxplayer_s *pplayer,
+                       FAR struct nxplayer_status_s *status)
+{
+  DEBUGASSERT(pplayer != NULL && status != NULL);
+
+  pthread_mutex_lock(&pplayer->mutex);
+
+  *status = pplayer->status;
+  if (pplayer->prefetch != NULL)
+    {
+      status->prefetch = nxplayer_ring_count(&pplayer->prefetch->ready);
+    }
+
+  pthread_mutex_unlock(&pplayer->mutex);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxplayer_systemreset
  *
@@ -89,6 +89,10 @@ static int nxplayer_cmd_mediadir(FAR struct nxplayer_s *pplayer, char *parg);
 static int nxplayer_cmd_stop(FAR struct nxplayer_s *pplayer, char *parg);
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+static int nxplayer_cmd_status(FAR struct nxplayer_s *pplayer, char *parg);
+#endif
+
 #ifndef CONFIG_AUDIO_EXCLUDE_VOLUME
 static int nxplayer_cmd_volume(FAR struct nxplayer_s *pplayer, char *parg);
 #ifndef CONFIG_AUDIO_EXCLUDE_BALANCE
@@ -195,6 +199,14 @@ static struct mp_cmd_s g_nxplayer_cmds[] =
     NXPLAYER_HELP_TEXT("Resume playback")
   },
 #endif
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  {
+    "status",
+    "",
+    nxplayer_cmd_status,
+    NXPLAYER_HELP_TEXT("Show underruns and prefetch level")
+  },
+#endif
 #ifndef CONFIG_AUDIO_EXCLUDE_STOP
   {
     "stop",
@@ -542,6 +554,32 @@ static int nxplayer_cmd_stop(FAR struct nxplayer_s *pplayer, char *parg)
 }
 #endif
 
+/****************************************************************************
+ * Name: nxplayer_cmd_status
+ *
+ *   nxplayer_cmd_status() displays the underrun counters and prefetch
+ *   level of the current or last playback.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXPLAYER_PREFETCH
+static int nxplayer_cmd_status(FAR struct nxplayer_s *pplayer, char *parg)
+{
+  struct nxplayer_status_s status;
+
+  nxplayer_getstatus(pplayer, &status);
+
+  printf("Buffers:   %u (%u prefetch)\n", status.nbuffers,
+         CONFIG_NXPLAYER_PREFETCH_DEPTH);
+  printf("Prefetch:  %u now, %u minimum\n", status.prefetch,
+         status.minprefetch);
+  printf("Late:      %lu\n", (unsigned long)status.late);
+  printf("Underruns: %lu\n", (unsigned long)status.underruns);
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxplayer_cmd_pause
  *
@@ -0,0 +1,101 @@
+/****************************************************************************
+ * apps/system/sched_note/note.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_SYSTEM_SCHED_NOTE_NOTE_H
+#define __APPS_SYSTEM_SCHED_NOTE_NOTE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_dump_unflatten
+ *
+ * Description:
+ *   Copy a multi-byte field out of a note in host byte order.
+ *
+ ****************************************************************************/
+
+static inline void trace_dump_unflatten(FAR void *dst,
+                                        FAR uint8_t *src, size_t len)
+{
+#ifdef CONFIG_ENDIAN_BIG
+  FAR uint8_t *end = (FAR uint8_t *)dst + len - 1;
+  while (len-- > 0)
+    {
+      *end-- = *src++;
+    }
+#else
+  memcpy(dst, src, len);
+#endif
+}
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+
+/****************************************************************************
+ * Name: note_analyze
+ *
+ * Description:
+ *   Update the scheduler statistics with the notes in 'buffer'.
+ *
+ ****************************************************************************/
+
+void note_analyze(FAR uint8_t *buffer, size_t nread);
+
+/****************************************************************************
+ * Name: note_analyze_report
+ *
+ * Description:
+ *   Print a summary of the statistics gathered since the previous report
+ *   and start a new interval.
+ *
+ ****************************************************************************/
+
+void note_analyze_report(void);
+
+#endif /* CONFIG_SYSTEM_NOTE_ANALYZE */
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_SYSTEM_SCHED_NOTE_NOTE_H */
@@ -0,0 +1,640 @@
+/****************************************************************************
+ * apps/system/sched_note/note_analyze.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <syslog.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/sched.h>
+#include <nuttx/sched_note.h>
+
+#include "note.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Latency histogram bucket n counts latencies below 2^n microseconds, the
+ * last bucket counts everything above.
+ */
+
+#define NOTE_HIST_BUCKETS 17
+
+#if CONFIG_TASK_NAME_SIZE > 0
+#  define NOTE_NAME_SIZE  (CONFIG_TASK_NAME_SIZE + 1)
+#else
+#  define NOTE_NAME_SIZE  1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Per-task statistics.  Times are in nanoseconds of note time, latencies
+ * in microseconds.
+ */
+
+struct note_task_s
+{
+  pid_t pid;                 /* Task ID, -1 if the entry is free */
+  uint8_t priority;          /* Last seen priority */
+  bool exited;               /* Task exited, free after the next report */
+  char name[NOTE_NAME_SIZE]; /* Task name, if known */
+  uint64_t runstart;         /* Time the task started running, 0 if not */
+  uint64_t readysince;       /* Time the task became ready, 0 if not */
+  uint64_t lockstart;        /* Time preemption was disabled, 0 if not */
+  uint64_t runtime;          /* Time spent running in this interval */
+  uint64_t lattotal;         /* Sum of ready-to-run latencies */
+  uint32_t latcount;         /* Number of ready-to-run latencies */
+  uint32_t latmax;           /* Maximum ready-to-run latency */
+  uint32_t lockmax;          /* Longest period with preemption disabled */
+  uint32_t switches;         /* Number of times the task was switched in */
+  uint32_t preemptions;      /* Number of times the task was preempted */
+};
+
+/* Per-IRQ statistics */
+
+struct note_irq_s
+{
+  int irq;                   /* IRQ number, -1 if the entry is free */
+  uint64_t entry;            /* Time of the handler entry, 0 if not active */
+  uint64_t total;            /* Total handler time in this interval */
+  uint32_t count;            /* Number of handler invocations */
+  uint32_t max;              /* Longest handler invocation */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct note_task_s g_tasks[CONFIG_SYSTEM_NOTE_ANALYZE_NTASKS];
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+static struct note_irq_s g_irqs[CONFIG_SYSTEM_NOTE_ANALYZE_NIRQS];
+#endif
+static uint32_t g_lathist[NOTE_HIST_BUCKETS];
+static uint32_t g_nnotes;
+static uint32_t g_untracked;
+static uint64_t g_first;
+static uint64_t g_last;
+static bool g_initialized;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: note_initialize
+ ****************************************************************************/
+
+static void note_initialize(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NTASKS; i++)
+    {
+      g_tasks[i].pid = -1;
+    }
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NIRQS; i++)
+    {
+      g_irqs[i].irq = -1;
+    }
+#endif
+
+  g_initialized = true;
+}
+
+/****************************************************************************
+ * Name: note_findtask
+ *
+ * Description:
+ *   Find the table entry of 'pid', allocating a new entry if there is none
+ *   yet.  Returns NULL if the table is full.
+ *
+ ****************************************************************************/
+
+static FAR struct note_task_s *note_findtask(pid_t pid)
+{
+  FAR struct note_task_s *freeentry = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NTASKS; i++)
+    {
+      if (g_tasks[i].pid == pid)
+        {
+          return &g_tasks[i];
+        }
+      else if (g_tasks[i].pid < 0 && freeentry == NULL)
+        {
+          freeentry = &g_tasks[i];
+        }
+    }
+
+  if (freeentry == NULL)
+    {
+      g_untracked++;
+      return NULL;
+    }
+
+  memset(freeentry, 0, sizeof(*freeentry));
+  freeentry->pid = pid;
+  return freeentry;
+}
+
+/****************************************************************************
+ * Name: note_findirq
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+static FAR struct note_irq_s *note_findirq(int irq)
+{
+  FAR struct note_irq_s *freeentry = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NIRQS; i++)
+    {
+      if (g_irqs[i].irq == irq)
+        {
+          return &g_irqs[i];
+        }
+      else if (g_irqs[i].irq < 0 && freeentry == NULL)
+        {
+          freeentry = &g_irqs[i];
+        }
+    }
+
+  if (freeentry == NULL)
+    {
+      g_untracked++;
+      return NULL;
+    }
+
+  memset(freeentry, 0, sizeof(*freeentry));
+  freeentry->irq = irq;
+  return freeentry;
+}
+#endif
+
+/****************************************************************************
+ * Name: note_elapsed
+ *
+ * Description:
+ *   Return the time from 'start' to 'now' in microseconds, saturated to
+ *   32 bits.
+ *
+ ****************************************************************************/
+
+static uint32_t note_elapsed(uint64_t start, uint64_t now)
+{
+  uint64_t usec;
+
+  if (now <= start)
+    {
+      return 0;
+    }
+
+  usec = (now - start) / NSEC_PER_USEC;
+  return usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec;
+}
+
+/****************************************************************************
+ * Name: note_stoprunning
+ *
+ * Description:
+ *   Account the time a task has been running up to 'now'.
+ *
+ ****************************************************************************/
+
+static void note_stoprunning(FAR struct note_task_s *task, uint64_t now)
+{
+  if (task->runstart != 0 && now > task->runstart)
+    {
+      task->runtime += now - task->runstart;
+    }
+
+  task->runstart = 0;
+}
+
+/****************************************************************************
+ * Name: note_tasksuspend
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+static void note_tasksuspend(FAR struct note_task_s *task, uint8_t state,
+                             uint64_t now)
+{
+  note_stoprunning(task, now);
+
+  /* A task that is suspended while still runnable has been preempted.
+   * Its ready-to-run latency is measured from now until it runs again.
+   */
+
+  if (state == TSTATE_TASK_READYTORUN || state == TSTATE_TASK_PENDING)
+    {
+      task->preemptions++;
+      task->readysince = now;
+    }
+  else
+    {
+      task->readysince = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: note_taskresume
+ ****************************************************************************/
+
+static void note_taskresume(FAR struct note_task_s *task, uint64_t now)
+{
+  uint32_t latency;
+  int bucket;
+
+  task->switches++;
+  task->runstart = now;
+
+  if (task->readysince == 0)
+    {
+      return;
+    }
+
+  latency = note_elapsed(task->readysince, now);
+  task->readysince = 0;
+  task->lattotal  += latency;
+  task->latcount++;
+
+  if (latency > task->latmax)
+    {
+      task->latmax = latency;
+    }
+
+  for (bucket = 0;
+       bucket < NOTE_HIST_BUCKETS - 1 && latency >= (UINT32_C(1) << bucket);
+       bucket++)
+    {
+    }
+
+  g_lathist[bucket]++;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: note_analyze
+ *
+ * Description:
+ *   Update the scheduler statistics with the notes in 'buffer'.  Only
+ *   fixed-size tables are updated so the cost per note is small and
+ *   bounded.
+ *
+ ****************************************************************************/
+
+void note_analyze(FAR uint8_t *buffer, size_t nread)
+{
+  FAR struct note_common_s *note;
+  FAR struct note_task_s *task;
+  uint32_t systime_sec;
+  uint32_t systime_nsec;
+  uint64_t now;
+  pid_t pid;
+  off_t offset;
+
+  if (!g_initialized)
+    {
+      note_initialize();
+    }
+
+  offset = 0;
+  while (offset + sizeof(struct note_common_s) <= nread)
+    {
+      note = (FAR struct note_common_s *)&buffer[offset];
+      if (note->nc_length < sizeof(struct note_common_s) ||
+          offset + note->nc_length > nread)
+        {
+          syslog(LOG_ERR, "note: bad note length: %d\n", note->nc_length);
+          return;
+        }
+
+      offset += note->nc_length;
+
+      trace_dump_unflatten(&pid, note->nc_pid, sizeof(pid));
+      trace_dump_unflatten(&systime_nsec,
+                           note->nc_systime_nsec, sizeof(systime_nsec));
+      trace_dump_unflatten(&systime_sec,
+                           note->nc_systime_sec, sizeof(systime_sec));
+
+      /* A zero timestamp means "not set" in the tables */
+
+      now = (uint64_t)systime_sec * NSEC_PER_SEC + systime_nsec + 1;
+      if (g_first == 0)
+        {
+          g_first = now;
+        }
+
+      g_last = now;
+      g_nnotes++;
+
+      switch (note->nc_type)
+        {
+          case NOTE_START:
+            {
+              task = note_findtask(pid);
+              if (task != NULL)
+                {
+#if CONFIG_TASK_NAME_SIZE > 0
+                  FAR struct note_start_s *note_start =
+                    (FAR struct note_start_s *)note;
+
+                  strlcpy(task->name, note_start->nst_name,
+                          sizeof(task->name));
+#endif
+                  task->priority = note->nc_priority;
+                }
+            }
+            break;
+
+          case NOTE_STOP:
+            {
+              task = note_findtask(pid);
+              if (task != NULL)
+                {
+                  note_stoprunning(task, now);
+                  task->priority = note->nc_priority;
+                  task->exited   = true;
+                }
+            }
+            break;
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+          case NOTE_SUSPEND:
+            {
+              FAR struct note_suspend_s *note_suspend =
+                (FAR struct note_suspend_s *)note;
+
+              task = note_findtask(pid);
+              if (task != NULL)
+                {
+                  task->priority = note->nc_priority;
+                  note_tasksuspend(task, note_suspend->nsu_state, now);
+                }
+            }
+            break;
+
+          case NOTE_RESUME:
+            {
+              task = note_findtask(pid);
+              if (task != NULL)
+                {
+                  task->priority = note->nc_priority;
+                  note_taskresume(task, now);
+                }
+            }
+            break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_PREEMPTION
+          case NOTE_PREEMPT_LOCK:
+          case NOTE_PREEMPT_UNLOCK:
+            {
+              FAR struct note_preempt_s *note_preempt =
+                (FAR struct note_preempt_s *)note;
+              uint32_t locktime;
+              uint16_t count;
+
+              task = note_findtask(pid);
+              if (task == NULL)
+                {
+                  break;
+                }
+
+              trace_dump_unflatten(&count, note_preempt->npr_count,
+                                   sizeof(count));
+
+              if (note->nc_type == NOTE_PREEMPT_LOCK)
+                {
+                  if (task->lockstart == 0)
+                    {
+                      task->lockstart = now;
+                    }
+                }
+              else if (count == 0 && task->lockstart != 0)
+                {
+                  locktime = note_elapsed(task->lockstart, now);
+                  if (locktime > task->lockmax)
+                    {
+                      task->lockmax = locktime;
+                    }
+
+                  task->lockstart = 0;
+                }
+            }
+            break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+          case NOTE_IRQ_ENTER:
+          case NOTE_IRQ_LEAVE:
+            {
+              FAR struct note_irqhandler_s *note_irq =
+                (FAR struct note_irqhandler_s *)note;
+              FAR struct note_irq_s *irq;
+              uint32_t duration;
+
+              irq = note_findirq(note_irq->nih_irq);
+              if (irq == NULL)
+                {
+                  break;
+                }
+
+              if (note->nc_type == NOTE_IRQ_ENTER)
+                {
+                  irq->entry = now;
+                }
+              else if (irq->entry != 0)
+                {
+                  duration    = note_elapsed(irq->entry, now);
+                  irq->entry  = 0;
+                  irq->total += duration;
+                  irq->count++;
+
+                  if (duration > irq->max)
+                    {
+                      irq->max = duration;
+                    }
+                }
+            }
+            break;
+#endif
+
+          default:
+            break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: note_analyze_report
+ *
+ * Description:
+ *   Print a summary of the statistics gathered since the previous report
+ *   and start a new interval.  Tasks that have exited are removed from the
+ *   table after they have been reported once.
+ *
+ ****************************************************************************/
+
+void note_analyze_report(void)
+{
+  FAR struct note_task_s *task;
+  uint64_t interval;
+  uint32_t permille;
+  char hist[96];
+  int len;
+  int i;
+
+  if (!g_initialized || g_nnotes == 0)
+    {
+      syslog(LOG_INFO, "note: no notes\n");
+      return;
+    }
+
+  interval = g_last > g_first ? g_last - g_first : 1;
+
+  syslog(LOG_INFO,
+         "note: %" PRIu32 " notes in %" PRIu32 " ms, %" PRIu32
+         " untracked\n",
+         g_nnotes, (uint32_t)(interval / NSEC_PER_MSEC), g_untracked);
+  syslog(LOG_INFO,
+         "  PID PRI   CPU%% SWITCH PREEMPT  LATAVG  LATMAX LOCKMAX NAME\n");
+
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NTASKS; i++)
+    {
+      task = &g_tasks[i];
+      if (task->pid < 0)
+        {
+          continue;
+        }
+
+      /* Account the running time of tasks that are still running */
+
+      if (task->runstart != 0)
+        {
+          note_stoprunning(task, g_last);
+          task->runstart = g_last;
+        }
+
+#if CONFIG_TASK_NAME_SIZE > 0
+      if (task->name[0] == '\0' && !task->exited)
+        {
+          pthread_getname_np(task->pid, task->name, sizeof(task->name));
+        }
+#endif
+
+      permille = (uint32_t)(task->runtime * 1000 / interval);
+
+      syslog(LOG_INFO,
+             "%5d %3u %3" PRIu32 ".%" PRIu32 " %6" PRIu32 " %7" PRIu32
+             " %7" PRIu32 " %7" PRIu32 " %7" PRIu32 " %s%s\n",
+             (int)task->pid, task->priority,
+             permille / 10, permille % 10,
+             task->switches, task->preemptions,
+             task->latcount ?
+               (uint32_t)(task->lattotal / task->latcount) : 0,
+             task->latmax, task->lockmax,
+             task->name, task->exited ? " (exited)" : "");
+
+      /* Start a new interval */
+
+      if (task->exited)
+        {
+          task->pid = -1;
+        }
+      else
+        {
+          task->runtime     = 0;
+          task->lattotal    = 0;
+          task->latcount    = 0;
+          task->latmax      = 0;
+          task->lockmax     = 0;
+          task->switches    = 0;
+          task->preemptions = 0;
+        }
+    }
+
+  /* Ready-to-run latency histogram, non-empty buckets only */
+
+  len = 0;
+  hist[0] = '\0';
+  for (i = 0; i < NOTE_HIST_BUCKETS; i++)
+    {
+      if (g_lathist[i] != 0 && len < sizeof(hist))
+        {
+          len += snprintf(&hist[len], sizeof(hist) - len,
+                          i < NOTE_HIST_BUCKETS - 1 ?
+                            " <%" PRIu32 ":%" PRIu32 :
+                            " >=%" PRIu32 ":%" PRIu32,
+                          UINT32_C(1) << (i < NOTE_HIST_BUCKETS - 1 ?
+                                          i : i - 1),
+                          g_lathist[i]);
+        }
+    }
+
+  syslog(LOG_INFO, "  Latency (usec):%s\n", hist);
+  memset(g_lathist, 0, sizeof(g_lathist));
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+  syslog(LOG_INFO, "  IRQ   COUNT  AVG(us)  MAX(us)\n");
+
+  for (i = 0; i < CONFIG_SYSTEM_NOTE_ANALYZE_NIRQS; i++)
+    {
+      FAR struct note_irq_s *irq = &g_irqs[i];
+
+      if (irq->irq < 0 || irq->count == 0)
+        {
+          continue;
+        }
+
+      syslog(LOG_INFO, "  %3d %7" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n",
+             irq->irq, irq->count, (uint32_t)(irq->total / irq->count),
+             irq->max);
+
+      irq->total = 0;
+      irq->count = 0;
+      irq->max   = 0;
+    }
+#endif
+
+  g_nnotes    = 0;
+  g_untracked = 0;
+  g_first     = g_last;
+}
@@ -30,19 +30,23 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <syslog.h>
+#include <string.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <nuttx/sched_note.h>
 
+#include "note.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
 #  define syslog_time(priority, fmt, ...) \
-            syslog(priority, "%08lx: " fmt, \
-                   (unsigned long)systime, \
+            syslog(priority, "%4" PRIu32 ".%09" PRIu32 ": " fmt, \
+                   systime_sec, systime_nsec, \
                    __VA_ARGS__)
 
 /****************************************************************************
@@ -77,24 +81,6 @@ static FAR const char *g_statenames[] =
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************
- * Name: trace_dump_unflatten
- ****************************************************************************/
-
-static void trace_dump_unflatten(FAR void *dst,
-                                 FAR uint8_t *src, size_t len)
-{
-#ifdef CONFIG_ENDIAN_BIG
-  FAR uint8_t *end = (FAR uint8_t *)dst + len - 1;
-  while (len-- > 0)
-    {
-      *end-- = *src++;
-    }
-#else
-  memcpy(dst, src, len);
-#endif
-}
-
 /****************************************************************************
  * Name: dump_notes
  ****************************************************************************/
@@ -775,9 +761,19 @@ static void dump_notes(size_t nread)
 
 static int note_daemon(int argc, char *argv[])
 {
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+  struct timespec last;
+  struct timespec now;
+  bool analyze;
+#endif
   ssize_t nread;
   int fd;
 
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+  analyze = argc > 1 && strcmp(argv[1], "-a") == 0;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+#endif
+
   /* Indicate that we are running */
 
   g_note_daemon_started = true;
@@ -800,6 +796,32 @@ static int note_daemon(int argc, char *argv[])
 
   for (; ; )
     {
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+      if (analyze)
+        {
+          /* Drain all buffered notes into the statistics tables and print
+           * a summary once per interval.
+           */
+
+          while ((nread = read(fd, g_note_buffer,
+                               CONFIG_SYSTEM_NOTE_BUFFERSIZE)) > 0)
+            {
+              note_analyze(g_note_buffer, nread);
+            }
+
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          if (now.tv_sec - last.tv_sec >=
+              CONFIG_SYSTEM_NOTE_ANALYZE_INTERVAL)
+            {
+              note_analyze_report();
+              last = now;
+            }
+
+          usleep(CONFIG_SYSTEM_NOTE_DELAY * 1000L);
+          continue;
+        }
+#endif
+
       nread = read(fd, g_note_buffer, CONFIG_SYSTEM_NOTE_BUFFERSIZE);
       if (nread > 0)
         {
@@ -828,8 +850,32 @@ errout:
 
 int main(int argc, FAR char *argv[])
 {
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+  FAR char *daemon_argv[2] =
+  {
+    NULL, NULL
+  };
+#endif
+
   int ret;
 
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+  /* Usage: note [-a] */
+
+  if (argc > 1)
+    {
+      if (strcmp(argv[1], "-a") != 0)
+        {
+          printf("Usage: %s [-a]\n"
+                 "  -a  Print scheduler statistics instead of each note\n",
+                 argv[0]);
+          return EXIT_FAILURE;
+        }
+
+      daemon_argv[0] = argv[1];
+    }
+#endif
+
   printf("note_main: Starting the note_daemon\n");
   if (g_note_daemon_started)
     {
@@ -837,9 +883,15 @@ int main(int argc, FAR char *argv[])
       return EXIT_SUCCESS;
     }
 
+#ifdef CONFIG_SYSTEM_NOTE_ANALYZE
+  ret = task_create("note_daemon", CONFIG_SYSTEM_NOTE_PRIORITY,
+                    CONFIG_SYSTEM_NOTE_STACKSIZE, note_daemon,
+                    daemon_argv);
+#else
   ret = task_create("note_daemon", CONFIG_SYSTEM_NOTE_PRIORITY,
                     CONFIG_SYSTEM_NOTE_STACKSIZE, note_daemon,
                     NULL);
+#endif
   if (ret < 0)
     {
       int errcode = errno;
@@ -0,0 +1,1086 @@
+/****************************************************************************
+ * apps/system/sysmon/sysmon.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+
+#ifdef CONFIG_SYSTEM_SYSMON
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_SYSMON_DAEMON_STACKSIZE
+#  define CONFIG_SYSTEM_SYSMON_DAEMON_STACKSIZE 2048
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_DAEMON_PRIORITY
+#  define CONFIG_SYSTEM_SYSMON_DAEMON_PRIORITY 50
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_INTERVAL
+#  define CONFIG_SYSTEM_SYSMON_INTERVAL 2
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_NTASKS
+#  define CONFIG_SYSTEM_SYSMON_NTASKS 32
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_NRECORDS
+#  define CONFIG_SYSTEM_SYSMON_NRECORDS 512
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_RINGFILE
+#  define CONFIG_SYSTEM_SYSMON_RINGFILE "/tmp/sysmon.bin"
+#endif
+
+#ifndef CONFIG_SYSTEM_SYSMON_MOUNTPOINT
+#  define CONFIG_SYSTEM_SYSMON_MOUNTPOINT "/proc"
+#endif
+
+#ifdef CONFIG_SMP
+#  define SYSMON_NCPUS         CONFIG_SMP_NCPUS
+#else
+#  define SYSMON_NCPUS         1
+#endif
+
+/* Records of one interval: every task plus the per-CPU totals */
+
+#define SYSMON_NSAMPLES        (CONFIG_SYSTEM_SYSMON_NTASKS + SYSMON_NCPUS)
+
+#define SYSMON_MAGIC           0x4e4d5953  /* "SYMN" */
+#define SYSMON_VERSION         1
+#define SYSMON_NAMELEN         12
+#define SYSMON_LINELEN         128
+#define SYSMON_MAXERRORS       100
+
+/* Number of records that "sysmon" reads from the ring file at once */
+
+#define SYSMON_READCHUNK       16
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The ring file starts with this header, followed by nrecords records.
+ * Record n of the ring lives in slot (n % nrecords).
+ */
+
+struct sysmon_header_s
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recsize;
+  uint32_t nrecords;            /* Number of record slots in the file */
+  uint32_t total;               /* Number of records written so far */
+  uint32_t seq;                 /* Last completed interval */
+};
+
+/* One sample of one task.  Times are in microseconds and hold the longest
+ * duration seen since the previous interval.
+ */
+
+struct sysmon_record_s
+{
+  uint32_t seq;                 /* Interval that the sample belongs to */
+  uint32_t timestamp;           /* Milliseconds since boot */
+  int32_t  pid;                 /* Task ID, or -1 - CPU for CPU totals */
+  uint32_t preempt;             /* Longest time with pre-emption disabled */
+  uint32_t csection;            /* Longest time in a critical section */
+  uint32_t run;                 /* Longest time run without a switch */
+  uint32_t stacksize;           /* Size of the stack in bytes */
+  uint32_t stackused;           /* Stack high water mark in bytes */
+  char     name[SYSMON_NAMELEN];
+};
+
+/* The record size is part of the file format (and of the Kconfig help) */
+
+static_assert(sizeof(struct sysmon_record_s) == 44,
+              "sysmon record size changed");
+
+/* The daemon keeps the procfs files of each task open across intervals */
+
+struct sysmon_task_s
+{
+  pid_t pid;                    /* -1 if the entry is unused */
+  bool  seen;                   /* Still listed in the current interval */
+  int   critfd;                 /* /proc/<pid>/critmon */
+  int   stackfd;                /* /proc/<pid>/stack */
+  char  name[SYSMON_NAMELEN];
+};
+
+struct sysmon_state_s
+{
+  volatile bool started;
+  volatile bool stop;
+  pid_t pid;
+};
+
+/* Thresholds of the "sysmon" query, zero means not used */
+
+struct sysmon_query_s
+{
+  uint32_t preempt;
+  uint32_t csection;
+  uint32_t run;
+  uint32_t stackpct;
+  pid_t    pid;
+  bool     pidset;
+  bool     filter;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct sysmon_state_s g_sysmon;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sysmon_check_name
+ ****************************************************************************/
+
+static bool sysmon_check_name(FAR const char *name)
+{
+  int i;
+
+  /* Check each character in the name */
+
+  for (i = 0; i < NAME_MAX && name[i] != '\0'; i++)
+    {
+      if (!isdigit(name[i]))
+        {
+          /* Name contains something other than a decimal numeric character */
+
+          return false;
+        }
+    }
+
+  return i > 0;
+}
+
+/****************************************************************************
+ * Name: sysmon_readfile
+ *
+ * Description:
+ *   Read an open procfs file from the start into 'buffer' and terminate
+ *   it.  Returns the number of bytes read or a negated errno value.
+ *
+ ****************************************************************************/
+
+static ssize_t sysmon_readfile(int fd, FAR char *buffer, size_t buflen)
+{
+  ssize_t nread;
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    {
+      return -errno;
+    }
+
+  nread = read(fd, buffer, buflen - 1);
+  if (nread < 0)
+    {
+      return -errno;
+    }
+
+  buffer[nread] = '\0';
+  return nread;
+}
+
+/****************************************************************************
+ * Name: sysmon_openfile
+ ****************************************************************************/
+
+static int sysmon_openfile(pid_t pid, FAR const char *file)
+{
+  char path[32 + sizeof(CONFIG_SYSTEM_SYSMON_MOUNTPOINT)];
+
+  snprintf(path, sizeof(path), CONFIG_SYSTEM_SYSMON_MOUNTPOINT "/%d/%s",
+           (int)pid, file);
+  return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+/****************************************************************************
+ * Name: sysmon_parsetime
+ *
+ * Description:
+ *   Convert a "seconds.nanoseconds" field to microseconds, saturating at
+ *   UINT32_MAX, and step past it and the separator that follows.
+ *
+ ****************************************************************************/
+
+static uint32_t sysmon_parsetime(FAR const char **pptr)
+{
+  FAR const char *ptr = *pptr;
+  uint64_t sec = 0;
+  uint32_t usec = 0;
+  int ndigits;
+
+  while (isdigit(*ptr))
+    {
+      if (sec < UINT32_MAX)
+        {
+          sec = sec * 10 + (*ptr - '0');
+        }
+
+      ptr++;
+    }
+
+  if (*ptr == '.')
+    {
+      for (ptr++, ndigits = 0; isdigit(*ptr); ptr++, ndigits++)
+        {
+          if (ndigits < 6)
+            {
+              usec = usec * 10 + (*ptr - '0');
+            }
+        }
+
+      for (; ndigits < 6; ndigits++)
+        {
+          usec *= 10;
+        }
+    }
+
+  if (*ptr == ',')
+    {
+      ptr++;
+    }
+
+  *pptr = ptr;
+  sec   = sec * 1000000 + usec;
+  return sec > UINT32_MAX ? UINT32_MAX : (uint32_t)sec;
+}
+
+/****************************************************************************
+ * Name: sysmon_parsefield
+ *
+ * Description:
+ *   Find the "<key> <value>" line in 'buffer' and return its decimal value,
+ *   or 0 if there is no such line.
+ *
+ ****************************************************************************/
+
+static uint32_t sysmon_parsefield(FAR const char *buffer,
+                                  FAR const char *key)
+{
+  FAR const char *ptr = strstr(buffer, key);
+
+  if (ptr == NULL)
+    {
+      return 0;
+    }
+
+  return (uint32_t)strtoul(ptr + strlen(key), NULL, 10);
+}
+
+/****************************************************************************
+ * Name: sysmon_gettime
+ ****************************************************************************/
+
+static uint32_t sysmon_gettime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/****************************************************************************
+ * Name: sysmon_task_open
+ *
+ * Description:
+ *   Start monitoring a task that showed up in the procfs.  The task name is
+ *   read only once here.
+ *
+ ****************************************************************************/
+
+static int sysmon_task_open(FAR struct sysmon_task_s *task, pid_t pid)
+{
+  char line[SYSMON_LINELEN];
+  FAR char *name;
+  int fd;
+  int i;
+
+  task->pid     = pid;
+  task->critfd  = -1;
+  task->stackfd = -1;
+  task->name[0] = '\0';
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  task->critfd = sysmon_openfile(pid, "critmon");
+  if (task->critfd < 0)
+    {
+      return -errno;
+    }
+#endif
+
+  task->stackfd = sysmon_openfile(pid, "stack");
+
+  /* The first line of the status file is "Name: <name>" */
+
+  fd = sysmon_openfile(pid, "status");
+  if (fd >= 0)
+    {
+      if (sysmon_readfile(fd, line, sizeof(line)) > 0 &&
+          strncmp(line, "Name:", 5) == 0)
+        {
+          name = line + 5;
+          while (isblank(*name))
+            {
+              name++;
+            }
+
+          for (i = 0; i < SYSMON_NAMELEN - 1 && isgraph(name[i]); i++)
+            {
+              task->name[i] = name[i];
+            }
+
+          task->name[i] = '\0';
+        }
+
+      close(fd);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sysmon_task_close
+ ****************************************************************************/
+
+static void sysmon_task_close(FAR struct sysmon_task_s *task)
+{
+  if (task->critfd >= 0)
+    {
+      close(task->critfd);
+    }
+
+  if (task->stackfd >= 0)
+    {
+      close(task->stackfd);
+    }
+
+  task->pid = -1;
+}
+
+/****************************************************************************
+ * Name: sysmon_task_sample
+ *
+ * Description:
+ *   Read the current values of one task into 'rec'.
+ *
+ ****************************************************************************/
+
+static int sysmon_task_sample(FAR struct sysmon_task_s *task,
+                              FAR struct sysmon_record_s *rec)
+{
+  char line[SYSMON_LINELEN];
+  FAR const char *ptr;
+  ssize_t ret;
+
+  memset(rec, 0, sizeof(*rec));
+  rec->pid = task->pid;
+  memcpy(rec->name, task->name, SYSMON_NAMELEN);
+
+  /* Format: <preempt>,<csection>,<run>,<runtime>.  Reading the file also
+   * resets the maxima, so each sample covers one interval.
+   */
+
+  if (task->critfd >= 0)
+    {
+      ret = sysmon_readfile(task->critfd, line, sizeof(line));
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ptr           = line;
+      rec->preempt  = sysmon_parsetime(&ptr);
+      rec->csection = sysmon_parsetime(&ptr);
+      rec->run      = sysmon_parsetime(&ptr);
+    }
+
+  if (task->stackfd >= 0)
+    {
+      ret = sysmon_readfile(task->stackfd, line, sizeof(line));
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      rec->stacksize = sysmon_parsefield(line, "StackSize:");
+      rec->stackused = sysmon_parsefield(line, "StackUsed:");
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sysmon_cpu_sample
+ *
+ * Description:
+ *   Add one record per CPU from the global critmon file.  Returns the
+ *   number of records added.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+static int sysmon_cpu_sample(int fd, FAR struct sysmon_record_s *rec)
+{
+  char line[SYSMON_LINELEN];
+  FAR const char *ptr;
+  FAR char *endptr;
+  int cpu;
+  int n = 0;
+
+  if (fd < 0 || sysmon_readfile(fd, line, sizeof(line)) <= 0)
+    {
+      return 0;
+    }
+
+  /* One line per CPU, format: <cpu>,<preempt>,<csection> */
+
+  ptr = line;
+  while (*ptr != '\0' && n < SYSMON_NCPUS)
+    {
+      cpu = (int)strtol(ptr, &endptr, 10);
+      if (*endptr != ',')
+        {
+          break;
+        }
+
+      ptr           = endptr + 1;
+      memset(rec, 0, sizeof(*rec));
+      rec->pid      = -1 - cpu;
+      rec->preempt  = sysmon_parsetime(&ptr);
+      rec->csection = sysmon_parsetime(&ptr);
+      snprintf(rec->name, SYSMON_NAMELEN, "CPU %d", cpu);
+
+      rec++;
+      n++;
+
+      ptr = strchr(ptr, '\n');
+      if (ptr == NULL)
+        {
+          break;
+        }
+
+      ptr++;
+    }
+
+  return n;
+}
+#endif
+
+/****************************************************************************
+ * Name: sysmon_lookup
+ *
+ * Description:
+ *   Find the table entry of 'pid', or set up a free one for it.
+ *
+ ****************************************************************************/
+
+static FAR struct sysmon_task_s *
+sysmon_lookup(FAR struct sysmon_task_s *tasks, pid_t pid)
+{
+  FAR struct sysmon_task_s *freetask = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_SYSMON_NTASKS; i++)
+    {
+      if (tasks[i].pid == pid)
+        {
+          return &tasks[i];
+        }
+      else if (tasks[i].pid < 0 && freetask == NULL)
+        {
+          freetask = &tasks[i];
+        }
+    }
+
+  if (freetask != NULL && sysmon_task_open(freetask, pid) < 0)
+    {
+      sysmon_task_close(freetask);
+      freetask = NULL;
+    }
+
+  return freetask;
+}
+
+/****************************************************************************
+ * Name: sysmon_flush
+ *
+ * Description:
+ *   Append the records of one interval to the ring file and publish them
+ *   by updating the header.
+ *
+ ****************************************************************************/
+
+static int sysmon_flush(int fd, FAR struct sysmon_header_s *hdr,
+                        FAR struct sysmon_record_s *recs, uint32_t nrecs)
+{
+  uint32_t chunk;
+  uint32_t slot;
+
+  /* Only the newest records survive if there are more than slots */
+
+  if (nrecs > hdr->nrecords)
+    {
+      recs  += nrecs - hdr->nrecords;
+      nrecs  = hdr->nrecords;
+    }
+
+  while (nrecs > 0)
+    {
+      slot  = hdr->total % hdr->nrecords;
+      chunk = hdr->nrecords - slot;
+      if (chunk > nrecs)
+        {
+          chunk = nrecs;
+        }
+
+      if (pwrite(fd, recs, chunk * sizeof(*recs),
+                 sizeof(*hdr) + slot * sizeof(*recs)) < 0)
+        {
+          return -errno;
+        }
+
+      recs       += chunk;
+      nrecs      -= chunk;
+      hdr->total += chunk;
+    }
+
+  hdr->seq++;
+  if (pwrite(fd, hdr, sizeof(*hdr), 0) < 0)
+    {
+      return -errno;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sysmon_sample
+ *
+ * Description:
+ *   Walk the procfs once, sample every task and write out the records.
+ *
+ ****************************************************************************/
+
+static int sysmon_sample(FAR struct sysmon_task_s *tasks,
+                         FAR struct sysmon_record_s *recs,
+                         int cpufd, int ringfd,
+                         FAR struct sysmon_header_s *hdr)
+{
+  FAR struct sysmon_task_s *task;
+  FAR struct dirent *entryp;
+  uint32_t timestamp;
+  uint32_t nrecs = 0;
+  uint32_t i;
+  DIR *dirp;
+
+  dirp = opendir(CONFIG_SYSTEM_SYSMON_MOUNTPOINT);
+  if (dirp == NULL)
+    {
+      return -errno;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SYSMON_NTASKS; i++)
+    {
+      tasks[i].seen = false;
+    }
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  nrecs = sysmon_cpu_sample(cpufd, recs);
+#endif
+
+  while ((entryp = readdir(dirp)) != NULL)
+    {
+      /* Task/thread entries in the /proc directory will all be (1)
+       * directories with (2) all numeric names.
+       */
+
+      if (!DIRENT_ISDIRECTORY(entryp->d_type) ||
+          !sysmon_check_name(entryp->d_name))
+        {
+          continue;
+        }
+
+      task = sysmon_lookup(tasks, atoi(entryp->d_name));
+      if (task == NULL)
+        {
+          /* The table is full, the task is not monitored */
+
+          continue;
+        }
+
+      if (sysmon_task_sample(task, &recs[nrecs]) < 0)
+        {
+          /* The task has gone away while we looked at it */
+
+          sysmon_task_close(task);
+          continue;
+        }
+
+      task->seen = true;
+      nrecs++;
+    }
+
+  closedir(dirp);
+
+  /* Drop the tasks that have exited since the previous interval */
+
+  for (i = 0; i < CONFIG_SYSTEM_SYSMON_NTASKS; i++)
+    {
+      if (tasks[i].pid >= 0 && !tasks[i].seen)
+        {
+          sysmon_task_close(&tasks[i]);
+        }
+    }
+
+  timestamp = sysmon_gettime();
+  for (i = 0; i < nrecs; i++)
+    {
+      recs[i].seq       = hdr->seq + 1;
+      recs[i].timestamp = timestamp;
+    }
+
+  return sysmon_flush(ringfd, hdr, recs, nrecs);
+}
+
+/****************************************************************************
+ * Name: sysmon_daemon
+ ****************************************************************************/
+
+static int sysmon_daemon(int argc, FAR char **argv)
+{
+  FAR struct sysmon_record_s *recs;
+  FAR struct sysmon_task_s *tasks;
+  struct sysmon_header_s hdr;
+  int exitcode = EXIT_FAILURE;
+  int errcount = 0;
+  int ringfd;
+  int cpufd = -1;
+  int ret;
+  int i;
+
+  printf("System Monitor: Running: %d\n", g_sysmon.pid);
+
+  tasks = malloc(CONFIG_SYSTEM_SYSMON_NTASKS * sizeof(*tasks));
+  recs  = malloc(SYSMON_NSAMPLES * sizeof(*recs));
+  if (tasks == NULL || recs == NULL)
+    {
+      fprintf(stderr, "System Monitor: Out of memory\n");
+      goto errout_with_memory;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SYSMON_NTASKS; i++)
+    {
+      tasks[i].pid = -1;
+    }
+
+  ringfd = open(CONFIG_SYSTEM_SYSMON_RINGFILE,
+                O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (ringfd < 0)
+    {
+      fprintf(stderr, "System Monitor: Failed to open %s: %d\n",
+              CONFIG_SYSTEM_SYSMON_RINGFILE, errno);
+      goto errout_with_memory;
+    }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic    = SYSMON_MAGIC;
+  hdr.version  = SYSMON_VERSION;
+  hdr.recsize  = sizeof(struct sysmon_record_s);
+  hdr.nrecords = CONFIG_SYSTEM_SYSMON_NRECORDS;
+
+  if (write(ringfd, &hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+      fprintf(stderr, "System Monitor: Failed to write %s: %d\n",
+              CONFIG_SYSTEM_SYSMON_RINGFILE, errno);
+      goto errout_with_ringfd;
+    }
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  cpufd = open(CONFIG_SYSTEM_SYSMON_MOUNTPOINT "/critmon",
+               O_RDONLY | O_CLOEXEC);
+#endif
+
+  exitcode = EXIT_SUCCESS;
+
+  /* Loop until we detect that there is a request to stop. */
+
+  while (!g_sysmon.stop)
+    {
+      ret = sysmon_sample(tasks, recs, cpufd, ringfd, &hdr);
+      if (ret < 0)
+        {
+          fprintf(stderr, "System Monitor: Failed to take a sample: %d\n",
+                  ret);
+
+          if (++errcount > SYSMON_MAXERRORS)
+            {
+              fprintf(stderr,
+                      "System Monitor: Too many errors ... exiting\n");
+              exitcode = EXIT_FAILURE;
+              break;
+            }
+        }
+
+      /* Wait for the next sample interval */
+
+      sleep(CONFIG_SYSTEM_SYSMON_INTERVAL);
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SYSMON_NTASKS; i++)
+    {
+      if (tasks[i].pid >= 0)
+        {
+          sysmon_task_close(&tasks[i]);
+        }
+    }
+
+  if (cpufd >= 0)
+    {
+      close(cpufd);
+    }
+
+errout_with_ringfd:
+  close(ringfd);
+
+errout_with_memory:
+  free(recs);
+  free(tasks);
+
+  /* Stopped */
+
+  g_sysmon.stop    = false;
+  g_sysmon.started = false;
+  printf("System Monitor: Stopped: %d\n", g_sysmon.pid);
+
+  return exitcode;
+}
+
+/****************************************************************************
+ * Name: sysmon_match
+ ****************************************************************************/
+
+static bool sysmon_match(FAR const struct sysmon_query_s *query,
+                         FAR const struct sysmon_header_s *hdr,
+                         FAR const struct sysmon_record_s *rec)
+{
+  /* Skip empty slots and records of an interval still being written */
+
+  if (rec->seq == 0 || rec->seq > hdr->seq)
+    {
+      return false;
+    }
+
+  if (query->pidset && rec->pid != query->pid)
+    {
+      return false;
+    }
+
+  if (!query->filter)
+    {
+      return true;
+    }
+
+  return (query->preempt  != 0 && rec->preempt  >= query->preempt) ||
+         (query->csection != 0 && rec->csection >= query->csection) ||
+         (query->run      != 0 && rec->run      >= query->run) ||
+         (query->stackpct != 0 && rec->stacksize > 0 &&
+          (uint64_t)rec->stackused * 100 >=
+          (uint64_t)rec->stacksize * query->stackpct);
+}
+
+/****************************************************************************
+ * Name: sysmon_scan
+ *
+ * Description:
+ *   Go through the ring file from the oldest record to the newest one.
+ *   Matching records are counted and, once 'skip' of them have gone by,
+ *   printed.  Returns the number of matching records.
+ *
+ ****************************************************************************/
+
+static long sysmon_scan(int fd, FAR const struct sysmon_header_s *hdr,
+                        FAR const struct sysmon_query_s *query, long skip)
+{
+  struct sysmon_record_s recs[SYSMON_READCHUNK];
+  uint32_t nvalid;
+  uint32_t first;
+  uint32_t slot;
+  uint32_t n;
+  uint32_t i;
+  long count = 0;
+
+  nvalid = hdr->total < hdr->nrecords ? hdr->total : hdr->nrecords;
+  first  = hdr->total - nvalid;
+
+  while (nvalid > 0)
+    {
+      slot = first % hdr->nrecords;
+      n    = hdr->nrecords - slot;
+      if (n > nvalid)
+        {
+          n = nvalid;
+        }
+
+      if (n > SYSMON_READCHUNK)
+        {
+          n = SYSMON_READCHUNK;
+        }
+
+      if (pread(fd, recs, n * sizeof(recs[0]),
+                sizeof(*hdr) + slot * sizeof(recs[0])) !=
+          (ssize_t)(n * sizeof(recs[0])))
+        {
+          return -EIO;
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          if (!sysmon_match(query, hdr, &recs[i]))
+            {
+              continue;
+            }
+
+          if (count++ >= skip)
+            {
+              printf("%6lu %10lu %5ld %11lu %11lu %11lu %6lu %6lu %.*s\n",
+                     (unsigned long)recs[i].seq,
+                     (unsigned long)recs[i].timestamp,
+                     (long)recs[i].pid,
+                     (unsigned long)recs[i].preempt,
+                     (unsigned long)recs[i].csection,
+                     (unsigned long)recs[i].run,
+                     (unsigned long)recs[i].stacksize,
+                     (unsigned long)recs[i].stackused,
+                     SYSMON_NAMELEN, recs[i].name);
+            }
+        }
+
+      first  += n;
+      nvalid -= n;
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: sysmon_showusage
+ ****************************************************************************/
+
+static void sysmon_showusage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-p <us>] [-c <us>] [-r <us>] [-s <percent>] "
+          "[-i <pid>] [-n <count>]\n", progname);
+  fprintf(stderr, "  -p  Pre-emption disabled for at least <us>\n");
+  fprintf(stderr, "  -c  Critical section held for at least <us>\n");
+  fprintf(stderr, "  -r  Ran at least <us> without a switch\n");
+  fprintf(stderr, "  -s  Stack usage of at least <percent>\n");
+  fprintf(stderr, "  -i  Only show task <pid> (negative: -1 - CPU)\n");
+  fprintf(stderr, "  -n  Only show the newest <count> samples\n");
+  fprintf(stderr, "Samples exceeding any of the thresholds are shown, "
+          "or all without thresholds.\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int sysmon_start_main(int argc, FAR char **argv)
+{
+  /* Has the monitor already started? */
+
+  sched_lock();
+  if (!g_sysmon.started)
+    {
+      int ret;
+
+      /* No.. start it now */
+
+      g_sysmon.started = true;
+      g_sysmon.stop    = false;
+
+      ret = task_create("System Monitor",
+                        CONFIG_SYSTEM_SYSMON_DAEMON_PRIORITY,
+                        CONFIG_SYSTEM_SYSMON_DAEMON_STACKSIZE,
+                        sysmon_daemon, NULL);
+      if (ret < 0)
+        {
+          int errcode = errno;
+          g_sysmon.started = false;
+          printf("System Monitor ERROR: "
+                 "Failed to start the system monitor: %d\n",
+                 errcode);
+        }
+      else
+        {
+          g_sysmon.pid = ret;
+          printf("System Monitor: Started: %d\n", g_sysmon.pid);
+        }
+
+      sched_unlock();
+      return 0;
+    }
+
+  sched_unlock();
+  printf("System Monitor: %s: %d\n",
+         g_sysmon.stop ? "Stopping" : "Running", g_sysmon.pid);
+  return 0;
+}
+
+int sysmon_stop_main(int argc, FAR char **argv)
+{
+  /* Has the monitor already started? */
+
+  if (g_sysmon.started)
+    {
+      /* Stop the system monitor.  The next time the monitor wakes up,
+       * it will see the stop indication and will exit.
+       */
+
+      printf("System Monitor: Stopping: %d\n", g_sysmon.pid);
+      g_sysmon.stop = true;
+    }
+
+  printf("System Monitor: Stopped: %d\n", g_sysmon.pid);
+  return 0;
+}
+
+int main(int argc, FAR char **argv)
+{
+  struct sysmon_header_s hdr;
+  struct sysmon_query_s query;
+  long count = -1;
+  long total;
+  int fd;
+  int ch;
+
+  memset(&query, 0, sizeof(query));
+
+  while ((ch = getopt(argc, argv, "p:c:r:s:i:n:h")) != ERROR)
+    {
+      switch (ch)
+        {
+          case 'p':
+            query.preempt  = strtoul(optarg, NULL, 10);
+            query.filter   = true;
+            break;
+
+          case 'c':
+            query.csection = strtoul(optarg, NULL, 10);
+            query.filter   = true;
+            break;
+
+          case 'r':
+            query.run      = strtoul(optarg, NULL, 10);
+            query.filter   = true;
+            break;
+
+          case 's':
+            query.stackpct = strtoul(optarg, NULL, 10);
+            query.filter   = true;
+            break;
+
+          case 'i':
+            query.pid      = atoi(optarg);
+            query.pidset   = true;
+            break;
+
+          case 'n':
+            count          = strtol(optarg, NULL, 10);
+            break;
+
+          default:
+            sysmon_showusage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  fd = open(CONFIG_SYSTEM_SYSMON_RINGFILE, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      fprintf(stderr, "System Monitor: Failed to open %s: %d\n",
+              CONFIG_SYSTEM_SYSMON_RINGFILE, errno);
+      return EXIT_FAILURE;
+    }
+
+  if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+      hdr.magic != SYSMON_MAGIC || hdr.version != SYSMON_VERSION ||
+      hdr.recsize != sizeof(struct sysmon_record_s) || hdr.nrecords == 0)
+    {
+      fprintf(stderr, "System Monitor: Bad ring file %s\n",
+              CONFIG_SYSTEM_SYSMON_RINGFILE);
+      close(fd);
+      return EXIT_FAILURE;
+    }
+
+  /* Count the matches first so that only the newest 'count' are shown */
+
+  total = 0;
+  if (count >= 0)
+    {
+      total = sysmon_scan(fd, &hdr, &query, LONG_MAX);
+      total = total > count ? total - count : 0;
+    }
+
+  printf("   SEQ    TIME-MS   PID PRE-EMPTION    CSECTION         RUN "
+         "  SIZE   USED NAME\n");
+
+  total = sysmon_scan(fd, &hdr, &query, total);
+  close(fd);
+
+  if (total < 0)
+    {
+      fprintf(stderr, "System Monitor: Failed to read %s\n",
+              CONFIG_SYSTEM_SYSMON_RINGFILE);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+#endif /* CONFIG_SYSTEM_SYSMON */
@@ -95,5 +95,14 @@ int main(int argc, FAR char *argv[])
         }
     }
 
-  return daemon ? telnetd_daemon(&config) : nsh_telnetmain(1, argv);
+  if (!daemon)
+    {
+      return nsh_telnetmain(1, argv);
+    }
+
+#ifdef CONFIG_NETUTILS_TELNETD_MUX
+  return telnetd_mux(&config);
+#else
+  return telnetd_daemon(&config);
+#endif
 }
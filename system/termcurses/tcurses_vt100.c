@@ -55,6 +55,15 @@
 #define KEY_HOME        0x106  /* home key */
 #define KEY_F0          0x108  /* function keys; 64 reserved */
 
+#ifndef CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE
+#  define CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE 0
+#endif
+
+/* Bits of the attributes that are sent as an SGR sequence */
+
+#define VT100_SGR_ATTRIBS (TCURS_ATTRIB_BOLD | TCURS_ATTRIB_BLINK | \
+                           TCURS_ATTRIB_UNDERLINE)
+
 #ifdef CONFIG_TERMINFO_INCLUDE_NAME
 #define TINFO_ENTRY(n, d, c)  n, d, c
 #else
@@ -76,6 +85,22 @@ struct tcurses_vt100_s
   int    keycount;
   char   keybuf[16];
   tcflag_t lflag;
+
+  /* Last state sent to the terminal, so that repeated requests for the
+   * same colors or attributes are not sent again.  -1 means unknown.
+   */
+
+  int    fgcolor;                  /* 256-color index of the foreground */
+  int    bgcolor;                  /* 256-color index of the background */
+  long   attrib;                   /* VT100_SGR_ATTRIBS bits */
+  int    cursor;                   /* 1 shown, 0 hidden */
+
+#if CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE > 0
+  /* Output not yet written to out_fd */
+
+  size_t outlen;
+  char   outbuf[CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE];
+#endif
 };
 
 /****************************************************************************
@@ -96,6 +121,9 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
 static int tcurses_vt100_getkeycode(FAR struct termcurses_s *dev,
               FAR int *specialkey, FAR int *keymodifers);
 static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev);
+static ssize_t tcurses_vt100_write(FAR struct termcurses_s *dev,
+              FAR const char *buf, size_t len);
+static int tcurses_vt100_flush(FAR struct termcurses_s *dev);
 static int tcurses_vt100_terminate(FAR struct termcurses_s *dev);
 
 /****************************************************************************
@@ -112,6 +140,8 @@ static const struct termcurses_ops_s g_vt100_ops =
   tcurses_vt100_setattributes,
   tcurses_vt100_getkeycode,
   tcurses_vt100_checkkey,
+  tcurses_vt100_write,
+  tcurses_vt100_flush,
   tcurses_vt100_terminate
 };
 
@@ -122,9 +152,10 @@ static const char *g_clreos         = "\033[J";       /* Clear to end of screen
 static const char *g_clreol         = "\033[K";       /* Clear to end of line */
 
 static const char *g_movecurs       = "\033[%d;%dH";  /* Move cursor to x,y */
-static const char *g_getwinsize     = "\x1b[s\x1b[999;999H\x1b[6n\x1bu";
+static const char *g_getwinsize     = "\x1b[s\x1b[999;999H\x1b[6n\x1b[u";
 static const char *g_setfgcolor     = "\x1b[38;5;%dm";
 static const char *g_setbgcolor     = "\x1b[48;5;%dm";
+static const char *g_setfgbgcolor   = "\x1b[38;5;%d;48;5;%dm";
 static const char *g_showcursor     = "\x1b[?25h";
 static const char *g_hidecursor     = "\x1b[?25l";
 static const char *g_setbold        = "\x1b[1";
@@ -729,6 +760,68 @@ struct termcurses_dev_s g_vt100_tcurs =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Write all of a buffer to the terminal
+ ****************************************************************************/
+
+static int tcurses_vt100_writeall(int fd, FAR const char *buf, size_t len)
+{
+  ssize_t ret;
+
+  while (len > 0)
+    {
+      ret = write(fd, buf, len);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      buf += ret;
+      len -= ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Queue output for the terminal, writing the buffer out when it is full
+ ****************************************************************************/
+
+static int tcurses_vt100_output(FAR struct tcurses_vt100_s *priv,
+                                FAR const char *buf, size_t len)
+{
+#if CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE > 0
+  int ret;
+
+  if (priv->outlen + len > sizeof(priv->outbuf))
+    {
+      ret = tcurses_vt100_flush((FAR struct termcurses_s *)priv);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Too big to be buffered at all */
+
+      if (len > sizeof(priv->outbuf))
+        {
+          return tcurses_vt100_writeall(priv->out_fd, buf, len);
+        }
+    }
+
+  memcpy(&priv->outbuf[priv->outlen], buf, len);
+  priv->outlen += len;
+  return OK;
+#else
+  return tcurses_vt100_writeall(priv->out_fd, buf, len);
+#endif
+}
+
 /****************************************************************************
  * Clear screen / line operations
  ****************************************************************************/
@@ -737,41 +830,32 @@ static int tcurses_vt100_clear(FAR struct termcurses_s *dev, int type)
 {
   FAR struct tcurses_vt100_s *priv;
   int ret = -ENOSYS;
-  int fd;
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd = priv->out_fd;
 
   /* Perform operation based on type */
 
   switch (type)
     {
       case TCURS_CLEAR_SCREEN:
-        ret = write(fd, g_clrscr, strlen(g_clrscr));
+        ret = tcurses_vt100_output(priv, g_clrscr, strlen(g_clrscr));
         break;
 
       case TCURS_CLEAR_LINE:
         break;
 
       case TCURS_CLEAR_EOS:
-        ret = write(fd, g_clrscr, strlen(g_clreos));
+        ret = tcurses_vt100_output(priv, g_clreos, strlen(g_clreos));
         break;
 
       case TCURS_CLEAR_EOL:
-        ret = write(fd, g_clrscr, strlen(g_clreol));
+        ret = tcurses_vt100_output(priv, g_clreol, strlen(g_clreol));
         break;
 
       default:
         return -ENOSYS;
     }
 
-  /* If data written successfully, return OK */
-
-  if (ret > 0)
-    {
-      ret = OK;
-    }
-
   return ret;
 }
 
@@ -784,32 +868,24 @@ static int tcurses_vt100_move(FAR struct termcurses_s *dev, int type,
 {
   FAR struct tcurses_vt100_s *priv;
   int   ret = -ENOSYS;
-  int   fd;
+  int   len;
   char  str[32];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
   /* Perform operation based on type */
 
   switch (type)
     {
       case TCURS_MOVE_YX:
-        snprintf(str, sizeof(str), g_movecurs, row + 1, col + 1);
-        ret = write(fd, str, strlen(str));
+        len = snprintf(str, sizeof(str), g_movecurs, row + 1, col + 1);
+        ret = tcurses_vt100_output(priv, str, len);
         break;
 
       default:
         return -ENOSYS;
     }
 
-  /* If bytes written, return OK */
-
-  if (ret > 0)
-    {
-      ret = OK;
-    }
-
   return ret;
 }
 
@@ -907,24 +983,31 @@ static int tcurses_vt100_setcolors(FAR struct termcurses_s *dev,
                                    FAR struct termcurses_colors_s *colors)
 {
   FAR struct tcurses_vt100_s *priv;
-  int  ret = -ENOSYS;
-  int  fd;
+  int  fg = -1;
+  int  bg = -1;
+  int  len;
   char str[48];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
-  /* Test if FG color to be set */
+  if ((colors->color_mask & (TCURS_COLOR_FG | TCURS_COLOR_BG)) == 0)
+    {
+      return -ENOSYS;
+    }
+
+  /* Test if FG color to be set and differs from the terminal's */
 
   if ((colors->color_mask & TCURS_COLOR_FG) != 0)
     {
-      snprintf(str, sizeof(str), g_setfgcolor,
-               tcurses_vt100_getcolorindex(colors->fg_red, colors->fg_green,
-                                           colors->fg_blue));
-      ret = write(fd, str, strlen(str));
+      fg = tcurses_vt100_getcolorindex(colors->fg_red, colors->fg_green,
+                                       colors->fg_blue);
+      if (fg == priv->fgcolor)
+        {
+          fg = -1;
+        }
     }
 
-  /* Test if BG color to be set */
+  /* Test if BG color to be set and differs from the terminal's */
 
   if ((colors->color_mask & TCURS_COLOR_BG) != 0)
     {
@@ -934,20 +1017,44 @@ static int tcurses_vt100_setcolors(FAR struct termcurses_s *dev,
           colors->bg_red = 0;
         }
 
-      snprintf(str, sizeof(str), g_setbgcolor,
-               tcurses_vt100_getcolorindex(colors->bg_red, colors->bg_green,
-                                           colors->bg_blue));
-      ret = write(fd, str, strlen(str));
+      bg = tcurses_vt100_getcolorindex(colors->bg_red, colors->bg_green,
+                                       colors->bg_blue);
+      if (bg == priv->bgcolor)
+        {
+          bg = -1;
+        }
     }
 
-  /* If bytes written, return OK */
+  /* Send both colors in one sequence if possible */
 
-  if (ret > 0)
+  if (fg >= 0 && bg >= 0)
+    {
+      len = snprintf(str, sizeof(str), g_setfgbgcolor, fg, bg);
+    }
+  else if (fg >= 0)
     {
-      ret = OK;
+      len = snprintf(str, sizeof(str), g_setfgcolor, fg);
+    }
+  else if (bg >= 0)
+    {
+      len = snprintf(str, sizeof(str), g_setbgcolor, bg);
+    }
+  else
+    {
+      return OK;
     }
 
-  return ret;
+  if (fg >= 0)
+    {
+      priv->fgcolor = fg;
+    }
+
+  if (bg >= 0)
+    {
+      priv->bgcolor = bg;
+    }
+
+  return tcurses_vt100_output(priv, str, len);
 }
 
 /****************************************************************************
@@ -978,8 +1085,13 @@ static int tcurses_vt100_getwinsize(FAR struct termcurses_s *dev,
 
   /* Write command to get window size */
 
-  ret = write(fd, g_getwinsize, strlen(g_getwinsize));
-  if (ret <= 0)
+  ret = tcurses_vt100_output(priv, g_getwinsize, strlen(g_getwinsize));
+  if (ret >= 0)
+    {
+      ret = tcurses_vt100_flush(dev);
+    }
+
+  if (ret < 0)
     {
       return ret;
     }
@@ -1055,12 +1167,9 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
                                        unsigned long attrib)
 {
   FAR struct tcurses_vt100_s *priv;
-  int ret;
-  int fd;
   char str[48];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
   /* Test for cursor hide */
 
@@ -1068,18 +1177,38 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
     {
       /* Send sequence to hide the cursor */
 
-      ret = write(fd, g_hidecursor, strlen(g_hidecursor));
-      return ret;
+      if (priv->cursor == 0)
+        {
+          return OK;
+        }
+
+      priv->cursor = 0;
+      return tcurses_vt100_output(priv, g_hidecursor, strlen(g_hidecursor));
     }
 
   if (attrib & TCURS_ATTRIB_CURS_SHOW)
     {
-      /* Send sequence to hide the cursor */
+      /* Send sequence to show the cursor */
 
-      ret = write(fd, g_showcursor, strlen(g_showcursor));
-      return ret;
+      if (priv->cursor == 1)
+        {
+          return OK;
+        }
+
+      priv->cursor = 1;
+      return tcurses_vt100_output(priv, g_showcursor, strlen(g_showcursor));
     }
 
+  /* Nothing to do if the terminal already has these attributes */
+
+  attrib &= VT100_SGR_ATTRIBS;
+  if ((long)attrib == priv->attrib)
+    {
+      return OK;
+    }
+
+  priv->attrib = attrib;
+
   /* Build attribute string */
 
   if (attrib & TCURS_ATTRIB_BOLD)
@@ -1111,13 +1240,7 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
 
   strlcat(str, "m", sizeof(str));
 
-  ret = write(fd, str, strlen(str));
-
-  /* If bytes written, return OK */
-
-  ret = (ret > 0) ? OK : -ENOSYS;
-
-  return ret;
+  return tcurses_vt100_output(priv, str, strlen(str));
 }
 
 /****************************************************************************
@@ -1160,6 +1283,10 @@ static int tcurses_vt100_getkeycode(FAR struct termcurses_s *dev,
   priv = (FAR struct tcurses_vt100_s *)dev;
   fd   = priv->in_fd;
 
+  /* Make sure the user sees everything before waiting for a key */
+
+  tcurses_vt100_flush(dev);
+
   /* Watch stdin (fd 0) to see when it has input. */
 
   FD_ZERO(&rfds);
@@ -1429,6 +1556,10 @@ static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev)
   priv = (FAR struct tcurses_vt100_s *)dev;
   fd   = priv->in_fd;
 
+  /* Make sure the user sees everything before waiting for a key */
+
+  tcurses_vt100_flush(dev);
+
   /* Test for queued characters */
 
   if (priv->keycount > 0)
@@ -1459,6 +1590,50 @@ static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev)
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcurses_vt100_write
+ *
+ * Description:
+ *   Queue text for output at the current cursor position.
+ *
+ ****************************************************************************/
+
+static ssize_t tcurses_vt100_write(FAR struct termcurses_s *dev,
+                                   FAR const char *buf, size_t len)
+{
+  FAR struct tcurses_vt100_s *priv = (FAR struct tcurses_vt100_s *)dev;
+  int ret;
+
+  ret = tcurses_vt100_output(priv, buf, len);
+  return ret < 0 ? ret : len;
+}
+
+/****************************************************************************
+ * Name: tcurses_vt100_flush
+ *
+ * Description:
+ *   Write all buffered output to the terminal.
+ *
+ ****************************************************************************/
+
+static int tcurses_vt100_flush(FAR struct termcurses_s *dev)
+{
+#if CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUF_SIZE > 0
+  FAR struct tcurses_vt100_s *priv = (FAR struct tcurses_vt100_s *)dev;
+  size_t len = priv->outlen;
+
+  if (len == 0)
+    {
+      return OK;
+    }
+
+  priv->outlen = 0;
+  return tcurses_vt100_writeall(priv->out_fd, priv->outbuf, len);
+#else
+  return OK;
+#endif
+}
+
 /****************************************************************************
  * Name: tcurses_vt100_initialize
  *
@@ -1491,6 +1666,10 @@ FAR struct termcurses_s *tcurses_vt100_initialize(int in_fd, int out_fd)
   priv->in_fd    = in_fd;
   priv->out_fd   = out_fd;
   priv->keycount = 0;
+  priv->fgcolor  = -1;
+  priv->bgcolor  = -1;
+  priv->attrib   = -1;
+  priv->cursor   = -1;
 
       if (isatty(priv->in_fd))
         {
@@ -1533,16 +1712,15 @@ static int tcurses_vt100_terminate(FAR struct termcurses_s *dev)
 {
   FAR struct tcurses_vt100_s *priv;
   struct termios cfg;
-  int  fd;
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
-  /* Set default foreground and background colors.
-   * (Ignore the return result.)
+  /* Set default foreground and background colors and send anything still
+   * buffered.  (Ignore the return result.)
    */
 
-  write(fd, g_setdefcolors, strlen(g_setdefcolors));
+  tcurses_vt100_output(priv, g_setdefcolors, strlen(g_setdefcolors));
+  tcurses_vt100_flush(dev);
 
       if (isatty(priv->in_fd))
         {
@@ -235,6 +235,51 @@ int termcurses_getwinsize(FAR struct termcurses_s *term,
   return -ENOSYS;
 }
 
+/****************************************************************************
+ * Name: termcurses_write
+ *
+ * Description:
+ *   Write text at the current cursor position.
+ *
+ ****************************************************************************/
+
+ssize_t termcurses_write(FAR struct termcurses_s *term, FAR const char *buf,
+                         size_t len)
+{
+  FAR struct termcurses_dev_s *dev = (FAR struct termcurses_dev_s *)term;
+
+  /* Call the dev function */
+
+  if (dev->ops->write)
+    {
+      return dev->ops->write(term, buf, len);
+    }
+
+  return -ENOSYS;
+}
+
+/****************************************************************************
+ * Name: termcurses_flush
+ *
+ * Description:
+ *   Send any buffered output to the terminal.
+ *
+ ****************************************************************************/
+
+int termcurses_flush(FAR struct termcurses_s *term)
+{
+  FAR struct termcurses_dev_s *dev = (FAR struct termcurses_dev_s *)term;
+
+  /* Call the dev function */
+
+  if (dev->ops->flush)
+    {
+      return dev->ops->flush(term);
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Name: termcurses_getkeycode
  *
@@ -34,6 +34,12 @@
 #include <sys/ioctl.h>
 #include <nuttx/note/notectl_driver.h>
 
+#if defined(CONFIG_SYSTEM_TRACE_STREAM) && defined(CONFIG_NET_TCP)
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#endif
+
 #include "trace.h"
 
 /****************************************************************************
@@ -218,6 +224,189 @@ static int trace_cmd_dump(int index, int argc, FAR char **argv,
 }
 #endif
 
+/****************************************************************************
+ * Name: trace_stream_open
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+static int trace_stream_open(FAR const char *target)
+{
+#ifdef CONFIG_NET_TCP
+  struct sockaddr_in addr;
+  FAR const char *port;
+  char host[INET_ADDRSTRLEN];
+  int sockfd;
+#endif
+
+  /* '-' means stdout */
+
+  if (strcmp(target, "-") == 0)
+    {
+      return dup(STDOUT_FILENO);
+    }
+
+#ifdef CONFIG_NET_TCP
+  /* <ipaddr>:<port> means a TCP connection to a collecting host */
+
+  port = strchr(target, ':');
+  if (port != NULL && (size_t)(port - target) < sizeof(host))
+    {
+      memcpy(host, target, port - target);
+      host[port - target] = '\0';
+
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port   = htons(atoi(port + 1));
+
+      if (inet_pton(AF_INET, host, &addr.sin_addr) == 1)
+        {
+          sockfd = socket(AF_INET, SOCK_STREAM, 0);
+          if (sockfd < 0)
+            {
+              return ERROR;
+            }
+
+          if (connect(sockfd, (FAR struct sockaddr *)&addr,
+                      sizeof(addr)) < 0)
+            {
+              close(sockfd);
+              return ERROR;
+            }
+
+          return sockfd;
+        }
+    }
+#endif
+
+  /* Anything else is a file name */
+
+  return open(target, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+}
+
+/****************************************************************************
+ * Name: trace_cmd_stream
+ ****************************************************************************/
+
+static int trace_cmd_stream(int index, int argc, FAR char **argv,
+                            int notectlfd)
+{
+  static const char header[] = "# tracer: nop\n#\n";
+  size_t bufsize = CONFIG_SYSTEM_TRACE_STREAM_BUFSIZE;
+  unsigned int duration = 0;
+  FAR char *endptr;
+  bool changed;
+  bool cont = false;
+  ssize_t total;
+  ssize_t ret;
+  int outfd;
+
+  /* Usage: trace stream [-c][-b <bufsize>][-d <duration>] <target> */
+
+  while (index < argc && argv[index][0] == '-' && argv[index][1] != '\0')
+    {
+      if (strcmp(argv[index], "-c") == 0)
+        {
+          cont = true;
+        }
+      else if (strcmp(argv[index], "-b") == 0 && index + 1 < argc)
+        {
+          bufsize = strtoul(argv[++index], &endptr, 0);
+          if (bufsize == 0 || *endptr != '\0')
+            {
+              fprintf(stderr,
+                      "trace stream: invalid size '%s'\n", argv[index]);
+              return ERROR;
+            }
+        }
+      else if (strcmp(argv[index], "-d") == 0 && index + 1 < argc)
+        {
+          duration = strtoul(argv[++index], &endptr, 0);
+          if (duration == 0 || *endptr != '\0')
+            {
+              fprintf(stderr,
+                      "trace stream: invalid duration '%s'\n", argv[index]);
+              return ERROR;
+            }
+        }
+      else
+        {
+          fprintf(stderr,
+                  "trace stream: invalid option '%s'\n", argv[index]);
+          return ERROR;
+        }
+
+      index++;
+    }
+
+  if (index >= argc)
+    {
+      /* <target> parameter is mandatory. */
+
+      fprintf(stderr,
+              "trace stream: no argument\n");
+      return ERROR;
+    }
+
+  outfd = trace_stream_open(argv[index]);
+  if (outfd < 0)
+    {
+      fprintf(stderr,
+              "trace stream: cannot open '%s'\n", argv[index]);
+      return ERROR;
+    }
+
+  index++;
+
+  /* Clear the trace buffer */
+
+  if (!cont)
+    {
+      trace_dump_clear();
+    }
+
+  /* Stream the notes while tracing.  Once tracing has been stopped, drain
+   * whatever is still left in the buffer.
+   */
+
+  ret = write(outfd, header, sizeof(header) - 1);
+  if (ret != (ssize_t)(sizeof(header) - 1))
+    {
+      fprintf(stderr,
+              "trace stream: stream failed: %zd\n",
+              ret < 0 ? (ssize_t)-errno : (ssize_t)-EIO);
+      close(outfd);
+      return ERROR;
+    }
+
+  changed = notectl_enable(true, notectlfd);
+
+  total = trace_stream(outfd, bufsize, duration, false);
+
+  if (changed)
+    {
+      notectl_enable(false, notectlfd);
+    }
+
+  if (total >= 0)
+    {
+      ret = trace_stream(outfd, bufsize, 0, true);
+      total = ret < 0 ? ret : total + ret;
+    }
+
+  close(outfd);
+
+  if (total < 0)
+    {
+      fprintf(stderr,
+              "trace stream: stream failed: %zd\n", total);
+      return ERROR;
+    }
+
+  fprintf(stderr, "trace stream: %zd bytes\n", total);
+  return index;
+}
+#endif
+
 /****************************************************************************
  * Name: trace_cmd_cmd
  ****************************************************************************/
@@ -791,6 +980,11 @@ static void show_usage(void)
           " dump    [-a][-c][<filename>]        :"
                                 " Output the trace result\n"
           "                                       [-a] <Android SysTrace>\n"
+#endif
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+          " stream  [-c][-b <bufsize>][-d <duration>]\n"
+          "         <filename>|<ipaddr>:<port>  :"
+                                " Stream the trace while running\n"
 #endif
           " mode    [{+|-}{o|w|s|a|i|d}...]     :"
                                 " Set task trace options\n"
@@ -863,6 +1057,12 @@ int main(int argc, FAR char *argv[])
           i = trace_cmd_dump(i + 1, argc, argv, notectlfd);
         }
 #endif
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+      else if (strcmp(argv[i], "stream") == 0)
+        {
+          i = trace_cmd_stream(i + 1, argc, argv, notectlfd);
+        }
+#endif
 #ifdef CONFIG_SYSTEM_SYSTEM
       else if (strcmp(argv[i], "cmd") == 0)
         {
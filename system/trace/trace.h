@@ -27,7 +27,9 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 #ifdef __cplusplus
 #define EXTERN extern "C"
@@ -87,6 +89,19 @@ bool trace_dump_get_overwrite(void);
 
 void trace_dump_set_overwrite(bool mode);
 
+/****************************************************************************
+ * Name: trace_stream
+ *
+ * Description:
+ *   Continuously drain the note buffer into 'outfd' while tracing runs.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+ssize_t trace_stream(int outfd, size_t bufsize, unsigned int duration,
+                     bool untilempty);
+#endif
+
 #else /* CONFIG_DRIVERS_NOTERAM */
 
 #define trace_dump(type,out)
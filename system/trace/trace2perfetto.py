@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# apps/system/trace/trace2perfetto.py
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+# Convert the text produced by "trace dump" or "trace stream" into a
+# Perfetto protobuf trace that can be opened with https://ui.perfetto.dev
+# or processed with trace_processor.
+#
+# Scheduler switches and wakeups are emitted as native ftrace events.
+# IRQ handlers, system calls and tracing_mark_write notes are emitted as
+# atrace style print events so that they show up as slices on the thread
+# they ran on.
+#
+import argparse
+import re
+import sys
+
+# Field numbers from perfetto/protos/perfetto/trace
+
+TRACE_PACKET = 1  # Trace.packet
+PACKET_FTRACE_EVENTS = 1  # TracePacket.ftrace_events
+BUNDLE_CPU = 1  # FtraceEventBundle.cpu
+BUNDLE_EVENT = 2  # FtraceEventBundle.event
+EVENT_TIMESTAMP = 1  # FtraceEvent.timestamp
+EVENT_PID = 2  # FtraceEvent.pid
+EVENT_PRINT = 3  # FtraceEvent.print
+EVENT_SCHED_SWITCH = 4  # FtraceEvent.sched_switch
+EVENT_SCHED_WAKING = 20  # FtraceEvent.sched_waking (sched_wakeup is 17)
+
+BUNDLE_MAX_EVENTS = 1024
+
+# Linux task state bits used by sched_switch.prev_state
+
+TASK_STATES = {
+    "R": 0,
+    "S": 1,
+    "D": 2,
+    "T": 4,
+    "t": 8,
+    "X": 16,
+    "Z": 32,
+}
+
+HEADER_RE = re.compile(
+    r"^\s*(?P<comm>.*?)-(?P<pid>\d+)\s+"
+    r"(?:\(\s*\S+\)\s+)?"
+    r"\[(?P<cpu>\d+)\]\s+"
+    r"(?:[\w.]{4}\s+)?"
+    r"(?P<sec>\d+)\.(?P<frac>\d+):\s+"
+    r"(?P<body>.*)$"
+)
+
+SWITCH_RE = re.compile(
+    r"prev_comm=(?P<prev_comm>.*?) prev_pid=(?P<prev_pid>\d+) "
+    r"prev_prio=(?P<prev_prio>\d+) prev_state=(?P<prev_state>\S+) ==> "
+    r"next_comm=(?P<next_comm>.*?) next_pid=(?P<next_pid>\d+) "
+    r"next_prio=(?P<next_prio>\d+)"
+)
+
+WAKING_RE = re.compile(
+    r"comm=(?P<comm>.*?) pid=(?P<pid>\d+)"
+    r"(?: prio=(?P<prio>\d+))?(?: target_cpu=(?P<cpu>\d+))?"
+)
+
+IRQ_RE = re.compile(r"irq=(?P<irq>\d+)(?: name=(?P<name>\S+))?")
+
+SYSCALL_ENTER_RE = re.compile(r"^sys_(?P<name>\w+)\(")
+SYSCALL_EXIT_RE = re.compile(r"^sys_(?P<name>\w+) -> ")
+
+
+def varint(value):
+    if value < 0:
+        value += 1 << 64
+
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def field_varint(field, value):
+    return varint(field << 3) + varint(value)
+
+
+def field_bytes(field, data):
+    if isinstance(data, str):
+        data = data.encode("utf-8", "replace")
+
+    return varint((field << 3) | 2) + varint(len(data)) + data
+
+
+class Converter:
+    def __init__(self, out):
+        self.out = out
+        self.cpu = None
+        self.events = []
+        self.count = 0
+        self.skipped = 0
+
+    def flush(self):
+        if not self.events:
+            return
+
+        bundle = field_varint(BUNDLE_CPU, self.cpu)
+        bundle += b"".join(field_bytes(BUNDLE_EVENT, e) for e in self.events)
+        packet = field_bytes(PACKET_FTRACE_EVENTS, bundle)
+        self.out.write(field_bytes(TRACE_PACKET, packet))
+        self.events = []
+
+    def emit(self, cpu, ts, pid, field, payload):
+        if cpu != self.cpu or len(self.events) >= BUNDLE_MAX_EVENTS:
+            self.flush()
+            self.cpu = cpu
+
+        event = field_varint(EVENT_TIMESTAMP, ts)
+        event += field_varint(EVENT_PID, pid)
+        event += field_bytes(field, payload)
+        self.events.append(event)
+        self.count += 1
+
+    def emit_print(self, cpu, ts, pid, text):
+        self.emit(cpu, ts, pid, EVENT_PRINT, field_bytes(2, text + "\n"))
+
+    def sched_switch(self, cpu, ts, pid, args):
+        m = SWITCH_RE.match(args)
+        if not m:
+            return False
+
+        state = TASK_STATES.get(m.group("prev_state")[0], 0)
+        payload = field_bytes(1, m.group("prev_comm"))
+        payload += field_varint(2, int(m.group("prev_pid")))
+        payload += field_varint(3, int(m.group("prev_prio")))
+        payload += field_varint(4, state)
+        payload += field_bytes(5, m.group("next_comm"))
+        payload += field_varint(6, int(m.group("next_pid")))
+        payload += field_varint(7, int(m.group("next_prio")))
+        self.emit(cpu, ts, pid, EVENT_SCHED_SWITCH, payload)
+        return True
+
+    def sched_waking(self, cpu, ts, pid, args):
+        m = WAKING_RE.match(args)
+        if not m:
+            return False
+
+        payload = field_bytes(1, m.group("comm"))
+        payload += field_varint(2, int(m.group("pid")))
+        if m.group("prio"):
+            payload += field_varint(3, int(m.group("prio")))
+
+        payload += field_varint(4, 1)
+        if m.group("cpu"):
+            payload += field_varint(5, int(m.group("cpu")))
+
+        self.emit(cpu, ts, pid, EVENT_SCHED_WAKING, payload)
+        return True
+
+    def line(self, text):
+        m = HEADER_RE.match(text)
+        if not m:
+            return
+
+        cpu = int(m.group("cpu"))
+        pid = int(m.group("pid"))
+        ts = int(m.group("sec")) * 1000000000
+        ts += int((m.group("frac") + "000000000")[:9])
+        body = m.group("body")
+
+        event, _, args = body.partition(": ")
+        if event == "sched_switch":
+            handled = self.sched_switch(cpu, ts, pid, args)
+        elif event in ("sched_waking", "sched_wakeup", "sched_wakeup_new"):
+            handled = self.sched_waking(cpu, ts, pid, args)
+        elif event == "irq_handler_entry":
+            irq = IRQ_RE.match(args)
+            name = "irq %s" % (irq.group("irq") if irq else "?")
+            if irq and irq.group("name"):
+                name += " " + irq.group("name")
+
+            self.emit_print(cpu, ts, pid, "B|%d|%s" % (pid, name))
+            handled = True
+        elif event == "irq_handler_exit":
+            self.emit_print(cpu, ts, pid, "E|%d" % pid)
+            handled = True
+        elif event == "tracing_mark_write":
+            self.emit_print(cpu, ts, pid, args)
+            handled = True
+        else:
+            handled = False
+            m = SYSCALL_ENTER_RE.match(body)
+            if m:
+                self.emit_print(cpu, ts, pid, "B|%d|%s" % (pid, m.group("name")))
+                handled = True
+            elif SYSCALL_EXIT_RE.match(body):
+                self.emit_print(cpu, ts, pid, "E|%d" % pid)
+                handled = True
+
+        if not handled:
+            self.skipped += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert a NuttX note trace to a Perfetto protobuf trace"
+    )
+    parser.add_argument(
+        "input", help='Text from "trace dump" or "trace stream" ("-" = stdin)'
+    )
+    parser.add_argument("output", help="Perfetto trace file to write")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        infile = sys.stdin
+    else:
+        infile = open(args.input, "r", errors="replace")
+
+    with open(args.output, "wb") as out:
+        conv = Converter(out)
+        for text in infile:
+            conv.line(text.rstrip("\r\n"))
+
+        conv.flush()
+
+    if infile is not sys.stdin:
+        infile.close()
+
+    print(
+        "%d events written, %d lines skipped" % (conv.count, conv.skipped),
+        file=sys.stderr,
+    )
+
+
+if __name__ == "__main__":
+    main()
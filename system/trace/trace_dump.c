@@ -25,15 +25,30 @@
 #include <nuttx/config.h>
 #include <nuttx/note/noteram_driver.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "trace.h"
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+static volatile bool g_stream_stop;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
 /****************************************************************************
  * Name: note_ioctl
  ****************************************************************************/
@@ -53,6 +68,45 @@ static void note_ioctl(int cmd, unsigned long arg)
   close(notefd);
 }
 
+/****************************************************************************
+ * Name: stream_sigint
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+static void stream_sigint(int signo)
+{
+  g_stream_stop = true;
+}
+
+/****************************************************************************
+ * Name: stream_write
+ ****************************************************************************/
+
+static int stream_write(int outfd, FAR const uint8_t *buffer, size_t size)
+{
+  ssize_t nwritten;
+
+  while (size > 0)
+    {
+      nwritten = write(outfd, buffer, size);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      buffer += nwritten;
+      size   -= nwritten;
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -147,3 +201,107 @@ void trace_dump_set_overwrite(bool enable)
 
   note_ioctl(NOTERAM_SETMODE, (unsigned long)&mode);
 }
+
+/****************************************************************************
+ * Name: trace_stream
+ *
+ * Description:
+ *   Continuously drain the note buffer into 'outfd' while tracing runs.
+ *   Notes are read with 'bufsize' byte reads so that the RAM buffer only
+ *   has to absorb the notes produced between two polls.  Streaming stops
+ *   after 'duration' seconds (0 = no limit) or when SIGINT is received.
+ *   If 'untilempty' is true, streaming instead stops as soon as the note
+ *   buffer is empty; this is used to collect the remaining notes after
+ *   tracing has been disabled.
+ *
+ * Returned Value:
+ *   The number of bytes streamed on success; a negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+ssize_t trace_stream(int outfd, size_t bufsize, unsigned int duration,
+                     bool untilempty)
+{
+  struct timespec start;
+  struct timespec now;
+  FAR uint8_t *buffer;
+  sighandler_t oldhandler;
+  ssize_t total = 0;
+  ssize_t nread;
+  int ret = OK;
+  int fd;
+
+  buffer = malloc(bufsize);
+  if (buffer == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Open note for read */
+
+  fd = open("/dev/note/ram", O_RDONLY);
+  if (fd < 0)
+    {
+      ret = -errno;
+      fprintf(stderr, "trace: cannot open /dev/note/ram\n");
+      free(buffer);
+      return ret;
+    }
+
+  g_stream_stop = false;
+  oldhandler = signal(SIGINT, stream_sigint);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (!g_stream_stop)
+    {
+      if (duration > 0)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          if (now.tv_sec - start.tv_sec >= duration)
+            {
+              break;
+            }
+        }
+
+      nread = read(fd, buffer, bufsize);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          ret = -errno;
+          break;
+        }
+      else if (nread == 0)
+        {
+          if (untilempty)
+            {
+              break;
+            }
+
+          /* Nothing buffered yet, give the traced tasks time to run */
+
+          usleep(CONFIG_SYSTEM_TRACE_STREAM_INTERVAL * 1000);
+          continue;
+        }
+
+      ret = stream_write(outfd, buffer, nread);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      total += nread;
+    }
+
+  signal(SIGINT, oldhandler);
+  close(fd);
+  free(buffer);
+
+  return ret < 0 ? ret : total;
+}
+#endif
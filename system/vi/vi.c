@@ -79,6 +79,11 @@
 #define TEXT_GULP_SIZE  512  /* Text buffer allocations are managed with this unit */
 #define TEXT_GULP_MASK  511  /* Mask for aligning buffer allocation sizes */
 #define ALIGN_GULP(x)   (((x) + TEXT_GULP_MASK) & ~TEXT_GULP_MASK)
+#define TEXT_GAP_SIZE(n) MAX((n) / 16, TEXT_GULP_SIZE) /* Minimum gap size */
+
+#define LINEIDX_SHIFT   5    /* The line index records every 32nd line */
+#define LINEIDX_STRIDE  (1 << LINEIDX_SHIFT)
+#define LINEIDX_GULP    64   /* Line index allocation unit (entries) */
 
 #define VI_TABSIZE      8    /* A TAB is eight characters */
 #define TABMASK         7    /* Mask for TAB alignment */
@@ -285,7 +290,7 @@ struct vi_s
   off_t textsize;           /* The size of the text buffer */
   off_t winpos;             /* Offset corresponding to the start of the display */
   off_t prevpos;            /* Previous display position */
-  off_t vscroll;            /* Vertical display offset in rows */
+  off_t vscroll;            /* Line number of the first line on display */
   uint16_t hscroll;         /* Horizontal display offset */
   uint16_t value;           /* Numeric value entered prior to a command */
   uint16_t reqcolumn;       /* Requested column when moving up/down */
@@ -310,6 +315,11 @@ struct vi_s
 
   FAR char *text;           /* Dynamically allocated text buffer */
   size_t txtalloc;          /* Current allocated size of the text buffer */
+  off_t gapstart;           /* Offset of the unused gap in the text buffer */
+  size_t gapsize;           /* Size of the gap (txtalloc - textsize) */
+  FAR off_t *lineidx;       /* Offset of every LINEIDX_STRIDE'th line */
+  size_t lineidxcnt;        /* Number of valid entries in lineidx[] */
+  size_t lineidxalloc;      /* Allocated number of entries in lineidx[] */
   FAR char *yank;           /* Dynamically allocated yank buffer */
   size_t yankalloc;         /* Current allocated size of the yank buffer */
   size_t yanksize;          /* Current size of the text in the yank buffer */
@@ -366,12 +376,33 @@ static void     vi_clrscreen(FAR struct vi_s *vi);
 static void     vi_printf(FAR struct vi_s *vi, FAR const char *prefix,
                   FAR const char *fmt, ...) printf_like(3, 4);
 
+/* Text buffer access */
+
+static char     vi_textchar(FAR struct vi_s *vi, off_t pos);
+static FAR char *vi_textptr(FAR struct vi_s *vi, off_t pos);
+static size_t   vi_textspan(FAR struct vi_s *vi, off_t pos, size_t size);
+static void     vi_movegap(FAR struct vi_s *vi, off_t pos);
+static void     vi_copytext(FAR struct vi_s *vi, FAR char *dest, off_t pos,
+                  size_t size);
+static void     vi_writetext(FAR struct vi_s *vi, off_t pos, size_t size);
+static bool     vi_textmatch(FAR struct vi_s *vi, off_t pos,
+                  FAR const char *str, size_t len);
+
 /* Line positioning */
 
 static off_t    vi_linebegin(FAR struct vi_s *vi, off_t pos);
 static off_t    vi_prevline(FAR struct vi_s *vi, off_t pos);
 static off_t    vi_lineend(FAR struct vi_s *vi, off_t pos);
 static off_t    vi_nextline(FAR struct vi_s *vi, off_t pos);
+static void     vi_trimindex(FAR struct vi_s *vi, off_t pos);
+static void     vi_buildindex(FAR struct vi_s *vi, off_t pos, off_t lineno);
+#if CONFIG_SYSTEM_VI_DEBUGLEVEL > 1
+static void     vi_checkindex(FAR struct vi_s *vi);
+#else
+#  define       vi_checkindex(vi)
+#endif
+static off_t    vi_lineno(FAR struct vi_s *vi, off_t pos);
+static off_t    vi_linepos(FAR struct vi_s *vi, off_t lineno);
 
 /* Text buffer management */
 
@@ -890,6 +921,177 @@ static void vi_printf(FAR struct vi_s *vi, FAR const char *prefix,
   VI_BEL(vi);
 }
 
+/****************************************************************************
+ * Text buffer access
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vi_textchar
+ *
+ * Description:
+ *   Return the character at logical offset 'pos' in the text buffer.  The
+ *   text buffer is a gap buffer:  Text before vi->gapstart is stored at the
+ *   beginning of the allocation and the remaining text is stored after the
+ *   gap at the end of the allocation.  Offsets outside of the text return
+ *   the NUL character.
+ *
+ ****************************************************************************/
+
+static char vi_textchar(FAR struct vi_s *vi, off_t pos)
+{
+  if (pos < 0 || pos >= vi->textsize)
+    {
+      return '\0';
+    }
+
+  return *vi_textptr(vi, pos);
+}
+
+/****************************************************************************
+ * Name: vi_textptr
+ *
+ * Description:
+ *   Return a pointer to the storage of the character at logical offset
+ *   'pos' in the text buffer.
+ *
+ ****************************************************************************/
+
+static FAR char *vi_textptr(FAR struct vi_s *vi, off_t pos)
+{
+  if (pos >= vi->gapstart)
+    {
+      pos += vi->gapsize;
+    }
+
+  return &vi->text[pos];
+}
+
+/****************************************************************************
+ * Name: vi_textspan
+ *
+ * Description:
+ *   Return the number of bytes, up to 'size', that are stored contiguously
+ *   beginning at logical offset 'pos'.
+ *
+ ****************************************************************************/
+
+static size_t vi_textspan(FAR struct vi_s *vi, off_t pos, size_t size)
+{
+  if (pos < vi->gapstart && pos + size > vi->gapstart)
+    {
+      size = vi->gapstart - pos;
+    }
+
+  return size;
+}
+
+/****************************************************************************
+ * Name: vi_movegap
+ *
+ * Description:
+ *   Move the gap in the text buffer so that it begins at logical offset
+ *   'pos'.  Only the text between the old and new gap positions is moved.
+ *
+ ****************************************************************************/
+
+static void vi_movegap(FAR struct vi_s *vi, off_t pos)
+{
+  if (pos < vi->gapstart)
+    {
+      memmove(vi->text + pos + vi->gapsize, vi->text + pos,
+              vi->gapstart - pos);
+    }
+  else if (pos > vi->gapstart)
+    {
+      memmove(vi->text + vi->gapstart,
+              vi->text + vi->gapstart + vi->gapsize,
+              pos - vi->gapstart);
+    }
+
+  vi->gapstart = pos;
+}
+
+/****************************************************************************
+ * Name: vi_copytext
+ *
+ * Description:
+ *   Copy a region of the text buffer into a contiguous user buffer.
+ *
+ ****************************************************************************/
+
+static void vi_copytext(FAR struct vi_s *vi, FAR char *dest, off_t pos,
+                        size_t size)
+{
+  size_t nbytes;
+
+  while (size > 0)
+    {
+      nbytes = vi_textspan(vi, pos, size);
+      memcpy(dest, vi_textptr(vi, pos), nbytes);
+
+      dest += nbytes;
+      pos  += nbytes;
+      size -= nbytes;
+    }
+}
+
+/****************************************************************************
+ * Name: vi_writetext
+ *
+ * Description:
+ *   Write a region of the text buffer to the display.
+ *
+ ****************************************************************************/
+
+static void vi_writetext(FAR struct vi_s *vi, off_t pos, size_t size)
+{
+  size_t nbytes;
+
+  while (size > 0)
+    {
+      nbytes = vi_textspan(vi, pos, size);
+      vi_write(vi, vi_textptr(vi, pos), nbytes);
+
+      pos  += nbytes;
+      size -= nbytes;
+    }
+}
+
+/****************************************************************************
+ * Name: vi_textmatch
+ *
+ * Description:
+ *   Return true if the 'len' bytes of text at logical offset 'pos' match
+ *   the string 'str'.
+ *
+ ****************************************************************************/
+
+static bool vi_textmatch(FAR struct vi_s *vi, off_t pos,
+                         FAR const char *str, size_t len)
+{
+  size_t nbytes;
+
+  if (pos + len > vi->textsize)
+    {
+      return false;
+    }
+
+  while (len > 0)
+    {
+      nbytes = vi_textspan(vi, pos, len);
+      if (memcmp(vi_textptr(vi, pos), str, nbytes) != 0)
+        {
+          return false;
+        }
+
+      str += nbytes;
+      pos += nbytes;
+      len -= nbytes;
+    }
+
+  return true;
+}
+
 /****************************************************************************
  * Line positioning
  ****************************************************************************/
@@ -908,7 +1110,7 @@ static off_t vi_linebegin(FAR struct vi_s *vi, off_t pos)
    * the beginning of the text buffer).
    */
 
-  while (pos && vi->text[pos - 1] != '\n')
+  while (pos && vi_textchar(vi, pos - 1) != '\n')
     {
       pos--;
     }
@@ -958,12 +1160,12 @@ static off_t vi_lineend(FAR struct vi_s *vi, off_t pos)
    * the end of the text buffer).
    */
 
-  while (pos < vi->textsize && vi->text[pos] != '\n')
+  while (pos < vi->textsize && vi_textchar(vi, pos) != '\n')
     {
       pos++;
     }
 
-  if (vi->text[pos] == '\n')
+  if (vi_textchar(vi, pos) == '\n')
     {
       pos--;
     }
@@ -999,6 +1201,224 @@ static off_t vi_nextline(FAR struct vi_s *vi, off_t pos)
   return pos;
 }
 
+/****************************************************************************
+ * Name: vi_trimindex
+ *
+ * Description:
+ *   Discard all line index entries that lie beyond 'pos'.  This must be
+ *   called whenever text is inserted or deleted at 'pos', and whenever a
+ *   newline is written or overwritten in place at 'pos'.  The discarded
+ *   entries are rebuilt on demand by vi_buildindex().
+ *
+ ****************************************************************************/
+
+static void vi_trimindex(FAR struct vi_s *vi, off_t pos)
+{
+  while (vi->lineidxcnt > 1 && vi->lineidx[vi->lineidxcnt - 1] > pos)
+    {
+      vi->lineidxcnt--;
+    }
+}
+
+/****************************************************************************
+ * Name: vi_buildindex
+ *
+ * Description:
+ *   Extend the line index until it holds an entry beyond offset 'pos' or
+ *   an entry for line 'lineno', or until the end of the text is reached.
+ *   Passing vi->textsize for either limit removes that limit.  If the
+ *   index cannot be extended, the lookups simply scan further from the
+ *   last valid entry.
+ *
+ ****************************************************************************/
+
+static void vi_buildindex(FAR struct vi_s *vi, off_t pos, off_t lineno)
+{
+  FAR off_t *alloc;
+  off_t next;
+  int i;
+
+  if (vi->lineidxcnt == 0)
+    {
+      if (vi->lineidxalloc == 0)
+        {
+          vi->lineidx = malloc(LINEIDX_GULP * sizeof(off_t));
+          if (vi->lineidx == NULL)
+            {
+              return;
+            }
+
+          vi->lineidxalloc = LINEIDX_GULP;
+        }
+
+      vi->lineidx[0] = 0;
+      vi->lineidxcnt = 1;
+    }
+
+  while (vi->lineidx[vi->lineidxcnt - 1] <= pos &&
+         ((off_t)vi->lineidxcnt << LINEIDX_SHIFT) <= lineno)
+    {
+      /* Find the start of the next indexed line */
+
+      next = vi->lineidx[vi->lineidxcnt - 1];
+      for (i = 0; i < LINEIDX_STRIDE && next < vi->textsize; i++)
+        {
+          next = vi_nextline(vi, next);
+        }
+
+      if (i < LINEIDX_STRIDE || next >= vi->textsize)
+        {
+          return;
+        }
+
+      if (vi->lineidxcnt >= vi->lineidxalloc)
+        {
+          alloc = realloc(vi->lineidx,
+                          (vi->lineidxalloc + LINEIDX_GULP) * sizeof(off_t));
+          if (alloc == NULL)
+            {
+              return;
+            }
+
+          vi->lineidx       = alloc;
+          vi->lineidxalloc += LINEIDX_GULP;
+        }
+
+      vi->lineidx[vi->lineidxcnt++] = next;
+    }
+
+  vi_checkindex(vi);
+}
+
+/****************************************************************************
+ * Name: vi_checkindex
+ *
+ * Description:
+ *   Debug check that every line index entry is still the start of its
+ *   line, i.e. that no edit missed a vi_trimindex() call.
+ *
+ ****************************************************************************/
+
+#if CONFIG_SYSTEM_VI_DEBUGLEVEL > 1
+static void vi_checkindex(FAR struct vi_s *vi)
+{
+  off_t pos = 0;
+  size_t index;
+  int i;
+
+  for (index = 1; index < vi->lineidxcnt; index++)
+    {
+      for (i = 0; i < LINEIDX_STRIDE && pos < vi->textsize; i++)
+        {
+          pos = vi_nextline(vi, pos);
+        }
+
+      if (vi->lineidx[index] != pos)
+        {
+          vidbg("ERROR: line index entry %zu is %ld, line %ld is at %ld\n",
+                index, (long)vi->lineidx[index],
+                (long)index << LINEIDX_SHIFT, (long)pos);
+          return;
+        }
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: vi_lineno
+ *
+ * Description:
+ *   Return the zero-based number of the line containing offset 'pos'.
+ *
+ ****************************************************************************/
+
+static off_t vi_lineno(FAR struct vi_s *vi, off_t pos)
+{
+  off_t lineno;
+  off_t start;
+  size_t low;
+  size_t high;
+  size_t mid;
+
+  pos = vi_linebegin(vi, pos);
+  vi_buildindex(vi, pos, vi->textsize);
+
+  /* Find the last index entry at or before the beginning of the line */
+
+  lineno = 0;
+  start  = 0;
+
+  if (vi->lineidxcnt > 0)
+    {
+      low  = 0;
+      high = vi->lineidxcnt - 1;
+      while (low < high)
+        {
+          mid = (low + high + 1) >> 1;
+          if (vi->lineidx[mid] <= pos)
+            {
+              low = mid;
+            }
+          else
+            {
+              high = mid - 1;
+            }
+        }
+
+      lineno = (off_t)low << LINEIDX_SHIFT;
+      start  = vi->lineidx[low];
+    }
+
+  /* Then count the remaining lines */
+
+  while (start < pos)
+    {
+      start = vi_nextline(vi, start);
+      lineno++;
+    }
+
+  return lineno;
+}
+
+/****************************************************************************
+ * Name: vi_linepos
+ *
+ * Description:
+ *   Return the offset to the beginning of the zero-based line 'lineno'.
+ *
+ ****************************************************************************/
+
+static off_t vi_linepos(FAR struct vi_s *vi, off_t lineno)
+{
+  off_t line;
+  off_t pos;
+  size_t index;
+
+  vi_buildindex(vi, vi->textsize, lineno);
+
+  line = 0;
+  pos  = 0;
+
+  if (vi->lineidxcnt > 0)
+    {
+      index = lineno >> LINEIDX_SHIFT;
+      if (index >= vi->lineidxcnt)
+        {
+          index = vi->lineidxcnt - 1;
+        }
+
+      line = (off_t)index << LINEIDX_SHIFT;
+      pos  = vi->lineidx[index];
+    }
+
+  for (; line < lineno && pos < vi->textsize; line++)
+    {
+      pos = vi_nextline(vi, pos);
+    }
+
+  return pos;
+}
+
 /****************************************************************************
  * Text buffer management
  ****************************************************************************/
@@ -1009,25 +1429,30 @@ static off_t vi_nextline(FAR struct vi_s *vi, off_t pos)
  * Description:
  *   Reallocate the in-memory file memory by (at least) 'increment' and make
  *   space for new text of size 'increment' at the specified cursor position.
+ *   On return, the new region is contiguous in memory at
+ *   vi_textptr(vi, pos).
  *
  ****************************************************************************/
 
 static bool vi_extendtext(FAR struct vi_s *vi, off_t pos, size_t increment)
 {
   FAR char *alloc;
-  int i;
+  size_t allocsize;
+  size_t tailsize;
 
   viinfo("pos=%ld increment=%ld\n", (long)pos, (long)increment);
 
   /* Check if we need to reallocate */
 
-  if (!vi->text || vi->textsize + increment > vi->txtalloc)
+  if (!vi->text || increment > vi->gapsize)
     {
       /* Allocate in chunksize so that we do not have to reallocate so
-       * often.
+       * often.  Leave a gap proportional to the text size so that the
+       * cost of reallocation is amortized over many insertions.
        */
 
-      size_t allocsize = ALIGN_GULP(vi->textsize + increment);
+      allocsize = ALIGN_GULP(vi->textsize + increment +
+                             TEXT_GAP_SIZE(vi->textsize));
       alloc = realloc(vi->text, allocsize);
       if (alloc == NULL)
         {
@@ -1037,20 +1462,28 @@ static bool vi_extendtext(FAR struct vi_s *vi, off_t pos, size_t increment)
           return false;
         }
 
+      /* Move the text after the gap to the end of the new allocation */
+
+      tailsize = vi->textsize - vi->gapstart;
+      memmove(alloc + allocsize - tailsize,
+              alloc + vi->gapstart + vi->gapsize, tailsize);
+
       /* Save the new buffer information */
 
-      vi->text    = alloc;
+      vi->text     = alloc;
+      vi->gapsize += allocsize - vi->txtalloc;
       vi->txtalloc = allocsize;
     }
 
-  /* Move text to make space for new text of size 'increment' at the current
-   * cursor position
+  /* Move the gap to the current cursor position and take space for new
+   * text of size 'increment' from the beginning of the gap.
    */
 
-  for (i = vi->textsize - 1; i >= pos; i--)
-    {
-      vi->text[i + increment] = vi->text[i];
-    }
+  vi_movegap(vi, pos);
+  vi_trimindex(vi, pos);
+
+  vi->gapstart += increment;
+  vi->gapsize  -= increment;
 
   /* Adjust end of file position */
 
@@ -1120,9 +1553,9 @@ static void vi_shrinkpos(FAR struct vi_s *vi, off_t delpos, size_t delsize,
  * Name: vi_shrinktext
  *
  * Description:
- *   Delete a region in the text buffer by copying the end of the text buffer
- *   over the deleted region and adjusting the size of the region.  The text
- *   region may be reallocated in order to recover the unused memory.
+ *   Delete a region in the text buffer by moving the gap to the deleted
+ *   region and growing the gap over it.  The text region may be
+ *   reallocated in order to recover the unused memory.
  *
  ****************************************************************************/
 
@@ -1130,23 +1563,22 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
 {
   FAR char *alloc;
   size_t allocsize;
-  int i;
+  size_t tailsize;
 
   viinfo("pos=%ld size=%ld\n", (long)pos, (long)size);
 
-  /* Close up the gap to remove 'size' characters at 'pos' */
+  /* Ensure we are not shrinking more than we have */
 
-  for (i = pos + size; i < vi->textsize; i++)
+  if (pos + size > vi->textsize)
     {
-      vi->text[i - size] = vi->text[i];
+      size = vi->textsize - pos;
     }
 
-  /* Ensure we are not shrinking more than we have */
+  /* Absorb the 'size' characters at 'pos' into the gap */
 
-  if (size > vi->textsize)
-    {
-      size = vi->textsize;
-    }
+  vi_movegap(vi, pos);
+  vi_trimindex(vi, pos);
+  vi->gapsize += size;
 
   /* Adjust sizes and positions */
 
@@ -1156,16 +1588,30 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
   vi_shrinkpos(vi, pos, size, &vi->winpos);
   vi_shrinkpos(vi, pos, size, &vi->prevpos);
 
-  /* Reallocate the buffer to free up memory no longer in use */
+  /* Reallocate the buffer to free up memory no longer in use.  This is
+   * only done when the gap has become much larger than needed so that
+   * repeated deletions do not reallocate every time.
+   */
 
-  allocsize = ALIGN_GULP(vi->textsize);
-  if (allocsize == 0)
+  if (vi->gapsize <= 4 * TEXT_GAP_SIZE(vi->textsize))
     {
-      allocsize = TEXT_GULP_SIZE;
+      return;
     }
 
+  allocsize = ALIGN_GULP(vi->textsize + TEXT_GAP_SIZE(vi->textsize));
   if (allocsize < vi->txtalloc)
     {
+      /* Move the text after the gap down to the end of the smaller
+       * allocation before shrinking.
+       */
+
+      tailsize = vi->textsize - vi->gapstart;
+      memmove(vi->text + allocsize - tailsize,
+              vi->text + vi->gapstart + vi->gapsize, tailsize);
+
+      vi->gapsize -= vi->txtalloc - allocsize;
+      vi->txtalloc = allocsize;
+
       alloc = realloc(vi->text, allocsize);
       if (!alloc)
         {
@@ -1175,8 +1621,7 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
 
       /* Save the new buffer information */
 
-      vi->text    = alloc;
-      vi->txtalloc = allocsize;
+      vi->text = alloc;
     }
 }
 
@@ -1241,7 +1686,7 @@ static bool vi_insertfile(FAR struct vi_s *vi, off_t pos,
        * current cursor position.
        */
 
-      nread = fread(vi->text + pos, 1, filesize, stream);
+      nread = fread(vi_textptr(vi, pos), 1, filesize, stream);
       if (nread < filesize)
         {
           /* Report the error (or partial read), EINTR is not handled */
@@ -1273,6 +1718,8 @@ static bool vi_savetext(FAR struct vi_s *vi, FAR const char *filename,
 {
   FAR FILE *stream;
   size_t nwritten;
+  size_t nbytes;
+  size_t span;
   int len;
 
   viinfo("filename=\"%s\" pos=%ld size=%ld\n",
@@ -1288,17 +1735,21 @@ static bool vi_savetext(FAR struct vi_s *vi, FAR const char *filename,
     }
 
   /* Write the region of the text buffer beginning at pos and extending
-   * through pos + size -1.
+   * through pos + size -1.  The region may be split by the gap.
    */
 
-  nwritten = fwrite(vi->text + pos, 1, size, stream);
-  if (nwritten < size)
+  for (nwritten = 0; nwritten < size; nwritten += nbytes)
     {
-      /* Report the error (or partial write).  EINTR is not handled. */
+      span   = vi_textspan(vi, pos + nwritten, size - nwritten);
+      nbytes = fwrite(vi_textptr(vi, pos + nwritten), 1, span, stream);
+      if (nbytes < span)
+        {
+          /* Report the error (or partial write).  EINTR is not handled. */
 
-      vi_error(vi, g_fmtcmdfail, "fwrite", errno);
-      fclose(stream);
-      return false;
+          vi_error(vi, g_fmtcmdfail, "fwrite", errno);
+          fclose(stream);
+          return false;
+        }
     }
 
   fclose(stream);
@@ -1486,7 +1937,7 @@ static void vi_windowpos(FAR struct vi_s *vi, off_t start, off_t end,
     {
       /* Is there a newline terminator at this position? */
 
-      if (vi->text[pos] == '\n')
+      if (vi_textchar(vi, pos) == '\n')
         {
           /* Yes... break out of the loop return the cursor column */
 
@@ -1502,7 +1953,7 @@ static void vi_windowpos(FAR struct vi_s *vi, off_t start, off_t end,
 
       /* No... Is there a TAB at this position? */
 
-      else if (vi->text[pos] == '\t')
+      else if (vi_textchar(vi, pos) == '\t')
         {
           /* Yes.. expand the TAB */
 
@@ -1520,7 +1971,7 @@ static void vi_windowpos(FAR struct vi_s *vi, off_t start, off_t end,
   /* Keep cursor in bounds of text (i.e. not at the '\n') */
 
   if (((pos == vi->textsize && column != 0) ||
-       (vi->text[pos] == '\n' && pos != start)) &&
+       (vi_textchar(vi, pos) == '\n' && pos != start)) &&
         vi->mode != MODE_INSERT && vi->mode != MODE_REPLACE)
     {
       pos--;
@@ -1557,6 +2008,9 @@ static void vi_windowpos(FAR struct vi_s *vi, off_t start, off_t end,
 static void vi_scrollcheck(FAR struct vi_s *vi)
 {
   off_t curline;
+  off_t curlineno;
+  off_t winlineno;
+  off_t toplineno;
   off_t pos;
   uint16_t tmp;
   int column;
@@ -1573,40 +2027,49 @@ static void vi_scrollcheck(FAR struct vi_s *vi)
 
   curline = vi_linebegin(vi, vi->curpos);
 
-  /* Check if the current line is above the first line on the display */
-
-  while (curline < vi->winpos)
-    {
-      /* Yes.. move the window position up to the beginning of the previous
-       * line line and check again
-       */
+  /* Get the line numbers of the current line and of the first line on the
+   * display from the line index.  This avoids walking the text line by
+   * line when the cursor jumps far away from the display.
+   */
 
-      vi->winpos = vi_prevline(vi, vi->winpos);
-      vi->vscroll--;
-      vi->fullredraw = true;
-    }
+  curlineno = vi_lineno(vi, curline);
+  winlineno = vi_lineno(vi, vi->winpos);
 
-  /* Reset the cursor row position so that it is relative to the
-   * top of the display.
+  /* Check if the current line is above the first line on the display.  If
+   * so, the current line becomes the first line on the display.
    */
 
-  vi->cursor.row = 0;
-  for (pos = vi->winpos; pos < curline; pos = vi_nextline(vi, pos))
+  if (curlineno < winlineno)
     {
-      vi->cursor.row++;
+      toplineno = curlineno;
     }
 
-  /* Check if the cursor row position is below the bottom of the display */
+  /* Check if the current line is below the bottom of the display.  If so,
+   * the current line becomes the last line on the display.
+   */
 
-  for (; vi->cursor.row >= vi->display.row - 1; vi->cursor.row--)
+  else if (curlineno - winlineno >= vi->display.row - 1)
     {
-      /* Yes.. move the window position down by one line and check again */
+      toplineno = curlineno - vi->display.row + 2;
+    }
+  else
+    {
+      toplineno = winlineno;
+    }
 
-      vi->winpos = vi_nextline(vi, vi->winpos);
-      vi->vscroll++;
+  if (toplineno != winlineno)
+    {
+      vi->winpos     = vi_linepos(vi, toplineno);
       vi->fullredraw = true;
     }
 
+  /* Set the cursor row position so that it is relative to the top of the
+   * display.
+   */
+
+  vi->vscroll    = toplineno;
+  vi->cursor.row = curlineno - toplineno;
+
   /* Check if the cursor column is on the display.  vi_windowpos returns the
    * unrestricted column number of cursor.  hscroll is the horizontal offset
    * in characters.
@@ -1842,20 +2305,20 @@ static void vi_showtext(FAR struct vi_s *vi)
                * last column is encountered.
                */
 
-              if (vi->text[pos] == '\n')
+              if (vi_textchar(vi, pos) == '\n')
                 {
                   break;
                 }
 
               /* Perform TAB expansion */
 
-              else if (vi->text[pos] == '\t')
+              else if (vi_textchar(vi, pos) == '\t')
                 {
                   /* Write collected characters */
 
                   if (writefrom != pos)
                     {
-                      vi_write(vi, &vi->text[writefrom], pos - writefrom);
+                      vi_writetext(vi, writefrom, pos - writefrom);
                     }
 
                   tabcol = NEXT_TAB(column);
@@ -1891,7 +2354,7 @@ static void vi_showtext(FAR struct vi_s *vi)
 
           if (writefrom != pos)
             {
-              vi_write(vi, &vi->text[writefrom], pos - writefrom);
+              vi_writetext(vi, writefrom, pos - writefrom);
             }
 
           vi_clrtoeol(vi);
@@ -1902,7 +2365,7 @@ static void vi_showtext(FAR struct vi_s *vi)
       pos = vi_nextline(vi, pos);
     }
 
-  if (pos == vi->textsize && vi->text[pos - 1] == '\n')
+  if (pos == vi->textsize && vi_textchar(vi, pos - 1) == '\n')
     {
       vi_setcursor(vi, row, 0);
       vi_clrtoeol(vi);
@@ -2076,7 +2539,7 @@ static off_t vi_cursorleft(FAR struct vi_s *vi, off_t curpos, int ncolumns)
    */
 
   for (remaining = (ncolumns < 1 ? 1 : ncolumns);
-       curpos > 0 && remaining > 0 && vi->text[curpos - 1] != '\n';
+       curpos > 0 && remaining > 0 && vi_textchar(vi, curpos - 1) != '\n';
        curpos--, remaining--)
     {
     }
@@ -2106,13 +2569,14 @@ static off_t vi_cursorright(FAR struct vi_s *vi, off_t curpos, int ncolumns)
    */
 
   for (remaining = (ncolumns < 1 ? 1 : ncolumns);
-       curpos < vi->textsize && remaining > 0 && vi->text[curpos] != '\n';
+       curpos < vi->textsize && remaining > 0 &&
+       vi_textchar(vi, curpos) != '\n';
        curpos++, remaining--)
     {
     }
 
 #if 0
-  if (vi->text[curpos] == '\n' || (curpos == vi->textsize &&
+  if (vi_textchar(vi, curpos) == '\n' || (curpos == vi->textsize &&
       vi->mode != MODE_INSERT && vi->mode != MODE_REPLACE))
     {
       curpos--;
@@ -2182,8 +2646,8 @@ static int vi_gotoscreenbottom(FAR struct vi_s *vi, int rows)
 static void vi_gotofirstnonwhite(FAR struct vi_s *vi)
 {
   vi->curpos = vi_linebegin(vi, vi->curpos);
-  while (vi->curpos <= vi->textsize && (vi->text[vi->curpos] == ' ' ||
-         vi->text[vi->curpos] == '\t'))
+  while (vi->curpos <= vi->textsize && (vi_textchar(vi, vi->curpos) == ' ' ||
+         vi_textchar(vi, vi->curpos) == '\t'))
     {
       vi->curpos++;
     }
@@ -2219,7 +2683,7 @@ static void vi_delforward(FAR struct vi_s *vi)
       /* If at end of file, just return */
 
       if (vi->curpos == vi->textsize ||
-          vi->text[vi->curpos] == '\n')
+          vi_textchar(vi, vi->curpos) == '\n')
         {
           return;
         }
@@ -2273,8 +2737,8 @@ static void vi_delbackward(FAR struct vi_s *vi)
 
   /* Test if we are at beginning of line */
 
-  if (vi->curpos == 0 || vi->text[vi->curpos] == '\n' ||
-      vi->text[vi->curpos - 1] == '\n')
+  if (vi->curpos == 0 || vi_textchar(vi, vi->curpos) == '\n' ||
+      vi_textchar(vi, vi->curpos - 1) == '\n')
     {
       return;
     }
@@ -2300,7 +2764,7 @@ static void vi_delbackward(FAR struct vi_s *vi)
     {
       /* Test if \n' in the range.  Don't delete through \n */
 
-      if (vi->text[x] == '\n')
+      if (vi_textchar(vi, x) == '\n')
         {
           start = x + 1;
           break;
@@ -2383,7 +2847,7 @@ static void vi_deltoeol(FAR struct vi_s *vi)
 
   /* If we are at the end of the line, then return */
 
-  if (vi->curpos == vi->textsize || vi->text[vi->curpos] == '\n')
+  if (vi->curpos == vi->textsize || vi_textchar(vi, vi->curpos) == '\n')
     {
       return;
     }
@@ -2392,7 +2856,7 @@ static void vi_deltoeol(FAR struct vi_s *vi)
 
   start = vi->curpos;
   end   = vi_lineend(vi, vi->curpos);
-  if (end == vi->textsize || vi->text[end] == '\n')
+  if (end == vi->textsize || vi_textchar(vi, end) == '\n')
     {
       end--;
     }
@@ -2400,7 +2864,8 @@ static void vi_deltoeol(FAR struct vi_s *vi)
   /* Yank and remove text from the buffer */
 
   vi_yanktext(vi, start, end, true, true);
-  if (start > 0 && start != vi->textsize && vi->text[start - 1] != '\n')
+  if (start > 0 && start != vi->textsize &&
+      vi_textchar(vi, start - 1) != '\n')
     {
       vi->curpos = start - 1;
     }
@@ -2429,7 +2894,7 @@ static void vi_yanktext(FAR struct vi_s *vi, off_t start, off_t end,
 
   /* At end of file, in line yank mode, if there is no LF, we append one */
 
-  if (vi->text[end] != '\n' && !yankcharmode)
+  if (vi_textchar(vi, end) != '\n' && !yankcharmode)
     {
       append_lf = 1;
     }
@@ -2482,7 +2947,7 @@ static void vi_yanktext(FAR struct vi_s *vi, off_t start, off_t end,
   /* Copy the block from the text buffer to the yank buffer */
 
   vi->yanksize = size;
-  memcpy(vi->yank, &vi->text[start], size);
+  vi_copytext(vi, vi->yank, start, size);
 
   /* Append \n if needed */
 
@@ -2544,7 +3009,7 @@ static void vi_yank(FAR struct vi_s *vi, bool del_after_yank)
 
   yank_end = end;
   if (del_after_yank && end == textsize - 1 && start != end &&
-      vi->text[end] == '\n')
+      vi_textchar(vi, end) == '\n')
     {
       yank_end--;
       pos_increment = 1;
@@ -2555,8 +3020,8 @@ static void vi_yank(FAR struct vi_s *vi, bool del_after_yank)
   /* Test if deleting last line with empty line above it */
 
   if ((end > 0 && start == end && end == vi->textsize -1 &&
-      vi->text[end - 1] == '\n') || (start > 1 && end + 1 ==
-      vi->textsize && vi->text[start - 2] == '\n'))
+      vi_textchar(vi, end - 1) == '\n') || (start > 1 && end + 1 ==
+      vi->textsize && vi_textchar(vi, start - 2) == '\n'))
     {
       empty_last_line = true;
     }
@@ -2629,8 +3094,8 @@ static void vi_paste(FAR struct vi_s *vi, bool paste_before)
 
           /* Paste at next col to the right of cursor */
 
-          if (vi->text[vi->curpos] == '\n' || vi->curpos == vi->textsize ||
-              paste_before)
+          if (vi_textchar(vi, vi->curpos) == '\n' ||
+              vi->curpos == vi->textsize || paste_before)
             {
               pos = vi->curpos;
             }
@@ -2645,12 +3110,13 @@ static void vi_paste(FAR struct vi_s *vi, bool paste_before)
                * at the position where the start of the next line was.
                */
 
-              memcpy(&vi->text[pos], vi->yank, vi->yanksize);
+              memcpy(vi_textptr(vi, pos), vi->yank, vi->yanksize);
 
               /* Advance the cursor */
 
               vi->curpos = vi->curpos + vi->yanksize;
-              if (vi->curpos > vi->textsize || vi->text[vi->curpos] == '\n')
+              if (vi->curpos > vi->textsize ||
+                  vi_textchar(vi, vi->curpos) == '\n')
                 {
                   vi->curpos--;
                 }
@@ -2676,8 +3142,9 @@ static void vi_paste(FAR struct vi_s *vi, bool paste_before)
           /* Test if pasting at end of file */
 
           new_curpos = start;
-          if ((start >= vi->textsize && vi->text[vi->textsize - 1] != '\n')
-              || vi->curpos == vi->textsize)
+          if ((start >= vi->textsize &&
+               vi_textchar(vi, vi->textsize - 1) != '\n') ||
+              vi->curpos == vi->textsize)
             {
               off_t textsize = vi->textsize;
               bool at_end = vi->curpos == vi->textsize;
@@ -2689,7 +3156,7 @@ static void vi_paste(FAR struct vi_s *vi, bool paste_before)
 
               /* Don't append the \n' in the yank buffer */
 
-              if (vi->text[textsize - 1] != '\n' || at_end)
+              if (vi_textchar(vi, textsize - 1) != '\n' || at_end)
                 {
                   size--;
                 }
@@ -2714,7 +3181,7 @@ static void vi_paste(FAR struct vi_s *vi, bool paste_before)
                * at the position where the start of the next line was.
                */
 
-              memcpy(&vi->text[start], vi->yank, size);
+              memcpy(vi_textptr(vi, start), vi->yank, size);
 
               /* Advance to next line */
 
@@ -2754,19 +3221,20 @@ static void vi_join(FAR struct vi_s *vi)
 
   /* Ensure the line ends with '\n' */
 
-  if (vi->text[start + 1] != '\n')
+  if (vi_textchar(vi, start + 1) != '\n')
     {
       return;
     }
 
-  /* Convert the '\n' to a space */
+  /* Convert the '\n' to a space.  The following lines move up by one. */
 
-  vi->text[++start] = ' ';
+  vi_trimindex(vi, ++start);
+  *vi_textptr(vi, start) = ' ';
   end = start + 1;
 
   /* Skip all spaces and tabs on next line */
 
-  while ((vi->text[end] == ' ' || vi->text[end] == '\t') &&
+  while ((vi_textchar(vi, end) == ' ' || vi_textchar(vi, end) == '\t') &&
       end < vi->textsize)
     {
       end++;
@@ -2779,6 +3247,7 @@ static void vi_join(FAR struct vi_s *vi)
 
   vi->curpos    = start;
   vi->drawtoeos = true;
+  vi_checkindex(vi);
 }
 
 /****************************************************************************
@@ -2802,20 +3271,11 @@ static void vi_gotoline(FAR struct vi_s *vi)
       vi->curpos = 0;
     }
 
-  /* Work harder to position to lines in the middle */
+  /* Use the line index to position to lines in the middle */
 
   else if (vi->value > 0)
     {
-      uint32_t line;
-
-      /* Got to the line == value */
-
-      for (line = vi->value, vi->curpos = 0;
-          --line > 0 && vi->curpos < vi->textsize;
-          )
-        {
-          vi->curpos = vi_nextline(vi, vi->curpos);
-        }
+      vi->curpos = vi_linepos(vi, vi->value - 1);
     }
 
   /* No value means to go to beginning of the last line */
@@ -2890,14 +3350,14 @@ static off_t vi_findnextword(FAR struct vi_s *vi)
    * next "word" looks like.
    */
 
-  srch_type = vi_chartype(vi->text[vi->curpos]);
+  srch_type = vi_chartype(vi_textchar(vi, vi->curpos));
   pos = vi->curpos + 1;
 
   for (; pos < vi->textsize; pos++)
     {
       /* Get type of the next character */
 
-      pos_type = vi_chartype(vi->text[pos]);
+      pos_type = vi_chartype(vi_textchar(vi, pos));
 
       /* Skip CR and NL */
 
@@ -2992,13 +3452,14 @@ static void vi_gotonextword(FAR struct vi_s *vi)
       pos     = vi->curpos;
       crfound = false;
 
-      while ((vi->text[pos - 1] == ' ' || vi->text[pos - 1] == '\t' ||
-             vi->text[pos - 1] == '\n') && pos > start)
+      while ((vi_textchar(vi, pos - 1) == ' ' ||
+              vi_textchar(vi, pos - 1) == '\t' ||
+              vi_textchar(vi, pos - 1) == '\n') && pos > start)
         {
           /* We rewind only if '\n' found before non-space */
 
           pos--;
-          if (vi->text[pos] == '\n')
+          if (vi_textchar(vi, pos) == '\n')
             {
               crfound = true;
             }
@@ -3021,7 +3482,7 @@ static void vi_gotonextword(FAR struct vi_s *vi)
             {
               /* Test for '\n' */
 
-              if (vi->text[x] == '\n')
+              if (vi_textchar(vi, x) == '\n')
                 {
                   /* Modify the yank / delete range */
 
@@ -3047,7 +3508,7 @@ static void vi_gotonextword(FAR struct vi_s *vi)
 
       /* Yank text if it isn't a single \n character */
 
-      if (!(start == end && vi->text[start] == '\n'))
+      if (!(start == end && vi_textchar(vi, start) == '\n'))
         {
           vi_yanktext(vi, start, end, 1, vi->delarm | vi->chgarm);
         }
@@ -3113,9 +3574,9 @@ static off_t vi_findprevword(FAR struct vi_s *vi)
    * next "word" looks like.
    */
 
-  srch_type = vi_chartype(vi->text[vi->curpos]);
+  srch_type = vi_chartype(vi_textchar(vi, vi->curpos));
   pos       = vi->curpos - 1;
-  pos_type  = vi_chartype(vi->text[pos]);
+  pos_type  = vi_chartype(vi_textchar(vi, pos));
 
   /* Test if we are at the beginning of a word */
 
@@ -3125,7 +3586,7 @@ static off_t vi_findprevword(FAR struct vi_s *vi)
 
       while (pos > 0)
         {
-          pos_type = vi_chartype(vi->text[pos - 1]);
+          pos_type = vi_chartype(vi_textchar(vi, pos - 1));
 
           if (pos_type != srch_type && pos_type != VI_CHAR_CRLF)
             {
@@ -3145,14 +3606,14 @@ static off_t vi_findprevword(FAR struct vi_s *vi)
        * non-space character.
        */
 
-      pos_type = vi_chartype(vi->text[--pos]);
+      pos_type = vi_chartype(vi_textchar(vi, --pos));
     }
 
   /* If the previous char is space, then skip them */
 
   while ((pos_type == VI_CHAR_SPACE || pos_type == VI_CHAR_CRLF) && pos > 0)
     {
-      pos_type = vi_chartype(vi->text[--pos]);
+      pos_type = vi_chartype(vi_textchar(vi, --pos));
     }
 
   if (pos == 0)
@@ -3162,8 +3623,8 @@ static off_t vi_findprevword(FAR struct vi_s *vi)
 
   /* Now find beginning of this new type */
 
-  srch_type = vi_chartype(vi->text[pos]);
-  while (pos > 0 && vi_chartype(vi->text[pos - 1]) == srch_type)
+  srch_type = vi_chartype(vi_textchar(vi, pos));
+  while (pos > 0 && vi_chartype(vi_textchar(vi, pos - 1)) == srch_type)
     {
       pos--;
     }
@@ -3219,19 +3680,19 @@ static void vi_bottom_line_debug(FAR struct vi_s *vi)
 
   while (pos < vi->textsize && column < vi->display.column)
     {
-      if (vi->text[pos] == '\n')
+      if (vi_textchar(vi, pos) == '\n')
         {
           vi_putch(vi, '\\');
           vi_putch(vi, 'n');
         }
-      else if (vi->text[pos] == '\t')
+      else if (vi_textchar(vi, pos) == '\t')
         {
           vi_putch(vi, '\\');
           vi_putch(vi, 'n');
         }
       else
         {
-          vi_putch(vi, vi->text[pos]);
+          vi_putch(vi, vi_textchar(vi, pos));
         }
 
       pos++;
@@ -3555,8 +4016,8 @@ static void vi_cmd_mode(FAR struct vi_s *vi)
         case KEY_CMDMODE_RIGHT: /* Move the cursor right one character */
         case KEY_RIGHT:         /* Move the cursor right one character */
           {
-            if (vi->text[vi->curpos] != '\n' &&
-                vi->text[vi->curpos + 1] != '\n')
+            if (vi_textchar(vi, vi->curpos) != '\n' &&
+                vi_textchar(vi, vi->curpos + 1) != '\n')
               {
                 vi->curpos = vi_cursorright(vi, vi->curpos, vi->value);
                 if (vi->curpos >= vi->textsize)
@@ -3692,7 +4153,7 @@ static void vi_cmd_mode(FAR struct vi_s *vi)
 
                 /* If we moved to \n on the previous line, skip it */
 
-                if (vi->curpos > 0 && vi->text[vi->curpos] == '\n')
+                if (vi->curpos > 0 && vi_textchar(vi, vi->curpos) == '\n')
                   {
                     vi->curpos--;
                   }
@@ -3944,13 +4405,14 @@ static void vi_cmd_mode(FAR struct vi_s *vi)
 #endif
             /* If we are at the end of the line, then delete backward */
 
-            if (vi->text[pos] == '\n')
+            if (vi_textchar(vi, pos) == '\n')
               {
                 /* Nothing to do */
 
                 break;
               }
-            else if (pos + 1 != vi->textsize && vi->text[pos + 1] == '\n')
+            else if (pos + 1 != vi->textsize &&
+                     vi_textchar(vi, pos + 1) == '\n')
               {
                 if (pos > 0)
                   {
@@ -4642,7 +5104,7 @@ static bool vi_findstring(FAR struct vi_s *vi)
     {
       /* Check for the matching sub-string */
 
-      if (strncmp(vi->text + pos, vi->scratch, len) == 0)
+      if (vi_textmatch(vi, pos, vi->scratch, len))
         {
           /* Found it... save the cursor position and
            * return success.
@@ -4661,7 +5123,7 @@ static bool vi_findstring(FAR struct vi_s *vi)
     {
       /* Check for the matching sub-string */
 
-      if (strncmp(vi->text + pos, vi->scratch, len) == 0)
+      if (vi_textmatch(vi, pos, vi->scratch, len))
         {
           vi_write(vi, g_fmtsrcbot, sizeof(g_fmtsrcbot));
 
@@ -4712,7 +5174,7 @@ static bool vi_revfindstring(FAR struct vi_s *vi)
     {
       /* Check for the matching sub-string */
 
-      if (strncmp(vi->text + pos, vi->scratch, len) == 0)
+      if (vi_textmatch(vi, pos, vi->scratch, len))
         {
           /* Found it... save the cursor position and
            * return success.
@@ -4731,7 +5193,7 @@ static bool vi_revfindstring(FAR struct vi_s *vi)
     {
       /* Check for the matching sub-string */
 
-      if (strncmp(vi->text + pos, vi->scratch, len) == 0)
+      if (vi_textmatch(vi, pos, vi->scratch, len))
         {
           vi_write(vi, g_fmtsrctop, sizeof(g_fmtsrctop));
 
@@ -4895,7 +5357,7 @@ static void vi_replacech(FAR struct vi_s *vi, char ch)
 
   /* Is there a newline at the current cursor position? */
 
-  if (vi->text[vi->curpos] == '\n')
+  if (vi_textchar(vi, vi->curpos) == '\n')
     {
       /* Yes, then insert the new character before the newline */
 
@@ -4904,10 +5366,22 @@ static void vi_replacech(FAR struct vi_s *vi, char ch)
     }
   else
     {
-      /* No, just replace the character and increment the cursor position */
+      /* No, just replace the character and increment the cursor position.
+       * A newline splits the line, so the following lines move down.
+       */
 
-      vi->text[vi->curpos++] = ch;
-      vi->redrawline = true;
+      if (ch == '\n')
+        {
+          vi_trimindex(vi, vi->curpos);
+          vi->drawtoeos = true;
+        }
+      else
+        {
+          vi->redrawline = true;
+        }
+
+      *vi_textptr(vi, vi->curpos++) = ch;
+      vi_checkindex(vi);
     }
 }
 
@@ -5062,7 +5536,7 @@ static void vi_findinline_mode(FAR struct vi_s *vi)
   pos = vi->curpos + 1;
   count = vi->value > 0 ? vi->value : 1;
 
-  while (count > 0 && pos < vi->textsize - 1 && vi->text[pos] != '\n')
+  while (count > 0 && pos < vi->textsize - 1 && vi_textchar(vi, pos) != '\n')
     {
       /* Increment to next character */
 
@@ -5070,7 +5544,7 @@ static void vi_findinline_mode(FAR struct vi_s *vi)
 
       /* Test if this character matches */
 
-      if (vi->text[pos] == ch)
+      if (vi_textchar(vi, pos) == ch)
         {
           count--;
         }
@@ -5157,7 +5631,7 @@ static void vi_insertch(FAR struct vi_s *vi, char ch)
     {
       /* Add the new character to the buffer */
 
-      vi->text[vi->curpos++] = ch;
+      *vi_textptr(vi, vi->curpos++) = ch;
     }
 }
 
@@ -5257,7 +5731,7 @@ static void vi_insert_mode(FAR struct vi_s *vi)
 
           if (vi->cursor.column + 1 < vi->display.column && ch != '\t' &&
               (vi->curpos + 1 == vi->textsize ||
-               vi->text[vi->curpos + 1] == '\n'))
+               vi_textchar(vi, vi->curpos + 1) == '\n'))
             {
               vi_putch(vi, ch);
             }
@@ -5292,7 +5766,7 @@ static void vi_insert_mode(FAR struct vi_s *vi)
             {
               if (vi->curpos < vi->textsize)
                 {
-                  if (vi->text[vi->curpos] == '\n')
+                  if (vi_textchar(vi, vi->curpos) == '\n')
                     {
                       vi->drawtoeos = true;
                     }
@@ -5312,7 +5786,7 @@ static void vi_insert_mode(FAR struct vi_s *vi)
 
                   if (vi->curpos > 0)
                     {
-                      if (vi->text[vi->curpos - 1] == '\n')
+                      if (vi_textchar(vi, vi->curpos - 1) == '\n')
                         {
                           vi->drawtoeos = true;
                         }
@@ -5339,7 +5813,7 @@ static void vi_insert_mode(FAR struct vi_s *vi)
 
               /* Move cursor 1 space to the left when exiting insert mode */
 
-              if (vi->curpos > 0 && vi->text[vi->curpos - 1] != '\n')
+              if (vi->curpos > 0 && vi_textchar(vi, vi->curpos - 1) != '\n')
                 {
                   --vi->curpos;
                 }
@@ -5460,6 +5934,11 @@ static void vi_release(FAR struct vi_s *vi)
           free(vi->text);
         }
 
+      if (vi->lineidx)
+        {
+          free(vi->lineidx);
+        }
+
       if (vi->yank)
         {
           free(vi->yank);
@@ -5655,7 +6134,7 @@ int main(int argc, FAR char *argv[])
   if (vi->text == NULL)
     {
       vi_extendtext(vi, 0, TEXT_GULP_SIZE);
-      vi->textsize = 0;
+      vi_shrinktext(vi, 0, TEXT_GULP_SIZE);
       vi->modified = 0;
     }
 
@@ -332,6 +332,9 @@ static void show_usage(FAR const char *progname)
           "Threshold must be less than or equal buffersize, Default: 0kB\n");
   fprintf(stderr,
           "\t-k <size>: Use a custom size to tansfer, Default: 1kB\n");
+  fprintf(stderr,
+          "\t-g|--streaming: Request YMODEM-G streaming, data packets are"
+          " not acknowledged. Use on reliable links only\n");
 
   exit(EXIT_FAILURE);
 }
@@ -350,6 +353,7 @@ int main(int argc, FAR char *argv[])
   struct option options[] =
     {
       {"buffersize", 1, NULL, 'b'},
+      {"streaming", 0, NULL, 'g'},
       {"skip_prefix", 1, NULL, 'p'},
       {"skip_suffix", 1, NULL, 's'},
       {"threshold", 1, NULL, 't'}
@@ -357,7 +361,7 @@ int main(int argc, FAR char *argv[])
 
   memset(&priv, 0, sizeof(priv));
   memset(&ctx, 0, sizeof(ctx));
-  while ((ret = getopt_long(argc, argv, "b:d:f:hk:p:s:t:", options, NULL))
+  while ((ret = getopt_long(argc, argv, "b:d:f:ghk:p:s:t:", options, NULL))
          != ERROR)
     {
       switch (ret)
@@ -375,6 +379,9 @@ int main(int argc, FAR char *argv[])
                 priv.foldname[strlen(priv.foldname)] = '\0';
               }
 
+            break;
+          case 'g':
+            ctx.streaming = true;
             break;
           case 'h':
             show_usage(argv[0]);
@@ -35,6 +35,7 @@ ACK = b"\x06"  # Acknowledge
 NAK = b"\x15"  # Negative acknowledge
 CAN = b"\x18"  # Two of these in succession aborts transfer
 CRC = b"\x43"  # "C" == 0x43, request 16-bit CRC
+CRCG = b"\x47"  # "G" == 0x47, request YMODEM-G streaming
 
 PACKET_SIZE = 128
 PACKET_1K_SIZE = 1024
@@ -391,12 +392,14 @@ class ymodem:
         timeout=100,
         debug="",
         customsize=0,
+        streaming=False,
     ):
         self.read = read
         self.write = write
         self.timeout = timeout
         self.progress = progress
         self.customsize = customsize
+        self.streaming = streaming
         if debug != "":
             self.debugfd = open(debug, "w+")
         else:
@@ -453,6 +456,9 @@ class ymodem:
         chunk = self.read(1)
         if chunk == NAK:
             return -EAGAIN
+        if cmd == CRC and chunk == CRCG:
+            self.streaming = True
+            return 0
         if chunk != cmd:
             self.debug("should be " + binascii.hexlify(cmd).decode("utf-8"))
             self.debug("but receive " + binascii.hexlify(chunk).decode("utf-8") + "\n")
@@ -468,11 +474,15 @@ class ymodem:
         base = float(int(now.timestamp() * 1000)) / 1000
         totolbytes = 0
 
+        self.streaming = False
         while retries < 10:
             self.write(CRC)
             chunk = self.read(1)
             if chunk == CRC:
                 break
+            elif chunk == CRCG:
+                self.streaming = True
+                break
             else:
                 retries += 1
 
@@ -493,6 +503,10 @@ class ymodem:
             sendfilesize = 0
             self.progress(" filesize:%d\n" % (filesize))
             self.data = self.data + str(filesize).encode("utf-8")
+            if self.customsize != 0:
+                # After the NUL that ends the standard fields, where other
+                # receivers stop reading
+                self.data = self.data + (b"\x00%d" % self.customsize)
             self.data = self.data.ljust(self.get_pkt_size(), b"\x00")
             self.send_pkt()
 
@@ -526,6 +540,8 @@ class ymodem:
                 retry = 0
                 while retry < 10:
                     self.send_pkt()
+                    if self.streaming:
+                        break
                     ret = self.recv_cmd(ACK)
                     if ret < 0:
                         retry += 1
@@ -619,13 +635,15 @@ class ymodem:
             self.debug("recv EBADMSG" + str(chunk) + "\n")
             return -EINVAL
 
-        seq0 = self.read(1)
-        seq1 = self.read(1)
-
-        self.data = self.read(self.packetsize)
+        body = self.read(self.packetsize + 4)
+        if body is None or len(body) != self.packetsize + 4:
+            return -EINVAL
 
-        crch = self.read(1)
-        crcl = self.read(1)
+        seq0 = body[0:1]
+        seq1 = body[1:2]
+        self.data = body[2 : 2 + self.packetsize]
+        crch = body[2 + self.packetsize : 3 + self.packetsize]
+        crcl = body[3 + self.packetsize :]
 
         if seq0 != self.seq0:
             self.debug("recv bad seq0" + binascii.hexlify(seq0).decode("utf-8") + "\n")
@@ -660,7 +678,8 @@ class ymodem:
         now = datetime.datetime.now()
         base = float(int(now.timestamp() * 1000)) / 1000
         totolbytes = 0
-        self.write(CRC)
+        request = CRCG if self.streaming else CRC
+        self.write(request)
         while True:
             now = datetime.datetime.now()
             start = float(int(now.timestamp() * 1000)) / 1000
@@ -669,7 +688,7 @@ class ymodem:
 
             if ret == -EEOT:
                 self.write(ACK)
-                self.write(CRC)
+                self.write(request)
                 continue
 
             elif ret < 0:
@@ -687,18 +706,24 @@ class ymodem:
                 break
 
             self.progress("name:" + filename + " ")
-            size_str = bytes.decode(self.data.split(b"\x00")[1], "utf-8")
-            filesize = int(size_str)
+            fields = self.data.split(b"\x00")
+            filesize = int(bytes.decode(fields[1], "utf-8").split()[0])
+            if len(fields) > 2 and fields[2].isdigit() and int(fields[2]) != 0:
+                self.customsize = int(fields[2])
             self.progress("size:%d" % (filesize) + "\n")
 
             self.write(ACK)
-            self.write(CRC)
+            self.write(request)
             fd = open(filename, "wb+")
             writensize = 0
             while writensize < filesize:
                 ret = self.recv_packet()
                 if ret < 0:
                     self.debug("recv a bad data packet\n")
+                    if self.streaming:
+                        self.write(CAN + CAN)
+                        fd.close()
+                        return -1
                     if retries > RETRIESMAX:
                         return -1
                     retries += 1
@@ -707,7 +732,7 @@ class ymodem:
                 size = 0
                 if self.packetsize > filesize - writensize:
                     self.debug("last data packet\n")
-                    size = self.packetsize - (filesize - writensize)
+                    size = filesize - writensize
                 else:
                     size = self.packetsize
 
@@ -723,7 +748,8 @@ class ymodem:
                 left = (filesize - writensize) / 1024 / (realspeed)
                 self.progress(" left:" + format_time(left))
 
-                self.write(ACK)
+                if not self.streaming:
+                    self.write(ACK)
 
             now = datetime.datetime.now()
             time = float(now.timestamp() * 1000) / 1000
@@ -758,6 +784,13 @@ if __name__ == "__main__":
         default=0,
     )
 
+    parser.add_argument(
+        "-g",
+        "--streaming",
+        help="Use YMODEM-G streaming, data packets are not acknowledged",
+        action="store_true",
+    )
+
     parser.add_argument("-t", "--tty", default=None, help="Serial path")
 
     parser.add_argument(
@@ -808,22 +841,24 @@ if __name__ == "__main__":
             fd_serial.write(("sb %s\r\n" % (recvfile)).encode())
             tmp = fd_serial.read(len(("sb %s\r\n" % (recvfile)).encode()))
         else:
-            if args.sendto:
-                fd_serial.write("rb\r\n".encode())
-                fd_serial.read(len("rb\r\n".encode()))
-            else:
-                fd_serial.write(("rb\r\n").encode())
-                fd_serial.read(len(("rb\r\n").encode()))
+            cmd = "rb -g\r\n" if args.streaming else "rb\r\n"
+            fd_serial.write(cmd.encode())
+            fd_serial.read(len(cmd.encode()))
 
             fd_serial.reset_input_buffer()
         sbrb = ymodem(
             debug=args.debug,
             customsize=args.kblocksize * 1024,
+            streaming=args.streaming,
             read=ymodem_ser_read,
             write=ymodem_ser_write,
         )
     else:
-        sbrb = ymodem(debug=args.debug, customsize=args.kblocksize * 1024)
+        sbrb = ymodem(
+            debug=args.debug,
+            customsize=args.kblocksize * 1024,
+            streaming=args.streaming,
+        )
 
     if len(args.filelist) == 0:
         sbrb.progress("receiving\n")
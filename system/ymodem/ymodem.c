@@ -22,9 +22,11 @@
  * Included Files
  ****************************************************************************/
 
+#include <ctype.h>
 #include <errno.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -59,13 +61,62 @@
 #define NAK           0x15  /* Negative acknowledge */
 #define CAN           0x18  /* Two of these in succession aborts transfer */
 #define CRC           0x43  /* 'C' == 0x43, request 16-bit CRC */
+#define CRCG          0x47  /* 'G' == 0x47, request 16-bit CRC, streaming */
 
 #define MAX_RETRIES   100
 
+#ifndef CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE
+#  define CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE 1024
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+static int ymodem_recv_fill(FAR struct ymodem_ctx_s *ctx, size_t size)
+{
+  /* Make sure that at least size bytes are buffered, taking as many bytes
+   * per read() as the device has ready.
+   */
+
+  if (ctx->rxhead == ctx->rxtail)
+    {
+      ctx->rxhead = 0;
+      ctx->rxtail = 0;
+    }
+  else if (ctx->rxtail - ctx->rxhead < size &&
+           ctx->rxhead + size > CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE)
+    {
+      memmove(ctx->rxbuf, ctx->rxbuf + ctx->rxhead,
+              ctx->rxtail - ctx->rxhead);
+      ctx->rxtail -= ctx->rxhead;
+      ctx->rxhead = 0;
+    }
+
+  while (ctx->rxtail - ctx->rxhead < size)
+    {
+      ssize_t ret = read(ctx->recvfd, ctx->rxbuf + ctx->rxtail,
+                         CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE - ctx->rxtail);
+      if (ret > 0)
+        {
+          ymodem_debug("recv buffer data, size %zd\n", ret);
+          ctx->rxtail += ret;
+        }
+      else if (ret == 0)
+        {
+          ymodem_debug("recv buffer timeout\n");
+          return -ETIMEDOUT;
+        }
+      else
+        {
+          ymodem_debug("recv buffer error, ret %d\n", -errno);
+          return -errno;
+        }
+    }
+
+  return 0;
+}
+
 static int ymodem_recv_buffer(FAR struct ymodem_ctx_s *ctx, FAR uint8_t *buf,
                               size_t size)
 {
@@ -74,22 +125,62 @@ static int ymodem_recv_buffer(FAR struct ymodem_ctx_s *ctx, FAR uint8_t *buf,
   ymodem_debug("recv buffer data, read size is %zu\n", size);
   while (i < size)
     {
-      ssize_t ret = read(ctx->recvfd, buf + i, size - i);
-      if (ret >= 0)
+      size_t n = ctx->rxtail - ctx->rxhead;
+
+      if (n > 0)
         {
-          ymodem_debug("recv buffer data, size %zd\n", ret);
-          i += ret;
+          /* Consume the buffered data first */
+
+          if (n > size - i)
+            {
+              n = size - i;
+            }
+
+          memcpy(buf + i, ctx->rxbuf + ctx->rxhead, n);
+          ctx->rxhead += n;
+          i += n;
+        }
+      else if (size - i >= CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE)
+        {
+          /* Large remainders are read directly into the caller's buffer */
+
+          ssize_t ret = read(ctx->recvfd, buf + i, size - i);
+          if (ret > 0)
+            {
+              ymodem_debug("recv buffer data, size %zd\n", ret);
+              i += ret;
+            }
+          else if (ret == 0)
+            {
+              ymodem_debug("recv buffer timeout\n");
+              return -ETIMEDOUT;
+            }
+          else
+            {
+              ymodem_debug("recv buffer error, ret %d\n", -errno);
+              return -errno;
+            }
         }
       else
         {
-          ymodem_debug("recv buffer error, ret %d\n", -errno);
-          return -errno;
+          int ret = ymodem_recv_fill(ctx, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
         }
     }
 
   return 0;
 }
 
+static void ymodem_recv_flush(FAR struct ymodem_ctx_s *ctx)
+{
+  tcflush(ctx->recvfd, TCIOFLUSH);
+  ctx->rxhead = 0;
+  ctx->rxtail = 0;
+}
+
 static int ymodem_send_buffer(FAR struct ymodem_ctx_s *ctx,
                               FAR const uint8_t *buf, size_t size)
 {
@@ -98,7 +189,7 @@ static int ymodem_send_buffer(FAR struct ymodem_ctx_s *ctx,
   ymodem_debug("send buffer data, write size is %zu\n", size);
   while (i < size)
     {
-      ssize_t ret = write(ctx->sendfd, buf, size);
+      ssize_t ret = write(ctx->sendfd, buf + i, size - i);
       if (ret >= 0)
         {
           ymodem_debug("send buffer data, size %zd\n", ret);
@@ -114,63 +205,127 @@ static int ymodem_send_buffer(FAR struct ymodem_ctx_s *ctx,
   return 0;
 }
 
+static int ymodem_set_custom_size(FAR struct ymodem_ctx_s *ctx,
+                                  size_t size)
+{
+  FAR uint8_t *header;
+
+  if (size == 0 || size > YMODEM_PACKET_MAX_SIZE)
+    {
+      return -EINVAL;
+    }
+
+  if (3 + size + 2 > ctx->header_size)
+    {
+      header = realloc(ctx->header, 3 + size + 2);
+      if (header == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      ctx->header = header;
+      ctx->data = header + 3;
+      ctx->header_size = 3 + size + 2;
+    }
+
+  ctx->custom_size = size;
+  return 0;
+}
+
 static int ymodem_recv_packet(FAR struct ymodem_ctx_s *ctx)
 {
+  FAR const uint8_t *hdr;
+  size_t skipped = 0;
   uint16_t recv_crc;
   uint16_t cal_crc;
   int ret;
 
-  ret = ymodem_recv_buffer(ctx, ctx->header, 1);
-  if (ret < 0)
+  /* Scan the received data for a packet header.  Line noise and the rest
+   * of a damaged packet are skipped without another round trip, until a
+   * start byte followed by a valid sequence number pair is found.
+   */
+
+  for (; ; )
     {
-      return ret;
-    }
+      ret = ymodem_recv_fill(ctx, 1);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      hdr = ctx->rxbuf + ctx->rxhead;
+      switch (hdr[0])
+        {
+          case SOH:
+            ctx->packet_size = YMODEM_PACKET_SIZE;
+            break;
+          case STX:
+            ctx->packet_size = YMODEM_PACKET_1K_SIZE;
+            break;
+          case STC:
+            ctx->packet_size = ctx->custom_size;
+            break;
+          case EOT:
+            ctx->rxhead++;
+            return -EAGAIN;
+          case CAN:
+            ret = ymodem_recv_fill(ctx, 2);
+            if (ret < 0)
+              {
+                return ret;
+              }
+
+            hdr = ctx->rxbuf + ctx->rxhead;
+            if (hdr[1] == CAN)
+              {
+                ctx->rxhead += 2;
+                return -ECANCELED;
+              }
+
+            /* A single CAN is line noise, skip it like any other byte */
+
+            /* Fall through */
+
+          default:
+            ctx->packet_size = 0;
+            break;
+        }
 
-  switch (ctx->header[0])
-    {
-      case SOH:
-        ctx->packet_size = YMODEM_PACKET_SIZE;
-        break;
-      case STX:
-        ctx->packet_size = YMODEM_PACKET_1K_SIZE;
-        break;
-      case STC:
-        ctx->packet_size = ctx->custom_size;
-        break;
-      case EOT:
-        return -EAGAIN;
-      case CAN:
-        ret = ymodem_recv_buffer(ctx, ctx->header, 1);
-        if (ret < 0)
-          {
-            return ret;
-          }
-        else if (ctx->header[0] == CAN)
-          {
-            return -ECANCELED;
-          }
-
-      default:
-          ymodem_debug("recv_packet: EBADMSG: header[0]=0x%x\n",
-                       ctx->header[0]);
+      if (ctx->packet_size != 0)
+        {
+          ret = ymodem_recv_fill(ctx, 3);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          hdr = ctx->rxbuf + ctx->rxhead;
+          if (hdr[1] + hdr[2] == 0xff)
+            {
+              break;
+            }
+
+          ymodem_debug("recv_packet: EILSEQ seq[]=%d %d\n",
+                       hdr[1], hdr[2]);
+        }
+
+      ctx->rxhead++;
+      if (++skipped >= ctx->header_size)
+        {
+          ymodem_debug("recv_packet: EBADMSG: header[0]=0x%x\n", hdr[0]);
           return -EBADMSG;
+        }
     }
 
-  ret = ymodem_recv_buffer(ctx, &ctx->header[1],
-                           2 + ctx->packet_size + 2);
+  memcpy(ctx->header, hdr, 3);
+  ctx->rxhead += 3;
+  ret = ymodem_recv_buffer(ctx, ctx->data, ctx->packet_size + 2);
   if (ret < 0)
     {
       ymodem_debug("recv_packet: err=%d\n", ret);
       return ret;
     }
 
-  if ((ctx->header[1] + ctx->header[2]) != 0xff)
-    {
-      ymodem_debug("recv_packet: EILSEQ seq[]=%d %d\n",
-                   ctx->header[1], ctx->header[2]);
-      return -EILSEQ;
-    }
-
   recv_crc = (ctx->data[ctx->packet_size] << 8) +
               ctx->data[ctx->packet_size + 1];
   cal_crc = crc16(ctx->data, ctx->packet_size);
@@ -190,12 +345,15 @@ static int ymodem_recv_file(FAR struct ymodem_ctx_s *ctx)
 {
   FAR char *str = NULL;
   uint32_t total_seq = 0;
+  uint8_t request = ctx->streaming ? CRCG : CRC;
+  size_t custom_size;
   int retries = 0;
   int ret;
 
-  ctx->header[0] = CRC;
+  ctx->header[0] = request;
 recv_packet:
   ymodem_send_buffer(ctx, ctx->header, 1);
+recv_stream:
   ret = ymodem_recv_packet(ctx);
   if (ret == -ECANCELED)
     {
@@ -207,7 +365,7 @@ recv_packet:
       ctx->header[0] = ACK;
       ymodem_send_buffer(ctx, ctx->header, 1);
       ymodem_debug("recv_file: finished one file transfer\n");
-      ctx->header[0] = CRC;
+      ctx->header[0] = request;
       total_seq = 0;
       goto recv_packet;
     }
@@ -215,7 +373,15 @@ recv_packet:
     {
       /* other errors, like ETIMEDOUT, EILSEQ, EBADMSG... */
 
-      tcflush(ctx->recvfd, TCIOFLUSH);
+      if (ctx->streaming && total_seq > 0)
+        {
+          /* YMODEM-G has no way to request a packet again */
+
+          ymodem_debug("recv_file: error while streaming, cancel!!\n");
+          goto cancel;
+        }
+
+      ymodem_recv_flush(ctx);
       if (++retries > MAX_RETRIES)
         {
           ymodem_debug("recv_file: too many errors, cancel!!\n");
@@ -224,10 +390,19 @@ recv_packet:
 
       /* Use str to mask transfer start */
 
-      ctx->header[0] = str ? NAK : CRC;
+      ctx->header[0] = str ? NAK : request;
       goto recv_packet;
     }
 
+  if (ctx->streaming && total_seq > 0 &&
+      (total_seq & 0xff) != ctx->header[1])
+    {
+      ymodem_debug("recv_file: seq error while streaming:%" PRIu32 " %u\n",
+                   total_seq, ctx->header[1]);
+      ret = -EILSEQ;
+      goto cancel;
+    }
+
   if ((total_seq & 0xff) - 1 == ctx->header[1])
     {
       ymodem_debug("recv_file: Received the previous packet that has"
@@ -241,7 +416,7 @@ recv_packet:
     {
       ymodem_debug("recv_file: total seq error:%" PRIu32 " %u\n", total_seq,
                    ctx->header[1]);
-      ctx->header[0] = CRC;
+      ctx->header[0] = request;
       goto recv_packet;
     }
 
@@ -265,7 +440,30 @@ recv_packet:
       ctx->packet_type = YMODEM_FILENAME_PACKET;
       strlcpy(ctx->file_name, str, PATH_MAX);
       str += strlen(str) + 1;
-      ctx->file_length = atoi(str);
+      ctx->file_length = strtoul(str, &str, 10);
+
+      /* The size of the STC packets the sender is going to use follows the
+       * NUL that ends the length and the optional standard fields, where
+       * other receivers stop reading.
+       */
+
+      str += strnlen(str, (FAR char *)ctx->data + ctx->packet_size - str);
+      if (str + 1 < (FAR char *)ctx->data + ctx->packet_size &&
+          isdigit((unsigned char)str[1]))
+        {
+          custom_size = strtoul(str + 1, NULL, 10);
+          if (custom_size != 0)
+            {
+              ret = ymodem_set_custom_size(ctx, custom_size);
+              if (ret < 0)
+                {
+                  ymodem_debug("recv_file: bad packet size %zu\n",
+                               custom_size);
+                  goto cancel;
+                }
+            }
+        }
+
       ymodem_debug("recv_file: new file %s(%zu) start\n", ctx->file_name,
                    ctx->file_length);
       ret = ctx->packet_handler(ctx);
@@ -278,7 +476,7 @@ recv_packet:
 
       ctx->header[0] = ACK;
       ymodem_send_buffer(ctx, ctx->header, 1);
-      ctx->header[0] = CRC;
+      ctx->header[0] = request;
       total_seq++;
       goto recv_packet;
     }
@@ -293,10 +491,15 @@ recv_packet:
       goto cancel;
     }
 
-  ctx->header[0] = ACK;
   total_seq++;
   ymodem_debug("recv_file: recv data success\n");
   retries = 0;
+  if (ctx->streaming)
+    {
+      goto recv_stream;
+    }
+
+  ctx->header[0] = ACK;
   goto recv_packet;
 
 cancel:
@@ -309,30 +512,72 @@ cancel:
 
 static int ymodem_recv_cmd(FAR struct ymodem_ctx_s *ctx, uint8_t cmd)
 {
+  uint8_t recv;
   int ret;
 
-  ret = ymodem_recv_buffer(ctx, ctx->header, 1);
+  /* Don't receive into ctx->header, it holds the packet to send again */
+
+  ret = ymodem_recv_buffer(ctx, &recv, 1);
   if (ret < 0)
     {
       ymodem_debug("recv cmd error\n");
       return ret;
     }
 
-  if (ctx->header[0] == NAK)
+  if (recv == NAK)
     {
       return -EAGAIN;
     }
 
-  if (ctx->header[0] != cmd)
+  /* A receiver requests YMODEM-G streaming with 'G' instead of 'C' */
+
+  if (cmd == CRC && recv == CRCG)
+    {
+      ctx->streaming = true;
+      return 0;
+    }
+
+  if (recv != cmd)
     {
       ymodem_debug("recv cmd error, must 0x%x, but receive 0x%x\n",
-                   cmd, ctx->header[0]);
+                   cmd, recv);
       return -EINVAL;
     }
 
   return 0;
 }
 
+static int ymodem_recv_cancel(FAR struct ymodem_ctx_s *ctx)
+{
+  struct pollfd fds;
+  uint8_t recv;
+  int ret;
+
+  /* While streaming, the only thing the receiver may send is CAN */
+
+  fds.fd = ctx->recvfd;
+  fds.events = POLLIN;
+  fds.revents = 0;
+  if (ctx->rxhead == ctx->rxtail && poll(&fds, 1, 0) <= 0)
+    {
+      return 0;
+    }
+
+  ret = ymodem_recv_buffer(ctx, &recv, 1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (recv == CAN)
+    {
+      ymodem_debug("recv CAN while streaming\n");
+      return -ECANCELED;
+    }
+
+  return 0;
+}
+
 static int ymodem_send_file(FAR struct ymodem_ctx_s *ctx)
 {
   uint16_t crc;
@@ -340,6 +585,7 @@ static int ymodem_send_file(FAR struct ymodem_ctx_s *ctx)
   int ret;
 
   ymodem_debug("waiting handshake\n");
+  ctx->streaming = false;
   for (retries = 0; retries < MAX_RETRIES; retries++)
     {
       ret = ymodem_recv_cmd(ctx, CRC);
@@ -366,8 +612,28 @@ send_start:
 
   ymodem_debug("sendfile filename:%s filelength:%zu\n",
                ctx->file_name, ctx->file_length);
-  sprintf((FAR char *)ctx->data, "%s%c%zu", ctx->file_name,
-          '\0', ctx->file_length);
+
+  /* The rest of the filename packet must be NUL, stale data of the last
+   * file would be read as the STC packet size.
+   */
+
+  memset(ctx->data, 0, YMODEM_PACKET_SIZE);
+  if (ctx->custom_size != 0)
+    {
+      /* Tell the receiver the size of STC packets after the NUL that ends
+       * the standard fields.  Other receivers (lrzsz) read the fields
+       * after the length as files and bytes left and ignore the rest.
+       */
+
+      sprintf((FAR char *)ctx->data, "%s%c%zu%c%zu", ctx->file_name,
+              '\0', ctx->file_length, '\0', ctx->custom_size);
+    }
+  else
+    {
+      sprintf((FAR char *)ctx->data, "%s%c%zu", ctx->file_name,
+              '\0', ctx->file_length);
+    }
+
   ctx->header[0] = SOH;
   ctx->header[1] = 0x00;
   ctx->header[2] = 0xff;
@@ -448,11 +714,20 @@ send_packet_again:
       return ret;
     }
 
-  ret = ymodem_recv_cmd(ctx, ACK);
-  if (ret == -EAGAIN)
+  if (ctx->streaming)
     {
-      ymodem_debug("send data packet recv NAK, need send again\n");
-      goto send_packet_again;
+      /* YMODEM-G: data packets are not acknowledged */
+
+      ret = ymodem_recv_cancel(ctx);
+    }
+  else
+    {
+      ret = ymodem_recv_cmd(ctx, ACK);
+      if (ret == -EAGAIN)
+        {
+          ymodem_debug("send data packet recv NAK, need send again\n");
+          goto send_packet_again;
+        }
     }
 
   if (ret < 0)
@@ -538,6 +813,39 @@ send_last_again:
   return 0;
 }
 
+static int ymodem_alloc(FAR struct ymodem_ctx_s *ctx)
+{
+  ctx->header_size = 3 + YMODEM_PACKET_1K_SIZE + 2;
+  if (ctx->custom_size > YMODEM_PACKET_1K_SIZE)
+    {
+      ctx->header_size = 3 + ctx->custom_size + 2;
+    }
+
+  ctx->header = calloc(1, ctx->header_size);
+  if (ctx->header == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ctx->rxbuf = malloc(CONFIG_SYSTEM_YMODEM_RECV_BUFFERSIZE);
+  if (ctx->rxbuf == NULL)
+    {
+      free(ctx->header);
+      return -ENOMEM;
+    }
+
+  ctx->data = ctx->header + 3;
+  ctx->rxhead = 0;
+  ctx->rxtail = 0;
+  return 0;
+}
+
+static void ymodem_free(FAR struct ymodem_ctx_s *ctx)
+{
+  free(ctx->rxbuf);
+  free(ctx->header);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -553,27 +861,18 @@ int ymodem_recv(FAR struct ymodem_ctx_s *ctx)
       return -EINVAL;
     }
 
-  if (ctx->custom_size != 0)
-    {
-      ctx->header = calloc(1, 3 + ctx->custom_size + 2);
-    }
-  else
-    {
-      ctx->header = calloc(1, 3 + YMODEM_PACKET_1K_SIZE + 2);
-    }
-
-  if (ctx->header == NULL)
+  ret = ymodem_alloc(ctx);
+  if (ret < 0)
     {
-      return -ENOMEM;
+      return ret;
     }
 
-  ctx->data = ctx->header + 3;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   ctx->debug_fd = open(CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH,
                        O_CREAT | O_TRUNC | O_WRONLY, 0666);
   if (ctx->debug_fd < 0)
     {
-      free(ctx->header);
+      ymodem_free(ctx);
       return -errno;
     }
 #endif
@@ -581,8 +880,11 @@ int ymodem_recv(FAR struct ymodem_ctx_s *ctx)
   tcgetattr(ctx->recvfd, &term);
   memcpy(&saveterm, &term, sizeof(struct termios));
   cfmakeraw(&term);
+
+  /* Return whatever has arrived, or nothing after 1.5s of silence */
+
   term.c_cc[VTIME] = 15;
-  term.c_cc[VMIN] = 255;
+  term.c_cc[VMIN] = 0;
   tcsetattr(ctx->recvfd, TCSANOW, &term);
 
   ret = ymodem_recv_file(ctx);
@@ -592,7 +894,7 @@ int ymodem_recv(FAR struct ymodem_ctx_s *ctx)
   close(ctx->debug_fd);
 #endif
 
-  free(ctx->header);
+  ymodem_free(ctx);
   return ret;
 }
 
@@ -607,27 +909,18 @@ int ymodem_send(FAR struct ymodem_ctx_s *ctx)
       return -EINVAL;
     }
 
-  if (ctx->custom_size != 0)
-    {
-      ctx->header = calloc(1, 3 + ctx->custom_size + 2);
-    }
-  else
-    {
-      ctx->header = calloc(1, 3 + YMODEM_PACKET_1K_SIZE + 2);
-    }
-
-  if (ctx->header == NULL)
+  ret = ymodem_alloc(ctx);
+  if (ret < 0)
     {
-      return -ENOMEM;
+      return ret;
     }
 
-  ctx->data = ctx->header + 3;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   ctx->debug_fd = open(CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH,
                        O_CREAT | O_TRUNC | O_WRONLY, 0666);
   if (ctx->debug_fd < 0)
     {
-      free(ctx->header);
+      ymodem_free(ctx);
       return -errno;
     }
 #endif
@@ -648,6 +941,6 @@ int ymodem_send(FAR struct ymodem_ctx_s *ctx)
   close(ctx->debug_fd);
 #endif
 
-  free(ctx->header);
+  ymodem_free(ctx);
   return ret;
 }
@@ -25,6 +25,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /****************************************************************************
@@ -33,6 +34,7 @@
 
 #define YMODEM_PACKET_SIZE               128
 #define YMODEM_PACKET_1K_SIZE            1024
+#define YMODEM_PACKET_MAX_SIZE           (64 * 1024)
 
 #define YMODEM_FILENAME_PACKET           0
 #define YMODEM_DATA_PACKET               1
@@ -51,6 +53,12 @@ struct ymodem_ctx_s
   size_t custom_size;
   FAR void *priv;
 
+  /* Receiver: request YMODEM-G streaming.
+   * Sender: set if the receiver requested YMODEM-G streaming.
+   */
+
+  bool streaming;
+
   /* Public data */
 
   FAR uint8_t *data;
@@ -62,6 +70,10 @@ struct ymodem_ctx_s
   /* Private data */
 
   FAR uint8_t *header;
+  size_t header_size;
+  FAR uint8_t *rxbuf;
+  size_t rxhead;
+  size_t rxtail;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   int debug_fd;
 #endif
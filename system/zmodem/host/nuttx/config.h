@@ -48,8 +48,11 @@
 #define CONFIG_SYSTEM_ZMODEM_RCVBUFSIZE 512
 #define CONFIG_SYSTEM_ZMODEM_PKTBUFSIZE 1024
 #define CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE 512
+#undef  CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+#define CONFIG_SYSTEM_ZMODEM_SNDWINDOW 16384
 #define CONFIG_SYSTEM_ZMODEM_MOUNTPOINT "/tmp"
 #undef  CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
+#undef  CONFIG_SYSTEM_ZMODEM_RCVSTREAM
 #undef  CONFIG_SYSTEM_ZMODEM_SENDATTN
 #define CONFIG_SYSTEM_ZMODEM_ALWAYSSINT 1
 #undef  CONFIG_SYSTEM_ZMODEM_SENDBRAK
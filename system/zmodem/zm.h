@@ -33,10 +33,15 @@
 #include <nuttx/config.h>
 #include <sys/types.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <debug.h>
 #include <syslog.h>
 
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+#  include <pthread.h>
+#endif
+
 #include <nuttx/compiler.h>
 #include <nuttx/ascii.h>
 
@@ -193,6 +198,8 @@
 #define ZM_FLAG_APPEND    (1 << 7)   /* Append to the existing file */
 #define ZM_FLAG_TIMEOUT   (1 << 8)   /* A timeout has been detected */
 #define ZM_FLAG_OO        (1 << 9)   /* "OO" may be received */
+#define ZM_FLAG_STREAM    (1 << 10)  /* Streaming paused to parse input */
+#define ZM_FLAG_RPOSDUP   (1 << 11)  /* Ignored a repeated ZRPOS */
 
 /* The Zmodem parser success/error return code definitions:
  *
@@ -380,6 +387,30 @@ struct zmr_state_s
   int outfd;                 /* Local output file descriptor */
 };
 
+/* File data read ahead by the sender's reader thread.  buffer[head] is
+ * consumed by the Zmodem state machine while buffer[tail] is filled by the
+ * reader thread.  A buffer belongs to the state machine while full[] is set
+ * and to the reader thread otherwise.
+ */
+
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+struct zms_reader_s
+{
+  pthread_t thread;          /* The reader thread */
+  pthread_mutex_t lock;      /* Protects all fields below */
+  pthread_cond_t cond;       /* Signals changes of full[] and stop */
+  off_t rdoffs;              /* File offset of the next read */
+  uint32_t seq;              /* Incremented when the file is repositioned */
+  uint16_t rdndx;            /* Next byte to consume in buffer[head] */
+  uint8_t head;              /* Buffer being consumed */
+  uint8_t tail;              /* Buffer being filled */
+  bool stop;                 /* Reader thread should terminate */
+  bool full[2];              /* Buffer holds data (or read status) */
+  ssize_t nbytes[2];         /* Bytes in buffer; <= 0: EOF or -errno */
+  uint8_t buffer[2][CONFIG_SYSTEM_ZMODEM_SNDREADSIZE];
+};
+#endif
+
 /* Send state information */
 
 struct zms_state_s
@@ -406,6 +437,19 @@ struct zms_state_s
   off_t zrpos;               /* Last offset from ZRPOS */
   off_t filesize;            /* Size of the file to send */
   int infd;                  /* Local input file descriptor */
+  bool crcvalid;             /* filecrc holds the CRC of the whole file */
+  uint32_t filecrc;          /* Cached file CRC returned by ZCRC */
+  bool inframe;              /* Receiver left in data mode by ZCRCG/ZCRCQ */
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  bool rdstarted;            /* The reader thread is running */
+  struct zms_reader_s rd;    /* Double buffered file read ahead */
+#else
+  uint16_t fbndx;            /* Next byte to send from the file buffer */
+  uint16_t fblen;            /* Number of valid bytes in the file buffer */
+#  ifndef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
+  uint8_t fbyte;             /* Single byte file buffer */
+#  endif
+#endif
 };
 
 /****************************************************************************
@@ -745,7 +789,8 @@ int zm_timeout(FAR struct zm_state_s *pzm);
  * Description:
  *   Return true if data from the remote receiver is pending.  In that case,
  *   the local sender should stop data streaming operations and process the
- *   incoming data.
+ *   incoming data.  The reverse channel is sampled with a zero timeout
+ *   poll().
  *
  ****************************************************************************/
 
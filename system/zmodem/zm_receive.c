@@ -317,8 +317,15 @@ static int zmr_zrinit(FAR struct zm_state_s *pzm)
   /* Send ZRINIT */
 
   pzm->timeout = CONFIG_SYSTEM_ZMODEM_RESPTIME;
+#ifdef CONFIG_SYSTEM_ZMODEM_RCVSTREAM
+  /* A buffer length of zero lets the sender stream without waiting */
+
+  buf[0]       = 0;
+  buf[1]       = 0;
+#else
   buf[0]       = CONFIG_SYSTEM_ZMODEM_PKTBUFSIZE & 0xff;
   buf[1]       = (CONFIG_SYSTEM_ZMODEM_PKTBUFSIZE >> 8) & 0xff;
+#endif
   buf[2]       = 0;
   buf[3]       = pzmr->rcaps;
   return zm_sendhexhdr(pzm, ZRINIT, buf);
@@ -1619,7 +1626,11 @@ ZMRHANDLE zmr_initialize(int remfd)
       pzm->pstate    = PSTATE_IDLE;
       pzm->psubstate = PIDLE_ZPAD;
       pzm->remfd     = remfd;
+#ifdef CONFIG_SYSTEM_ZMODEM_RCVSTREAM
+      pzmr->rcaps    = CANFC32 | CANFDX | CANOVIO;
+#else
       pzmr->rcaps    = CANFC32 | CANFDX;
+#endif
       pzmr->outfd    = -1;
 
       /* Create a timer to handle timeout events */
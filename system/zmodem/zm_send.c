@@ -46,6 +46,10 @@
 #include <assert.h>
 #include <errno.h>
 
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+#  include <pthread.h>
+#endif
+
 #include <nuttx/crc16.h>
 #include <nuttx/crc32.h>
 #include <nuttx/ascii.h>
@@ -58,6 +62,31 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* While streaming, every subpacket that crosses a multiple of
+ * ZMS_ACKINTERVAL bytes is sent as ZCRCQ so that ZACKs keep coming back
+ * before the send window is exhausted.
+ */
+
+#define ZMS_ACKINTERVAL (CONFIG_SYSTEM_ZMODEM_SNDWINDOW / 4)
+
+/* Room reserved in the transmit buffer for one escaped data byte, ZDLE, the
+ * packet type and an escaped 4-byte CRC.
+ */
+
+#define ZMS_PKTRESERVE  12
+
+/* File buffer used when the file is read synchronously */
+
+#ifndef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+#  ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
+#    define ZMS_FILEBUF(p)  ((p)->cmn.filebuf)
+#    define ZMS_FILEBUFSIZE CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE
+#  else
+#    define ZMS_FILEBUF(p)  (&(p)->fbyte)
+#    define ZMS_FILEBUFSIZE 1
+#  endif
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -135,6 +164,7 @@ static int zms_endoftransfer(FAR struct zm_state_s *pzm);
 static int zms_fileskip(FAR struct zm_state_s *pzm);
 static int zms_sendfiledata(FAR struct zm_state_s *pzm);
 static int zms_sendpacket(FAR struct zm_state_s *pzm);
+static int zms_sendack(FAR struct zm_state_s *pzm);
 static int zms_filecrc(FAR struct zm_state_s *pzm);
 static int zms_sendwaitack(FAR struct zm_state_s *pzm);
 static int zms_sendnak(FAR struct zm_state_s *pzm);
@@ -144,12 +174,24 @@ static int zms_resendeof(FAR struct zm_state_s *pzm);
 static int zms_xfrdone(FAR struct zm_state_s *pzm);
 static int zms_finish(FAR struct zm_state_s *pzm);
 static int zms_timeout(FAR struct zm_state_s *pzm);
+static int zms_sendwaitto(FAR struct zm_state_s *pzm);
 static int zms_cmdto(FAR struct zm_state_s *pzm);
 static int zms_doneto(FAR struct zm_state_s *pzm);
 static int zms_error(FAR struct zm_state_s *pzm);
 
 /* Internal helpers */
 
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+static FAR void *zms_reader(FAR void *arg);
+#endif
+static int zms_fileopen(FAR struct zms_state_s *pzms,
+                        FAR const char *filename);
+static int zms_fileseek(FAR struct zms_state_s *pzms, off_t offset);
+static ssize_t zms_fileget(FAR struct zms_state_s *pzms,
+                           FAR const uint8_t **data);
+static void zms_fileconsume(FAR struct zms_state_s *pzms, size_t nbytes);
+static void zms_fileclose(FAR struct zms_state_s *pzms);
+static int zms_endframe(FAR struct zms_state_s *pzms);
 static int zms_startfiledata(FAR struct zms_state_s *pzms);
 static int zms_sendfile(FAR struct zms_state_s *pzms,
                         FAR const char *filename,
@@ -249,7 +291,7 @@ static const struct zm_transition_s g_zms_crcwait[] =
 static const struct zm_transition_s g_zmr_sending[] =
 {
   {ZME_SINIT,     false, ZMS_START,    zms_attention},
-  {ZME_ACK,       false, ZMS_SENDING,  zms_sendpacket},
+  {ZME_ACK,       false, ZMS_SENDING,  zms_sendack},
   {ZME_RPOS,      true,  ZMS_SENDING,  zms_sendrpos},
   {ZME_SKIP,      true,  ZMS_FILEWAIT, zms_fileskip},
   {ZME_NAK,       true,  ZMS_SENDING,  zms_sendnak},
@@ -272,7 +314,7 @@ static const struct zm_transition_s g_zms_sendwait[] =
   {ZME_RINIT,     true,  ZMS_FILEWAIT, zms_sendfilename},
   {ZME_ABORT,     true,  ZMS_FINISH,   zms_abort},
   {ZME_FERR,      true,  ZMS_FINISH,   zms_abort},
-  {ZME_TIMEOUT,   false, ZMS_SENDWAIT, zms_timeout},
+  {ZME_TIMEOUT,   false, ZMS_SENDWAIT, zms_sendwaitto},
   {ZME_ERROR,     false, ZMS_SENDWAIT, zms_error},
 };
 
@@ -438,37 +480,25 @@ static int zms_zrinit(FAR struct zm_state_s *pzm)
    *    follow immediately."
    *
    *
-   * In order to support ZCRCG, this logic must be able to sample the
-   * reverse channel while streaming to determine if the receiving wants
-   * interrupt the transfer (CONFIG_SYSTEM_ZMODEM_RCVSAMPLE).
-   *
    * ZCRCQ
    *   "ZCRCQ data subpackets expect a ZACK response with the
    *    receiver's file offset if no error, otherwise a ZRPOS response
    *    with the last good file offset.  Another data subpacket
    *    continues immediately.  ZCRCQ subpackets are not used if the
    *    receiver does not indicate FDX ability with the CANFDX bit.
+   *
+   * When streaming, ZCRCG subpackets are sent with a ZCRCQ every
+   * ZMS_ACKINTERVAL bytes.  No more than CONFIG_SYSTEM_ZMODEM_SNDWINDOW
+   * bytes are left unacknowledged, so an error reported by the receiver is
+   * noticed within one window even if the reverse channel is not sampled
+   * while streaming (CONFIG_SYSTEM_ZMODEM_RCVSAMPLE).
    */
 
-#ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
-  /* We support CANFDX.  We can do ZCRCG if the remote sender does too */
-
   if ((rcaps & (CANFDX | CANOVIO)) ==
       (CANFDX | CANOVIO) && pzms->rcvmax == 0)
     {
       pzms->dpkttype = ZCRCG;
     }
-#else
-  /* We don't support CANFDX.  We can do ZCRCQ if the remote sender does  */
-
-  if ((rcaps & (CANFDX | CANOVIO)) ==
-      (CANFDX | CANOVIO) && pzms->rcvmax == 0)
-    {
-      /* For the local sender, this is just like ZCRCW */
-
-      pzms->dpkttype = ZCRCQ;
-    }
-#endif
 
   /* Otherwise, we have to do ZCRCW */
 
@@ -815,8 +845,7 @@ static int zms_fileskip(FAR struct zm_state_s *pzm)
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
 
   zmdbg("ZMS_STATE %d\n", pzm->state);
-  close(pzms->infd);
-  pzms->infd = -1;
+  zms_fileclose(pzms);
   return ZM_XFRDONE;
 }
 
@@ -853,15 +882,19 @@ static int zms_sendfiledata(FAR struct zm_state_s *pzm)
 static int zms_sendpacket(FAR struct zm_state_s *pzm)
 {
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+  FAR const uint8_t *data;
   ssize_t nwritten;
+  ssize_t navail;
   int32_t unacked;
+  int32_t sndsize;
+  int32_t limit;
+  off_t pktstart;
   bool bcrc32;
   uint32_t crc;
   uint8_t by[4];
   uint8_t *ptr;
   uint8_t type;
-  bool wait = false;
-  int sndsize;
+  bool wait;
   int pktsize;
   int i;
 
@@ -881,34 +914,31 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
 
       unacked = pzms->offset - pzms->lastoffs;
 
-      /* Can we still send?  If so, how much?   If rcvmax is zero, then the
-       * remote can handle full streaming and we never have to wait.
-       * Otherwise, we have to restrict the total number of unacknowledged
-       * bytes to rcvmax.
+      /* Can we still send?  If so, how much?  If rcvmax is non-zero, the
+       * receiver cannot overlap serial and disk I/O and we have to restrict
+       * the total number of unacknowledged bytes to rcvmax.  When streaming,
+       * the number of unacknowledged bytes is limited by the send window.
        */
 
-      zmdbg("sndsize: %d unacked: %d rcvmax: %d\n",
-            sndsize, unacked, pzms->rcvmax);
-
-      if (pzms->rcvmax != 0)
+      limit = pzms->rcvmax;
+      if (limit == 0 && pzms->dpkttype != ZCRCW)
         {
-          /* If we were to send 'sndsize' more bytes,
-           * would that exceed recvmax?
-           */
+          limit = CONFIG_SYSTEM_ZMODEM_SNDWINDOW;
+        }
 
-          if (sndsize + unacked > pzms->rcvmax)
-            {
-              /* Yes... clip the maximum so that we stay within that limit */
+      zmdbg("sndsize: %ld unacked: %ld limit: %ld\n",
+            (long)sndsize, (long)unacked, (long)limit);
 
-              int maximum = pzms->rcvmax - unacked;
-              if (sndsize < maximum)
-                {
-                  sndsize = maximum;
-                }
+      wait = false;
+      if (limit != 0 && sndsize + unacked > limit)
+        {
+          /* Clip the size so that we stay within that limit.  The packet
+           * that reaches the limit is sent with ZCRCW.
+           */
 
-              wait = true;
-              zmdbg("Clipped sndsize: %d\n", sndsize);
-            }
+          sndsize = limit - unacked;
+          wait    = true;
+          zmdbg("Clipped sndsize: %ld\n", (long)sndsize);
         }
 
       /* Can we send anything? */
@@ -924,6 +954,62 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
           return OK;
         }
 
+      /* Escape file data into the transmit buffer until the buffer is full
+       * or sndsize bytes have been taken.  The CRC is accumulated over each
+       * contiguous run of file data rather than byte by byte.
+       */
+
+      bcrc32      = ((pzm->flags & ZM_FLAG_CRC32) != 0);
+      crc         = bcrc32 ? 0xffffffff : 0;
+      pzm->flags &= ~ZM_FLAG_ATSIGN;
+
+      ptr         = pzm->scratch;
+      pktsize     = 0;
+      pktstart    = pzms->offset;
+
+      while (pktsize + ZMS_PKTRESERVE < CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE &&
+             pzms->offset - pktstart < sndsize)
+        {
+          navail = zms_fileget(pzms, &data);
+          if (navail < 0)
+            {
+              zmdbg("ERROR: zms_fileget failed: %d\n", (int)navail);
+              return (int)navail;
+            }
+
+          if (navail > sndsize - (pzms->offset - pktstart))
+            {
+              navail = sndsize - (pzms->offset - pktstart);
+            }
+
+          /* Put the characters into the buffer, escaping as necessary */
+
+          for (i = 0;
+               i < navail &&
+               pktsize + ZMS_PKTRESERVE < CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE;
+               i++)
+            {
+              ptr     = zm_putzdle(pzm, ptr, data[i]);
+              pktsize = ptr - pzm->scratch;
+            }
+
+          /* Add the new data to the accumulated CRC */
+
+          if (!bcrc32)
+            {
+              crc = (uint32_t)crc16part(data, i, (uint16_t)crc);
+            }
+          else
+            {
+              crc = crc32part(data, i, crc);
+            }
+
+          /* And increment the file offset */
+
+          zms_fileconsume(pzms, i);
+          pzms->offset += i;
+        }
+
       /* Determine what kind of packet to send
        *
        * ZCRCW:
@@ -951,74 +1037,20 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
           type = ZCRCW;
           pzm->flags &= ~ZM_FLAG_WAIT;
         }
-      else if (wait)
+      else if (wait && pzms->offset - pktstart >= sndsize)
         {
           type = ZCRCW;
         }
-      else
+      else if (pzms->dpkttype == ZCRCG &&
+               pktstart / ZMS_ACKINTERVAL != pzms->offset / ZMS_ACKINTERVAL)
         {
-          type = pzms->dpkttype;
+          type = ZCRCQ;
         }
-
-      /* Read characters from file and put into buffer until buffer is full
-       * or file is exhausted
-       */
-
-      bcrc32      = ((pzm->flags & ZM_FLAG_CRC32) != 0);
-      crc         = bcrc32 ? 0xffffffff : 0;
-      pzm->flags &= ~ZM_FLAG_ATSIGN;
-
-      ptr         = pzm->scratch;
-      pktsize     = 0;
-
-#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
-      /* Read multiple bytes of file and store into the temporal buffer */
-
-      zm_read(pzms->infd, pzm->filebuf, CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE);
-
-      i = 0;
-#endif
-
-      while (pktsize <= (CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE - 10) &&
-             (pzms->offset < pzms->filesize))
+      else
         {
-          /* Add the new value to the accumulated CRC */
-
-#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
-          uint8_t ch = pzm->filebuf[i++];
-#else
-          uint8_t ch = zm_getc(pzms->infd);
-#endif
-          if (!bcrc32)
-            {
-              crc = (uint32_t)crc16part(&ch, 1, (uint16_t)crc);
-            }
-          else
-            {
-              crc = crc32part(&ch, 1, crc);
-            }
-
-          /* Put the character into the buffer, escaping as necessary */
-
-          ptr = zm_putzdle(pzm, ptr, ch);
-
-          /* Recalculate the accumulated packet size to handle expansion due
-           * to escaping.
-           */
-
-          pktsize = (int32_t)(ptr - pzm->scratch);
-
-          /* And increment the file offset */
-
-          pzms->offset++;
+          type = pzms->dpkttype;
         }
 
-#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
-      /* Restore file position to be read next time */
-
-      lseek(pzms->infd, pzms->offset, SEEK_SET);
-#endif
-
       /* If we've reached file end, a ZEOF header will follow.  If there's
        * room in the outgoing buffer for it, end the packet with ZCRCE and
        * append the ZEOF header.  If there isn't room, we'll have to do a
@@ -1102,14 +1134,16 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
         case ZCRCE:  /* CRC next, transfer ends, ZEOF follows */
           zmdbg("ZMS_STATE %d->%d: ZCRCE\n", pzm->state, ZMS_SENDEOF);
 
-          pzm->state   = ZMS_SENDEOF;
-          pzm->timeout = CONFIG_SYSTEM_ZMODEM_RESPTIME;
+          pzms->inframe = false;
+          pzm->state    = ZMS_SENDEOF;
+          pzm->timeout  = CONFIG_SYSTEM_ZMODEM_RESPTIME;
           zm_be32toby(pzms->offset, by);
           return zm_sendhexhdr(pzm, ZEOF, by);
 
         /* We need to want for ZACK */
 
         case ZCRCW:  /* CRC next, send ZACK, transfer ends */
+          pzms->inframe = false;
           if ((pzm->flags & ZM_FLAG_EOF) != 0)
             {
               zmdbg("ZMS_STATE %d->%d: EOF\n", pzm->state, ZMS_SENDDONE);
@@ -1131,19 +1165,53 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
         default:
           zmdbg("ZMS_STATE %d->%d: Default\n", pzm->state, ZMS_SENDING);
 
-          pzm->state = ZMS_SENDING;
+          pzms->inframe = true;
+          pzm->state    = ZMS_SENDING;
           break;
         }
     }
 #ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
   while (pzm->state == ZMS_SENDING && !zm_rcvpending(pzm));
+
+  /* Have zm_datapump() resume streaming once the input is parsed */
+
+  if (pzm->state == ZMS_SENDING)
+    {
+      pzm->flags |= ZM_FLAG_STREAM;
+    }
 #else
-  while (0);
+  while (pzm->state == ZMS_SENDING);
 #endif
 
   return OK;
 }
 
+/****************************************************************************
+ * Name: zms_sendack
+ *
+ * Description:
+ *   A ZACK for a ZCRCQ subpacket arrived while streaming.  Update the last
+ *   known receiver offset and continue streaming.
+ *
+ ****************************************************************************/
+
+static int zms_sendack(FAR struct zm_state_s *pzm)
+{
+  FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+  off_t offset;
+
+  /* ZACKs beyond the current offset were sent before a ZRPOS rewind */
+
+  offset = zm_bytobe32(pzm->hdrdata + 1);
+  if (offset > pzms->lastoffs && offset <= pzms->offset)
+    {
+      pzms->lastoffs = offset;
+    }
+
+  zmdbg("ZMS_STATE %d: offset: %ld\n", pzm->state, (unsigned long)offset);
+  return zms_sendpacket(pzm);
+}
+
 /****************************************************************************
  * Name: zms_filecrc
  *
@@ -1156,12 +1224,20 @@ static int zms_filecrc(FAR struct zm_state_s *pzm)
 {
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
   uint8_t by[4];
-  uint32_t crc;
 
-  crc = zm_filecrc(pzm, pzms->filename);
-  zmdbg("ZMS_STATE %d: CRC %08x\n", pzm->state, crc);
+  /* The receiver may ask again (ZNAK, repeated ZCRC).  The file is only
+   * read once.
+   */
+
+  if (!pzms->crcvalid)
+    {
+      pzms->filecrc  = zm_filecrc(pzm, pzms->filename);
+      pzms->crcvalid = true;
+    }
+
+  zmdbg("ZMS_STATE %d: CRC %08x\n", pzm->state, pzms->filecrc);
 
-  zm_be32toby(crc, by);
+  zm_be32toby(pzms->filecrc, by);
   return zm_sendhexhdr(pzm, ZCRC, by);
 }
 
@@ -1187,13 +1263,26 @@ static int zms_sendwaitack(FAR struct zm_state_s *pzm)
 
   offset = zm_bytobe32(pzm->hdrdata + 1);
 
-  if (offset > pzms->lastoffs)
+  if (offset > pzms->lastoffs && offset <= pzms->offset)
     {
       pzms->lastoffs = offset;
     }
 
   zmdbg("ZMS_STATE %d: offset: %ld\n", pzm->state, (unsigned long)offset);
 
+  /* When streaming without sampling the reverse channel, ZACKs of earlier
+   * ZCRCQ subpackets may still be queued.  Keep waiting for the ZACK of the
+   * ZCRCW subpacket that ended the window; the receiver is not ready for a
+   * new ZDATA header before that.  Stale ZACKs from before a ZRPOS rewind
+   * may carry a larger offset.
+   */
+
+  if (offset != pzms->offset)
+    {
+      pzm->state = ZMS_SENDWAIT;
+      return OK;
+    }
+
   /* Now send the next data packet */
 
   zm_be32toby(pzms->offset, by);
@@ -1217,28 +1306,43 @@ static int zms_sendwaitack(FAR struct zm_state_s *pzm)
 static int zms_sendnak(FAR struct zm_state_s *pzm)
 {
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
-  off_t offset;
+  uint8_t by[4];
+  int ret;
 
   /* Save the ZRPOS file offset */
 
-  pzms->offset = pzms->zrpos;
+  pzms->offset   = pzms->zrpos;
+  pzms->lastoffs = pzms->zrpos;
 
-  /* TODO: What is the correct thing to do if lseek fails? Send ZEOF? */
+  /* TODO: What is the correct thing to do if the seek fails? Send ZEOF? */
 
-  offset = lseek(pzms->infd, pzms->offset, SEEK_SET);
-  if (offset == (off_t)-1)
+  ret = zms_fileseek(pzms, pzms->offset);
+  if (ret < 0)
     {
-      int errorcode = errno;
-
-      zmdbg("ERROR: Failed to seek to %ld: %d\n",
-            (unsigned long)pzms->offset, errorcode);
-      DEBUGASSERT(errorcode > 0);
-      return -errorcode;
+      return ret;
     }
 
   zmdbg("ZMS_STATE %d: offset: %ld\n",
         pzm->state, (unsigned long)pzms->offset);
 
+  /* The receiver discards data subpackets until it sees a valid ZDATA
+   * header, so the header must be resent along with the data.
+   */
+
+  ret = zms_endframe(pzms);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  zm_be32toby(pzms->offset, by);
+  ret = zm_sendbinhdr(pzm, ZDATA, by);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  pzm->flags |= ZM_FLAG_WAIT;
   return zms_sendpacket(pzm);
 }
 
@@ -1253,7 +1357,26 @@ static int zms_sendnak(FAR struct zm_state_s *pzm)
 static int zms_sendrpos(FAR struct zm_state_s *pzm)
 {
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+  off_t offset;
+
+  /* After an error, the receiver answers every stale ZDATA header still in
+   * flight with the same ZRPOS.  Restarting for each of them would put a
+   * new stale header in flight every time, so ignore one repeat of the
+   * offset that data was just restarted from.
+   */
+
+  offset = zm_bytobe32(pzm->hdrdata + 1);
+  if (offset == pzms->zrpos && pzms->lastoffs == pzms->zrpos &&
+      (pzm->flags & ZM_FLAG_RPOSDUP) == 0)
+    {
+      zmdbg("ZMS_STATE %d: Ignoring repeated ZRPOS(%ld)\n",
+            pzm->state, (unsigned long)offset);
+
+      pzm->flags |= ZM_FLAG_RPOSDUP;
+      return pzm->state == ZMS_SENDING ? zms_sendpacket(pzm) : OK;
+    }
 
+  pzm->flags &= ~ZM_FLAG_RPOSDUP;
   pzm->nerrors++;
   pzm->flags |= ZM_FLAG_WAIT;
   return zms_startfiledata(pzms);
@@ -1279,7 +1402,7 @@ static int zms_senddoneack(FAR struct zm_state_s *pzm)
 
   offset = zm_bytobe32(pzm->hdrdata + 1);
 
-  if (offset > pzms->lastoffs)
+  if (offset > pzms->lastoffs && offset <= pzms->offset)
     {
       pzms->lastoffs = offset;
     }
@@ -1354,6 +1477,29 @@ static int zms_timeout(FAR struct zm_state_s *pzm)
   return -ETIMEDOUT;
 }
 
+/****************************************************************************
+ * Name: zms_sendwaitto
+ *
+ * Description:
+ *   Timed out waiting for ZACK of a ZCRCW subpacket.  If a repeated ZRPOS
+ *   was ignored, the subpacket sent in response to the first one was lost
+ *   as well.  Act on the ignored ZRPOS now.
+ *
+ ****************************************************************************/
+
+static int zms_sendwaitto(FAR struct zm_state_s *pzm)
+{
+  FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+
+  if ((pzm->flags & ZM_FLAG_RPOSDUP) == 0)
+    {
+      return zms_timeout(pzm);
+    }
+
+  zm_be32toby(pzms->zrpos, pzm->hdrdata + 1);
+  return zms_sendrpos(pzm);
+}
+
 /****************************************************************************
  * Name: zms_cmdto
  *
@@ -1397,6 +1543,352 @@ static int zms_error(FAR struct zm_state_s *pzm)
   return OK;
 }
 
+/****************************************************************************
+ * Name: zms_reader
+ *
+ * Description:
+ *   Reader thread.  Reads the file ahead into whichever buffer is free
+ *   while the state machine escapes and sends the data of the other one.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+static FAR void *zms_reader(FAR void *arg)
+{
+  FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)arg;
+  FAR struct zms_reader_s *rd = &pzms->rd;
+  ssize_t nread;
+  uint32_t seq;
+  off_t offset;
+  int ndx;
+
+  pthread_mutex_lock(&rd->lock);
+  for (; ; )
+    {
+      /* Wait until the next buffer has been consumed */
+
+      while (!rd->stop && rd->full[rd->tail])
+        {
+          pthread_cond_wait(&rd->cond, &rd->lock);
+        }
+
+      if (rd->stop)
+        {
+          break;
+        }
+
+      ndx    = rd->tail;
+      seq    = rd->seq;
+      offset = rd->rdoffs;
+      pthread_mutex_unlock(&rd->lock);
+
+      /* The lock is not held while reading so that the state machine can
+       * consume the other buffer meanwhile.
+       */
+
+      do
+        {
+          nread = pread(pzms->infd, rd->buffer[ndx],
+                        CONFIG_SYSTEM_ZMODEM_SNDREADSIZE, offset);
+        }
+      while (nread < 0 && errno == EINTR);
+
+      if (nread < 0)
+        {
+          nread = -errno;
+        }
+
+      pthread_mutex_lock(&rd->lock);
+
+      /* Discard the data if the file was repositioned meanwhile */
+
+      if (seq == rd->seq)
+        {
+          rd->nbytes[ndx] = nread;
+          rd->full[ndx]   = true;
+          rd->tail        = ndx ^ 1;
+
+          if (nread > 0)
+            {
+              rd->rdoffs += nread;
+            }
+
+          pthread_cond_broadcast(&rd->cond);
+        }
+    }
+
+  pthread_mutex_unlock(&rd->lock);
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: zms_fileopen
+ *
+ * Description:
+ *   Open the local file and, if so configured, start the reader thread.
+ *
+ ****************************************************************************/
+
+static int zms_fileopen(FAR struct zms_state_s *pzms,
+                        FAR const char *filename)
+{
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  FAR struct zms_reader_s *rd = &pzms->rd;
+  int ret;
+#endif
+
+  pzms->infd = open(filename, O_RDONLY);
+  if (pzms->infd < 0)
+    {
+      int errorcode = errno;
+      DEBUGASSERT(errorcode > 0);
+      zmdbg("Failed to open %s: %d\n", filename, errorcode);
+      return -errorcode;
+    }
+
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  rd->rdoffs  = 0;
+  rd->seq     = 0;
+  rd->rdndx   = 0;
+  rd->head    = 0;
+  rd->tail    = 0;
+  rd->stop    = false;
+  rd->full[0] = false;
+  rd->full[1] = false;
+  pthread_mutex_init(&rd->lock, NULL);
+  pthread_cond_init(&rd->cond, NULL);
+
+  ret = pthread_create(&rd->thread, NULL, zms_reader, pzms);
+  if (ret != 0)
+    {
+      zmdbg("ERROR: pthread_create failed: %d\n", ret);
+      pthread_cond_destroy(&rd->cond);
+      pthread_mutex_destroy(&rd->lock);
+      close(pzms->infd);
+      pzms->infd = -1;
+      return -ret;
+    }
+
+  pzms->rdstarted = true;
+#else
+  pzms->fbndx = 0;
+  pzms->fblen = 0;
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zms_fileseek
+ *
+ * Description:
+ *   Reposition the file, discarding any data already read ahead.
+ *
+ ****************************************************************************/
+
+static int zms_fileseek(FAR struct zms_state_s *pzms, off_t offset)
+{
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  FAR struct zms_reader_s *rd = &pzms->rd;
+
+  pthread_mutex_lock(&rd->lock);
+  rd->seq++;
+  rd->rdoffs  = offset;
+  rd->full[0] = false;
+  rd->full[1] = false;
+  rd->head    = 0;
+  rd->tail    = 0;
+  rd->rdndx   = 0;
+  pthread_cond_broadcast(&rd->cond);
+  pthread_mutex_unlock(&rd->lock);
+#else
+  if (lseek(pzms->infd, offset, SEEK_SET) == (off_t)-1)
+    {
+      int errorcode = errno;
+
+      zmdbg("ERROR: Failed to seek to %ld: %d\n",
+            (unsigned long)offset, errorcode);
+      DEBUGASSERT(errorcode > 0);
+      return -errorcode;
+    }
+
+  pzms->fbndx = 0;
+  pzms->fblen = 0;
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zms_fileget
+ *
+ * Description:
+ *   Return the file data available at the current file position.  The data
+ *   stays valid until zms_fileconsume() is called.
+ *
+ * Returned Value:
+ *   The number of bytes available (> 0) or a negated errno value.  The end
+ *   of the file is reported as -EIO:  The caller never reads beyond the
+ *   size of the file that was sent in the ZFILE header.
+ *
+ ****************************************************************************/
+
+static ssize_t zms_fileget(FAR struct zms_state_s *pzms,
+                           FAR const uint8_t **data)
+{
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  FAR struct zms_reader_s *rd = &pzms->rd;
+  ssize_t nbytes;
+
+  pthread_mutex_lock(&rd->lock);
+  while (!rd->full[rd->head])
+    {
+      pthread_cond_wait(&rd->cond, &rd->lock);
+    }
+
+  nbytes = rd->nbytes[rd->head];
+  pthread_mutex_unlock(&rd->lock);
+
+  if (nbytes <= 0)
+    {
+      return nbytes < 0 ? nbytes : -EIO;
+    }
+
+  *data = &rd->buffer[rd->head][rd->rdndx];
+  return nbytes - rd->rdndx;
+#else
+  ssize_t nread;
+
+  if (pzms->fbndx >= pzms->fblen)
+    {
+      nread = zm_read(pzms->infd, ZMS_FILEBUF(pzms), ZMS_FILEBUFSIZE);
+      if (nread <= 0)
+        {
+          return nread < 0 ? nread : -EIO;
+        }
+
+      pzms->fbndx = 0;
+      pzms->fblen = nread;
+    }
+
+  *data = ZMS_FILEBUF(pzms) + pzms->fbndx;
+  return pzms->fblen - pzms->fbndx;
+#endif
+}
+
+/****************************************************************************
+ * Name: zms_fileconsume
+ *
+ * Description:
+ *   Advance the file position by nbytes of the data returned by
+ *   zms_fileget().
+ *
+ ****************************************************************************/
+
+static void zms_fileconsume(FAR struct zms_state_s *pzms, size_t nbytes)
+{
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  FAR struct zms_reader_s *rd = &pzms->rd;
+
+  rd->rdndx += nbytes;
+  if (rd->rdndx >= rd->nbytes[rd->head])
+    {
+      /* Hand the buffer back to the reader thread */
+
+      pthread_mutex_lock(&rd->lock);
+      rd->full[rd->head] = false;
+      rd->head ^= 1;
+      rd->rdndx = 0;
+      pthread_cond_broadcast(&rd->cond);
+      pthread_mutex_unlock(&rd->lock);
+    }
+#else
+  pzms->fbndx += nbytes;
+#endif
+}
+
+/****************************************************************************
+ * Name: zms_fileclose
+ *
+ * Description:
+ *   Stop the reader thread, if any, and close the local file.
+ *
+ ****************************************************************************/
+
+static void zms_fileclose(FAR struct zms_state_s *pzms)
+{
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDTHREAD
+  FAR struct zms_reader_s *rd = &pzms->rd;
+
+  if (pzms->rdstarted)
+    {
+      pthread_mutex_lock(&rd->lock);
+      rd->stop = true;
+      pthread_cond_broadcast(&rd->cond);
+      pthread_mutex_unlock(&rd->lock);
+
+      pthread_join(rd->thread, NULL);
+      pthread_cond_destroy(&rd->cond);
+      pthread_mutex_destroy(&rd->lock);
+      pzms->rdstarted = false;
+    }
+#endif
+
+  if (pzms->infd >= 0)
+    {
+      close(pzms->infd);
+      pzms->infd = -1;
+    }
+}
+
+/****************************************************************************
+ * Name: zms_endframe
+ *
+ * Description:
+ *   A header sent while the receiver is still in data mode after a ZCRCG or
+ *   ZCRCQ subpacket would be taken for subpacket data.  End the frame with
+ *   an empty ZCRCE subpacket first.
+ *
+ ****************************************************************************/
+
+static int zms_endframe(FAR struct zms_state_s *pzms)
+{
+  FAR struct zm_state_s *pzm = &pzms->cmn;
+  FAR uint8_t *ptr = pzm->scratch;
+  uint8_t type = ZCRCE;
+  ssize_t nwritten;
+  uint32_t crc;
+  int i;
+
+  if (!pzms->inframe)
+    {
+      return OK;
+    }
+
+  pzms->inframe = false;
+  *ptr++ = ZDLE;
+  *ptr++ = type;
+
+  if ((pzm->flags & ZM_FLAG_CRC32) == 0)
+    {
+      crc = crc16part(&type, 1, 0);
+      ptr = zm_putzdle(pzm, ptr, (crc >> 8) & 0xff);
+      ptr = zm_putzdle(pzm, ptr, crc & 0xff);
+    }
+  else
+    {
+      crc = ~crc32part(&type, 1, 0xffffffff);
+      for (i = 0; i < 4; i++, crc >>= 8)
+        {
+          ptr = zm_putzdle(pzm, ptr, crc & 0xff);
+        }
+    }
+
+  nwritten = zm_remwrite(pzm->remfd, pzm->scratch, ptr - pzm->scratch);
+  return nwritten < 0 ? (int)nwritten : OK;
+}
+
 /****************************************************************************
  * Name: zms_sendfiledata
  *
@@ -1408,7 +1900,6 @@ static int zms_error(FAR struct zm_state_s *pzm)
 
 static int zms_startfiledata(FAR struct zms_state_s *pzms)
 {
-  off_t offset;
   int ret;
 
   zmdbg("ZMS_STATE %d: offset %ld nerrors %d\n",
@@ -1425,15 +1916,10 @@ static int zms_startfiledata(FAR struct zms_state_s *pzms)
 
   /* See to the requested file position */
 
-  offset = lseek(pzms->infd, pzms->offset, SEEK_SET);
-  if (offset == (off_t)-1)
+  ret = zms_fileseek(pzms, pzms->offset);
+  if (ret < 0)
     {
-      int errorcode = errno;
-
-      zmdbg("ERROR: Failed to seek to %ld: %d\n",
-            (unsigned long)pzms->offset, errorcode);
-      DEBUGASSERT(errorcode > 0);
-      return -errorcode;
+      return ret;
     }
 
   /* Paragraph 8.2: "The sender sends a ZDATA binary header (with file
@@ -1443,6 +1929,12 @@ static int zms_startfiledata(FAR struct zms_state_s *pzms)
   zmdbg("ZMS_STATE %d: Send ZDATA offset %ld\n",
         pzms->cmn.state, (unsigned long)pzms->offset);
 
+  ret = zms_endframe(pzms);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
   ret = zm_sendbinhdr(&pzms->cmn, ZDATA, pzms->cmn.hdrdata + 1);
   if (ret != OK)
     {
@@ -1495,15 +1987,13 @@ static int zms_sendfile(FAR struct zms_state_s *pzms,
       return -errorcode;
     }
 
-  /* Open the local file for reading */
+  /* Close the previous file and open the local file for reading */
 
-  pzms->infd = open(filename, O_RDONLY);
-  if (pzms->infd < 0)
+  zms_fileclose(pzms);
+  ret = zms_fileopen(pzms, filename);
+  if (ret < 0)
     {
-      int errorcode = errno;
-      DEBUGASSERT(errorcode > 0);
-      zmdbg("Failed to open %s: %d\n", filename, errorcode);
-      return -errorcode;
+      return ret;
     }
 
   /* Initialize for the transfer */
@@ -1519,6 +2009,8 @@ static int zms_sendfile(FAR struct zms_state_s *pzms,
   pzms->fflags[0]  = 0;
   pzms->offset     = 0;
   pzms->lastoffs   = 0;
+  pzms->crcvalid   = false;
+  pzms->inframe    = false;
 
   pzms->filesize   = buf.st_size;
 #ifdef CONFIG_SYSTEM_ZMODEM_TIMESTAMPS
@@ -1578,6 +2070,7 @@ ZMSHANDLE zms_initialize(int remfd)
       pzm->pstate    = PSTATE_IDLE;
       pzm->psubstate = PIDLE_ZPAD;
       pzm->remfd     = remfd;
+      pzms->infd     = -1;
 
       /* Create a timer to handle timeout events */
 
@@ -1735,10 +2228,7 @@ int zms_release(ZMSHANDLE handle)
 
   /* Make sure that the file is closed */
 
-  if (pzms->infd)
-    {
-      close(pzms->infd);
-    }
+  zms_fileclose(pzms);
 
   /* And free the Zmodem state structure */
 
@@ -44,6 +44,7 @@
 #include <ctype.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sched.h>
 #include <assert.h>
 #include <errno.h>
@@ -116,7 +117,8 @@ static int zm_event(FAR struct zm_state_s *pzm, int event)
 
   /* Perform the state transition */
 
-  pzm->state = ptr->next;
+  pzm->state  = ptr->next;
+  pzm->flags &= ~ZM_FLAG_STREAM;
 
   /* Discard buffered data if so requested */
 
@@ -868,6 +870,19 @@ int zm_datapump(FAR struct zm_state_s *pzm)
 
   do
     {
+#ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
+      /* A sender that paused streaming to process incoming data resumes
+       * as soon as that data has been parsed.  In the streaming state, a
+       * timeout event continues sending data subpackets.
+       */
+
+      if ((pzm->flags & ZM_FLAG_STREAM) != 0 && !zm_rcvpending(pzm))
+        {
+          ret = zm_timeout(pzm);
+          continue;
+        }
+
+#endif
       /* Start/restart the timer.  Whenever we read data from the peer we
        * must anticipate a timeout because we can never be sure that the peer
        * is still responding.
@@ -920,6 +935,7 @@ int zm_datapump(FAR struct zm_state_s *pzm)
                 {
                   /* Yes... a timeout occurred */
 
+                  pzm->flags &= ~ZM_FLAG_TIMEOUT;
                   ret = zm_timeout(pzm);
                 }
 
@@ -986,3 +1002,37 @@ int zm_timeout(FAR struct zm_state_s *pzm)
 {
   return zm_event(pzm, ZME_TIMEOUT);
 }
+
+/****************************************************************************
+ * Name: zm_rcvpending
+ *
+ * Description:
+ *   Return true if data from the remote receiver is pending.  In that case,
+ *   the local sender should stop data streaming operations and process the
+ *   incoming data.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
+bool zm_rcvpending(FAR struct zm_state_s *pzm)
+{
+  struct pollfd fds;
+
+  /* Data already read but not yet parsed is pending too if it may hold
+   * another header.
+   */
+
+  if (pzm->rcvndx < pzm->rcvlen &&
+      memchr(&pzm->rcvbuf[pzm->rcvndx], ZPAD,
+             pzm->rcvlen - pzm->rcvndx) != NULL)
+    {
+      return true;
+    }
+
+  fds.fd      = pzm->remfd;
+  fds.events  = POLLIN;
+  fds.revents = 0;
+
+  return poll(&fds, 1, 0) > 0 && (fds.revents & POLLIN) != 0;
+}
+#endif